@@ -28,8 +28,16 @@ include(CheckSymbolExists)
 check_symbol_exists("gai_strerror" "netdb.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_GAI_STRERROR)
 check_symbol_exists("getnameinfo" "netdb.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_GETNAMEINFO)
 check_symbol_exists("inet_ntop" "arpa/inet.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_NTOP)
+check_symbol_exists("inet_pton" "arpa/inet.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON)
 check_symbol_exists("poll" "poll.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL)
 check_symbol_exists("recvmsg" "sys/socket.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG)
+check_symbol_exists("sendmsg" "sys/socket.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG)
+check_symbol_exists("posix_fallocate" "fcntl.h" AVS_COMMONS_STREAM_FILE_FD_HAVE_POSIX_FALLOCATE)
+check_symbol_exists("fdatasync" "unistd.h" AVS_COMMONS_STREAM_FILE_FD_HAVE_FDATASYNC)
+check_symbol_exists("stat" "sys/stat.h" AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT)
+
+include(CheckStructHasMember)
+check_struct_has_member("struct stat" st_mtim "sys/stat.h" AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT_MTIM LANGUAGE C)
 
 # When _POSIX_C_SOURCE is defined, but none of _BSD_SOURCE, _SVID_SOURCE and
 # _GNU_SOURCE, some toolchains (e.g. default GCC on Ubuntu 16.04 or CentOS 7)
@@ -50,4 +58,10 @@ else()
     message(STATUS "Checking if IN6_IS_ADDR_V4MAPPED is usable - no")
 endif()
 
+# Batched socket I/O calls are Linux-specific and declared only with _GNU_SOURCE
+set(CMAKE_REQUIRED_DEFINITIONS ${CMAKE_REQUIRED_DEFINITIONS} -D_GNU_SOURCE)
+check_symbol_exists("recvmmsg" "sys/socket.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG)
+check_symbol_exists("sendmmsg" "sys/socket.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG)
+check_symbol_exists("UDP_SEGMENT" "netinet/udp.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT)
+
 set(CMAKE_REQUIRED_DEFINITIONS "${STORED_REQUIRED_DEFINITIONS}")
@@ -147,6 +147,7 @@ static inline const char *_avs_wsa_set_errno_str(const char *result) {
 #define AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_GAI_STRERROR
 #define AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_GETNAMEINFO
 #define AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_NTOP
+#define AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON
 #define AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL
 
 #define accept(...) _avs_wsa_set_errno_socket(accept(__VA_ARGS__))
@@ -26,13 +26,64 @@ class PrintAvsRbtreeBase(gdb.Command):
         self.int_type = gdb.lookup_type('int')
         self.output_format = '%%s 0x%%0%dx = %%s' % (self.intptr_type.sizeof * 2,)
 
-        # TODO
+        self.compact_nodes = False
         self.color_offset = -32
         self.parent_offset = -24
         self.left_offset = -16
         self.right_offset = -8
+        self.color_names = { 0x50DC: 'DETACHED_POOLED', 0x50DD: 'DETACHED',
+                             0x50DE: 'RED', 0x50DF: 'BLACK' }
+        self._layout_detected = False
+
+    def _detect_layout(self):
+        # Node layout depends on AVS_COMMONS_RBTREE_WITH_COMPACT_NODES, so read
+        # it from debug info if available; the defaults above match the
+        # non-compact layout on x86_64.
+        if self._layout_detected:
+            return
+        self._layout_detected = True
+        try:
+            node_space_type = gdb.lookup_type('struct rb_node_space')
+        except gdb.error:
+            return
+
+        value_offset = None
+        node_fields = None
+        for field in node_space_type.fields():
+            if field.name == 'value':
+                value_offset = field.bitpos // 8
+            elif field.name == 'node':
+                node_fields = field.type.fields()
+        if value_offset is None or node_fields is None:
+            return
+
+        offsets = dict((f.name, f.bitpos // 8 - value_offset) for f in node_fields)
+        if 'parent_and_color' in offsets:
+            self.compact_nodes = True
+            self.color_offset = offsets['parent_and_color']
+            self.parent_offset = offsets['parent_and_color']
+        else:
+            self.color_offset = offsets['color']
+            self.parent_offset = offsets['parent']
+        self.left_offset = offsets['left']
+        self.right_offset = offsets['right']
+
+    def _read_color(self, intptr_ptr):
+        if self.compact_nodes:
+            raw = int((intptr_ptr + self.color_offset).cast(self.intptr_type.pointer()).dereference())
+            color = 0x50DC | (raw & 3)
+        else:
+            color = int((intptr_ptr + self.color_offset).cast(self.int_type.pointer()).dereference())
+        return self.color_names.get(color, str(color))
+
+    def _read_parent(self, intptr_ptr):
+        raw = int((intptr_ptr + self.parent_offset).cast(self.intptr_type.pointer()).dereference())
+        if self.compact_nodes:
+            raw &= ~3
+        return raw
 
     def _print_tree(self, ptr, path='', depth=0, visited_addrs=set()):
+        self._detect_layout()
         left_ptr_value = ptr.cast(self.intptr_type) + self.left_offset
         left_ptr = left_ptr_value.cast(ptr.type.pointer()).dereference()
 
@@ -138,6 +189,7 @@ class PrintAvsRbtreeNode(PrintAvsRbtreeBase):
         if ptr == 0:
             print('(null)')
         else:
+            self._detect_layout()
             intptr_ptr = ptr.cast(self.intptr_type)
             if with_magic:
                 print((intptr_ptr + self.rb_magic_offset))
@@ -145,8 +197,8 @@ class PrintAvsRbtreeNode(PrintAvsRbtreeBase):
                 print('rb magic:   %s' % ((intptr_ptr + self.rb_magic_offset).cast(self.int_type.pointer()).dereference()))
                 print('tree magic: %s' % ((intptr_ptr + self.tree_magic_offset).cast(self.int_type.pointer()).dereference()))
 
-            print('color:  %s' % ((intptr_ptr + self.color_offset ).cast(self.int_type.pointer()).dereference()))
-            print('parent: 0x%%0%dx' % (self.intptr_type.sizeof * 2) % ((intptr_ptr + self.parent_offset).cast(ptr.type.pointer()).dereference()))
+            print('color:  %s' % self._read_color(intptr_ptr))
+            print('parent: 0x%%0%dx' % (self.intptr_type.sizeof * 2) % self._read_parent(intptr_ptr))
             print('left:   0x%%0%dx' % (self.intptr_type.sizeof * 2) % ((intptr_ptr + self.left_offset  ).cast(ptr.type.pointer()).dereference()))
             print('right:  0x%%0%dx' % (self.intptr_type.sizeof * 2) % ((intptr_ptr + self.right_offset ).cast(ptr.type.pointer()).dereference()))
 
@@ -20,6 +20,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <avsystem/commons/avs_defs.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -69,6 +71,18 @@ typedef struct avs_buffer_struct avs_buffer_t;
  * Circular byte buffer object type.
  */
 
+/**
+ * Describes a contiguous block of free space in a buffer, as returned by
+ * @ref avs_buffer_free_spans. Unlike @ref avs_iovec_t, which is used for data
+ * spans, the memory it points to is writable.
+ */
+typedef struct {
+    /** Pointer to the beginning of the free space block. */
+    char *base;
+    /** Number of bytes in the free space block. */
+    size_t length;
+} avs_buffer_span_t;
+
 /**
  * Allocates a new buffer with a specified size (capacity).
  *
@@ -81,6 +95,28 @@ typedef struct avs_buffer_struct avs_buffer_t;
  */
 int avs_buffer_create(avs_buffer_t **buffer, size_t size);
 
+/**
+ * Allocates a new buffer with a specified size (capacity), operating in ring
+ * mode.
+ *
+ * In ring mode, data is allowed to wrap around the end of the underlying
+ * storage. This means that consuming data and appending new data never moves
+ * the already buffered bytes, as long as the data is accessed through
+ * @ref avs_buffer_data_spans and free space is accessed through
+ * @ref avs_buffer_free_spans. All other functions remain usable, but
+ * @ref avs_buffer_linearize and @ref avs_buffer_raw_insert_ptr will need to
+ * move the data if the area they are expected to return is not contiguous, and
+ * @ref avs_buffer_data shall not be called while the data wraps around.
+ *
+ * @param buffer Pointer to a variable which will be updated with the newly
+ *               allocated buffer object.
+ *
+ * @param size   Desired capacity of the buffer, in bytes.
+ *
+ * @return 0 for success, or -1 in case of error.
+ */
+int avs_buffer_create_ring(avs_buffer_t **buffer, size_t size);
+
 /**
  * Destroys a buffer object, freeing any used resources.
  *
@@ -126,16 +162,25 @@ size_t avs_buffer_space_left(const avs_buffer_t *buffer);
 /**
  * Returns a raw pointer to consumable data in the buffer.
  *
+ * This function never moves any data. In a buffer created using
+ * @ref avs_buffer_create_ring, the data may wrap around the end of the storage
+ * and so not be available contiguously - it is a programming error to call
+ * this function in that case. Use @ref avs_buffer_data_spans or
+ * @ref avs_buffer_linearize instead.
+ *
  * <strong>CAUTION:</strong> The pointer returned by this function may be
  * invalidated during calls to other functions, as <c>avs_buffer_t</c> may move
  * the data to ensure its integrity.
  *
  * List of functions that may invalidate the pointer returned from this
  * function:
- * - @ref avs_buffer_advance_ptr
- * - @ref avs_buffer_append_bytes
- * - @ref avs_buffer_fill_bytes
+ * - @ref avs_buffer_linearize
  * - @ref avs_buffer_raw_insert_ptr
+ * - in a buffer created using @ref avs_buffer_create only:
+ *   - @ref avs_buffer_advance_ptr
+ *   - @ref avs_buffer_append_bytes
+ *   - @ref avs_buffer_fill_bytes
+ *   - @ref avs_buffer_free_spans
  *
  * @param buffer Buffer object to operate on.
  *
@@ -144,6 +189,25 @@ size_t avs_buffer_space_left(const avs_buffer_t *buffer);
  */
 const char *avs_buffer_data(const avs_buffer_t *buffer);
 
+/**
+ * Makes the data contained in the buffer contiguous, moving it if it wraps
+ * around the end of the storage, and returns a raw pointer to it.
+ *
+ * In a buffer created using @ref avs_buffer_create, the data is always
+ * contiguous and this function is equivalent to @ref avs_buffer_data.
+ *
+ * Calling this function invalidates pointers previously returned by
+ * @ref avs_buffer_data_spans and @ref avs_buffer_free_spans if the data had to
+ * be moved. The returned pointer is subject to the same invalidation rules as
+ * the pointer returned by @ref avs_buffer_data.
+ *
+ * @param buffer Buffer object to operate on.
+ *
+ * @return Pointer to a contiguous array of @ref avs_buffer_data_size bytes of
+ *         data that has been appended but not yet consumed.
+ */
+const char *avs_buffer_linearize(avs_buffer_t *buffer);
+
 /**
  * Return a raw pointer to free space in the buffer.
  *
@@ -166,6 +230,57 @@ const char *avs_buffer_data(const avs_buffer_t *buffer);
  */
 char *avs_buffer_raw_insert_ptr(avs_buffer_t *buffer);
 
+/**
+ * Returns the data contained in the buffer as at most two contiguous spans,
+ * without moving any data.
+ *
+ * The first span always starts at the oldest byte of data; the second one, if
+ * non-empty, contains the data that wrapped around the end of the storage. In
+ * a buffer created using @ref avs_buffer_create, the second span is always
+ * empty.
+ *
+ * The returned pointers are subject to the same invalidation rules as the
+ * pointer returned by @ref avs_buffer_data. In particular, in a buffer created
+ * using @ref avs_buffer_create_ring, they are only invalidated by
+ * @ref avs_buffer_linearize and @ref avs_buffer_raw_insert_ptr. Consuming data
+ * does not move the remaining bytes, but the consumed part of the spans may be
+ * overwritten by subsequently appended data.
+ *
+ * @param buffer    Buffer object to operate on.
+ *
+ * @param out_spans Array of two elements that will be filled with the data
+ *                  spans. Unused elements are set to zero length.
+ *
+ * @return Number of non-empty spans (0, 1 or 2).
+ */
+size_t avs_buffer_data_spans(const avs_buffer_t *buffer,
+                             avs_iovec_t out_spans[2]);
+
+/**
+ * Returns the free space in the buffer as at most two contiguous spans.
+ *
+ * The spans shall be filled in order, and then @ref avs_buffer_advance_ptr
+ * shall be called with the total number of bytes filled. This allows e.g. to
+ * receive data into both spans with a single <c>readv()</c> call.
+ *
+ * In a buffer created using @ref avs_buffer_create_ring, this function never
+ * moves data. Otherwise, it behaves like @ref avs_buffer_raw_insert_ptr and
+ * the second span is always empty.
+ *
+ * The returned spans remain valid until the next call to any function that
+ * modifies @p buffer, other than @ref avs_buffer_advance_ptr used to commit
+ * the data written into them.
+ *
+ * @param buffer    Buffer object to operate on.
+ *
+ * @param out_spans Array of two elements that will be filled with the free
+ *                  space spans. Unused elements are set to zero length.
+ *
+ * @return Number of non-empty spans (0, 1 or 2).
+ */
+size_t avs_buffer_free_spans(avs_buffer_t *buffer,
+                             avs_buffer_span_t out_spans[2]);
+
 /**
  * Marks some amount of data as consumed, freeing portion of the available
  * capacity.
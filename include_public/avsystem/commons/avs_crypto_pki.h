@@ -414,6 +414,61 @@ avs_error_t avs_crypto_private_key_info_copy(
         avs_crypto_private_key_info_t **out_ptr,
         avs_crypto_private_key_info_t private_key_info);
 
+#ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+/**
+ * Drops any entries loaded from the specified certificate chain source from
+ * the process-wide cache of parsed certificates.
+ *
+ * Certificate chains and CRLs used as trust stores or client certificates by
+ * avs_net sockets are parsed once and then reused by all sockets that
+ * reference the same source. Changes to the sources are detected as follows:
+ *
+ * - files are reloaded if their modification or status change time, size,
+ *   inode or device number changes; timestamps are compared with nanosecond
+ *   resolution where the platform provides it, and with one second resolution
+ *   otherwise,
+ * - paths (hashed certificate directories) are handled differently depending
+ *   on the backend:
+ *   - with OpenSSL they are not cached at all; OpenSSL looks up certificates
+ *     in the directory lazily when verifying a peer, so all changes are
+ *     visible immediately,
+ *   - with Mbed TLS all certificates in the directory are parsed up front, and
+ *     reloaded only if the status of the directory itself changes, i.e. when
+ *     files are added, removed or renamed within it, but NOT when an existing
+ *     file is modified in place,
+ * - buffers are identified by their address and size, and reloaded if their
+ *   contents change; each cache entry holds a full copy of the source buffer
+ *   for that comparison, so caching a buffer source uses as much additional
+ *   memory as the buffer itself, for as long as the entry stays in the cache,
+ * - engine queries are never reloaded automatically.
+ *
+ * This function shall be called after changing the source in a way that is
+ * not detected automatically, e.g. after replacing a certificate stored in an
+ * engine. Sockets already using the previously parsed data are not affected.
+ *
+ * @param info Certificate chain source to invalidate. If it is an array or
+ *             list, all sources contained within it are invalidated.
+ */
+void avs_crypto_pki_cache_invalidate_certificate_chain(
+        const avs_crypto_certificate_chain_info_t *info);
+
+/**
+ * Drops any entries loaded from the specified CRL source from the
+ * process-wide cache of parsed certificates. See
+ * @ref avs_crypto_pki_cache_invalidate_certificate_chain for details.
+ *
+ * @param info CRL source to invalidate. If it is an array or list, all sources
+ *             contained within it are invalidated.
+ */
+void avs_crypto_pki_cache_invalidate_cert_revocation_list(
+        const avs_crypto_cert_revocation_list_info_t *info);
+
+/**
+ * Drops all entries from the process-wide cache of parsed certificates.
+ */
+void avs_crypto_pki_cache_invalidate_all(void);
+#endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+
 #ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
 /**
  * Persists any certificate chain info object.
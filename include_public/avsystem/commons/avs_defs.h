@@ -269,6 +269,17 @@ extern "C" {
 
 typedef long avs_off_t;
 
+/**
+ * Describes a single contiguous block of data in a scatter/gather operation -
+ * an equivalent of POSIX <c>struct iovec</c>.
+ */
+typedef struct avs_iovec {
+    /** Pointer to the beginning of the data block. */
+    const void *base;
+    /** Number of bytes in the data block. */
+    size_t length;
+} avs_iovec_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -87,6 +87,49 @@ typedef void avs_log_extended_handler_t(avs_log_level_t level,
                                         unsigned line,
                                         const char *message);
 
+#ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+/**
+ * User-defined structured handler for logging.
+ *
+ * The messages sent to the structured log handler are not formatted. Instead,
+ * the handler receives the format string and a compact binary encoding of the
+ * arguments, which can be stored or forwarded as is, and turned into text
+ * later using @ref avs_log_render.
+ *
+ * The encoding uses the native representation of the arguments, so it can
+ * only be rendered by code built for the same platform. Strings are copied
+ * into the encoding, so it stays valid after the handler returns.
+ *
+ * Messages that cannot be encoded (e.g. because their arguments are too long
+ * to fit in <c>AVS_COMMONS_LOG_MAX_LINE_LENGTH</c> bytes, or their format
+ * string contains unsupported conversions such as <c>%ls</c>) are formatted
+ * as usual and passed with @p format set to <c>"%s"</c>.
+ *
+ * @param level     Log level of the logged message.
+ *
+ * @param module    Name of the module that generated the message.
+ *
+ * @param file      File where message was generated.
+ *
+ * @param line      Line where message was generated.
+ *
+ * @param format    printf-style format string of the message. When using the
+ *                  @ref avs_log family of macros, it is a string literal.
+ *
+ * @param args      Encoded arguments of the message. Only valid until the
+ *                  handler returns.
+ *
+ * @param args_size Size of the data pointed to by @p args, in bytes.
+ */
+typedef void avs_log_structured_handler_t(avs_log_level_t level,
+                                          const char *module,
+                                          const char *file,
+                                          unsigned line,
+                                          const char *format,
+                                          const void *args,
+                                          size_t args_size);
+#endif /* AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER */
+
 /**
  * Sets the handler for the library's logging system. There may be only one
  * handler registered at a time.
@@ -152,6 +195,44 @@ void avs_log_set_handler(avs_log_handler_t *log_handler);
  */
 void avs_log_set_extended_handler(avs_log_extended_handler_t *log_handler);
 
+#ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+/**
+ * Sets the structured handler for the library's logging system. There may be
+ * only one handler registered at a time, so this replaces any handler set with
+ * @ref avs_log_set_handler or @ref avs_log_set_extended_handler.
+ *
+ * Structured handlers are called directly by the logging thread, even if the
+ * asynchronous mode is enabled.
+ *
+ * @param log_handler New log handler function to use. If @c NULL , log handler
+ *                    will be reset to the default one.
+ */
+void avs_log_set_structured_handler(avs_log_structured_handler_t *log_handler);
+
+/**
+ * Renders a message passed to a structured log handler into text.
+ *
+ * @param buf       Buffer to write the message to. The result is always
+ *                  null-terminated, and truncated if necessary.
+ *
+ * @param buf_size  Size of @p buf, in bytes.
+ *
+ * @param format    Format string, as passed to the structured log handler.
+ *
+ * @param args      Encoded arguments, as passed to the structured log handler.
+ *
+ * @param args_size Size of @p args, in bytes.
+ *
+ * @returns 0 on success, or a negative value if @p buf_size is zero, or
+ *          @p args do not match @p format.
+ */
+int avs_log_render(char *buf,
+                   size_t buf_size,
+                   const char *format,
+                   const void *args,
+                   size_t args_size);
+#endif /* AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER */
+
 /**
  * Resets the logging system to default settings and frees all resources that
  * may be used by it.
@@ -462,6 +543,95 @@ int avs_log_set_level__(const char *module, avs_log_level_t level);
         ((void) avs_log_set_level__(NULL, Level))
 #endif /* AVS_COMMONS_WITHOUT_LOG_CHECK_IN_RUNTIME */
 
+#ifdef AVS_COMMONS_LOG_WITH_ASYNC
+/**
+ * Specifies what happens to a log message that is generated while the
+ * asynchronous log queue is full.
+ */
+typedef enum {
+    /**
+     * The message is silently discarded.
+     */
+    AVS_LOG_ASYNC_OVERFLOW_DROP,
+
+    /**
+     * The logging thread waits until there is space in the queue. If no thread
+     * is running @ref avs_log_async_run at that time, the logging thread
+     * passes the oldest queued message to the log handler by itself.
+     */
+    AVS_LOG_ASYNC_OVERFLOW_BLOCK,
+
+    /**
+     * The message is discarded, and the number of discarded messages is
+     * reported through the log handler as a WARNING message of the
+     * <c>avs_log</c> module once the queue starts draining again.
+     */
+    AVS_LOG_ASYNC_OVERFLOW_COUNT
+} avs_log_async_overflow_policy_t;
+
+/**
+ * Switches avs_log into the asynchronous mode.
+ *
+ * In this mode, the logging threads only format the message into a slot of a
+ * preallocated ring buffer, and the log handler is called by a thread running
+ * @ref avs_log_async_run. This keeps slow log handlers (e.g. ones performing
+ * blocking I/O) off the latency-critical paths.
+ *
+ * NOTE: The module name and file name passed to the log handler are stored as
+ * pointers, so they need to have static storage duration. This is always the
+ * case when using the @ref avs_log family of macros.
+ *
+ * NOTE: In the @ref AVS_LOG_ASYNC_OVERFLOW_BLOCK mode, the log handler MUST NOT
+ * call any logging functions itself, as this might cause a deadlock.
+ *
+ * @param capacity Number of messages that the queue can hold. It is rounded up
+ *                 to the nearest power of two. Each message occupies roughly
+ *                 @c AVS_COMMONS_LOG_MAX_LINE_LENGTH bytes.
+ *
+ * @param policy   Behaviour to use when the queue is full.
+ *
+ * @returns 0 on success, or a negative value if @p capacity is zero, the
+ *          asynchronous mode is already enabled, or in case of an out of memory
+ *          condition.
+ */
+int avs_log_async_enable(size_t capacity,
+                         avs_log_async_overflow_policy_t policy);
+
+/**
+ * Passes the queued log messages to the log handler, waiting for new ones,
+ * until @ref avs_log_async_disable is called. Intended to be used as the body
+ * of a dedicated drain thread.
+ *
+ * This function returns immediately if the asynchronous mode is not enabled.
+ * Only one thread may run this function at a time; concurrent calls return
+ * immediately as well.
+ */
+void avs_log_async_run(void);
+
+/**
+ * Waits until all messages queued before the call are passed to the log
+ * handler. If no thread is currently running @ref avs_log_async_run, the
+ * messages are passed to the log handler in the calling thread.
+ *
+ * @returns 0 on success, or a negative value if the asynchronous mode is not
+ *          enabled.
+ */
+int avs_log_async_flush(void);
+
+/**
+ * @returns Total number of messages discarded because of a full queue since
+ *          the asynchronous mode has been enabled.
+ */
+size_t avs_log_async_dropped(void);
+
+/**
+ * Switches avs_log back into the synchronous mode. Any messages still in the
+ * queue are passed to the log handler, and @ref avs_log_async_run (if running)
+ * returns.
+ */
+void avs_log_async_disable(void);
+#endif /* AVS_COMMONS_LOG_WITH_ASYNC */
+
 #ifndef AVS_COMMONS_WITH_MICRO_LOGS
 #    define AVS_DISPOSABLE_LOG(Arg) Arg
 #else
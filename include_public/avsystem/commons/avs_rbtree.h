@@ -50,6 +50,12 @@ extern "C" {
  */
 typedef int avs_rbtree_element_comparator_t(const void *a, const void *b);
 
+/**
+ * Slab allocator for RB-tree elements of a fixed maximum size. See
+ * @ref AVS_RBTREE_POOL_NEW for details.
+ */
+typedef struct avs_rbtree_pool_struct avs_rbtree_pool_t;
+
 /** RB-tree type alias.  */
 #define AVS_RBTREE(type) type **
 /** Constant RB-tree type alias.  */
@@ -59,6 +65,9 @@ typedef int avs_rbtree_element_comparator_t(const void *a, const void *b);
 
 /* Internal functions. Use macros defined above instead. */
 AVS_RBTREE(void) avs_rbtree_new__(avs_rbtree_element_comparator_t *cmp);
+AVS_RBTREE(void)
+avs_rbtree_new_with_pool__(avs_rbtree_element_comparator_t *cmp,
+                           avs_rbtree_pool_t *pool);
 void avs_rbtree_delete__(AVS_RBTREE(void) *tree);
 AVS_RBTREE(void) avs_rbtree_simple_clone__(AVS_RBTREE_CONST(void) tree,
                                            size_t elem_size);
@@ -74,11 +83,34 @@ AVS_RBTREE_ELEM(void) avs_rbtree_attach__(AVS_RBTREE(void) tree,
                                           AVS_RBTREE_ELEM(void) node);
 AVS_RBTREE_ELEM(void) avs_rbtree_detach__(AVS_RBTREE(void) tree,
                                           AVS_RBTREE_ELEM(void) node);
+int avs_rbtree_build_from_sorted__(AVS_RBTREE(void) tree,
+                                   AVS_RBTREE_ELEM(void) *elems,
+                                   size_t count);
+int avs_rbtree_merge__(AVS_RBTREE(void) dst, AVS_RBTREE(void) src);
+int avs_rbtree_partition__(AVS_RBTREE(void) tree,
+                           AVS_RBTREE_CONST(void) other,
+                           AVS_RBTREE(void) out,
+                           int move_common);
+int avs_rbtree_detach_range__(AVS_RBTREE(void) tree,
+                              const void *lower_value,
+                              const void *upper_value,
+                              AVS_RBTREE(void) out);
+
+#ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+AVS_RBTREE_ELEM(void) avs_rbtree_nth__(AVS_RBTREE_CONST(void) tree,
+                                       size_t index);
+size_t avs_rbtree_rank__(AVS_RBTREE_ELEM(const void) elem);
+size_t avs_rbtree_count_range__(AVS_RBTREE_CONST(void) tree,
+                                const void *lower_value,
+                                const void *upper_value);
+#endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
 
 AVS_RBTREE_ELEM(void) avs_rbtree_first__(AVS_RBTREE(void) tree);
 AVS_RBTREE_ELEM(void) avs_rbtree_last__(AVS_RBTREE(void) tree);
 
 AVS_RBTREE_ELEM(void) avs_rbtree_elem_new_buffer__(size_t elem_size);
+AVS_RBTREE_ELEM(void) avs_rbtree_pool_elem_new__(avs_rbtree_pool_t *pool,
+                                                 size_t elem_size);
 void avs_rbtree_elem_delete__(AVS_RBTREE_ELEM(void) *node);
 
 AVS_RBTREE_ELEM(void) avs_rbtree_elem_next__(AVS_RBTREE_ELEM(void) elem);
@@ -87,6 +119,11 @@ AVS_RBTREE_ELEM(void) avs_rbtree_elem_prev__(AVS_RBTREE_ELEM(void) elem);
 AVS_RBTREE_ELEM(void) avs_rbtree_cleanup_first__(AVS_RBTREE(void) tree);
 AVS_RBTREE_ELEM(void) avs_rbtree_cleanup_next__(AVS_RBTREE(void) tree);
 
+avs_rbtree_pool_t *avs_rbtree_pool_new__(size_t elem_size,
+                                         size_t elems_per_slab);
+void avs_rbtree_pool_clear__(avs_rbtree_pool_t *pool);
+void avs_rbtree_pool_delete__(avs_rbtree_pool_t **pool_ptr);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -108,6 +145,95 @@ AVS_RBTREE_ELEM(void) avs_rbtree_cleanup_next__(AVS_RBTREE(void) tree);
  */
 #define AVS_RBTREE_NEW(type, cmp) ((AVS_RBTREE(type)) avs_rbtree_new__(cmp))
 
+/**
+ * Creates an element pool, i.e. a slab allocator for RB-tree elements, each
+ * able to hold a value of given @p type.
+ *
+ * Memory for elements is allocated in slabs of @p elems_per_slab elements,
+ * which improves locality of reference and reduces the number of avs_calloc()
+ * calls. Memory of elements released back to the pool is reused for new
+ * elements, but the slabs themselves are only freed when the pool is deleted.
+ *
+ * Elements allocated from a pool (see @ref AVS_RBTREE_POOL_ELEM_NEW) may only
+ * be inserted into trees created with @ref AVS_RBTREE_NEW_WITH_POOL using the
+ * same pool. Conversely, such trees may only contain elements allocated from
+ * their pool. Otherwise, the regular API, including freeing the elements, may
+ * be used without changes.
+ *
+ * Complexity: O(m), where:
+ * - m - avs_calloc() complexity.
+ *
+ * @param type           Type of elements that will be allocated from the pool.
+ * @param elems_per_slab Number of elements to allocate memory for at once.
+ *
+ * @returns Created pool on success, NULL in case of error.
+ */
+#define AVS_RBTREE_POOL_NEW(type, elems_per_slab) \
+    avs_rbtree_pool_new__(sizeof(type), (elems_per_slab))
+
+/**
+ * Variant of @ref AVS_RBTREE_POOL_NEW for arbitrarily-sized elements, see
+ * also @ref AVS_RBTREE_ELEM_NEW_BUFFER.
+ *
+ * @param size           Maximum number of bytes of element content.
+ * @param elems_per_slab Number of elements to allocate memory for at once.
+ *
+ * @returns Created pool on success, NULL in case of error.
+ */
+#define AVS_RBTREE_POOL_NEW_BUFFER(size, elems_per_slab) \
+    avs_rbtree_pool_new__((size), (elems_per_slab))
+
+/**
+ * Releases all elements allocated from @p pool at once, without visiting them.
+ * All trees that use @p pool become empty.
+ *
+ * Slabs are retained for reuse by subsequently allocated elements.
+ *
+ * WARNING: Any pointers to elements allocated from @p pool, including detached
+ * ones, become invalid. No cleanup is performed on the values stored in the
+ * elements - if they hold any resources, use @ref AVS_RBTREE_CLEAR instead.
+ *
+ * Complexity: O(t), where:
+ * - t - number of trees using @p pool.
+ *
+ * @param pool Pool to clear.
+ */
+#define AVS_RBTREE_POOL_CLEAR(pool) avs_rbtree_pool_clear__(pool)
+
+/**
+ * Releases given pool and all memory allocated for its elements.
+ *
+ * NOTE: All trees using the pool MUST be deleted before calling this. It is
+ * not necessary to clear them first if @ref AVS_RBTREE_POOL_CLEAR is used.
+ *
+ * Complexity: O(s * f), where:
+ * - s - number of slabs allocated by the pool,
+ * - f - avs_free() complexity.
+ *
+ * @param pool_ptr Pointer to the pool to destroy. *pool_ptr is set to NULL
+ *                 after the cleanup is done.
+ */
+#define AVS_RBTREE_POOL_DELETE(pool_ptr) avs_rbtree_pool_delete__(pool_ptr)
+
+/**
+ * Create an RB-tree with elements of given @p type, allocated from @p pool.
+ *
+ * Multiple trees may use the same pool.
+ *
+ * Complexity: O(m), where:
+ * - m - avs_calloc() complexity.
+ *
+ * @param type Type of elements stored in the tree nodes.
+ * @param cmp  Pointer to a function that compares two elements.
+ *             See @ref avs_rbtree_element_comparator_t .
+ * @param pool Pool created using @ref AVS_RBTREE_POOL_NEW. It MUST outlive the
+ *             tree.
+ *
+ * @returns Created RB-tree object on success, NULL in case of error.
+ */
+#define AVS_RBTREE_NEW_WITH_POOL(type, cmp, pool) \
+    ((AVS_RBTREE(type)) avs_rbtree_new_with_pool__((cmp), (pool)))
+
 #ifdef __cplusplus
 template <typename T>
 static inline AVS_RBTREE_ELEM(T)
@@ -332,6 +458,24 @@ static inline AVS_RBTREE(T) avs_rbtree_simple_clone_impl__(AVS_RBTREE_CONST(T)
 #define AVS_RBTREE_ELEM_NEW(type) \
     ((AVS_RBTREE_ELEM(type)) AVS_RBTREE_ELEM_NEW_BUFFER(sizeof(type)))
 
+/**
+ * Creates a detached RB-tree element allocated from @p pool, large enough to
+ * hold a value of given @p type.
+ *
+ * Complexity: O(1), unless a new slab needs to be allocated, in which case:
+ * O(m), where:
+ * - m - avs_calloc() complexity.
+ *
+ * @param type Desired element type. It MUST NOT be larger than the element
+ *             size @p pool has been created for.
+ * @param pool Pool to allocate the element from.
+ *
+ * @returns Pointer to created element cast to @p type * on success,
+ *          NULL in case of error.
+ */
+#define AVS_RBTREE_POOL_ELEM_NEW(type, pool) \
+    ((AVS_RBTREE_ELEM(type)) avs_rbtree_pool_elem_new__((pool), sizeof(type)))
+
 /**
  * Frees memory associated with given detached RB-tree element.
  *
@@ -370,6 +514,156 @@ static inline AVS_RBTREE(T) avs_rbtree_simple_clone_impl__(AVS_RBTREE_CONST(T)
     (_AVS_RB_TYPECHECK(*(tree), (elem)), \
      AVS_RBTREE_CALL_WITH_ELEM_CAST__(avs_rbtree_attach__, (tree), (elem)))
 
+/**
+ * Inserts @p count detached elements, sorted in strictly ascending order (wrt.
+ * @ref avs_rbtree_element_comparator_t of @p tree), into an empty @p tree.
+ *
+ * The tree is built directly in its final, balanced shape, without performing
+ * any searches or rebalancing. This is significantly faster than inserting the
+ * elements one by one using @ref AVS_RBTREE_INSERT, e.g. when restoring
+ * a previously serialized tree.
+ *
+ * NOTE: when any of the passed elements is attached to some tree, the behavior
+ * is undefined.
+ *
+ * Complexity: O(n * c), where:
+ * - n - @p count,
+ * - c - complexity of tree element comparator.
+ *
+ * The comparator is only called n - 1 times, to verify that the elements are
+ * actually sorted.
+ *
+ * @param tree  Empty tree to insert elements into.
+ * @param elems Array of pointers to detached elements to insert.
+ * @param count Number of elements in the @p elems array.
+ *
+ * @returns 0 on success, or a negative value if @p tree is not empty or
+ *          @p elems are not sorted in strictly ascending order. In case of
+ *          error, @p tree is not modified and all @p elems remain detached.
+ */
+#define AVS_RBTREE_BUILD_FROM_SORTED(tree, elems, count)               \
+    (_AVS_RB_TYPECHECK(*(tree), *(elems)),                             \
+     avs_rbtree_build_from_sorted__((AVS_RBTREE(void)) (tree),         \
+                                    (AVS_RBTREE_ELEM(void) *) (elems), \
+                                    (count)))
+
+/**
+ * Moves all elements of @p src that do not have an equivalent element in
+ * @p dst into @p dst, i.e. replaces @p dst with the union of both trees.
+ *
+ * Elements of @p src that compare equal to some element of @p dst are left in
+ * @p src. Both trees MUST use equivalent comparators and, if created with
+ * @ref AVS_RBTREE_NEW_WITH_POOL, the same element pool.
+ *
+ * Both trees are traversed in order once and rebuilt afterwards, which is
+ * faster than moving elements one by one unless @p src is much smaller than
+ * @p dst.
+ *
+ * Complexity: O((n + m) * c + a), where:
+ * - n - number of nodes in @p dst,
+ * - m - number of nodes in @p src,
+ * - c - complexity of tree element comparator,
+ * - a - avs_calloc() complexity.
+ *
+ * @param dst Tree to move elements into.
+ * @param src Tree to move elements from.
+ *
+ * @returns 0 on success, or a negative value in case of memory allocation
+ *          error, in which case neither tree is modified.
+ */
+#define AVS_RBTREE_MERGE(dst, src)      \
+    (_AVS_RB_TYPECHECK(*(dst), *(src)), \
+     avs_rbtree_merge__((AVS_RBTREE(void)) (dst), (AVS_RBTREE(void)) (src)))
+
+/**
+ * Replaces @p tree with the intersection of @p tree and @p other, by moving
+ * all elements of @p tree that do not have an equivalent element in @p other
+ * into @p removed.
+ *
+ * @p other is not modified. All trees MUST use equivalent comparators, and
+ * @p tree and @p removed MUST use the same element pool, if any.
+ *
+ * Complexity: O((n + m) * c + a), where:
+ * - n - number of nodes in @p tree,
+ * - m - number of nodes in @p other,
+ * - c - complexity of tree element comparator,
+ * - a - avs_calloc() complexity.
+ *
+ * @param tree    Tree to modify.
+ * @param other   Tree to intersect @p tree with.
+ * @param removed Empty tree that will receive the removed elements.
+ *
+ * @returns 0 on success, or a negative value if @p removed is not empty or in
+ *          case of memory allocation error, in which case no tree is modified.
+ */
+#define AVS_RBTREE_INTERSECTION(tree, other, removed)         \
+    (_AVS_RB_TYPECHECK(*(tree), *(other)),                    \
+     _AVS_RB_TYPECHECK(*(tree), *(removed)),                  \
+     avs_rbtree_partition__((AVS_RBTREE(void)) (tree),        \
+                            (AVS_RBTREE_CONST(void)) (other), \
+                            (AVS_RBTREE(void)) (removed), 0))
+
+/**
+ * Replaces @p tree with the difference of @p tree and @p other, by moving
+ * all elements of @p tree that have an equivalent element in @p other into
+ * @p removed.
+ *
+ * @p other is not modified. All trees MUST use equivalent comparators, and
+ * @p tree and @p removed MUST use the same element pool, if any.
+ *
+ * Complexity: O((n + m) * c + a), where:
+ * - n - number of nodes in @p tree,
+ * - m - number of nodes in @p other,
+ * - c - complexity of tree element comparator,
+ * - a - avs_calloc() complexity.
+ *
+ * @param tree    Tree to modify.
+ * @param other   Tree containing elements to remove from @p tree.
+ * @param removed Empty tree that will receive the removed elements.
+ *
+ * @returns 0 on success, or a negative value if @p removed is not empty or in
+ *          case of memory allocation error, in which case no tree is modified.
+ */
+#define AVS_RBTREE_DIFFERENCE(tree, other, removed)           \
+    (_AVS_RB_TYPECHECK(*(tree), *(other)),                    \
+     _AVS_RB_TYPECHECK(*(tree), *(removed)),                  \
+     avs_rbtree_partition__((AVS_RBTREE(void)) (tree),        \
+                            (AVS_RBTREE_CONST(void)) (other), \
+                            (AVS_RBTREE(void)) (removed), 1))
+
+/**
+ * Moves all elements of @p tree that are not less than @p lower_value and not
+ * greater than @p upper_value (i.e. ones from
+ * <c>AVS_RBTREE_LOWER_BOUND(tree, lower_value)</c> up to, but not including,
+ * <c>AVS_RBTREE_UPPER_BOUND(tree, upper_value)</c>) into @p out.
+ *
+ * @p tree and @p out MUST use equivalent comparators and the same element pool,
+ * if any.
+ *
+ * Complexity: O(k * log n * c) if the range covers at most half of @p tree,
+ * O(n + log n * c + a) otherwise, where:
+ * - n - number of nodes in @p tree,
+ * - k - number of nodes in the range,
+ * - c - complexity of tree element comparator,
+ * - a - avs_calloc() complexity.
+ *
+ * @param tree        Tree to detach elements from.
+ * @param lower_value Lowest value of the range to detach, inclusive.
+ * @param upper_value Highest value of the range to detach, inclusive.
+ * @param out         Empty tree that will receive the detached elements.
+ *
+ * @returns 0 on success, or a negative value if @p out is not empty or in case
+ *          of memory allocation error, in which case no tree is modified.
+ *          Memory is only allocated if the range covers more than half of
+ *          @p tree.
+ */
+#define AVS_RBTREE_DETACH_RANGE(tree, lower_value, upper_value, out)     \
+    (_AVS_RB_TYPECHECK(*(tree), *(out)),                                 \
+     _AVS_RB_TYPECHECK(*(tree), (lower_value)),                          \
+     _AVS_RB_TYPECHECK(*(tree), (upper_value)),                          \
+     avs_rbtree_detach_range__((AVS_RBTREE(void)) (tree), (lower_value), \
+                               (upper_value), (AVS_RBTREE(void)) (out)))
+
 /**
  * Detaches given @p elem from @p tree. Does not free @p elem.
  *
@@ -454,6 +748,73 @@ static inline AVS_RBTREE(T) avs_rbtree_simple_clone_impl__(AVS_RBTREE_CONST(T)
      AVS_RBTREE_CALL_WITH_CONST_ELEM_CAST__(  \
              avs_rbtree_upper_bound__, (tree), (val_ptr)))
 
+#ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+/**
+ * Finds the element at a given position in @p tree, i.e. one that has exactly
+ * @p index elements before it (in order defined by
+ * @ref avs_rbtree_element_comparator_t of @p tree).
+ *
+ * NOTE: This macro is only available if avs_commons is compiled with
+ * <c>AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS</c>.
+ *
+ * Complexity: O(log n), where:
+ * - n - number of nodes in @p tree.
+ *
+ * @param tree  Tree to search in.
+ * @param index Zero-based position of the element to find.
+ *
+ * @returns Attached element pointer on success, NULL if @p index is not less
+ *          than the number of elements in @p tree.
+ */
+#    define AVS_RBTREE_NTH(tree, index)        \
+        AVS_RBTREE_CALL_WITH_CONST_ELEM_CAST__( \
+                avs_rbtree_nth__, (tree), (index))
+
+/**
+ * Returns the position of an attached @p elem in the tree it is attached to,
+ * i.e. the number of elements before it (in order defined by
+ * @ref avs_rbtree_element_comparator_t of the tree).
+ *
+ * NOTE: when passed @p elem is detached, the behavior is undefined.
+ *
+ * NOTE: This macro is only available if avs_commons is compiled with
+ * <c>AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS</c>.
+ *
+ * Complexity: O(log n), where:
+ * - n - number of nodes in the tree @p elem is attached to.
+ *
+ * @param elem Element to get the position of.
+ *
+ * @returns Zero-based position of @p elem, such that
+ *          <c>AVS_RBTREE_NTH(tree, AVS_RBTREE_RANK(elem)) == elem</c>.
+ */
+#    define AVS_RBTREE_RANK(elem) avs_rbtree_rank__(elem)
+
+/**
+ * Counts elements in @p tree that are not less than @p lower_value and not
+ * greater than @p upper_value.
+ *
+ * NOTE: This macro is only available if avs_commons is compiled with
+ * <c>AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS</c>.
+ *
+ * Complexity: O((log n) * c), where:
+ * - n - number of nodes in @p tree,
+ * - c - complexity of tree element comparator.
+ *
+ * @param tree        Tree to search in.
+ * @param lower_value Lowest value of the range, inclusive.
+ * @param upper_value Highest value of the range, inclusive.
+ *
+ * @returns Number of elements in the range, or 0 if @p lower_value is greater
+ *          than @p upper_value.
+ */
+#    define AVS_RBTREE_COUNT_RANGE(tree, lower_value, upper_value) \
+        (_AVS_RB_TYPECHECK(*(tree), (lower_value)),                \
+         _AVS_RB_TYPECHECK(*(tree), (upper_value)),                \
+         avs_rbtree_count_range__((AVS_RBTREE_CONST(void)) (tree), \
+                                  (lower_value), (upper_value)))
+#endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+
 /**
  * Finds an element with value given by @p val_ptr in @p tree.
  *
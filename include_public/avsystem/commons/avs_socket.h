@@ -38,6 +38,12 @@
 #    include <avsystem/commons/avs_prng.h>
 #endif // AVS_COMMONS_WITH_AVS_CRYPTO
 
+#if defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) \
+        && defined(AVS_COMMONS_WITH_AVS_PERSISTENCE)
+#    include <avsystem/commons/avs_persistence.h>
+#endif // defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) &&
+       // defined(AVS_COMMONS_WITH_AVS_PERSISTENCE)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -48,6 +54,9 @@ extern "C" {
 /* 30 sec timeout */
 extern const avs_time_duration_t AVS_NET_SOCKET_DEFAULT_RECV_TIMEOUT;
 
+/* 60 sec */
+extern const avs_time_duration_t AVS_NET_SOCKET_DEFAULT_RESOLVE_CACHE_TTL;
+
 typedef struct {
     uint8_t size;
     union {
@@ -199,6 +208,27 @@ typedef struct {
      * <c>AVS_NET_UNSPEC</c>.
      */
     avs_net_af_t preferred_family;
+
+    /**
+     * Maximum number of entries in the per-socket cache of addresses used by
+     * @ref avs_net_socket_send_to . Each entry maps a host and port pair to the
+     * endpoint that the last datagram has been successfully sent to, so that
+     * subsequent calls for the same destination do not perform domain name
+     * resolution. If the cache is full, the least recently used entry is
+     * evicted. The cache is flushed whenever the socket is closed.
+     *
+     * The default value of 0 disables the cache. Note that hosts specified as
+     * numeric IPv4 or IPv6 address literals are converted directly, without
+     * calling the resolver, regardless of this setting.
+     */
+    size_t resolve_cache_size;
+
+    /**
+     * Time after which entries in the cache described above expire, so that
+     * the host name is resolved again. If not set to a positive duration,
+     * @ref AVS_NET_SOCKET_DEFAULT_RESOLVE_CACHE_TTL is used.
+     */
+    avs_time_duration_t resolve_cache_ttl;
 } avs_net_socket_configuration_t;
 
 #ifdef AVS_COMMONS_WITH_AVS_CRYPTO
@@ -383,6 +413,23 @@ static inline uint8_t avs_net_ssl_alert_description(avs_error_t error) {
 }
 
 #ifdef AVS_COMMONS_WITH_AVS_CRYPTO
+/**
+ * (D)TLS configuration that may be shared between multiple SSL or DTLS
+ * sockets, so that certificates, CRLs and keys are loaded only once.
+ *
+ * The object is reference-counted and thread-safe with regard to acquiring and
+ * releasing references. See @ref avs_net_tls_context_create for details.
+ */
+typedef struct avs_net_tls_context_struct avs_net_tls_context_t;
+
+/**
+ * Server-side store of (D)TLS sessions and session ticket keys, allowing
+ * clients to resume their sessions when connecting to an accepted socket. See
+ * @ref avs_net_tls_server_session_cache_create for details.
+ */
+typedef struct avs_net_tls_server_session_cache_struct
+        avs_net_tls_server_session_cache_t;
+
 typedef struct {
     /** Array of ciphersuite IDs, or NULL to enable all ciphers */
     uint32_t *ids;
@@ -493,6 +540,37 @@ typedef struct {
      * @c NULL .
      */
     avs_crypto_prng_ctx_t *prng_ctx;
+
+    /**
+     * Shared (D)TLS context to use, created with
+     * @ref avs_net_tls_context_create , or NULL to create a private one for
+     * the socket.
+     *
+     * If non-NULL, the socket holds a reference to the context, so the caller
+     * may release its own reference at any time. The <c>version</c>,
+     * <c>security</c>, <c>ciphersuites</c>,
+     * <c>additional_configuration_clb</c>, <c>use_connection_id</c> and
+     * <c>prng_ctx</c> fields are then ignored, as the values stored in the
+     * context are used instead. All other fields are still applied per socket.
+     */
+    avs_net_tls_context_t *tls_context;
+
+    /**
+     * Server-side session cache to use for handshakes performed on accepted
+     * sockets, created with @ref avs_net_tls_server_session_cache_create , or
+     * NULL to disable server-side session resumption. It MUST outlive the
+     * created socket, or the shared context if one is created from this
+     * configuration.
+     *
+     * This is a context-level setting: it is ignored if <c>tls_context</c> is
+     * non-NULL, and the value passed to @ref avs_net_tls_context_create is used
+     * instead. Note that the session cache is only useful if the same cache is
+     * used for multiple accepted sockets, either directly or through a shared
+     * context.
+     *
+     * Not supported by the TinyDTLS backend, where it is ignored.
+     */
+    avs_net_tls_server_session_cache_t *server_session_cache;
 } avs_net_ssl_configuration_t;
 #endif // AVS_COMMONS_WITH_AVS_CRYPTO
 
@@ -634,6 +712,38 @@ typedef enum {
      * connected, it will <strong>not</strong> be reconnected automatically.
      */
     AVS_NET_SOCKET_OPT_FORCED_ADDR_FAMILY,
+
+    /**
+     * Used to enable or disable UDP Generic Segmentation Offload for
+     * @ref avs_net_socket_send_to_many . The value is passed in the
+     * <c>flag</c> field of the @ref avs_net_socket_opt_value_t union.
+     *
+     * When enabled, runs of consecutive datagrams with the same destination
+     * and the same length (except for the last one, which may be shorter) are
+     * passed to the kernel as a single buffer, together with the segment size
+     * (<c>UDP_SEGMENT</c>). If the kernel rejects such a request, the
+     * datagrams are sent separately. The option is disabled by default.
+     *
+     * Attempting to enable this option on a socket or platform that does not
+     * support it will yield <c>avs_errno(AVS_ENOTSUP)</c>.
+     */
+    AVS_NET_SOCKET_OPT_UDP_SEGMENTATION,
+
+    /**
+     * Used to get the maximum number of bytes that the DTLS layer adds to the
+     * plaintext of a single record with the currently negotiated cipher suite,
+     * i.e. the record header, explicit IV or nonce, MAC or authentication tag
+     * and worst-case padding. The value is read-only and passed as bytes in the
+     * <c>mtu</c> field of the @ref avs_net_socket_opt_value_t union.
+     *
+     * A buffer for receiving a datagram that carries up to N bytes of
+     * application data needs to be at least N plus this value bytes long.
+     *
+     * Attempting to get this option on a socket that is not a DTLS socket will
+     * yield <c>avs_errno(AVS_ENOTSUP)</c>, and on a DTLS socket that has not
+     * been connected or accepted - <c>avs_errno(AVS_EBADF)</c>.
+     */
+    AVS_NET_SOCKET_OPT_DTLS_RECORD_OVERHEAD,
 } avs_net_socket_opt_key_t;
 
 typedef enum {
@@ -783,6 +893,271 @@ avs_net_ssl_socket_create(avs_net_socket_t **socket,
 #endif // AVS_COMMONS_WITH_AVS_CRYPTO
 /**@}*/
 
+#ifdef AVS_COMMONS_WITH_AVS_CRYPTO
+/**
+ * Creates a (D)TLS context that can be shared between multiple sockets by
+ * setting the <c>tls_context</c> field of @ref avs_net_ssl_configuration_t .
+ *
+ * The context is created from the <c>version</c>, <c>security</c>,
+ * <c>ciphersuites</c>, <c>additional_configuration_clb</c>,
+ * <c>use_connection_id</c> and <c>prng_ctx</c> fields of @p config ; all other
+ * fields are ignored. Certificates, CRLs and keys are loaded once, during this
+ * call, so the data they refer to is not required to outlive it. The
+ * <c>prng_ctx</c>, however, MUST outlive the context and all sockets that use
+ * it.
+ *
+ * @param[out] out_context Pointer to a variable that will be set to the newly
+ *                         created context. The caller holds a single reference
+ *                         to it, which shall be released using
+ *                         @ref avs_net_tls_context_cleanup .
+ * @param[in]  socket_type Type of sockets that will use the context - either
+ *                         @ref AVS_NET_SSL_SOCKET or
+ *                         @ref AVS_NET_DTLS_SOCKET . Using the context with a
+ *                         socket of a different type will fail.
+ * @param[in]  config      Configuration to create the context from.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>avs_errno(AVS_ENOTSUP)</c> is returned if the
+ *          (D)TLS backend does not support shared contexts.
+ */
+avs_error_t
+avs_net_tls_context_create(avs_net_tls_context_t **out_context,
+                           avs_net_socket_type_t socket_type,
+                           const avs_net_ssl_configuration_t *config);
+
+/**
+ * Releases a reference to a (D)TLS context and sets <c>*context</c> to NULL.
+ * The context is freed when the last socket using it is cleaned up.
+ *
+ * @param[inout] context Pointer to a variable holding the context to release.
+ *                       Does nothing if it is NULL or points to NULL.
+ */
+void avs_net_tls_context_cleanup(avs_net_tls_context_t **context);
+
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE
+typedef struct {
+    /**
+     * Maximum number of sessions stored for resumption based on session IDs.
+     * When exceeded, the least recently used sessions are dropped. Zero
+     * disables session ID based resumption.
+     */
+    size_t max_sessions;
+
+    /**
+     * Time after which a stored session or an issued session ticket is no
+     * longer accepted for resumption. MUST be a valid, positive duration.
+     */
+    avs_time_duration_t session_lifetime;
+
+    /**
+     * Enables issuing and accepting RFC 5077 session tickets, i.e. session
+     * state encrypted by the server and stored by the client, which does not
+     * occupy any space in the cache.
+     *
+     * For TLS 1.3, tickets are the only resumption mechanism. If they are
+     * disabled, the backend may still issue tickets that only refer to
+     * sessions stored in the cache by ID, if <c>max_sessions</c> is non-zero.
+     */
+    bool use_session_tickets;
+
+    /**
+     * Interval after which a new session ticket encryption key is generated.
+     * Tickets encrypted with the previous key are still accepted (and renewed
+     * if the backend supports it) until the next rotation. If not a valid
+     * positive duration, <c>session_lifetime</c> is used.
+     */
+    avs_time_duration_t ticket_key_rotation_interval;
+
+    /**
+     * PRNG context used to generate session ticket keys. It MUST outlive the
+     * cache. Required only if <c>use_session_tickets</c> is true.
+     */
+    avs_crypto_prng_ctx_t *prng_ctx;
+} avs_net_tls_server_session_cache_config_t;
+
+/**
+ * Creates an in-memory, thread-safe server-side (D)TLS session cache, which
+ * can be attached to accepted sockets through the
+ * <c>server_session_cache</c> field of @ref avs_net_ssl_configuration_t .
+ *
+ * @param[out] out_cache Pointer to a variable that will be set to the newly
+ *                       created cache. It shall be freed using
+ *                       @ref avs_net_tls_server_session_cache_cleanup after
+ *                       all the sockets and contexts that use it are cleaned
+ *                       up.
+ * @param[in]  config    Cache configuration.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>avs_errno(AVS_EINVAL)</c> is returned if the
+ *          configuration is invalid, or if it enables neither session ID based
+ *          resumption, nor session tickets.
+ */
+avs_error_t avs_net_tls_server_session_cache_create(
+        avs_net_tls_server_session_cache_t **out_cache,
+        const avs_net_tls_server_session_cache_config_t *config);
+
+/**
+ * Frees a server-side session cache, including all the stored sessions, and
+ * sets <c>*cache</c> to NULL.
+ *
+ * @param[inout] cache Pointer to a variable holding the cache to free. Does
+ *                     nothing if it is NULL or points to NULL.
+ */
+void avs_net_tls_server_session_cache_cleanup(
+        avs_net_tls_server_session_cache_t **cache);
+
+/**
+ * Immediately generates a new session ticket encryption key. Tickets encrypted
+ * with the current key will still be accepted until the next rotation; older
+ * tickets are invalidated.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>avs_errno(AVS_EINVAL)</c> is returned if
+ *          session tickets are not enabled for @p cache .
+ */
+avs_error_t avs_net_tls_server_session_cache_rotate_ticket_keys(
+        avs_net_tls_server_session_cache_t *cache);
+
+#        ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+/**
+ * Persists or restores (depending on @p ctx ) the contents of a server-side
+ * session cache: sessions that have not yet expired, and session ticket keys.
+ *
+ * When restoring, all sessions currently stored in the cache are dropped
+ * first. If the cache has been created without session ticket support, the
+ * keys are read but discarded. Sessions exceeding <c>max_sessions</c> are
+ * dropped as usual.
+ *
+ * <strong>WARNING:</strong> The persisted data contains the session master
+ * secrets and ticket encryption keys in plain text, so it needs to be stored
+ * securely.
+ *
+ * The format of session data is backend-specific, so data persisted using one
+ * (D)TLS backend is unlikely to be usable with another.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t avs_net_tls_server_session_cache_persistence(
+        avs_net_tls_server_session_cache_t *cache,
+        avs_persistence_context_t *ctx);
+#        endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
+#    endif     // AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE
+
+#    ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+/**
+ * Maximum supported value of
+ * @ref avs_net_dtls_listener_configuration_t::connection_id_length .
+ */
+#        define AVS_NET_DTLS_LISTENER_MAX_CONNECTION_ID_LENGTH 32
+
+typedef struct {
+    /**
+     * Configuration of the underlying UDP socket.
+     */
+    avs_net_socket_configuration_t backend_configuration;
+
+    /**
+     * Maximum number of peers served at the same time. ClientHello messages
+     * from new peers are ignored when it is reached. MUST be non-zero.
+     */
+    size_t max_peers;
+
+    /**
+     * Maximum number of datagrams buffered for each peer until they are read
+     * by the socket serving it, and maximum number of verified ClientHello
+     * messages from new peers waiting for @ref avs_net_socket_accept . Further
+     * datagrams are dropped. MUST be non-zero.
+     */
+    size_t max_queued_datagrams;
+
+    /**
+     * Size of the largest datagram that can be received; longer datagrams are
+     * dropped. MUST be non-zero.
+     *
+     * Whenever a peer socket is read into a buffer at least this large while
+     * none of its datagrams are buffered, the datagram is received straight
+     * into that buffer. The (D)TLS backends always read into buffers sized for
+     * the largest possible record, so records then reach the (D)TLS layer
+     * without any intermediate copies.
+     */
+    size_t max_datagram_size;
+
+    /**
+     * Length of DTLS Connection IDs (RFC 9146) assigned to accepted peers, or
+     * zero to identify peers by address only. Records carrying a known
+     * Connection ID are routed to their peer even if its address has changed
+     * (e.g. due to NAT rebinding); replies are sent to the new address once
+     * such a record has been authenticated.
+     *
+     * Connection IDs are only used if supported by the (D)TLS backend, which is
+     * currently the case only for mbed TLS. MUST NOT be larger than
+     * @ref AVS_NET_DTLS_LISTENER_MAX_CONNECTION_ID_LENGTH .
+     */
+    size_t connection_id_length;
+
+    /**
+     * Time for which a cookie sent in a HelloVerifyRequest is accepted. MUST be
+     * a valid, positive duration.
+     */
+    avs_time_duration_t cookie_lifetime;
+
+    /**
+     * PRNG context used to generate the cookie secret and Connection IDs. It
+     * MUST outlive the listener. MUST NOT be NULL.
+     */
+    avs_crypto_prng_ctx_t *prng_ctx;
+} avs_net_dtls_listener_configuration_t;
+
+/**
+ * Creates a DTLS listener socket, which serves multiple DTLS clients using a
+ * single, unconnected UDP socket.
+ *
+ * After binding it with @ref avs_net_socket_bind , new peers are accepted by
+ * calling @ref avs_net_socket_accept with a newly created DTLS socket (see
+ * @ref avs_net_dtls_socket_create ; using a shared context created with
+ * @ref avs_net_tls_context_create is recommended) as the client socket. Each
+ * accepted socket communicates with a single peer, and performs the server
+ * side of the DTLS handshake during the accept call.
+ *
+ * Received datagrams are routed to accepted sockets by the source address (or
+ * the Connection ID, if enabled), and buffered until read. Datagrams from
+ * unknown addresses are only considered if they contain a ClientHello message.
+ * Every ClientHello without a valid cookie is answered with a stateless
+ * HelloVerifyRequest (RFC 6347, section 4.2.1); only after the client proves
+ * that it can receive datagrams at its source address, it is queued for
+ * acceptance and any memory is allocated for it.
+ *
+ * All sockets share the system socket of the listener, which is also returned
+ * by @ref avs_net_socket_get_system for each of them. Whichever socket is read
+ * from, all datagrams waiting in the system socket are received and routed to
+ * the appropriate queues, so that a single event loop can serve all the peers:
+ * when the system socket becomes readable, call @ref avs_net_socket_accept
+ * with a zero receive timeout set on the listener (an error is returned if
+ * there is no new peer), then read from the accepted sockets for which
+ * @ref AVS_NET_SOCKET_HAS_BUFFERED_DATA is true.
+ *
+ * The listener and all the sockets accepted from it MUST be used from a single
+ * thread. Accepted sockets MAY outlive the listener, but they can no longer
+ * communicate after it is closed or cleaned up.
+ *
+ * Listener sockets are not supported with the TinyDTLS backend.
+ *
+ * @param[out] socket Pointer to a variable that will be set to the newly
+ *                    created socket.
+ * @param[in]  config Listener configuration.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>avs_errno(AVS_EINVAL)</c> is returned if the
+ *          configuration is invalid, and <c>avs_errno(AVS_ENOTSUP)</c> if the
+ *          (D)TLS backend does not support listener sockets.
+ */
+avs_error_t avs_net_dtls_listener_socket_create(
+        avs_net_socket_t **socket,
+        const avs_net_dtls_listener_configuration_t *config);
+#    endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+#endif     // AVS_COMMONS_WITH_AVS_CRYPTO
+
 /**
  * Shuts down @p socket , cleans up any allocated resources and sets
  * <c>*socket</c> to NULL. When called on a socket decorator, also cleans up all
@@ -889,6 +1264,29 @@ avs_error_t avs_net_socket_send(avs_net_socket_t *socket,
                                 const void *buffer,
                                 size_t buffer_length);
 
+/**
+ * Sends the concatenation of @p iov_count data blocks described by @p iov to
+ * @p socket, as if it was a single buffer passed to @ref avs_net_socket_send.
+ * In particular, for UDP sockets all the blocks form a single datagram.
+ *
+ * Implementations are expected to pass all the blocks to the operating system
+ * at once (e.g. using <c>sendmsg()</c>), so that no copying into an
+ * intermediate buffer, nor multiple system calls are necessary.
+ *
+ * @param socket    Socket object to send data to.
+ * @param iov       Array of data blocks to send.
+ * @param iov_count Number of elements in @p iov .
+ *
+ * @returns @li @ref AVS_OK if all the data was written,
+ *          @li <c>avs_errno(AVS_ENOTSUP)</c> if the socket does not support
+ *              vectored sending, or cannot send that many blocks as a single
+ *              datagram - @ref avs_net_socket_send shall be used instead,
+ *          @li an error condition for which the operation failed.
+ */
+avs_error_t avs_net_socket_sendv(avs_net_socket_t *socket,
+                                 const avs_iovec_t *iov,
+                                 size_t iov_count);
+
 /**
  * Sends exactly @p buffer_length bytes from @p buffer to @p host / @p port,
  * using @p socket.
@@ -915,6 +1313,56 @@ avs_error_t avs_net_socket_send_to(avs_net_socket_t *socket,
                                    size_t buffer_length,
                                    const char *host,
                                    const char *port);
+
+/**
+ * Single datagram to send using @ref avs_net_socket_send_to_many .
+ */
+typedef struct {
+    /** Payload of the datagram. */
+    const void *buffer;
+    /** Number of bytes in @ref buffer . */
+    size_t buffer_length;
+    /**
+     * Address to send the datagram to, e.g. one previously received in
+     * @ref avs_net_incoming_datagram_t::out_source or obtained with
+     * @ref avs_net_addrinfo_next . If NULL, the datagram is sent to the peer
+     * the socket is connected to.
+     */
+    const avs_net_resolved_endpoint_t *destination;
+} avs_net_outgoing_datagram_t;
+
+/**
+ * Sends multiple UDP datagrams, possibly to different destinations, using
+ * @p socket .
+ *
+ * Implementations are expected to pass as many datagrams as possible to the
+ * operating system in a single system call (e.g. <c>sendmmsg()</c>). If the
+ * @ref AVS_NET_SOCKET_OPT_UDP_SEGMENTATION option is enabled, consecutive
+ * datagrams with the same destination may additionally be passed to the
+ * network stack as a single buffer, segmented only by the kernel or the
+ * network card.
+ *
+ * The datagrams are sent in order; if sending any of them fails, the function
+ * returns immediately, without attempting to send the remaining ones.
+ *
+ * @param[in]  socket         Socket object to send data to.
+ * @param[in]  datagrams      Array of datagrams to send.
+ * @param[in]  datagram_count Number of elements in @p datagrams .
+ * @param[out] out_sent_count Number of initial elements of @p datagrams that
+ *                            have been successfully sent. May be NULL.
+ *
+ * @returns @li @ref AVS_OK if all datagrams have been sent,
+ *          @li <c>avs_errno(AVS_ENOTSUP)</c> if the socket does not support
+ *              batched sending - @ref avs_net_socket_send_to shall be used
+ *              instead,
+ *          @li an error condition for which the operation failed.
+ */
+avs_error_t
+avs_net_socket_send_to_many(avs_net_socket_t *socket,
+                            const avs_net_outgoing_datagram_t *datagrams,
+                            size_t datagram_count,
+                            size_t *out_sent_count);
+
 /**
  * Receives up to @p buffer_length bytes of data from @p socket into @p buffer .
  *
@@ -983,6 +1431,65 @@ avs_error_t avs_net_socket_receive_from(avs_net_socket_t *socket,
                                         char *port,
                                         size_t port_size);
 
+/**
+ * Slot for a single datagram received using
+ * @ref avs_net_socket_receive_from_many .
+ */
+typedef struct {
+    /** Buffer to write the datagram to; set by the caller. */
+    void *buffer;
+    /** Number of bytes available in @ref buffer ; set by the caller. */
+    size_t buffer_length;
+    /** Number of bytes written to @ref buffer . */
+    size_t out_size;
+    /**
+     * Set to true if the datagram was longer than @ref buffer_length and has
+     * been truncated. The actual length of such datagram is lost.
+     */
+    bool out_truncated;
+    /**
+     * Address of the sender. It may be passed to
+     * @ref avs_net_resolved_endpoint_get_host_port to convert it into text.
+     */
+    avs_net_resolved_endpoint_t out_source;
+} avs_net_incoming_datagram_t;
+
+/**
+ * Receives multiple UDP datagrams from @p socket at once.
+ *
+ * The function waits (for no longer than the receive timeout configured for
+ * the socket) until at least one datagram is available, and then receives as
+ * many datagrams as are already queued, up to @p datagram_count , without any
+ * further waiting. Each datagram is received into a separate slot from the
+ * @p datagrams array, in the order of arrival.
+ *
+ * Implementations are expected to receive all the datagrams using as few
+ * system calls as possible (e.g. <c>recvmmsg()</c>), which considerably
+ * reduces overhead of servers that handle many small datagrams.
+ *
+ * Unlike @ref avs_net_socket_receive_from , truncation of a datagram is not
+ * treated as an error, but reported in the
+ * @ref avs_net_incoming_datagram_t::out_truncated field.
+ *
+ * @param[in]    socket             Socket object to read data from.
+ * @param[inout] datagrams          Array of slots to receive datagrams into.
+ * @param[in]    datagram_count     Number of elements in @p datagrams ; must
+ *                                  be nonzero.
+ * @param[out]   out_received_count Number of initial elements of
+ *                                  @p datagrams that have been filled.
+ *
+ * @returns @li @ref AVS_OK if at least one datagram has been received,
+ *          @li <c>avs_errno(AVS_ENOTSUP)</c> if the socket does not support
+ *              batched receiving - @ref avs_net_socket_receive_from shall be
+ *              used instead,
+ *          @li an error condition for which the operation failed.
+ */
+avs_error_t
+avs_net_socket_receive_from_many(avs_net_socket_t *socket,
+                                 avs_net_incoming_datagram_t *datagrams,
+                                 size_t datagram_count,
+                                 size_t *out_received_count);
+
 /**
  * Binds @p socket to specified local @p address and @p port .
  *
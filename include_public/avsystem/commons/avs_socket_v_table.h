@@ -32,6 +32,9 @@ typedef avs_error_t (*avs_net_socket_decorate_t)(
 typedef avs_error_t (*avs_net_socket_send_t)(avs_net_socket_t *socket,
                                              const void *buffer,
                                              size_t buffer_length);
+typedef avs_error_t (*avs_net_socket_sendv_t)(avs_net_socket_t *socket,
+                                              const avs_iovec_t *iov,
+                                              size_t iov_count);
 typedef avs_error_t (*avs_net_socket_send_to_t)(avs_net_socket_t *socket,
                                                 const void *buffer,
                                                 size_t buffer_length,
@@ -49,6 +52,16 @@ typedef avs_error_t (*avs_net_socket_receive_from_t)(avs_net_socket_t *socket,
                                                      size_t host_size,
                                                      char *port,
                                                      size_t port_size);
+typedef avs_error_t (*avs_net_socket_receive_from_many_t)(
+        avs_net_socket_t *socket,
+        avs_net_incoming_datagram_t *datagrams,
+        size_t datagram_count,
+        size_t *out_received_count);
+typedef avs_error_t (*avs_net_socket_send_to_many_t)(
+        avs_net_socket_t *socket,
+        const avs_net_outgoing_datagram_t *datagrams,
+        size_t datagram_count,
+        size_t *out_sent_count);
 typedef avs_error_t (*avs_net_socket_bind_t)(avs_net_socket_t *socket,
                                              const char *address,
                                              const char *port);
@@ -111,6 +124,9 @@ typedef struct {
     avs_net_socket_get_local_port_t get_local_port;
     avs_net_socket_get_opt_t get_opt;
     avs_net_socket_set_opt_t set_opt;
+    avs_net_socket_sendv_t sendv;
+    avs_net_socket_receive_from_many_t receive_from_many;
+    avs_net_socket_send_to_many_t send_to_many;
 } avs_net_socket_v_table_t;
 
 #ifdef __cplusplus
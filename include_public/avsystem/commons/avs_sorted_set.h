@@ -118,6 +118,11 @@ AVS_SORTED_SET_ELEM(void)
 avs_sorted_set_insert__(AVS_SORTED_SET(void) sorted_set, void *insert_ptr);
 AVS_SORTED_SET_ELEM(void) avs_sorted_set_find__(AVS_SORTED_SET(void) sorted_set,
                                                 const void *element);
+AVS_SORTED_SET_ELEM(void)
+avs_sorted_set_detach__(AVS_SORTED_SET(void) sorted_set, void *elem);
+
+size_t avs_sorted_set_size__(AVS_SORTED_SET_CONST(void) sorted_set);
+void avs_sorted_set_clear_index__(AVS_SORTED_SET(void) sorted_set);
 #    ifdef __cplusplus
 } /* extern "C" */
 #    endif
@@ -160,18 +165,25 @@ static inline AVS_SORTED_SET_ELEM(T) AVS_SORTED_SET_CALL_WITH_CONST_ELEM_CAST__(
                     (AVS_SORTED_SET_CONST(void)) __VA_ARGS__))
 #    endif // __cplusplus
 
+/*
+ * NOTE: In this implementation, the sorted set is a regular AVS_LIST,
+ * accompanied by a sorted array of pointers to its elements, which is used to
+ * perform lookups using binary search. The list MUST NOT be modified directly
+ * with AVS_LIST_* macros - use the AVS_SORTED_SET_* macros instead, or the
+ * lookup index will become inconsistent.
+ */
+
 /**
- * Return the number of element in the @p sorted_set. Wrapper around
- * AVS_LIST_SIZE.
+ * Return the number of element in the @p sorted_set.
  *
- * Complexity: O(n), where:
- * - n - number of elements in set.
+ * Complexity: O(1).
  *
  * @param sorted_set   Object to operate on.
  *
  * @return Total number of elements stored in the set.
  */
-#    define AVS_SORTED_SET_SIZE(sorted_set) AVS_LIST_SIZE(*sorted_set)
+#    define AVS_SORTED_SET_SIZE(sorted_set) \
+        avs_sorted_set_size__((AVS_SORTED_SET_CONST(void)) (sorted_set))
 
 /**
  * A shorthand notation for a for-each loop. Wrapper around AVS_LIST_FOREACH.
@@ -185,13 +197,19 @@ static inline AVS_SORTED_SET_ELEM(T) AVS_SORTED_SET_CALL_WITH_CONST_ELEM_CAST__(
 /**
  * Insert an element into the @p sorted_set.
  *
- * Complexity O(n), where:
- * - n - number of elements in set
+ * Complexity O(log n * c + n), where:
+ * - n - number of elements in set,
+ * - c - complexity of @p sorted_set element comparator.
+ *
+ * The linear term only accounts for moving pointers within the lookup index,
+ * no comparisons are performed on it.
  *
  * @param sorted_set    Sorted set object to insert the element
  * @param element       The element to insert
  *
- * @return The inserted element
+ * @return The inserted element, or an already present element equal to it.
+ *         NULL is returned if the lookup index could not be grown due to an
+ *         out-of-memory condition - @p element is not inserted in such case.
  */
 #    define AVS_SORTED_SET_INSERT(sorted_set, element)                \
         AVS_SORTED_SET_CALL_WITH_ELEM_CAST__(avs_sorted_set_insert__, \
@@ -206,35 +224,37 @@ static inline AVS_SORTED_SET_ELEM(T) AVS_SORTED_SET_CALL_WITH_CONST_ELEM_CAST__(
         AVS_LIST_DELETE(elem_ptr)
 
 /**
- * Deallocates all @p sorted_set elements. Wrapper around AVS_LIST_CLEAR.
+ * Deallocates all @p sorted_set elements. Like AVS_LIST_CLEAR, may be followed
+ * by a loop body that is executed for each element just before deleting it.
  *
  * @param sorted_set   Object to operate on.
  */
-#    define AVS_SORTED_SET_CLEAR(sorted_set) AVS_LIST_CLEAR(sorted_set)
+#    define AVS_SORTED_SET_CLEAR(sorted_set)               \
+        for (avs_sorted_set_clear_index__(                 \
+                     (AVS_SORTED_SET(void)) (sorted_set)); \
+             *(sorted_set);                                \
+             AVS_LIST_DELETE(sorted_set))
 
 /**
  * Deletes a element attached to a @p sorted_set detaching it before freeing
- * memory.
+ * memory. If the element is not attached to @p sorted_set, nothing happens.
  *
  * @param sorted_set    Object to operate on.
  * @param elem_ptr      Pointer to the element to remove.
  */
-#    define AVS_SORTED_SET_DELETE_ELEM(sorted_set, elem_ptr)          \
-        do {                                                          \
-            AVS_SORTED_SET_ELEM(void) *ptr =                          \
-                    (AVS_SORTED_SET_ELEM(void) *) (elem_ptr);         \
-            if (ptr && *ptr) {                                        \
-                avs_free(((char *) (intptr_t) (AVS_SORTED_SET_DETACH( \
-                                 sorted_set, *ptr)))                  \
-                         - AVS_LIST_SPACE_FOR_NEXT__);                \
-                *ptr = NULL;                                          \
-            }                                                         \
+#    define AVS_SORTED_SET_DELETE_ELEM(sorted_set, elem_ptr)              \
+        do {                                                              \
+            AVS_SORTED_SET_ELEM(void) *ptr =                              \
+                    (AVS_SORTED_SET_ELEM(void) *) (elem_ptr);             \
+            if (ptr && *ptr && AVS_SORTED_SET_DETACH(sorted_set, *ptr)) { \
+                AVS_SORTED_SET_ELEM_DELETE_DETACHED(ptr);                 \
+            }                                                             \
         } while (0)
 
 /**
  * Finds an element with value given by @p val_ptr in @p sorted_set.
  *
- * Complexity: O(n * c), where:
+ * Complexity: O(log n * c), where:
  * - n - number of nodes in @p sorted_set.
  * - c - complexity of @p sorted_set element comparator.
  *
@@ -251,14 +271,21 @@ static inline AVS_SORTED_SET_ELEM(T) AVS_SORTED_SET_CALL_WITH_CONST_ELEM_CAST__(
 /**
  * Detaches given @p elem from @p sorted_set. Does not free @p elem.
  *
- * Complexity: O(n), where:
- * - n - number of nodes in @p sorted_set.
+ * Complexity: O(log n * c + n), where:
+ * - n - number of nodes in @p sorted_set,
+ * - c - complexity of @p sorted_set element comparator.
+ *
+ * The linear term only accounts for moving pointers within the lookup index,
+ * no comparisons are performed on it.
  *
  * @param sorted_set    Sorted set object to operate on.
  * @param elem          Element to remove.
+ *
+ * @returns @p elem, or NULL if it is not attached to @p sorted_set.
  */
-#    define AVS_SORTED_SET_DETACH(sorted_set, elem) \
-        AVS_LIST_DETACH(AVS_LIST_FIND_PTR((sorted_set), (elem)))
+#    define AVS_SORTED_SET_DETACH(sorted_set, elem)                   \
+        AVS_SORTED_SET_CALL_WITH_ELEM_CAST__(avs_sorted_set_detach__, \
+                                             (sorted_set), (elem))
 
 /**
  * Releases given @p sorted_set and all its elements.
@@ -306,7 +333,7 @@ static inline AVS_SORTED_SET_ELEM(T) AVS_SORTED_SET_CALL_WITH_CONST_ELEM_CAST__(
  * Finds the first element in @p sorted_set that has a value greater or equal to
  * @p val_ptr
  *
- * Complexity: O(n * c), where:
+ * Complexity: O(log n * c), where:
  * - n - number of nodes in @p sorted_set,
  * - c - complexity of sorted set element comparator.
  *
@@ -324,7 +351,7 @@ static inline AVS_SORTED_SET_ELEM(T) AVS_SORTED_SET_CALL_WITH_CONST_ELEM_CAST__(
  * than
  * @p val_ptr
  *
- * Complexity: O(n * c), where:
+ * Complexity: O(log n * c), where:
  * - n - number of nodes in @p sorted_set,
  * - c - complexity of sorted set element comparator.
  *
@@ -360,12 +387,11 @@ static inline AVS_SORTED_SET_ELEM(T) AVS_SORTED_SET_CALL_WITH_CONST_ELEM_CAST__(
  * Finds the last element in @p sorted_set in order defined by
  * @ref avs_sorted_set_element_comparator_t of @p sorted_set.
  *
- * Complexity: O(n), where:
- * - n - number of nodes in @p sorted_set,
+ * Complexity: O(1).
  *
  * @param sorted_set  Sorted set to search in.
  *
- * @returns the first element in @p sorted_set (in order defined by
+ * @returns the last element in @p sorted_set (in order defined by
  *          @ref avs_sorted_set_element_comparator_t of @p sorted_set) or NULL
  * if the
  *          @p sorted_set is empty.
@@ -109,6 +109,23 @@ avs_error_t avs_stream_write(avs_stream_t *stream,
                              const void *buffer,
                              size_t buffer_length);
 
+/**
+ * Writes the concatenation of @p iov_count data blocks to the stream. This is
+ * semantically equivalent to calling @ref avs_stream_write for each of them in
+ * order, but streams that support the WRITEV extension may pass all the data to
+ * the underlying medium at once.
+ *
+ * @param stream    Stream to write data to.
+ * @param iov       Array of data blocks to write.
+ * @param iov_count Number of elements in @p iov .
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t avs_stream_writev(avs_stream_t *stream,
+                              const avs_iovec_t *iov,
+                              size_t iov_count);
+
 /**
  * Finishes the message written onto stream by calling
  * @ref avs_stream_vtable_t#finish_message. The underlying stream may freely
@@ -365,7 +382,9 @@ avs_error_t avs_stream_peekline(avs_stream_t *stream,
  * This repeatedly calls @ref avs_stream_read to read a chunk of data from
  * @p input_stream, then @ref avs_stream_write to write that chunk into
  * @p output_stream, until <c>*out_message_finished</c> is true on the input
- * stream or an error occurs.
+ * stream or an error occurs. If @p output_stream supports
+ * @ref avs_stream_write_reserve, the data is read directly into its storage
+ * instead.
  *
  * NOTE: @ref avs_stream_finish_message is NOT called on the output stream, so
  * you need to call it manually if needed.
@@ -440,6 +459,77 @@ size_t avs_stream_nonblock_write_ready(avs_stream_t *stream);
  */
 avs_error_t avs_stream_offset(avs_stream_t *stream, avs_off_t *out_offset);
 
+/**
+ * Optional method on streams that support the READ_WINDOW extension. Provides
+ * direct access to a contiguous block of already buffered data, starting at
+ * @p offset from the current stream position, without consuming it.
+ *
+ * The window is owned by the stream and remains valid only until the next
+ * operation performed on it.
+ *
+ * @param stream     Stream to operate on.
+ * @param offset     Offset from the current stream position.
+ * @param out_data   Pointer to a variable that will be set to the beginning of
+ *                   the window.
+ * @param out_length Pointer to a variable that will be set to the number of
+ *                   bytes available in the window, which is never 0 on success.
+ *
+ * @returns @li @ref AVS_OK for success,
+ *          @li @ref AVS_EOF if @p offset points past end-of-stream,
+ *          @li <c>avs_errno(AVS_ENOTSUP)</c> if the stream does not support
+ *              the READ_WINDOW extension,
+ *          @li an error condition for which the operation failed.
+ */
+avs_error_t avs_stream_peek_window(avs_stream_t *stream,
+                                   size_t offset,
+                                   const char **out_data,
+                                   size_t *out_length);
+
+/**
+ * Optional method on streams that support the WRITE_WINDOW extension. Provides
+ * direct access to a contiguous region of the stream's internal storage that
+ * can be filled with data to write, without copying it through an
+ * intermediate buffer. The data becomes part of the stream only after calling
+ * @ref avs_stream_write_commit.
+ *
+ * The region is owned by the stream and remains valid only until the next
+ * operation performed on it.
+ *
+ * @param stream     Stream to operate on.
+ * @param size_hint  Number of bytes the caller would like to write; the stream
+ *                   may grow its storage accordingly, but the returned region
+ *                   may be of any size.
+ * @param out_ptr    Pointer to a variable that will be set to the beginning of
+ *                   the writable region.
+ * @param out_length Pointer to a variable that will be set to the size of the
+ *                   writable region. It may be 0 if data cannot be accepted
+ *                   this way at the moment - @ref avs_stream_write shall be
+ *                   used in that case.
+ *
+ * @returns @ref AVS_OK for success, <c>avs_errno(AVS_ENOTSUP)</c> if the stream
+ *          does not support the WRITE_WINDOW extension, or an error condition
+ *          for which the operation failed.
+ */
+avs_error_t avs_stream_write_reserve(avs_stream_t *stream,
+                                     size_t size_hint,
+                                     void **out_ptr,
+                                     size_t *out_length);
+
+/**
+ * Commits @p length bytes written into the region returned by the preceding
+ * @ref avs_stream_write_reserve call. This is semantically equivalent to
+ * writing that data with @ref avs_stream_write.
+ *
+ * @param stream Stream to operate on.
+ * @param length Number of bytes to commit; it MUST NOT be greater than the
+ *               size of the reserved region.
+ *
+ * @returns @ref AVS_OK for success, <c>avs_errno(AVS_ENOTSUP)</c> if the stream
+ *          does not support the WRITE_WINDOW extension, or an error condition
+ *          for which the operation failed.
+ */
+avs_error_t avs_stream_write_commit(avs_stream_t *stream, size_t length);
+
 #ifdef __cplusplus
 }
 #endif
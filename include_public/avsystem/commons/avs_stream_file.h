@@ -75,6 +75,22 @@ avs_error_t avs_stream_file_seek(avs_stream_t *stream,
 
 #define AVS_STREAM_FILE_READ 0x01
 #define AVS_STREAM_FILE_WRITE 0x02
+/**
+ * Flag that may be combined with @ref AVS_STREAM_FILE_READ (but not with
+ * @ref AVS_STREAM_FILE_WRITE) to map the whole file into memory instead of
+ * reading it through <c>stdio</c>.
+ *
+ * In this mode, reading, peeking, seeking and querying the length are simple
+ * pointer arithmetic, and the stream exposes the contiguous read window
+ * extension (see @ref avs_stream_peek_window), which allows parsers to scan
+ * the file contents directly. The file shall not be modified while the stream
+ * is open.
+ *
+ * If memory mapping is not supported (see
+ * @ref AVS_COMMONS_STREAM_WITH_FILE_MMAP) or the file cannot be mapped (e.g.
+ * it is not a regular file), the stream silently falls back to regular reads.
+ */
+#define AVS_STREAM_FILE_MMAP 0x04
 typedef struct avs_file_stream_struct avs_stream_file_t;
 /**
  * Creates a new file-stream. If file referred by @p path does not exist and
@@ -99,11 +115,86 @@ typedef struct avs_file_stream_struct avs_stream_file_t;
  *                      is written
  * @param path          path to the file
  * @param mode          combination of @ref AVS_STREAM_FILE_READ,
- *                                     @ref AVS_STREAM_FILE_WRITE
+ *                                     @ref AVS_STREAM_FILE_WRITE, or
+ *                      <c>AVS_STREAM_FILE_READ | AVS_STREAM_FILE_MMAP</c>
  * @return pointer to the new file stream, NULL on error
  */
 avs_stream_t *avs_stream_file_create(const char *path, uint8_t mode);
 
+#ifdef AVS_COMMONS_STREAM_WITH_FILE_FD
+/**
+ * Flag for @ref avs_stream_file_fd_config_t::flags : make
+ * @ref avs_stream_finish_message flush all buffered data and synchronize it
+ * with the storage device using <c>fdatasync()</c> (or <c>fsync()</c> where
+ * the former is not available).
+ */
+#    define AVS_STREAM_FILE_FD_SYNC 0x01
+/**
+ * Flag for @ref avs_stream_file_fd_config_t::flags : write all data to a
+ * temporary file named <c>path.tmp</c> (any existing file of that name is
+ * overwritten) and replace the target file with it only when
+ * @ref avs_stream_finish_message is called. The temporary file is synchronized
+ * with the storage device before being renamed, so after a crash the target
+ * path refers either to the old contents or to the complete new contents.
+ *
+ * After a successful commit the stream does not accept any more data. Closing
+ * the stream without committing removes the temporary file, leaving the target
+ * file untouched.
+ */
+#    define AVS_STREAM_FILE_FD_ATOMIC 0x02
+
+/**
+ * Default value of @ref avs_stream_file_fd_config_t::write_buffer_size .
+ */
+#    define AVS_STREAM_FILE_FD_DEFAULT_WRITE_BUFFER_SIZE 65536
+
+typedef struct {
+    /**
+     * Size of the write-coalescing buffer. Data is passed to the operating
+     * system only in multiples of this size (except for the final, partial
+     * block flushed by @ref avs_stream_finish_message or when closing the
+     * stream), so that small writes do not result in many small system calls.
+     *
+     * If 0, @ref AVS_STREAM_FILE_FD_DEFAULT_WRITE_BUFFER_SIZE is used.
+     */
+    size_t write_buffer_size;
+
+    /**
+     * If nonzero, storage for that many bytes is allocated up front using
+     * <c>posix_fallocate()</c>, which reduces fragmentation of large files.
+     * The file is truncated to the size of actually written data when the
+     * message is finished or the stream is closed. Ignored if the platform or
+     * the filesystem does not support preallocation.
+     */
+    avs_off_t preallocate_size;
+
+    /**
+     * Combination of @ref AVS_STREAM_FILE_FD_SYNC and
+     * @ref AVS_STREAM_FILE_FD_ATOMIC .
+     */
+    uint8_t flags;
+} avs_stream_file_fd_config_t;
+
+/**
+ * Creates a write-only file stream that uses POSIX file descriptors directly,
+ * bypassing <c>stdio</c> buffering. The file referred to by @p path is created
+ * if it does not exist, and truncated if it does.
+ *
+ * Besides regular writing, the stream supports @ref avs_stream_offset and
+ * @ref avs_stream_write_reserve / @ref avs_stream_write_commit , the latter
+ * allowing data to be produced directly in the write-coalescing buffer.
+ *
+ * @param path   path to the file
+ * @param config stream configuration; may be NULL, in which case default
+ *               settings (no preallocation, no synchronization, default
+ *               buffer size) are used
+ *
+ * @returns pointer to the new file stream, NULL on error
+ */
+avs_stream_t *avs_stream_file_fd_create(
+        const char *path, const avs_stream_file_fd_config_t *config);
+#endif // AVS_COMMONS_STREAM_WITH_FILE_FD
+
 #ifdef __cplusplus
 }
 #endif
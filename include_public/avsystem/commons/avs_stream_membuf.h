@@ -83,6 +83,55 @@ avs_error_t avs_stream_membuf_take_ownership(avs_stream_t *stream,
                                              void **out_ptr,
                                              size_t *out_size);
 
+#define AVS_STREAM_V_TABLE_EXTENSION_MEMBUF_IOV 0x4d454d49UL /* MEMI */
+
+typedef avs_error_t (*avs_stream_membuf_take_ownership_iov_t)(
+        avs_stream_t *stream, avs_iovec_t **out_iov, size_t *out_iov_count);
+
+typedef struct {
+    avs_stream_membuf_take_ownership_iov_t take_ownership_iov;
+} avs_stream_v_table_extension_membuf_iov_t;
+
+/**
+ * Returns the stream's internal storage (containing all the unread data) as an
+ * array of memory blocks, and resets the original stream's state so that it
+ * contains no data.
+ *
+ * Unlike @ref avs_stream_membuf_take_ownership, this function does not need to
+ * gather the data into a single contiguous buffer, so for streams created
+ * using @ref avs_stream_membuf_chunked_create, the data is not copied (with
+ * the exception of the unread part of the first chunk, if it has been
+ * partially read).
+ *
+ * @param stream        membuf stream pointer
+ *
+ * @param out_iov       Pointer to a variable which will be set to a
+ *                      heap-allocated array of memory blocks. It shall be
+ *                      released using @ref avs_stream_membuf_iov_free. If the
+ *                      stream contains no data, it is set to NULL.
+ *
+ * @param out_iov_count Pointer to a variable which will be set to the number
+ *                      of elements in <c>*out_iov</c>.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. On error, the stream's state is not changed.
+ */
+avs_error_t avs_stream_membuf_take_ownership_iov(avs_stream_t *stream,
+                                                 avs_iovec_t **out_iov,
+                                                 size_t *out_iov_count);
+
+/**
+ * Releases an array of memory blocks returned by
+ * @ref avs_stream_membuf_take_ownership_iov, including the memory blocks
+ * themselves.
+ *
+ * @param iov       Pointer to a variable containing the array to free. It will
+ *                  be reset to NULL afterwards.
+ *
+ * @param iov_count Number of elements in <c>*iov</c>.
+ */
+void avs_stream_membuf_iov_free(avs_iovec_t **iov, size_t iov_count);
+
 typedef struct avs_stream_membuf_struct avs_stream_membuf_t;
 
 /**
@@ -93,6 +142,74 @@ typedef struct avs_stream_membuf_struct avs_stream_membuf_t;
  */
 avs_stream_t *avs_stream_membuf_create(void);
 
+typedef struct avs_stream_membuf_chunk_pool_struct
+        avs_stream_membuf_chunk_pool_t;
+
+/**
+ * Creates a pool of fixed-size memory chunks that may be shared between
+ * multiple streams created using
+ * @ref avs_stream_membuf_chunked_create_with_pool.
+ *
+ * Chunks released by the streams are kept in the pool for reuse, up to
+ * @p max_free_chunks of them.
+ *
+ * <strong>NOTE:</strong> The pool is not thread-safe. It shall also outlive
+ * all streams that use it.
+ *
+ * @param chunk_size      Size of each chunk, in bytes. It needs to be at least
+ *                        <c>sizeof(void *)</c>.
+ *
+ * @param max_free_chunks Maximum number of unused chunks kept in the pool.
+ *
+ * @return NULL in case of an error, pointer to the newly allocated pool
+ *         otherwise
+ */
+avs_stream_membuf_chunk_pool_t *
+avs_stream_membuf_chunk_pool_create(size_t chunk_size, size_t max_free_chunks);
+
+/**
+ * Destroys a chunk pool created using @ref avs_stream_membuf_chunk_pool_create
+ * and frees all unused chunks kept in it.
+ *
+ * @param pool Pointer to a variable containing the pool to free. It will be
+ *             reset to NULL afterwards.
+ */
+void avs_stream_membuf_chunk_pool_free(avs_stream_membuf_chunk_pool_t **pool);
+
+/**
+ * Creates a new in-memory auto-resizable bidirectional stream, storing the
+ * data in a list of fixed-size chunks instead of a single contiguous buffer.
+ *
+ * Appending data to such stream never copies the data already stored, so it
+ * is better suited for building large payloads than
+ * @ref avs_stream_membuf_create. The stream supports all membuf operations,
+ * but note that @ref avs_stream_membuf_take_ownership needs to copy the data
+ * into a newly allocated contiguous buffer -
+ * @ref avs_stream_membuf_take_ownership_iov shall be preferred instead.
+ *
+ * @param chunk_size Size of each chunk, in bytes.
+ *
+ * @return NULL in case of an error, pointer to the newly allocated
+ *         stream otherwise
+ */
+avs_stream_t *avs_stream_membuf_chunked_create(size_t chunk_size);
+
+/**
+ * Works like @ref avs_stream_membuf_chunked_create, but the chunks are
+ * allocated from, and returned to, the specified pool.
+ *
+ * Chunks returned by @ref avs_stream_membuf_take_ownership_iov are no longer
+ * owned by the pool.
+ *
+ * @param pool Chunk pool to use. It shall not be NULL and shall outlive the
+ *             created stream.
+ *
+ * @return NULL in case of an error, pointer to the newly allocated
+ *         stream otherwise
+ */
+avs_stream_t *avs_stream_membuf_chunked_create_with_pool(
+        avs_stream_membuf_chunk_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif
@@ -222,6 +222,115 @@ typedef struct {
     avs_stream_offset_t offset;
 } avs_stream_v_table_extension_offset_t;
 
+#define AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW 0x5257494EUL /* "RWIN" */
+
+/**
+ * @ref avs_stream_peek_window implementation callback type.
+ *
+ * Exposes a contiguous block of data already buffered by the stream, starting
+ * at specified offset from the current stream position, without consuming it.
+ * Like @ref avs_stream_peek_t, the implementation may fill its internal
+ * buffers if necessary.
+ *
+ * The returned window is borrowed from the stream and is valid only until the
+ * next operation performed on it.
+ *
+ * @param[in]  stream     Stream to operate on.
+ * @param[in]  offset     Offset from the current stream position.
+ * @param[out] out_data   Pointer to the beginning of the window.
+ * @param[out] out_length Number of bytes available in the window; never 0 on
+ *                        success.
+ *
+ * @returns @li @ref AVS_OK for success,
+ *          @li @ref AVS_EOF if @p offset has been reliably determined as
+ *              pointing past end-of-stream,
+ *          @li an error condition for which the operation failed; this includes
+ *              the stream not having buffered enough data.
+ */
+typedef avs_error_t (*avs_stream_peek_window_t)(avs_stream_t *stream,
+                                                size_t offset,
+                                                const char **out_data,
+                                                size_t *out_length);
+
+typedef struct {
+    avs_stream_peek_window_t peek_window;
+} avs_stream_v_table_extension_read_window_t;
+
+#define AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW 0x5757494EUL /* "WWIN" */
+
+/**
+ * @ref avs_stream_write_reserve implementation callback type.
+ *
+ * Exposes a contiguous writable region of the stream's internal storage, so
+ * that the caller may produce data in place instead of passing it to
+ * @ref avs_stream_write_some_t. Reserving space shall not perform any external
+ * I/O and has no visible effect until @ref avs_stream_write_commit_t is called.
+ *
+ * @param[in]  stream     Stream to operate on.
+ * @param[in]  size_hint  Number of bytes the caller would like to write. The
+ *                        implementation may use it to grow its storage, but is
+ *                        free to return a region of any size.
+ * @param[out] out_ptr    Pointer to the beginning of the writable region.
+ * @param[out] out_length Size of the writable region. It is valid to return 0,
+ *                        in which case the caller shall fall back to
+ *                        @ref avs_stream_write_some_t .
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+typedef avs_error_t (*avs_stream_write_reserve_t)(avs_stream_t *stream,
+                                                  size_t size_hint,
+                                                  void **out_ptr,
+                                                  size_t *out_length);
+
+/**
+ * @ref avs_stream_write_commit implementation callback type.
+ *
+ * Marks @p length bytes at the beginning of the region most recently returned
+ * by @ref avs_stream_write_reserve_t as written. Semantically, this is
+ * equivalent to a successful @ref avs_stream_write_some_t call with that data,
+ * including any flushing the stream would perform in that case.
+ *
+ * @param stream Stream to operate on.
+ * @param length Number of bytes written; not greater than the size of the
+ *               reserved region.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+typedef avs_error_t (*avs_stream_write_commit_t)(avs_stream_t *stream,
+                                                 size_t length);
+
+typedef struct {
+    avs_stream_write_reserve_t reserve;
+    avs_stream_write_commit_t commit;
+} avs_stream_v_table_extension_write_window_t;
+
+#define AVS_STREAM_V_TABLE_EXTENSION_WRITEV 0x57525456UL /* "WRTV" */
+
+/**
+ * @ref avs_stream_writev implementation callback type.
+ *
+ * Writes the concatenation of @p iov_count data blocks to the stream. The
+ * implementation shall either accept all the data or fail - short writes are
+ * not allowed. It is expected to pass the data to the underlying medium in as
+ * few operations as possible, e.g. as a single system call.
+ *
+ * @param stream    Stream to operate on.
+ * @param iov       Array of data blocks to write.
+ * @param iov_count Number of elements in @p iov .
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+typedef avs_error_t (*avs_stream_writev_t)(avs_stream_t *stream,
+                                           const avs_iovec_t *iov,
+                                           size_t iov_count);
+
+typedef struct {
+    avs_stream_writev_t writev;
+} avs_stream_v_table_extension_writev_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -56,12 +56,31 @@
 #    error "AVS_COMMONS_WITH_AVS_LOG is required for AVS_COMMONS_WITH_INTERNAL_LOGS"
 #endif
 
+#if defined(AVS_COMMONS_WITH_AVS_LOG) && defined(AVS_COMMONS_LOG_WITH_ASYNC) \
+        && (!defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING)                 \
+            || !defined(AVS_COMMONS_HAVE_C11_STDATOMIC))
+#    error "AVS_COMMONS_LOG_WITH_ASYNC requires AVS_COMMONS_WITH_AVS_COMPAT_THREADING and AVS_COMMONS_HAVE_C11_STDATOMIC"
+#endif
+
 #if defined(AVS_COMMONS_WITH_AVS_NET)                            \
         && defined(AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE) \
         && !defined(AVS_COMMONS_WITH_AVS_PERSISTENCE)
 #    error "AVS_COMMONS_WITH_AVS_PERSISTENCE is required for AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE"
 #endif
 
+#if defined(AVS_COMMONS_WITH_AVS_NET)                             \
+        && defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) \
+        && (!defined(AVS_COMMONS_WITH_AVS_CRYPTO)                 \
+            || !defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING))
+#    error "AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE requires AVS_COMMONS_WITH_AVS_CRYPTO and AVS_COMMONS_WITH_AVS_COMPAT_THREADING"
+#endif
+
+#if defined(AVS_COMMONS_WITH_AVS_NET)                  \
+        && defined(AVS_COMMONS_NET_WITH_DTLS_LISTENER) \
+        && !defined(AVS_COMMONS_WITH_AVS_CRYPTO)
+#    error "AVS_COMMONS_NET_WITH_DTLS_LISTENER requires AVS_COMMONS_WITH_AVS_CRYPTO"
+#endif
+
 #if !defined(AVS_COMMONS_WITH_AVS_STREAM) \
         && defined(AVS_COMMONS_STREAM_WITH_FILE)
 #    error "AVS_COMMONS_WITH_AVS_STREAM is required for AVS_COMMONS_STREAM_WITH_FILE"
@@ -77,6 +96,12 @@
 #    error "AVS_COMMONS_WITH_AVS_CRYPTO_PSK is required for AVS_COMMONS_WITH_AVS_CRYPTO_PSK_ENGINE"
 #endif
 
+#if defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE)    \
+        && (!defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI) \
+            || !defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING))
+#    error "AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE requires AVS_COMMONS_WITH_AVS_CRYPTO_PKI and AVS_COMMONS_WITH_AVS_COMPAT_THREADING"
+#endif
+
 #if defined(AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR)        \
         && defined(AVS_COMMONS_UTILS_WITH_ALIGNFIX_ALLOCATOR) \
         && !defined(AVS_COMMONS_ALIGNFIX_ALLOCATOR_TEST)
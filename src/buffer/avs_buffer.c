@@ -18,6 +18,8 @@
 
 #ifdef AVS_COMMONS_WITH_AVS_BUFFER
 
+#    include <assert.h>
+#    include <stdbool.h>
 #    include <stddef.h>
 #    include <stdlib.h>
 #    include <string.h>
@@ -33,32 +35,58 @@ VISIBILITY_SOURCE_BEGIN
 
 struct avs_buffer_struct {
     size_t capacity;
-    char *begin;
-    char *end;
+    /* offset of the first byte of data */
+    size_t begin;
+    /* number of bytes of data, possibly wrapping around in ring mode */
+    size_t size;
+    bool ring;
     union {
         char data[1]; /* variable length */
         avs_max_align_t align;
     } data;
 };
 
+static size_t wrap_offset(const avs_buffer_t *buffer, size_t offset) {
+    assert(offset <= 2 * buffer->capacity);
+    return offset >= buffer->capacity ? offset - buffer->capacity : offset;
+}
+
+static size_t end_offset(const avs_buffer_t *buffer) {
+    if (buffer->ring) {
+        return wrap_offset(buffer, buffer->begin + buffer->size);
+    } else {
+        return buffer->begin + buffer->size;
+    }
+}
+
+static bool data_wrapped(const avs_buffer_t *buffer) {
+    return buffer->begin + buffer->size > buffer->capacity;
+}
+
 size_t avs_buffer_space_left(const avs_buffer_t *buffer) {
     return buffer->capacity - avs_buffer_data_size(buffer);
 }
 
 static size_t space_left_without_moving(const avs_buffer_t *buffer) {
-    return buffer->capacity - (size_t) (buffer->end - buffer->data.data);
+    if (buffer->ring) {
+        return avs_buffer_space_left(buffer);
+    } else {
+        return buffer->capacity - end_offset(buffer);
+    }
 }
 
 void avs_buffer_reset(avs_buffer_t *buffer) {
-    buffer->begin = buffer->data.data;
-    buffer->end = buffer->data.data;
+    buffer->begin = 0;
+    buffer->size = 0;
 }
 
-int avs_buffer_create(avs_buffer_t **buffer_ptr, size_t capacity) {
+static int create_buffer(avs_buffer_t **buffer_ptr, size_t capacity,
+                         bool ring) {
     *buffer_ptr = (avs_buffer_t *) avs_malloc(offsetof(avs_buffer_t, data)
                                               + capacity);
     if (*buffer_ptr) {
         (*buffer_ptr)->capacity = capacity;
+        (*buffer_ptr)->ring = ring;
         avs_buffer_reset(*buffer_ptr);
         return 0;
     } else {
@@ -67,35 +95,109 @@ int avs_buffer_create(avs_buffer_t **buffer_ptr, size_t capacity) {
     }
 }
 
+int avs_buffer_create(avs_buffer_t **buffer_ptr, size_t capacity) {
+    return create_buffer(buffer_ptr, capacity, false);
+}
+
+int avs_buffer_create_ring(avs_buffer_t **buffer_ptr, size_t capacity) {
+    return create_buffer(buffer_ptr, capacity, true);
+}
+
 void avs_buffer_free(avs_buffer_t **buffer) {
     avs_free(*buffer);
     *buffer = NULL;
 }
 
 size_t avs_buffer_data_size(const avs_buffer_t *buffer) {
-    return (size_t) (buffer->end - buffer->begin);
+    return buffer->size;
 }
 
 size_t avs_buffer_capacity(const avs_buffer_t *buffer) {
     return buffer->capacity;
 }
 
-const char *avs_buffer_data(const avs_buffer_t *buffer) {
-    return buffer->begin;
+static void reverse_bytes(char *data, size_t length) {
+    for (size_t i = 0; i < length / 2; ++i) {
+        char tmp = data[i];
+        data[i] = data[length - 1 - i];
+        data[length - 1 - i] = tmp;
+    }
 }
 
 static void defragment_buffer(avs_buffer_t *buffer) {
-    if (buffer->begin != buffer->data.data) {
-        size_t used = avs_buffer_data_size(buffer);
-        memmove(buffer->data.data, buffer->begin, used);
-        buffer->end = buffer->data.data + used;
-        buffer->begin = buffer->data.data;
+    if (buffer->begin == 0) {
+        return;
+    }
+    if (data_wrapped(buffer)) {
+        // rotate the whole storage in place so that data starts at offset 0
+        reverse_bytes(buffer->data.data, buffer->begin);
+        reverse_bytes(buffer->data.data + buffer->begin,
+                      buffer->capacity - buffer->begin);
+        reverse_bytes(buffer->data.data, buffer->capacity);
+    } else {
+        memmove(buffer->data.data, buffer->data.data + buffer->begin,
+                buffer->size);
     }
+    buffer->begin = 0;
+}
+
+const char *avs_buffer_data(const avs_buffer_t *buffer) {
+    AVS_ASSERT(!data_wrapped(buffer),
+               "avs_buffer_data() called on wrapped data, use "
+               "avs_buffer_linearize() or avs_buffer_data_spans() instead");
+    return buffer->data.data + buffer->begin;
+}
+
+const char *avs_buffer_linearize(avs_buffer_t *buffer) {
+    if (data_wrapped(buffer)) {
+        defragment_buffer(buffer);
+    }
+    return avs_buffer_data(buffer);
 }
 
 char *avs_buffer_raw_insert_ptr(avs_buffer_t *buffer) {
-    defragment_buffer(buffer);
-    return buffer->end;
+    if (!buffer->ring || (buffer->begin > 0 && !data_wrapped(buffer)
+                          && end_offset(buffer) > 0)) {
+        // free space is not contiguous
+        defragment_buffer(buffer);
+    }
+    return buffer->data.data + end_offset(buffer);
+}
+
+size_t avs_buffer_data_spans(const avs_buffer_t *buffer,
+                             avs_iovec_t out_spans[2]) {
+    size_t first_length =
+            AVS_MIN(buffer->size, buffer->capacity - buffer->begin);
+    out_spans[0].base = buffer->data.data + buffer->begin;
+    out_spans[0].length = first_length;
+    out_spans[1].base = buffer->data.data;
+    out_spans[1].length = buffer->size - first_length;
+    return (size_t) (first_length > 0) + (size_t) (out_spans[1].length > 0);
+}
+
+static void get_free_spans(avs_buffer_t *buffer,
+                           avs_buffer_span_t out_spans[2]) {
+    size_t end = end_offset(buffer);
+    size_t first_length = buffer->capacity - end;
+    size_t second_length = 0;
+    if (buffer->ring) {
+        first_length = AVS_MIN(avs_buffer_space_left(buffer), first_length);
+        second_length = avs_buffer_space_left(buffer) - first_length;
+    }
+    out_spans[0].base = buffer->data.data + end;
+    out_spans[0].length = first_length;
+    out_spans[1].base = buffer->data.data;
+    out_spans[1].length = second_length;
+}
+
+size_t avs_buffer_free_spans(avs_buffer_t *buffer,
+                             avs_buffer_span_t out_spans[2]) {
+    if (!buffer->ring) {
+        defragment_buffer(buffer);
+    }
+    get_free_spans(buffer, out_spans);
+    return (size_t) (out_spans[0].length > 0)
+           + (size_t) (out_spans[1].length > 0);
 }
 
 int avs_buffer_consume_bytes(avs_buffer_t *buffer, size_t bytes_count) {
@@ -103,11 +205,25 @@ int avs_buffer_consume_bytes(avs_buffer_t *buffer, size_t bytes_count) {
         LOG(ERROR, _("not enough data"));
         return -1;
     }
-    buffer->begin += bytes_count;
+    buffer->size -= bytes_count;
+    if (!buffer->ring) {
+        buffer->begin += bytes_count;
+    } else if (!buffer->size) {
+        // rewind to maximize contiguous free space; this is free of cost
+        buffer->begin = 0;
+    } else {
+        buffer->begin = wrap_offset(buffer, buffer->begin + bytes_count);
+    }
 
     return 0;
 }
 
+static void prepare_for_append(avs_buffer_t *buffer, size_t length) {
+    if (length > space_left_without_moving(buffer)) {
+        defragment_buffer(buffer);
+    }
+}
+
 int avs_buffer_append_bytes(avs_buffer_t *buffer,
                             const void *data,
                             size_t data_length) {
@@ -115,11 +231,18 @@ int avs_buffer_append_bytes(avs_buffer_t *buffer,
         LOG(ERROR, _("buffer too small"));
         return -1;
     } else {
-        if (data_length > space_left_without_moving(buffer)) {
-            defragment_buffer(buffer);
+        prepare_for_append(buffer, data_length);
+        avs_buffer_span_t spans[2];
+        get_free_spans(buffer, spans);
+        size_t first_length = AVS_MIN(data_length, spans[0].length);
+        if (first_length) {
+            memcpy(spans[0].base, data, first_length);
+        }
+        if (data_length > first_length) {
+            memcpy(spans[1].base, (const char *) data + first_length,
+                   data_length - first_length);
         }
-        memcpy(buffer->end, data, data_length);
-        buffer->end += data_length;
+        buffer->size += data_length;
         return 0;
     }
 }
@@ -129,10 +252,8 @@ int avs_buffer_advance_ptr(avs_buffer_t *buffer, size_t n) {
         LOG(ERROR, _("position out of bounds"));
         return -1;
     } else {
-        if (n > space_left_without_moving(buffer)) {
-            defragment_buffer(buffer);
-        }
-        buffer->end += n;
+        prepare_for_append(buffer, n);
+        buffer->size += n;
         return 0;
     }
 }
@@ -141,11 +262,13 @@ int avs_buffer_fill_bytes(avs_buffer_t *buffer, int value, size_t bytes_count) {
     if (bytes_count > avs_buffer_space_left(buffer)) {
         return -1;
     } else {
-        if (bytes_count > space_left_without_moving(buffer)) {
-            defragment_buffer(buffer);
-        }
-        memset(buffer->end, value, bytes_count);
-        buffer->end += bytes_count;
+        prepare_for_append(buffer, bytes_count);
+        avs_buffer_span_t spans[2];
+        get_free_spans(buffer, spans);
+        size_t first_length = AVS_MIN(bytes_count, spans[0].length);
+        memset(spans[0].base, value, first_length);
+        memset(spans[1].base, value, bytes_count - first_length);
+        buffer->size += bytes_count;
         return 0;
     }
 }
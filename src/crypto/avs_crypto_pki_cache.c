@@ -0,0 +1,569 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_commons_config.h>
+
+// included before anything else, so that POSIX.1-2008 struct stat fields
+// (st_mtim, st_ctim) are visible
+#ifdef AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT
+#    include <avs_commons_posix_init.h>
+
+#    include <sys/stat.h>
+#endif // AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_CRYPTO)                   \
+        && defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI)       \
+        && defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE) \
+        && !defined(AVS_COMMONS_WITHOUT_TLS)
+
+#    include <assert.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_init_once.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    include "avs_crypto_pki_cache.h"
+#    include "avs_crypto_utils.h"
+
+#    define MODULE_NAME avs_crypto_pki_cache
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+struct avs_crypto_pki_cache_entry_struct {
+    // next, refcount and indexed are guarded by g_cache.mutex
+    avs_crypto_pki_cache_entry_t *next;
+    size_t refcount;
+    bool indexed;
+    // type and free_cb are compared along with the key, so that different
+    // kinds of objects loaded from the same source are not confused
+    avs_crypto_security_info_tag_t type;
+    avs_crypto_pki_cache_free_t *free_cb;
+    void *object;
+    size_t identity_size;
+    size_t version_size;
+    // identity_size bytes of identity, followed by version_size bytes of
+    // version; see build_key() for details
+    char key[];
+};
+
+static struct {
+    avs_mutex_t *mutex;
+    // most recently used first; each of the entries holds one reference
+    // on behalf of the index
+    avs_crypto_pki_cache_entry_t *entries;
+    size_t entry_count;
+} g_cache;
+
+static avs_init_once_handle_t g_cache_init_handle;
+
+static int initialize_global_state(void *unused) {
+    (void) unused;
+    return avs_mutex_create(&g_cache.mutex);
+}
+
+static int cache_lock(void) {
+    if (avs_init_once(&g_cache_init_handle, initialize_global_state, NULL)) {
+        LOG(ERROR, _("could not initialize PKI cache"));
+        return -1;
+    }
+    if (avs_mutex_lock(g_cache.mutex)) {
+        AVS_UNREACHABLE("could not lock mutex");
+    }
+    return 0;
+}
+
+static void cache_unlock(void) {
+    avs_mutex_unlock(g_cache.mutex);
+}
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} key_buffer_t;
+
+static avs_error_t
+key_buffer_append(key_buffer_t *buf, const void *data, size_t size) {
+    if (buf->size + size > buf->capacity) {
+        size_t new_capacity = AVS_MAX(2 * buf->capacity, buf->size + size);
+        char *new_data = (char *) avs_realloc(buf->data, new_capacity);
+        if (!new_data) {
+            LOG_OOM();
+            return avs_errno(AVS_ENOMEM);
+        }
+        buf->data = new_data;
+        buf->capacity = new_capacity;
+    }
+    if (size) {
+        memcpy(buf->data + buf->size, data, size);
+        buf->size += size;
+    }
+    return AVS_OK;
+}
+
+typedef struct {
+    // sequence of records, each consisting of a size_t length field and
+    // that many bytes of data, identifying a single leaf data source
+    key_buffer_t identity;
+    // concatenated data that changes when contents of the sources change
+    key_buffer_t version;
+    bool with_version;
+    bool cacheable;
+} cache_key_t;
+
+static void cache_key_cleanup(cache_key_t *key) {
+    avs_free(key->identity.data);
+    avs_free(key->version.data);
+}
+
+static avs_error_t
+append_identity_record(cache_key_t *key,
+                       const avs_crypto_security_info_union_t *desc,
+                       const void *data,
+                       size_t size) {
+    const size_t record_size =
+            sizeof(desc->type) + sizeof(desc->source) + size;
+    avs_error_t err;
+    (void) (avs_is_err((err = key_buffer_append(&key->identity, &record_size,
+                                                sizeof(record_size))))
+            || avs_is_err((err = key_buffer_append(&key->identity, &desc->type,
+                                                   sizeof(desc->type))))
+            || avs_is_err((err = key_buffer_append(&key->identity,
+                                                   &desc->source,
+                                                   sizeof(desc->source))))
+            || avs_is_err((err = key_buffer_append(&key->identity, data,
+                                                   size))));
+    return err;
+}
+
+#    ifdef AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    int64_t size;
+    int64_t mtime;
+    int64_t ctime;
+    int32_t mtime_nsec;
+    int32_t ctime_nsec;
+} file_version_t;
+
+static avs_error_t append_file_version(cache_key_t *key, const char *path) {
+    struct stat st;
+    if (stat(path, &st)) {
+        // let the loader report the actual error
+        key->cacheable = false;
+        return AVS_OK;
+    }
+    file_version_t version;
+    memset(&version, 0, sizeof(version));
+    version.dev = (uint64_t) st.st_dev;
+    version.ino = (uint64_t) st.st_ino;
+    version.size = (int64_t) st.st_size;
+    version.mtime = (int64_t) st.st_mtime;
+    version.ctime = (int64_t) st.st_ctime;
+#        ifdef AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT_MTIM
+    version.mtime_nsec = (int32_t) st.st_mtim.tv_nsec;
+    version.ctime_nsec = (int32_t) st.st_ctim.tv_nsec;
+#        endif // AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT_MTIM
+    return key_buffer_append(&key->version, &version, sizeof(version));
+}
+#    else  // AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT
+static avs_error_t append_file_version(cache_key_t *key, const char *path) {
+    (void) path;
+    // there is no way to detect modifications
+    key->cacheable = false;
+    return AVS_OK;
+}
+#    endif // AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT
+
+static avs_error_t append_path_key(cache_key_t *key,
+                                   const avs_crypto_security_info_union_t *desc,
+                                   const char *path) {
+    if (!path) {
+        key->cacheable = false;
+        return AVS_OK;
+    }
+    avs_error_t err = append_identity_record(key, desc, path, strlen(path));
+    if (avs_is_ok(err) && key->with_version) {
+        err = append_file_version(key, path);
+    }
+    return err;
+}
+
+static avs_error_t
+append_leaf_key(const avs_crypto_security_info_union_t *desc, void *key_) {
+    cache_key_t *key = (cache_key_t *) key_;
+    switch (desc->source) {
+    case AVS_CRYPTO_DATA_SOURCE_FILE:
+        return append_path_key(key, desc, desc->info.file.filename);
+    case AVS_CRYPTO_DATA_SOURCE_PATH:
+        return append_path_key(key, desc, desc->info.path.path);
+    case AVS_CRYPTO_DATA_SOURCE_BUFFER: {
+        if (!desc->info.buffer.buffer) {
+            key->cacheable = false;
+            return AVS_OK;
+        }
+        const struct {
+            const void *buffer;
+            size_t buffer_size;
+        } identity = {
+            .buffer = desc->info.buffer.buffer,
+            .buffer_size = desc->info.buffer.buffer_size
+        };
+        avs_error_t err =
+                append_identity_record(key, desc, &identity, sizeof(identity));
+        if (avs_is_ok(err) && key->with_version) {
+            // the whole contents, so that any modification is detected
+            err = key_buffer_append(&key->version, desc->info.buffer.buffer,
+                                    desc->info.buffer.buffer_size);
+        }
+        return err;
+    }
+#    if defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_ENGINE) \
+            || defined(AVS_COMMONS_WITH_AVS_CRYPTO_PSK_ENGINE)
+    case AVS_CRYPTO_DATA_SOURCE_ENGINE:
+        if (!desc->info.engine.query) {
+            key->cacheable = false;
+            return AVS_OK;
+        }
+        return append_identity_record(key, desc, desc->info.engine.query,
+                                      strlen(desc->info.engine.query));
+#    endif /* defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_ENGINE) || \
+              defined(AVS_COMMONS_WITH_AVS_CRYPTO_PSK_ENGINE) */
+    default:
+        key->cacheable = false;
+        return AVS_OK;
+    }
+}
+
+static avs_error_t build_key(cache_key_t *out_key,
+                             const avs_crypto_security_info_union_t *desc,
+                             bool with_version) {
+    memset(out_key, 0, sizeof(*out_key));
+    out_key->with_version = with_version;
+    out_key->cacheable = true;
+    avs_error_t err =
+            _avs_crypto_security_info_iterate(desc, append_leaf_key, out_key);
+    if (avs_is_err(err)) {
+        cache_key_cleanup(out_key);
+    }
+    return err;
+}
+
+static const char *entry_version(const avs_crypto_pki_cache_entry_t *entry) {
+    return entry->key + entry->identity_size;
+}
+
+static bool entry_identity_equal(const avs_crypto_pki_cache_entry_t *entry,
+                                 const avs_crypto_pki_cache_entry_t *other) {
+    return entry->type == other->type && entry->free_cb == other->free_cb
+           && entry->identity_size == other->identity_size
+           && !memcmp(entry->key, other->key, entry->identity_size);
+}
+
+static bool entry_version_equal(const avs_crypto_pki_cache_entry_t *entry,
+                                const avs_crypto_pki_cache_entry_t *other) {
+    return entry->version_size == other->version_size
+           && !memcmp(entry_version(entry), entry_version(other),
+                      entry->version_size);
+}
+
+static void entry_destroy(avs_crypto_pki_cache_entry_t *entry) {
+    assert(!entry->refcount);
+    entry->free_cb(entry->object);
+    avs_free(entry);
+}
+
+/**
+ * Removes @p *entry_ptr from the index, and drops the reference held by it.
+ * Entries with no more references are moved onto @p garbage, so that they can
+ * be destroyed after unlocking the cache. Shall be called with the cache
+ * locked.
+ */
+static void unindex_entry(avs_crypto_pki_cache_entry_t **entry_ptr,
+                          avs_crypto_pki_cache_entry_t **garbage) {
+    avs_crypto_pki_cache_entry_t *entry = *entry_ptr;
+    assert(entry->indexed);
+    *entry_ptr = entry->next;
+    entry->next = NULL;
+    entry->indexed = false;
+    --g_cache.entry_count;
+    if (!--entry->refcount) {
+        entry->next = *garbage;
+        *garbage = entry;
+    }
+}
+
+static void destroy_garbage(avs_crypto_pki_cache_entry_t *garbage) {
+    while (garbage) {
+        avs_crypto_pki_cache_entry_t *next = garbage->next;
+        entry_destroy(garbage);
+        garbage = next;
+    }
+}
+
+static avs_crypto_pki_cache_entry_t **
+find_entry_locked(const avs_crypto_pki_cache_entry_t *ref) {
+    avs_crypto_pki_cache_entry_t **entry_ptr = &g_cache.entries;
+    while (*entry_ptr && !entry_identity_equal(*entry_ptr, ref)) {
+        entry_ptr = &(*entry_ptr)->next;
+    }
+    return entry_ptr;
+}
+
+/**
+ * Looks up an entry with the same key as @p ref. If an up-to-date one exists,
+ * a new reference to it is returned. Otherwise, stale entries for the same
+ * source are dropped, and @p candidate is inserted into the index, if not
+ * NULL. Shall be called with the cache locked.
+ */
+static avs_crypto_pki_cache_entry_t *
+lookup_or_insert_locked(const avs_crypto_pki_cache_entry_t *ref,
+                        avs_crypto_pki_cache_entry_t *candidate,
+                        avs_crypto_pki_cache_entry_t **garbage) {
+    avs_crypto_pki_cache_entry_t **entry_ptr = find_entry_locked(ref);
+    if (*entry_ptr) {
+        avs_crypto_pki_cache_entry_t *entry = *entry_ptr;
+        if (entry_version_equal(entry, ref)) {
+            // move to front
+            *entry_ptr = entry->next;
+            entry->next = g_cache.entries;
+            g_cache.entries = entry;
+            ++entry->refcount;
+            return entry;
+        }
+        LOG(DEBUG, _("source modified, dropping cached entry"));
+        unindex_entry(entry_ptr, garbage);
+    }
+    if (candidate) {
+        candidate->next = g_cache.entries;
+        candidate->indexed = true;
+        ++candidate->refcount;
+        g_cache.entries = candidate;
+        if (++g_cache.entry_count > AVS_CRYPTO_PKI_CACHE_MAX_ENTRIES) {
+            avs_crypto_pki_cache_entry_t **last_ptr = &g_cache.entries;
+            while ((*last_ptr)->next) {
+                last_ptr = &(*last_ptr)->next;
+            }
+            unindex_entry(last_ptr, garbage);
+        }
+    }
+    return candidate;
+}
+
+static avs_crypto_pki_cache_entry_t *
+entry_new(const cache_key_t *key,
+          avs_crypto_security_info_tag_t type,
+          avs_crypto_pki_cache_free_t *free_cb) {
+    avs_crypto_pki_cache_entry_t *entry = (avs_crypto_pki_cache_entry_t *)
+            avs_calloc(1, sizeof(*entry) + key->identity.size
+                                  + key->version.size);
+    if (!entry) {
+        LOG_OOM();
+        return NULL;
+    }
+    entry->refcount = 1;
+    entry->type = type;
+    entry->free_cb = free_cb;
+    entry->identity_size = key->identity.size;
+    entry->version_size = key->version.size;
+    if (key->identity.size) {
+        memcpy(entry->key, key->identity.data, key->identity.size);
+    }
+    if (key->version.size) {
+        memcpy(entry->key + key->identity.size, key->version.data,
+               key->version.size);
+    }
+    return entry;
+}
+
+avs_error_t
+_avs_crypto_pki_cache_get(avs_crypto_pki_cache_entry_t **out_entry,
+                          const avs_crypto_security_info_union_t *desc,
+                          avs_crypto_pki_cache_load_t *load_cb,
+                          avs_crypto_pki_cache_free_t *free_cb,
+                          void *load_cb_arg) {
+    assert(out_entry && !*out_entry);
+    assert(desc);
+    cache_key_t key;
+    avs_error_t err = build_key(&key, desc, true);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    avs_crypto_pki_cache_entry_t *entry = entry_new(&key, desc->type, free_cb);
+    if (!entry) {
+        cache_key_cleanup(&key);
+        return avs_errno(AVS_ENOMEM);
+    }
+    if (cache_lock()) {
+        cache_key_cleanup(&key);
+        avs_free(entry);
+        return avs_errno(AVS_ENOMEM);
+    }
+
+    avs_crypto_pki_cache_entry_t *garbage = NULL;
+    if (key.cacheable) {
+        *out_entry = lookup_or_insert_locked(entry, NULL, &garbage);
+    }
+    cache_unlock();
+    destroy_garbage(garbage);
+
+    if (*out_entry) {
+        LOG(TRACE, _("using cached entry"));
+        cache_key_cleanup(&key);
+        avs_free(entry);
+        return AVS_OK;
+    }
+
+    // Load without holding the lock, parsing may take a long time
+    if (avs_is_err((err = load_cb(&entry->object, desc, load_cb_arg)))) {
+        cache_key_cleanup(&key);
+        avs_free(entry);
+        return err;
+    }
+
+    if (key.cacheable) {
+        garbage = NULL;
+        // cache_lock() succeeded before, so avs_init_once() won't fail now
+        cache_lock();
+        *out_entry = lookup_or_insert_locked(entry, entry, &garbage);
+        cache_unlock();
+        if (*out_entry != entry) {
+            // another thread loaded the same data in the meantime
+            --entry->refcount;
+            entry->next = garbage;
+            garbage = entry;
+        }
+        destroy_garbage(garbage);
+    } else {
+        *out_entry = entry;
+    }
+    cache_key_cleanup(&key);
+    return AVS_OK;
+}
+
+void *_avs_crypto_pki_cache_object(const avs_crypto_pki_cache_entry_t *entry) {
+    assert(entry);
+    return entry->object;
+}
+
+void _avs_crypto_pki_cache_release(avs_crypto_pki_cache_entry_t **entry_ptr) {
+    if (!entry_ptr || !*entry_ptr) {
+        return;
+    }
+    // the entry could only be created if the global state is initialized
+    cache_lock();
+    bool last_reference = !--(*entry_ptr)->refcount;
+    cache_unlock();
+    if (last_reference) {
+        entry_destroy(*entry_ptr);
+    }
+    *entry_ptr = NULL;
+}
+
+static bool identity_contains_record(const char *identity,
+                                     size_t identity_size,
+                                     const char *record,
+                                     size_t record_size) {
+    size_t offset = 0;
+    while (offset < identity_size) {
+        size_t size;
+        memcpy(&size, identity + offset, sizeof(size));
+        if (size + sizeof(size) == record_size
+                && !memcmp(identity + offset, record, record_size)) {
+            return true;
+        }
+        offset += sizeof(size) + size;
+    }
+    return false;
+}
+
+static bool entry_references_any(const avs_crypto_pki_cache_entry_t *entry,
+                                 const cache_key_t *key) {
+    size_t offset = 0;
+    while (offset < key->identity.size) {
+        size_t size;
+        memcpy(&size, key->identity.data + offset, sizeof(size));
+        if (identity_contains_record(entry->key, entry->identity_size,
+                                     key->identity.data + offset,
+                                     sizeof(size) + size)) {
+            return true;
+        }
+        offset += sizeof(size) + size;
+    }
+    return false;
+}
+
+static void invalidate(const cache_key_t *key) {
+    if (cache_lock()) {
+        return;
+    }
+    avs_crypto_pki_cache_entry_t *garbage = NULL;
+    avs_crypto_pki_cache_entry_t **entry_ptr = &g_cache.entries;
+    while (*entry_ptr) {
+        if (!key || entry_references_any(*entry_ptr, key)) {
+            unindex_entry(entry_ptr, &garbage);
+        } else {
+            entry_ptr = &(*entry_ptr)->next;
+        }
+    }
+    cache_unlock();
+    destroy_garbage(garbage);
+}
+
+static void invalidate_source(const avs_crypto_security_info_union_t *desc) {
+    cache_key_t key;
+    if (avs_is_ok(build_key(&key, desc, false))) {
+        invalidate(&key);
+        cache_key_cleanup(&key);
+    }
+}
+
+void avs_crypto_pki_cache_invalidate_certificate_chain(
+        const avs_crypto_certificate_chain_info_t *info) {
+    if (info) {
+        invalidate_source(&info->desc);
+    }
+}
+
+void avs_crypto_pki_cache_invalidate_cert_revocation_list(
+        const avs_crypto_cert_revocation_list_info_t *info) {
+    if (info) {
+        invalidate_source(&info->desc);
+    }
+}
+
+void avs_crypto_pki_cache_invalidate_all(void) {
+    invalidate(NULL);
+}
+
+void _avs_crypto_pki_cache_cleanup_global_state(void) {
+    if (g_cache.mutex) {
+        invalidate(NULL);
+        avs_mutex_cleanup(&g_cache.mutex);
+    }
+    g_cache_init_handle = NULL;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_CRYPTO) &&
+       // defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI) &&
+       // defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE) &&
+       // !defined(AVS_COMMONS_WITHOUT_TLS)
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_CRYPTO_PKI_CACHE_H
+#define AVS_COMMONS_CRYPTO_PKI_CACHE_H
+
+#include <avsystem/commons/avs_crypto_pki.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Maximum number of entries kept in the process-wide cache of parsed
+ * certificate chains and CRLs. When exceeded, least recently used entries are
+ * dropped from the cache; objects still referenced by their users stay alive
+ * until released.
+ */
+#define AVS_CRYPTO_PKI_CACHE_MAX_ENTRIES 32
+
+typedef struct avs_crypto_pki_cache_entry_struct avs_crypto_pki_cache_entry_t;
+
+/**
+ * Loads the backend-specific parsed representation of @p desc into
+ * @p *out_object. Called without any locks held.
+ */
+typedef avs_error_t
+avs_crypto_pki_cache_load_t(void **out_object,
+                            const avs_crypto_security_info_union_t *desc,
+                            void *arg);
+
+/**
+ * Frees an object previously created by @ref avs_crypto_pki_cache_load_t.
+ */
+typedef void avs_crypto_pki_cache_free_t(void *object);
+
+/**
+ * Retrieves the parsed objects loaded from @p desc from the cache, calling
+ * @p load_cb to load them if they are not there yet, or if the source changed
+ * since they have been loaded (file or directory status change, different
+ * buffer contents). Entries for buffer sources hold a full copy of the buffer
+ * contents, used to detect such changes.
+ *
+ * Sources that cannot be reliably identified (e.g. files on platforms without
+ * <c>stat()</c>) are loaded each time, into an entry that is not shared.
+ *
+ * @param out_entry Pointer to a variable that will be set to a new reference
+ *                  to the cache entry. It MUST be released using
+ *                  @ref _avs_crypto_pki_cache_release after use. The object
+ *                  itself can be accessed using
+ *                  @ref _avs_crypto_pki_cache_object, and MUST NOT be
+ *                  modified.
+ */
+avs_error_t
+_avs_crypto_pki_cache_get(avs_crypto_pki_cache_entry_t **out_entry,
+                          const avs_crypto_security_info_union_t *desc,
+                          avs_crypto_pki_cache_load_t *load_cb,
+                          avs_crypto_pki_cache_free_t *free_cb,
+                          void *load_cb_arg);
+
+void *_avs_crypto_pki_cache_object(const avs_crypto_pki_cache_entry_t *entry);
+
+void _avs_crypto_pki_cache_release(avs_crypto_pki_cache_entry_t **entry_ptr);
+
+void _avs_crypto_pki_cache_cleanup_global_state(void);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // AVS_COMMONS_CRYPTO_PKI_CACHE_H
@@ -409,6 +409,90 @@ avs_error_t _avs_crypto_mbedtls_load_crls(
     return err;
 }
 
+#        ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+static avs_error_t
+load_certs_for_cache(void **out_chain,
+                     const avs_crypto_security_info_union_t *desc,
+                     void *unused) {
+    (void) unused;
+    mbedtls_x509_crt *chain = NULL;
+    avs_error_t err = _avs_crypto_mbedtls_load_certs(
+            &chain, AVS_CONTAINER_OF(desc,
+                                     const avs_crypto_certificate_chain_info_t,
+                                     desc));
+    if (avs_is_ok(err)) {
+        *out_chain = chain;
+    }
+    return err;
+}
+
+static void free_cached_certs(void *chain_) {
+    mbedtls_x509_crt *chain = (mbedtls_x509_crt *) chain_;
+    _avs_crypto_mbedtls_x509_crt_cleanup(&chain);
+}
+
+avs_error_t _avs_crypto_mbedtls_load_certs_cached(
+        avs_crypto_pki_cache_entry_t **out_entry,
+        mbedtls_x509_crt **out,
+        const avs_crypto_certificate_chain_info_t *info) {
+    if (info == NULL) {
+        LOG(ERROR, _("Given cert info is empty."));
+        return avs_errno(AVS_EINVAL);
+    }
+
+    assert(!*out_entry);
+    assert(!*out);
+    avs_error_t err = _avs_crypto_pki_cache_get(
+            out_entry, &info->desc, load_certs_for_cache, free_cached_certs,
+            NULL);
+    if (avs_is_ok(err)) {
+        *out = (mbedtls_x509_crt *) _avs_crypto_pki_cache_object(*out_entry);
+    }
+    return err;
+}
+
+static avs_error_t
+load_crls_for_cache(void **out_crl,
+                    const avs_crypto_security_info_union_t *desc,
+                    void *unused) {
+    (void) unused;
+    mbedtls_x509_crl *crl = NULL;
+    avs_error_t err = _avs_crypto_mbedtls_load_crls(
+            &crl,
+            AVS_CONTAINER_OF(desc, const avs_crypto_cert_revocation_list_info_t,
+                             desc));
+    if (avs_is_ok(err)) {
+        *out_crl = crl;
+    }
+    return err;
+}
+
+static void free_cached_crls(void *crl_) {
+    mbedtls_x509_crl *crl = (mbedtls_x509_crl *) crl_;
+    _avs_crypto_mbedtls_x509_crl_cleanup(&crl);
+}
+
+avs_error_t _avs_crypto_mbedtls_load_crls_cached(
+        avs_crypto_pki_cache_entry_t **out_entry,
+        mbedtls_x509_crl **out,
+        const avs_crypto_cert_revocation_list_info_t *info) {
+    if (info == NULL) {
+        LOG(ERROR, _("Given CRL info is empty."));
+        return avs_errno(AVS_EINVAL);
+    }
+
+    assert(!*out_entry);
+    assert(!*out);
+    avs_error_t err = _avs_crypto_pki_cache_get(
+            out_entry, &info->desc, load_crls_for_cache, free_cached_crls,
+            NULL);
+    if (avs_is_ok(err)) {
+        *out = (mbedtls_x509_crl *) _avs_crypto_pki_cache_object(*out_entry);
+    }
+    return err;
+}
+#        endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+
 static avs_error_t
 load_private_key_from_buffer(mbedtls_pk_context *client_key,
                              const void *buffer,
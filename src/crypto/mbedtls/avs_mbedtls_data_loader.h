@@ -28,6 +28,10 @@
 
 #include "../avs_crypto_utils.h"
 
+#ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+#    include "../avs_crypto_pki_cache.h"
+#endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 #ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
@@ -44,6 +48,25 @@ avs_error_t _avs_crypto_mbedtls_load_crls(
         mbedtls_x509_crl **out,
         const avs_crypto_cert_revocation_list_info_t *info);
 
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+/**
+ * Variants of @ref _avs_crypto_mbedtls_load_certs and
+ * @ref _avs_crypto_mbedtls_load_crls that borrow the parsed objects from the
+ * process-wide cache. The objects MUST NOT be modified, and MUST NOT be
+ * accessed after releasing @p *out_entry using
+ * @ref _avs_crypto_pki_cache_release.
+ */
+avs_error_t _avs_crypto_mbedtls_load_certs_cached(
+        avs_crypto_pki_cache_entry_t **out_entry,
+        mbedtls_x509_crt **out,
+        const avs_crypto_certificate_chain_info_t *info);
+
+avs_error_t _avs_crypto_mbedtls_load_crls_cached(
+        avs_crypto_pki_cache_entry_t **out_entry,
+        mbedtls_x509_crl **out,
+        const avs_crypto_cert_revocation_list_info_t *info);
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+
 void _avs_crypto_mbedtls_pk_context_cleanup(mbedtls_pk_context **ctx);
 
 avs_error_t
@@ -66,6 +66,8 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
         CRYPTO_add(&(Key)->references, 1, CRYPTO_LOCK_EVP_PKEY)
 #    define X509_up_ref(Cert) \
         CRYPTO_add(&(Cert)->references, 1, CRYPTO_LOCK_X509)
+#    define X509_CRL_up_ref(Crl) \
+        CRYPTO_add(&(Crl)->references, 1, CRYPTO_LOCK_X509_CRL)
 #endif
 
 VISIBILITY_PRIVATE_HEADER_END
@@ -34,6 +34,9 @@
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_ENGINE
 
 #    include "../avs_crypto_global.h"
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+#        include "../avs_crypto_pki_cache.h"
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
 
 #    include <assert.h>
 #    include <stdio.h>
@@ -223,12 +226,108 @@ static avs_error_t load_crl_cb(void *crl, void *store) {
     return AVS_OK;
 }
 
+#    ifndef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
 static avs_error_t
 load_crls_from_buffer(X509_STORE *store, const void *buffer, size_t len) {
     return load_pem_or_der_objects(buffer, len, NULL, AVS_OSSL_OBJECT_X509_CRL,
                                    load_crl_cb, store);
 }
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
 
+#    if defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE) \
+            && defined(AVS_COMMONS_STREAM_WITH_FILE)
+#        define WITH_CRL_FILE_CACHE
+
+static avs_error_t load_file_into_buffer(void **out_buf,
+                                         size_t *out_buf_size,
+                                         const char *filename);
+#    endif /* defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE) && \
+              defined(AVS_COMMONS_STREAM_WITH_FILE) */
+
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+static avs_error_t push_crl_to_stack(void *crl, void *stack) {
+    if (!X509_CRL_up_ref((X509_CRL *) crl)) {
+        log_openssl_error();
+        return avs_errno(AVS_ENOMEM);
+    }
+    if (!sk_X509_CRL_push((STACK_OF(X509_CRL) *) stack, (X509_CRL *) crl)) {
+        X509_CRL_free((X509_CRL *) crl);
+        log_openssl_error();
+        return avs_errno(AVS_ENOMEM);
+    }
+    return AVS_OK;
+}
+
+static void free_crl_stack(void *stack) {
+    sk_X509_CRL_pop_free((STACK_OF(X509_CRL) *) stack, X509_CRL_free);
+}
+
+static avs_error_t
+load_crls_to_stack(void **out_stack,
+                   const avs_crypto_security_info_union_t *desc,
+                   void *unused) {
+    (void) unused;
+    STACK_OF(X509_CRL) *stack = sk_X509_CRL_new_null();
+    if (!stack) {
+        log_openssl_error();
+        return avs_errno(AVS_ENOMEM);
+    }
+    avs_error_t err;
+    switch (desc->source) {
+#        ifdef WITH_CRL_FILE_CACHE
+    case AVS_CRYPTO_DATA_SOURCE_FILE: {
+        LOG(DEBUG, _("CRL <file=") "%s" _(">: going to load"),
+            desc->info.file.filename);
+        void *buffer = NULL;
+        size_t buffer_size = 0;
+        (void) (avs_is_err((err = load_file_into_buffer(
+                                    &buffer, &buffer_size,
+                                    desc->info.file.filename)))
+                || avs_is_err((err = load_pem_or_der_objects(
+                                       buffer, buffer_size, NULL,
+                                       AVS_OSSL_OBJECT_X509_CRL,
+                                       push_crl_to_stack, stack))));
+        avs_free(buffer);
+        break;
+    }
+#        endif // WITH_CRL_FILE_CACHE
+    case AVS_CRYPTO_DATA_SOURCE_BUFFER:
+        err = load_pem_or_der_objects(desc->info.buffer.buffer,
+                                      desc->info.buffer.buffer_size, NULL,
+                                      AVS_OSSL_OBJECT_X509_CRL,
+                                      push_crl_to_stack, stack);
+        break;
+    default:
+        AVS_UNREACHABLE("invalid data source");
+        err = avs_errno(AVS_EINVAL);
+    }
+    if (avs_is_err(err)) {
+        free_crl_stack(stack);
+    } else {
+        *out_stack = stack;
+    }
+    return err;
+}
+
+static avs_error_t
+load_crls_cached(X509_STORE *store,
+                 const avs_crypto_cert_revocation_list_info_t *info) {
+    avs_crypto_pki_cache_entry_t *entry = NULL;
+    avs_error_t err = _avs_crypto_pki_cache_get(
+            &entry, &info->desc, load_crls_to_stack, free_crl_stack, NULL);
+    if (avs_is_ok(err)) {
+        STACK_OF(X509_CRL) *crls =
+                (STACK_OF(X509_CRL) *) _avs_crypto_pki_cache_object(entry);
+        for (int i = 0; avs_is_ok(err) && i < sk_X509_CRL_num(crls); ++i) {
+            err = load_crl_cb(sk_X509_CRL_value(crls, i), store);
+        }
+        _avs_crypto_pki_cache_release(&entry);
+    }
+    return err;
+}
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+
+#    ifndef WITH_CRL_FILE_CACHE
 static avs_error_t load_crl_from_file(X509_STORE *store, const char *file) {
     assert(file);
     LOG(DEBUG, _("CRL <file=") "%s" _(">: going to load"), file);
@@ -244,6 +343,7 @@ static avs_error_t load_crl_from_file(X509_STORE *store, const char *file) {
     log_openssl_error();
     return avs_errno(AVS_EPROTO);
 }
+#    endif // WITH_CRL_FILE_CACHE
 
 avs_error_t _avs_crypto_openssl_load_crls(
         X509_STORE *store, const avs_crypto_cert_revocation_list_info_t *info) {
@@ -273,7 +373,11 @@ avs_error_t _avs_crypto_openssl_load_crls(
             LOG(ERROR, _("attempt to load CRL from file, but filename=NULL"));
             return avs_errno(AVS_EINVAL);
         }
+#    ifdef WITH_CRL_FILE_CACHE
+        return load_crls_cached(store, info);
+#    else  // WITH_CRL_FILE_CACHE
         return load_crl_from_file(store, info->desc.info.file.filename);
+#    endif // WITH_CRL_FILE_CACHE
     case AVS_CRYPTO_DATA_SOURCE_PATH:
         LOG(ERROR, _("CRL cannot be loaded from path"));
         return avs_errno(AVS_EINVAL);
@@ -282,8 +386,12 @@ avs_error_t _avs_crypto_openssl_load_crls(
             LOG(ERROR, _("attempt to load CRL from buffer, but buffer=NULL"));
             return avs_errno(AVS_EINVAL);
         }
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+        return load_crls_cached(store, info);
+#    else  // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
         return load_crls_from_buffer(store, info->desc.info.buffer.buffer,
                                      info->desc.info.buffer.buffer_size);
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
     case AVS_CRYPTO_DATA_SOURCE_ARRAY: {
         avs_error_t err = AVS_OK;
         for (size_t i = 0;
@@ -522,9 +630,8 @@ typedef struct {
 } load_certs_cb_info_t;
 
 static avs_error_t
-pass_cert_to_cb(void *cb_info_,
-                const avs_crypto_certificate_chain_info_t *info) {
-    load_certs_cb_info_t *cb_info = (load_certs_cb_info_t *) cb_info_;
+load_certs_from_source(const load_certs_cb_info_t *cb_info,
+                       const avs_crypto_certificate_chain_info_t *info) {
     switch (info->desc.source) {
 #    if defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_ENGINE)
     case AVS_CRYPTO_DATA_SOURCE_ENGINE:
@@ -570,6 +677,75 @@ pass_cert_to_cb(void *cb_info_,
     }
 }
 
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+static avs_error_t push_cert_to_stack(void *cert, void *stack) {
+    if (!X509_up_ref((X509 *) cert)) {
+        log_openssl_error();
+        return avs_errno(AVS_ENOMEM);
+    }
+    if (!sk_X509_push((STACK_OF(X509) *) stack, (X509 *) cert)) {
+        X509_free((X509 *) cert);
+        log_openssl_error();
+        return avs_errno(AVS_ENOMEM);
+    }
+    return AVS_OK;
+}
+
+static void free_cert_stack(void *stack) {
+    sk_X509_pop_free((STACK_OF(X509) *) stack, X509_free);
+}
+
+static avs_error_t
+load_certs_to_stack(void **out_stack,
+                    const avs_crypto_security_info_union_t *desc,
+                    void *unused) {
+    (void) unused;
+    STACK_OF(X509) *stack = sk_X509_new_null();
+    if (!stack) {
+        log_openssl_error();
+        return avs_errno(AVS_ENOMEM);
+    }
+    avs_error_t err = load_certs_from_source(
+            &(const load_certs_cb_info_t) {
+                .cb = push_cert_to_stack,
+                .cb_arg = stack
+            },
+            AVS_CONTAINER_OF(desc, const avs_crypto_certificate_chain_info_t,
+                             desc));
+    if (avs_is_err(err)) {
+        free_cert_stack(stack);
+    } else {
+        *out_stack = stack;
+    }
+    return err;
+}
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+
+static avs_error_t
+pass_cert_to_cb(void *cb_info_,
+                const avs_crypto_certificate_chain_info_t *info) {
+    const load_certs_cb_info_t *cb_info =
+            (const load_certs_cb_info_t *) cb_info_;
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    // Parsed certificates are immutable and reference-counted, so they can be
+    // passed from the cache to all the users directly.
+    avs_crypto_pki_cache_entry_t *entry = NULL;
+    avs_error_t err = _avs_crypto_pki_cache_get(
+            &entry, &info->desc, load_certs_to_stack, free_cert_stack, NULL);
+    if (avs_is_ok(err)) {
+        STACK_OF(X509) *certs =
+                (STACK_OF(X509) *) _avs_crypto_pki_cache_object(entry);
+        for (int i = 0; avs_is_ok(err) && i < sk_X509_num(certs); ++i) {
+            err = cb_info->cb(sk_X509_value(certs, i), cb_info->cb_arg);
+        }
+        _avs_crypto_pki_cache_release(&entry);
+    }
+    return err;
+#    else  // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    return load_certs_from_source(cb_info, info);
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+}
+
 avs_error_t _avs_crypto_openssl_load_client_certs(
         const avs_crypto_certificate_chain_info_t *info,
         avs_crypto_ossl_object_load_t *load_cb,
@@ -228,6 +228,18 @@ http_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
     return avs_stream_peek(stream->body_receiver, offset, out_value);
 }
 
+static avs_error_t http_peek_window(avs_stream_t *stream_,
+                                    size_t offset,
+                                    const char **out_data,
+                                    size_t *out_length) {
+    http_stream_t *stream = (http_stream_t *) stream_;
+    if (!stream->body_receiver) {
+        return AVS_EOF;
+    }
+    return avs_stream_peek_window(stream->body_receiver, offset, out_data,
+                                  out_length);
+}
+
 static avs_error_t http_reset(avs_stream_t *stream_) {
     http_stream_t *stream = (http_stream_t *) stream_;
     LOG(TRACE, _("http_reset"));
@@ -309,6 +321,9 @@ static const avs_stream_v_table_t http_vtable = {
               &(avs_stream_v_table_extension_nonblock_t[]){
                       { http_nonblock_read_ready,
                         http_nonblock_write_ready } }[0] },
+            { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+              &(avs_stream_v_table_extension_read_window_t[]){
+                      { http_peek_window } }[0] },
             AVS_STREAM_V_TABLE_EXTENSION_NULL }[0]
 };
 
@@ -175,9 +175,15 @@ static avs_error_t read_chunk_size_getline_peeker(void *state_,
                                &state->offset, buffer, buffer_length);
 }
 
-static avs_error_t
-chunked_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
-    chunked_receiver_t *stream = (chunked_receiver_t *) stream_;
+/**
+ * Translates @p offset within the decoded body into an offset within the
+ * backend stream, peeking through any chunk headers in between. Also reports
+ * the number of body bytes remaining in the chunk that contains that offset.
+ */
+static avs_error_t locate_in_backend(chunked_receiver_t *stream,
+                                     size_t offset,
+                                     size_t *out_backend_offset,
+                                     size_t *out_chunk_left) {
     if (stream->finished) {
         return AVS_EOF;
     }
@@ -198,8 +204,40 @@ chunked_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
             return AVS_EOF;
         }
     }
-    offset += state.offset;
-    return avs_stream_peek(stream->backend, offset, out_value);
+    *out_backend_offset = state.offset + offset;
+    *out_chunk_left = chunk_left - offset;
+    return AVS_OK;
+}
+
+static avs_error_t
+chunked_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
+    chunked_receiver_t *stream = (chunked_receiver_t *) stream_;
+    size_t backend_offset;
+    size_t chunk_left;
+    avs_error_t err =
+            locate_in_backend(stream, offset, &backend_offset, &chunk_left);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    return avs_stream_peek(stream->backend, backend_offset, out_value);
+}
+
+static avs_error_t chunked_peek_window(avs_stream_t *stream_,
+                                       size_t offset,
+                                       const char **out_data,
+                                       size_t *out_length) {
+    chunked_receiver_t *stream = (chunked_receiver_t *) stream_;
+    size_t backend_offset;
+    size_t chunk_left;
+    avs_error_t err =
+            locate_in_backend(stream, offset, &backend_offset, &chunk_left);
+    if (avs_is_ok(err)
+            && avs_is_ok((err = avs_stream_peek_window(stream->backend,
+                                                       backend_offset, out_data,
+                                                       out_length)))) {
+        *out_length = AVS_MIN(*out_length, chunk_left);
+    }
+    return err;
 }
 
 static avs_error_t chunked_close(avs_stream_t *stream_) {
@@ -220,6 +258,9 @@ static const avs_stream_v_table_t chunked_receiver_vtable = {
                               .read_ready = chunked_nonblock_read_ready
                           }
                       }[0] },
+            { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+              &(avs_stream_v_table_extension_read_window_t[]){
+                      { chunked_peek_window } }[0] },
             AVS_STREAM_V_TABLE_EXTENSION_NULL }[0]
 };
 
@@ -82,6 +82,22 @@ content_length_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
     }
 }
 
+static avs_error_t content_length_peek_window(avs_stream_t *stream_,
+                                              size_t offset,
+                                              const char **out_data,
+                                              size_t *out_length) {
+    content_length_receiver_t *stream = (content_length_receiver_t *) stream_;
+    if (offset >= stream->content_left) {
+        return AVS_EOF;
+    }
+    avs_error_t err = avs_stream_peek_window(stream->backend, offset, out_data,
+                                             out_length);
+    if (avs_is_ok(err)) {
+        *out_length = AVS_MIN(*out_length, stream->content_left - offset);
+    }
+    return err;
+}
+
 static avs_error_t content_length_close(avs_stream_t *stream_) {
     content_length_receiver_t *stream = (content_length_receiver_t *) stream_;
     avs_stream_net_setsock(stream->backend, NULL); /* don't close the socket */
@@ -100,6 +116,9 @@ static const avs_stream_v_table_t content_length_receiver_vtable = {
                               .read_ready = content_length_nonblock_read_ready
                           }
                       }[0] },
+            { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+              &(avs_stream_v_table_extension_read_window_t[]){
+                      { content_length_peek_window } }[0] },
             AVS_STREAM_V_TABLE_EXTENSION_NULL }[0]
 };
 
@@ -53,6 +53,14 @@ dumb_proxy_peek(avs_stream_t *stream, size_t offset, char *out_value) {
                            out_value);
 }
 
+static avs_error_t dumb_proxy_peek_window(avs_stream_t *stream,
+                                          size_t offset,
+                                          const char **out_data,
+                                          size_t *out_length) {
+    return avs_stream_peek_window(((dumb_proxy_receiver_t *) stream)->backend,
+                                  offset, out_data, out_length);
+}
+
 static avs_error_t dumb_close(avs_stream_t *stream_) {
     dumb_proxy_receiver_t *stream = (dumb_proxy_receiver_t *) stream_;
     avs_stream_net_setsock(stream->backend, NULL); /* don't close the socket */
@@ -71,6 +79,9 @@ static const avs_stream_v_table_t dumb_body_receiver_vtable = {
                               .read_ready = dumb_proxy_nonblock_read_ready
                           }
                       }[0] },
+            { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+              &(avs_stream_v_table_extension_read_window_t[]){
+                      { dumb_proxy_peek_window } }[0] },
             AVS_STREAM_V_TABLE_EXTENSION_NULL }[0]
 };
 
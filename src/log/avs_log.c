@@ -27,11 +27,20 @@
 #    include <avsystem/commons/avs_list.h>
 #    include <avsystem/commons/avs_log.h>
 
+#    include "avs_log_private.h"
+
 #    ifdef AVS_COMMONS_WITH_AVS_COMPAT_THREADING
 #        include <avsystem/commons/avs_init_once.h>
 #        include <avsystem/commons/avs_mutex.h>
 #    endif // AVS_COMMONS_WITH_AVS_COMPAT_THREADING
 
+#    if defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) \
+            && defined(AVS_COMMONS_HAVE_C11_STDATOMIC)  \
+            && !defined(AVS_COMMONS_WITHOUT_LOG_CHECK_IN_RUNTIME)
+#        define AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+#        include <stdatomic.h>
+#    endif
+
 VISIBILITY_SOURCE_BEGIN
 
 static void default_log_handler(avs_log_level_t level,
@@ -53,12 +62,59 @@ typedef struct {
 } module_level_t;
 #    endif /* AVS_COMMONS_WITHOUT_LOG_CHECK_IN_RUNTIME */
 
+#    ifdef AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+/**
+ * Immutable copy of the level configuration, used by avs_log_should_log__()
+ * without locking g_log_mutex. The module entries are sorted by name; the
+ * names themselves are stored right after the array.
+ */
+typedef struct {
+    avs_log_level_t default_level;
+    size_t module_count;
+    struct {
+        avs_log_level_t level;
+        const char *module;
+    } modules[];
+} level_snapshot_t;
+
+static struct {
+    /**
+     * Lowest of the default level and all module levels - anything below it
+     * is never logged, regardless of the module.
+     */
+    atomic_int min_level;
+
+    /** Currently published snapshot, as a level_snapshot_t pointer. */
+    atomic_uintptr_t snapshot;
+
+    /** Number of avs_log_should_log__() calls currently reading a snapshot. */
+    atomic_size_t readers;
+
+    /**
+     * Previously published snapshots that might still be in use by readers.
+     * Guarded by g_log_mutex.
+     */
+    AVS_LIST(level_snapshot_t) retired;
+} g_levels;
+#    endif // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+
+typedef enum {
+    LOG_HANDLER_NORMAL,
+    LOG_HANDLER_EXTENDED,
+#    ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+    LOG_HANDLER_STRUCTURED
+#    endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+} log_handler_type_t;
+
 static struct {
     union {
         avs_log_handler_t *normal;
         avs_log_extended_handler_t *extended;
+#    ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+        avs_log_structured_handler_t *structured;
+#    endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
     } handler;
-    bool is_extended_handler;
+    log_handler_type_t handler_type;
 #    ifndef AVS_COMMONS_WITHOUT_LOG_CHECK_IN_RUNTIME
     avs_log_level_t default_level;
     AVS_LIST(module_level_t) module_levels;
@@ -74,13 +130,36 @@ static struct {
 #    endif /* AVS_COMMONS_WITHOUT_LOG_CHECK_IN_RUNTIME */
 };
 
+#    ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+#        define is_structured_handler() \
+            (g_log.handler_type == LOG_HANDLER_STRUCTURED)
+#    else // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+#        define is_structured_handler() false
+#    endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+
 #    ifdef AVS_COMMONS_WITH_AVS_COMPAT_THREADING
 static avs_mutex_t *g_log_mutex;
 static avs_init_once_handle_t g_log_init_handle;
 
+#        ifdef AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+static void cleanup_levels(void) {
+    AVS_LIST(level_snapshot_t) snapshot = (AVS_LIST(level_snapshot_t))
+            atomic_exchange(&g_levels.snapshot, (uintptr_t) NULL);
+    atomic_store(&g_levels.min_level, (int) AVS_LOG_TRACE);
+    AVS_LIST_DELETE(&snapshot);
+    AVS_LIST_CLEAR(&g_levels.retired);
+}
+#        endif // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+
 void _avs_log_cleanup_global_state(void);
 void _avs_log_cleanup_global_state(void) {
+#        ifdef AVS_COMMONS_LOG_WITH_ASYNC
+    avs_log_async_disable();
+#        endif // AVS_COMMONS_LOG_WITH_ASYNC
     avs_log_reset();
+#        ifdef AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+    cleanup_levels();
+#        endif // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
     avs_mutex_cleanup(&g_log_mutex);
     g_log_init_handle = NULL;
 }
@@ -133,7 +212,7 @@ static int _log_lock(const char *file, unsigned line, ...) {
 
 static inline void set_log_handler_unlocked(avs_log_handler_t *log_handler) {
     g_log.handler.normal = (log_handler ? log_handler : default_log_handler);
-    g_log.is_extended_handler = false;
+    g_log.handler_type = LOG_HANDLER_NORMAL;
 }
 
 void avs_log_set_handler(avs_log_handler_t *log_handler) {
@@ -148,10 +227,9 @@ static inline void
 set_log_extended_handler_unlocked(avs_log_extended_handler_t *log_handler) {
     if (log_handler) {
         g_log.handler.extended = log_handler;
-        g_log.is_extended_handler = true;
+        g_log.handler_type = LOG_HANDLER_EXTENDED;
     } else {
-        g_log.handler.normal = default_log_handler;
-        g_log.is_extended_handler = false;
+        set_log_handler_unlocked(default_log_handler);
     }
 }
 
@@ -163,6 +241,21 @@ void avs_log_set_extended_handler(avs_log_extended_handler_t *log_handler) {
     LOG_UNLOCK();
 }
 
+#    ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+void avs_log_set_structured_handler(avs_log_structured_handler_t *log_handler) {
+    if (LOG_LOCK()) {
+        return;
+    }
+    if (log_handler) {
+        g_log.handler.structured = log_handler;
+        g_log.handler_type = LOG_HANDLER_STRUCTURED;
+    } else {
+        set_log_handler_unlocked(default_log_handler);
+    }
+    LOG_UNLOCK();
+}
+#    endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+
 #    ifndef AVS_COMMONS_WITHOUT_LOG_CHECK_IN_RUNTIME
 static avs_log_level_t *level_for(const char *module, int create) {
     if (module) {
@@ -193,6 +286,87 @@ static avs_log_level_t *level_for(const char *module, int create) {
     return &g_log.default_level;
 }
 
+#        ifdef AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+/**
+ * Publishes the current state of g_log.default_level and g_log.module_levels
+ * for use by lockless readers. Shall be called with g_log_mutex locked after
+ * every change to the level configuration.
+ */
+static void publish_levels_unlocked(void) {
+    size_t module_count = 0;
+    size_t names_size = 0;
+    avs_log_level_t min_level = g_log.default_level;
+    AVS_LIST(module_level_t) entry;
+    AVS_LIST_FOREACH(entry, g_log.module_levels) {
+        ++module_count;
+        names_size += strlen(entry->module) + 1;
+        if (entry->level < min_level) {
+            min_level = entry->level;
+        }
+    }
+
+    AVS_LIST(level_snapshot_t) snapshot =
+            (level_snapshot_t *) AVS_LIST_NEW_BUFFER(
+                    sizeof(level_snapshot_t)
+                    + module_count * sizeof(snapshot->modules[0])
+                    + names_size);
+    if (snapshot) {
+        snapshot->default_level = g_log.default_level;
+        snapshot->module_count = module_count;
+        char *name_ptr = (char *) &snapshot->modules[module_count];
+        size_t i = 0;
+        AVS_LIST_FOREACH(entry, g_log.module_levels) {
+            size_t name_size = strlen(entry->module) + 1;
+            memcpy(name_ptr, entry->module, name_size);
+            snapshot->modules[i].level = entry->level;
+            snapshot->modules[i].module = name_ptr;
+            name_ptr += name_size;
+            ++i;
+        }
+    } else {
+        // make the readers fall back to the locked path
+        min_level = AVS_LOG_TRACE;
+    }
+
+    AVS_LIST(level_snapshot_t) old_snapshot = (AVS_LIST(level_snapshot_t))
+            atomic_exchange(&g_levels.snapshot, (uintptr_t) snapshot);
+    atomic_store(&g_levels.min_level, (int) min_level);
+    if (old_snapshot) {
+        AVS_LIST_INSERT(&g_levels.retired, old_snapshot);
+    }
+    // Readers increment the counter before loading the snapshot pointer, so if
+    // there are none now, any future reader is guaranteed to see the new one.
+    if (!atomic_load(&g_levels.readers)) {
+        AVS_LIST_CLEAR(&g_levels.retired);
+    }
+}
+
+static int snapshot_should_log(const level_snapshot_t *snapshot,
+                               avs_log_level_t level,
+                               const char *module) {
+    avs_log_level_t module_level = snapshot->default_level;
+    if (module) {
+        size_t lower = 0;
+        size_t upper = snapshot->module_count;
+        while (lower < upper) {
+            size_t middle = lower + (upper - lower) / 2;
+            int cmp = strcmp(snapshot->modules[middle].module, module);
+            if (cmp == 0) {
+                module_level = snapshot->modules[middle].level;
+                break;
+            } else if (cmp < 0) {
+                lower = middle + 1;
+            } else {
+                upper = middle;
+            }
+        }
+    }
+    return level >= module_level;
+}
+#        else // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+#            define publish_levels_unlocked() ((void) 0)
+#        endif // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+
 static int set_log_level_unlocked(const char *module, avs_log_level_t level) {
     avs_log_level_t *level_ptr = level_for(module, 1);
     if (!level_ptr) {
@@ -204,6 +378,7 @@ static int set_log_level_unlocked(const char *module, avs_log_level_t level) {
         return -1;
     }
     *level_ptr = level;
+    publish_levels_unlocked();
     return 0;
 }
 
@@ -235,10 +410,33 @@ int avs_log_should_log__(avs_log_level_t level, const char *module) {
         return 1;
     }
 
+#        ifdef AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+    if ((int) level
+            < atomic_load_explicit(&g_levels.min_level, memory_order_relaxed)) {
+        return 0;
+    }
+    int snapshot_result = -1;
+    atomic_fetch_add(&g_levels.readers, 1);
+    const level_snapshot_t *snapshot =
+            (const level_snapshot_t *) atomic_load(&g_levels.snapshot);
+    if (snapshot) {
+        snapshot_result = snapshot_should_log(snapshot, level, module);
+    }
+    atomic_fetch_sub(&g_levels.readers, 1);
+    if (snapshot_result >= 0) {
+        return snapshot_result;
+    }
+#        endif // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+
     if (LOG_LOCK()) {
         return 1;
     }
     int result = (level >= *level_for(module, 0));
+#        ifdef AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+    if (!atomic_load(&g_levels.snapshot)) {
+        publish_levels_unlocked();
+    }
+#        endif // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
     LOG_UNLOCK();
     return result;
 }
@@ -261,26 +459,46 @@ static const char *level_as_string(avs_log_level_t level) {
     }
 }
 
-static void log_with_buffer_unlocked_v(char *log_buf,
-                                       size_t log_buf_size,
-                                       avs_log_level_t level,
-                                       const char *module,
-                                       const char *file,
-                                       unsigned line,
-                                       const char *msg,
-                                       va_list ap) {
+static int format_message_v(char *log_buf,
+                            size_t log_buf_size,
+                            const char *msg,
+                            va_list ap) {
+    if (log_buf_size) {
+        int pfresult = vsnprintf(log_buf, log_buf_size, msg, ap);
+        if (pfresult < 0) {
+            // erroneous user-provided format string?
+            return -1;
+        }
+        if ((size_t) pfresult > log_buf_size) {
+            pfresult = (int) log_buf_size - 1;
+            char *log_buf_ptr = log_buf + pfresult - 3;
+            for (int i = 0; i < 3; i++) {
+                *log_buf_ptr = '.';
+                ++log_buf_ptr;
+            }
+        }
+    }
+    return 0;
+}
+
+int _avs_log_format_v(char *log_buf,
+                      size_t log_buf_size,
+                      avs_log_level_t level,
+                      const char *module,
+                      const char *file,
+                      unsigned line,
+                      const char *msg,
+                      va_list ap) {
     char *log_buf_ptr = log_buf;
     size_t log_buf_left = log_buf_size;
-    int pfresult;
 
-    if (!g_log.is_extended_handler) {
-        pfresult = snprintf(log_buf_ptr, log_buf_left,
-                            "%s [%s] [%s:%u]: ", level_as_string(level), module,
-                            file, line);
+    if (g_log.handler_type == LOG_HANDLER_NORMAL) {
+        int pfresult = snprintf(log_buf_ptr, log_buf_left, "%s [%s] [%s:%u]: ",
+                                level_as_string(level), module, file, line);
         if (pfresult < 0) {
             // it's hard to imagine why snprintf() above might fail,
             // but well, let's be compliant and check it
-            return;
+            return -1;
         }
         if ((size_t) pfresult > log_buf_left) {
             pfresult = (int) log_buf_left;
@@ -289,26 +507,68 @@ static void log_with_buffer_unlocked_v(char *log_buf,
         log_buf_left -= (size_t) pfresult;
     }
 
-    if (log_buf_left) {
-        pfresult = vsnprintf(log_buf_ptr, log_buf_left, msg, ap);
-        if (pfresult < 0) {
-            // erroneous user-provided format string?
-            return;
-        }
-        if ((size_t) pfresult > log_buf_left) {
-            pfresult = (int) log_buf_left - 1;
-            log_buf_ptr = log_buf_ptr + pfresult - 3;
-            for (int i = 0; i < 3; i++) {
-                *log_buf_ptr = '.';
-                ++log_buf_ptr;
-            }
-        }
+    return format_message_v(log_buf_ptr, log_buf_left, msg, ap);
+}
+
+void _avs_log_call_handler(avs_log_level_t level,
+                           const char *module,
+                           const char *file,
+                           unsigned line,
+                           const char *message) {
+    switch (g_log.handler_type) {
+    case LOG_HANDLER_NORMAL:
+        g_log.handler.normal(level, module, message);
+        break;
+    case LOG_HANDLER_EXTENDED:
+        g_log.handler.extended(level, module, file, line, message);
+        break;
+#    ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+    case LOG_HANDLER_STRUCTURED:
+        // "%s" with a single string argument is encoded as the string itself
+        g_log.handler.structured(level, module, file, line, "%s", message,
+                                 strlen(message) + 1);
+        break;
+#    endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
     }
+}
 
-    if (g_log.is_extended_handler) {
-        g_log.handler.extended(level, module, file, line, log_buf);
-    } else {
-        g_log.handler.normal(level, module, log_buf);
+#    ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+static void log_structured_with_buffer_unlocked_v(char *log_buf,
+                                                  size_t log_buf_size,
+                                                  avs_log_level_t level,
+                                                  const char *module,
+                                                  const char *file,
+                                                  unsigned line,
+                                                  const char *msg,
+                                                  va_list ap) {
+    size_t args_size;
+    if (!_avs_log_encode_args_v(log_buf, log_buf_size, &args_size, msg, ap)) {
+        g_log.handler.structured(level, module, file, line, msg, log_buf,
+                                 args_size);
+    } else if (!format_message_v(log_buf, log_buf_size, msg, ap)) {
+        _avs_log_call_handler(level, module, file, line, log_buf);
+    }
+}
+#    endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+
+static void log_with_buffer_unlocked_v(char *log_buf,
+                                       size_t log_buf_size,
+                                       avs_log_level_t level,
+                                       const char *module,
+                                       const char *file,
+                                       unsigned line,
+                                       const char *msg,
+                                       va_list ap) {
+#    ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+    if (is_structured_handler()) {
+        log_structured_with_buffer_unlocked_v(log_buf, log_buf_size, level,
+                                              module, file, line, msg, ap);
+        return;
+    }
+#    endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+    if (!_avs_log_format_v(log_buf, log_buf_size, level, module, file, line,
+                           msg, ap)) {
+        _avs_log_call_handler(level, module, file, line, log_buf);
     }
 }
 
@@ -318,6 +578,12 @@ void avs_log_internal_forced_v__(avs_log_level_t level,
                                  unsigned line,
                                  const char *msg,
                                  va_list ap) {
+#    ifdef AVS_COMMONS_LOG_WITH_ASYNC
+    if (!is_structured_handler()
+            && !_avs_log_async_push_v(level, module, file, line, msg, ap)) {
+        return;
+    }
+#    endif // AVS_COMMONS_LOG_WITH_ASYNC
 #    ifdef AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
     if (LOG_LOCK()) {
         return;
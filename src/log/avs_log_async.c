@@ -0,0 +1,473 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_LOG)                        \
+        && !defined(AVS_COMMONS_WITH_EXTERNAL_LOGGER_HEADER) \
+        && defined(AVS_COMMONS_LOG_WITH_ASYNC)
+
+#    include <stdarg.h>
+#    include <stdatomic.h>
+#    include <stdint.h>
+
+#    include <avsystem/commons/avs_condvar.h>
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_log.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+#    include <avsystem/commons/avs_time.h>
+
+#    include "avs_log_private.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    /**
+     * Sequence number used to synchronize access to the record, as in the
+     * bounded MPMC queue design by Dmitry Vyukov: equal to the enqueue position
+     * if the slot is free, or to that position plus one if it contains a
+     * message ready to be passed to the log handler.
+     */
+    atomic_size_t seq;
+    bool formatted;
+    avs_log_level_t level;
+    const char *module;
+    const char *file;
+    unsigned line;
+    char message[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+} async_record_t;
+
+enum { ASYNC_DISABLED, ASYNC_TRANSITIONING, ASYNC_ENABLED };
+
+static struct {
+    /** One of the ASYNC_* constants. */
+    atomic_int state;
+
+    /**
+     * Number of threads currently accessing the fields below, i.e. logging,
+     * flushing or running the drain loop, combined with the USERS_OPEN flag
+     * that is set while new users are accepted. The queue is not freed before
+     * the number of users drops to zero.
+     */
+    atomic_size_t users;
+
+    avs_log_async_overflow_policy_t policy;
+    async_record_t *records;
+    size_t mask;
+
+    atomic_size_t enqueue_pos;
+    atomic_size_t dequeue_pos;
+    /** Number of records that have been taken off the queue and handled. */
+    atomic_size_t delivered;
+    atomic_size_t dropped;
+    atomic_size_t dropped_unreported;
+
+    avs_mutex_t *mutex;
+    /**
+     * Signalled when a record is published or handled while data_waiters is
+     * non-zero.
+     */
+    avs_condvar_t *data_condvar;
+    /**
+     * Signalled when a record is handled while space_waiters is non-zero, and
+     * when the last user leaves after avs_log_async_disable() has been called.
+     */
+    avs_condvar_t *space_condvar;
+    atomic_size_t data_waiters;
+    atomic_size_t space_waiters;
+    /** Guarded by mutex. */
+    bool drain_running;
+    /** Guarded by mutex. */
+    bool users_left;
+} g_async;
+
+#    define USERS_OPEN (~(SIZE_MAX >> 1))
+
+static void nonfailing_mutex_lock(avs_mutex_t *mutex) {
+    if (avs_mutex_lock(mutex)) {
+        AVS_UNREACHABLE("could not lock mutex");
+    }
+}
+
+static bool queue_full(void) {
+    size_t pos = atomic_load(&g_async.enqueue_pos);
+    size_t seq = atomic_load(&g_async.records[pos & g_async.mask].seq);
+    return (intptr_t) (seq - pos) < 0;
+}
+
+static bool queue_empty(void) {
+    size_t pos = atomic_load(&g_async.dequeue_pos);
+    size_t seq = atomic_load(&g_async.records[pos & g_async.mask].seq);
+    return (intptr_t) (seq - (pos + 1)) < 0;
+}
+
+static void call_handler_l(avs_log_level_t level,
+                           const char *module,
+                           const char *file,
+                           unsigned line,
+                           const char *msg,
+                           ...) {
+    char log_buf[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+    va_list ap;
+    va_start(ap, msg);
+    int result = _avs_log_format_v(log_buf, sizeof(log_buf), level, module,
+                                   file, line, msg, ap);
+    va_end(ap);
+    if (!result) {
+        _avs_log_call_handler(level, module, file, line, log_buf);
+    }
+}
+
+/**
+ * Takes the oldest record off the queue and passes it to the log handler.
+ *
+ * @returns true if a record has been handled, false if there was no record
+ *          ready to be handled.
+ */
+static bool deliver_one(void) {
+    size_t pos = atomic_load_explicit(&g_async.dequeue_pos,
+                                      memory_order_relaxed);
+    async_record_t *record;
+    while (true) {
+        record = &g_async.records[pos & g_async.mask];
+        size_t seq = atomic_load_explicit(&record->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t) (seq - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak(&g_async.dequeue_pos, &pos,
+                                             pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load(&g_async.dequeue_pos);
+        }
+    }
+
+    if (record->formatted) {
+        _avs_log_call_handler(record->level, record->module, record->file,
+                              record->line, record->message);
+    }
+    atomic_store(&record->seq, pos + g_async.mask + 1);
+
+    size_t dropped = atomic_exchange(&g_async.dropped_unreported, 0);
+    if (dropped) {
+        call_handler_l(AVS_LOG_WARNING, "avs_log", __FILE__, __LINE__,
+                       "%lu log messages dropped", (unsigned long) dropped);
+    }
+
+    atomic_fetch_add(&g_async.delivered, 1);
+    if (atomic_load(&g_async.space_waiters)) {
+        nonfailing_mutex_lock(g_async.mutex);
+        avs_condvar_notify_all(g_async.space_condvar);
+        avs_mutex_unlock(g_async.mutex);
+    }
+    if (atomic_load(&g_async.data_waiters)) {
+        nonfailing_mutex_lock(g_async.mutex);
+        avs_condvar_notify_all(g_async.data_condvar);
+        avs_mutex_unlock(g_async.mutex);
+    }
+    return true;
+}
+
+static async_record_t *claim_record(size_t *out_pos) {
+    size_t pos = atomic_load_explicit(&g_async.enqueue_pos,
+                                      memory_order_relaxed);
+    while (true) {
+        async_record_t *record = &g_async.records[pos & g_async.mask];
+        size_t seq = atomic_load_explicit(&record->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t) (seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak(&g_async.enqueue_pos, &pos,
+                                             pos + 1)) {
+                *out_pos = pos;
+                return record;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = atomic_load(&g_async.enqueue_pos);
+        }
+    }
+}
+
+/**
+ * Blocks until a record is published or handled by another thread, unless
+ * @p still_waiting returns false when checked with the mutex locked. Used
+ * instead of spinning when the oldest record has been claimed by a producer,
+ * but not yet published.
+ */
+static void wait_for_data(bool (*still_waiting)(size_t), size_t arg) {
+    nonfailing_mutex_lock(g_async.mutex);
+    atomic_fetch_add(&g_async.data_waiters, 1);
+    if (queue_empty() && still_waiting(arg)) {
+        avs_condvar_wait(g_async.data_condvar, g_async.mutex,
+                         AVS_TIME_MONOTONIC_INVALID);
+    }
+    atomic_fetch_sub(&g_async.data_waiters, 1);
+    avs_mutex_unlock(g_async.mutex);
+}
+
+static bool queue_still_full(size_t unused) {
+    (void) unused;
+    return queue_full();
+}
+
+static void wait_for_space(void) {
+    bool deliver_ourselves = false;
+    nonfailing_mutex_lock(g_async.mutex);
+    atomic_fetch_add(&g_async.space_waiters, 1);
+    if (queue_full()) {
+        if (g_async.drain_running) {
+            avs_condvar_wait(g_async.space_condvar, g_async.mutex,
+                             AVS_TIME_MONOTONIC_INVALID);
+        } else {
+            deliver_ourselves = true;
+        }
+    }
+    atomic_fetch_sub(&g_async.space_waiters, 1);
+    avs_mutex_unlock(g_async.mutex);
+    if (deliver_ourselves && !deliver_one()) {
+        wait_for_data(queue_still_full, 0);
+    }
+}
+
+static void enqueue_v(avs_log_level_t level,
+                      const char *module,
+                      const char *file,
+                      unsigned line,
+                      const char *msg,
+                      va_list ap) {
+    size_t pos;
+    async_record_t *record;
+    while (!(record = claim_record(&pos))) {
+        if (g_async.policy != AVS_LOG_ASYNC_OVERFLOW_BLOCK) {
+            atomic_fetch_add(&g_async.dropped, 1);
+            if (g_async.policy == AVS_LOG_ASYNC_OVERFLOW_COUNT) {
+                atomic_fetch_add(&g_async.dropped_unreported, 1);
+            }
+            return;
+        }
+        wait_for_space();
+    }
+
+    record->level = level;
+    record->module = module;
+    record->file = file;
+    record->line = line;
+    record->formatted =
+            !_avs_log_format_v(record->message, sizeof(record->message),
+                               level, module, file, line, msg, ap);
+    atomic_store(&record->seq, pos + 1);
+
+    if (atomic_load(&g_async.data_waiters)) {
+        nonfailing_mutex_lock(g_async.mutex);
+        avs_condvar_notify_all(g_async.data_condvar);
+        avs_mutex_unlock(g_async.mutex);
+    }
+}
+
+static bool enter(void) {
+    size_t users = atomic_load(&g_async.users);
+    do {
+        if (!(users & USERS_OPEN)) {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak(&g_async.users, &users, users + 1));
+    return true;
+}
+
+static void leave(void) {
+    if (atomic_fetch_sub(&g_async.users, 1) == 1) {
+        // last user left after avs_log_async_disable() closed the queue
+        nonfailing_mutex_lock(g_async.mutex);
+        g_async.users_left = true;
+        avs_condvar_notify_all(g_async.space_condvar);
+        avs_mutex_unlock(g_async.mutex);
+    }
+}
+
+int _avs_log_async_push_v(avs_log_level_t level,
+                          const char *module,
+                          const char *file,
+                          unsigned line,
+                          const char *msg,
+                          va_list ap) {
+    if (!enter()) {
+        return -1;
+    }
+    enqueue_v(level, module, file, line, msg, ap);
+    leave();
+    return 0;
+}
+
+static void cleanup_queue(void) {
+    avs_condvar_cleanup(&g_async.space_condvar);
+    avs_condvar_cleanup(&g_async.data_condvar);
+    avs_mutex_cleanup(&g_async.mutex);
+    avs_free(g_async.records);
+    g_async.records = NULL;
+}
+
+int avs_log_async_enable(size_t capacity,
+                         avs_log_async_overflow_policy_t policy) {
+    if (!capacity) {
+        return -1;
+    }
+    size_t rounded_capacity = 1;
+    while (rounded_capacity < capacity) {
+        if (rounded_capacity > SIZE_MAX / 2) {
+            return -1;
+        }
+        rounded_capacity *= 2;
+    }
+
+    int expected = ASYNC_DISABLED;
+    if (!atomic_compare_exchange_strong(&g_async.state, &expected,
+                                        ASYNC_TRANSITIONING)) {
+        return -1;
+    }
+
+    if (!(g_async.records = (async_record_t *) avs_calloc(
+                  rounded_capacity, sizeof(async_record_t)))
+            || avs_mutex_create(&g_async.mutex)
+            || avs_condvar_create(&g_async.data_condvar)
+            || avs_condvar_create(&g_async.space_condvar)) {
+        cleanup_queue();
+        atomic_store(&g_async.state, ASYNC_DISABLED);
+        return -1;
+    }
+    for (size_t i = 0; i < rounded_capacity; ++i) {
+        atomic_store_explicit(&g_async.records[i].seq, i,
+                              memory_order_relaxed);
+    }
+    g_async.mask = rounded_capacity - 1;
+    g_async.policy = policy;
+    g_async.drain_running = false;
+    g_async.users_left = false;
+    atomic_store(&g_async.enqueue_pos, 0);
+    atomic_store(&g_async.dequeue_pos, 0);
+    atomic_store(&g_async.delivered, 0);
+    atomic_store(&g_async.dropped, 0);
+    atomic_store(&g_async.dropped_unreported, 0);
+    atomic_store(&g_async.data_waiters, 0);
+    atomic_store(&g_async.space_waiters, 0);
+
+    atomic_store(&g_async.state, ASYNC_ENABLED);
+    atomic_store(&g_async.users, USERS_OPEN);
+    return 0;
+}
+
+void avs_log_async_run(void) {
+    if (!enter()) {
+        return;
+    }
+    nonfailing_mutex_lock(g_async.mutex);
+    bool already_running = g_async.drain_running;
+    g_async.drain_running = true;
+    avs_mutex_unlock(g_async.mutex);
+
+    if (!already_running) {
+        bool finished = false;
+        while (!finished) {
+            while (deliver_one()) {
+            }
+
+            nonfailing_mutex_lock(g_async.mutex);
+            atomic_fetch_add(&g_async.data_waiters, 1);
+            if (queue_empty()
+                    && atomic_load(&g_async.state) == ASYNC_ENABLED) {
+                avs_condvar_wait(g_async.data_condvar, g_async.mutex,
+                                 AVS_TIME_MONOTONIC_INVALID);
+            }
+            atomic_fetch_sub(&g_async.data_waiters, 1);
+            finished = (atomic_load(&g_async.state) != ASYNC_ENABLED
+                        && queue_empty());
+            avs_mutex_unlock(g_async.mutex);
+        }
+
+        nonfailing_mutex_lock(g_async.mutex);
+        g_async.drain_running = false;
+        // producers blocked on a full queue need to deliver by themselves now
+        avs_condvar_notify_all(g_async.space_condvar);
+        avs_mutex_unlock(g_async.mutex);
+    }
+    leave();
+}
+
+static bool not_delivered_yet(size_t target) {
+    return atomic_load(&g_async.delivered) < target;
+}
+
+int avs_log_async_flush(void) {
+    if (!enter()) {
+        return -1;
+    }
+    size_t target = atomic_load(&g_async.enqueue_pos);
+    while (not_delivered_yet(target)) {
+        bool deliver_ourselves = false;
+        nonfailing_mutex_lock(g_async.mutex);
+        atomic_fetch_add(&g_async.space_waiters, 1);
+        if (!g_async.drain_running) {
+            deliver_ourselves = true;
+        } else if (not_delivered_yet(target)) {
+            avs_condvar_wait(g_async.space_condvar, g_async.mutex,
+                             AVS_TIME_MONOTONIC_INVALID);
+        }
+        atomic_fetch_sub(&g_async.space_waiters, 1);
+        avs_mutex_unlock(g_async.mutex);
+        if (deliver_ourselves && !deliver_one()) {
+            wait_for_data(not_delivered_yet, target);
+        }
+    }
+    leave();
+    return 0;
+}
+
+size_t avs_log_async_dropped(void) {
+    return atomic_load(&g_async.dropped);
+}
+
+void avs_log_async_disable(void) {
+    int expected = ASYNC_ENABLED;
+    if (!atomic_compare_exchange_strong(&g_async.state, &expected,
+                                        ASYNC_TRANSITIONING)) {
+        return;
+    }
+
+    // wake up the drain loop so that it can notice the state change, then
+    // wait for the last user to leave; leave() signals that under the mutex,
+    // so it is safe to free the queue afterwards
+    nonfailing_mutex_lock(g_async.mutex);
+    avs_condvar_notify_all(g_async.data_condvar);
+    if (atomic_fetch_and(&g_async.users, ~USERS_OPEN) & ~USERS_OPEN) {
+        while (!g_async.users_left) {
+            avs_condvar_wait(g_async.space_condvar, g_async.mutex,
+                             AVS_TIME_MONOTONIC_INVALID);
+        }
+    }
+    avs_mutex_unlock(g_async.mutex);
+
+    while (deliver_one()) {
+    }
+    cleanup_queue();
+    atomic_store(&g_async.state, ASYNC_DISABLED);
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_LOG) &&
+       // !defined(AVS_COMMONS_WITH_EXTERNAL_LOGGER_HEADER) &&
+       // defined(AVS_COMMONS_LOG_WITH_ASYNC)
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_LOG_PRIVATE_H
+#define AVS_LOG_PRIVATE_H
+
+#include <stdarg.h>
+
+#include <avsystem/commons/avs_log.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Formats a log message into @p log_buf, in the form expected by the currently
+ * set log handler. Messages too long to fit are truncated with "...".
+ *
+ * @returns 0 on success, or a negative value if formatting failed, in which
+ *          case the message shall not be passed to the handler.
+ */
+int _avs_log_format_v(char *log_buf,
+                      size_t log_buf_size,
+                      avs_log_level_t level,
+                      const char *module,
+                      const char *file,
+                      unsigned line,
+                      const char *msg,
+                      va_list ap);
+
+/**
+ * Passes a message formatted with @ref _avs_log_format_v to the currently set
+ * log handler.
+ */
+void _avs_log_call_handler(avs_log_level_t level,
+                           const char *module,
+                           const char *file,
+                           unsigned line,
+                           const char *message);
+
+#ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+/**
+ * Encodes the arguments consumed by @p format into the format accepted by
+ * @ref avs_log_render.
+ *
+ * @returns 0 on success, or a negative value if the format string contains
+ *          unsupported conversions, or the encoded arguments do not fit in
+ *          @p buf_size bytes. @p ap is not modified in either case.
+ */
+int _avs_log_encode_args_v(void *buf,
+                           size_t buf_size,
+                           size_t *out_size,
+                           const char *format,
+                           va_list ap);
+#endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+
+#ifdef AVS_COMMONS_LOG_WITH_ASYNC
+/**
+ * Queues a log message if the asynchronous mode is enabled.
+ *
+ * @returns 0 if the message has been queued or discarded according to the
+ *          overflow policy, or a negative value if the asynchronous mode is
+ *          disabled - @p ap is not accessed in that case, and the caller shall
+ *          log the message synchronously.
+ */
+int _avs_log_async_push_v(avs_log_level_t level,
+                          const char *module,
+                          const char *file,
+                          unsigned line,
+                          const char *msg,
+                          va_list ap);
+#endif // AVS_COMMONS_LOG_WITH_ASYNC
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // AVS_LOG_PRIVATE_H
@@ -0,0 +1,550 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_LOG)                        \
+        && !defined(AVS_COMMONS_WITH_EXTERNAL_LOGGER_HEADER) \
+        && defined(AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER)
+
+#    include <stdarg.h>
+#    include <stddef.h>
+#    include <stdint.h>
+#    include <stdio.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_log.h>
+
+#    include "avs_log_private.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/*
+ * The argument encoding is a plain concatenation of the values consumed by the
+ * format string, in their native representation and without any alignment
+ * padding. Arguments for "*" widths and precisions are stored as int right
+ * before the value they apply to. Strings are stored inline, including the
+ * terminating null character and limited to the precision, if specified.
+ */
+
+typedef enum {
+    ARG_NONE,
+    ARG_INT,
+    ARG_UINT,
+    ARG_LONG,
+    ARG_ULONG,
+    ARG_LLONG,
+    ARG_ULLONG,
+    ARG_INTMAX,
+    ARG_UINTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_POINTER,
+    ARG_STRING
+} arg_type_t;
+
+typedef enum {
+    LENGTH_NONE,
+    LENGTH_HH,
+    LENGTH_H,
+    LENGTH_L,
+    LENGTH_LL,
+    LENGTH_J,
+    LENGTH_Z,
+    LENGTH_T,
+    LENGTH_BIG_L
+} length_modifier_t;
+
+typedef struct {
+    const char *spec;
+    size_t spec_length;
+    bool width_from_arg;
+    bool precision_from_arg;
+    /** Negative if not specified, or if passed as an argument. */
+    int precision;
+    arg_type_t type;
+} conversion_t;
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static arg_type_t integer_type(length_modifier_t length, bool is_unsigned) {
+    switch (length) {
+    case LENGTH_NONE:
+    case LENGTH_HH:
+    case LENGTH_H:
+        return is_unsigned ? ARG_UINT : ARG_INT;
+    case LENGTH_L:
+        return is_unsigned ? ARG_ULONG : ARG_LONG;
+    case LENGTH_LL:
+        return is_unsigned ? ARG_ULLONG : ARG_LLONG;
+    case LENGTH_J:
+        return is_unsigned ? ARG_UINTMAX : ARG_INTMAX;
+    case LENGTH_Z:
+        return ARG_SIZE;
+    case LENGTH_T:
+        return ARG_PTRDIFF;
+    default:
+        return ARG_NONE;
+    }
+}
+
+/**
+ * Parses a single conversion specification.
+ *
+ * @param spec Pointer to the '%' character that starts the specification.
+ *
+ * @returns Pointer to the first character after the specification, or NULL if
+ *          it is malformed or not supported (e.g. "%n" or wide strings).
+ */
+static const char *parse_conversion(const char *spec, conversion_t *out) {
+    const char *ptr = spec + 1;
+    memset(out, 0, sizeof(*out));
+    out->spec = spec;
+    out->precision = -1;
+
+    while (*ptr && strchr("-+ #0", *ptr)) {
+        ++ptr;
+    }
+    if (*ptr == '*') {
+        out->width_from_arg = true;
+        ++ptr;
+    } else {
+        while (is_digit(*ptr)) {
+            ++ptr;
+        }
+    }
+    if (*ptr == '.') {
+        ++ptr;
+        if (*ptr == '*') {
+            out->precision_from_arg = true;
+            ++ptr;
+        } else {
+            out->precision = 0;
+            while (is_digit(*ptr)) {
+                if (out->precision < INT16_MAX) {
+                    out->precision = 10 * out->precision + (*ptr - '0');
+                }
+                ++ptr;
+            }
+        }
+    }
+
+    length_modifier_t length = LENGTH_NONE;
+    switch (*ptr) {
+    case 'h':
+        length = (ptr[1] == 'h' ? LENGTH_HH : LENGTH_H);
+        break;
+    case 'l':
+        length = (ptr[1] == 'l' ? LENGTH_LL : LENGTH_L);
+        break;
+    case 'j':
+        length = LENGTH_J;
+        break;
+    case 'z':
+        length = LENGTH_Z;
+        break;
+    case 't':
+        length = LENGTH_T;
+        break;
+    case 'L':
+        length = LENGTH_BIG_L;
+        break;
+    default:
+        break;
+    }
+    if (length == LENGTH_HH || length == LENGTH_LL) {
+        ptr += 2;
+    } else if (length != LENGTH_NONE) {
+        ++ptr;
+    }
+
+    switch (*ptr) {
+    case 'd':
+    case 'i':
+        out->type = integer_type(length, false);
+        break;
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+        out->type = integer_type(length, true);
+        break;
+    case 'c':
+        out->type = (length == LENGTH_NONE ? ARG_INT : ARG_NONE);
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        if (length == LENGTH_NONE || length == LENGTH_L) {
+            out->type = ARG_DOUBLE;
+        } else if (length == LENGTH_BIG_L) {
+            out->type = ARG_LDOUBLE;
+        }
+        break;
+    case 's':
+        out->type = (length == LENGTH_NONE ? ARG_STRING : ARG_NONE);
+        break;
+    case 'p':
+        out->type = (length == LENGTH_NONE ? ARG_POINTER : ARG_NONE);
+        break;
+    case '%':
+        if (ptr != spec + 1) {
+            return NULL;
+        }
+        break;
+    default:
+        return NULL;
+    }
+    if (*ptr != '%' && out->type == ARG_NONE) {
+        return NULL;
+    }
+    out->spec_length = (size_t) (ptr + 1 - spec);
+    return ptr + 1;
+}
+
+typedef struct {
+    char *ptr;
+    size_t left;
+} arg_writer_t;
+
+static int write_arg(arg_writer_t *writer, const void *data, size_t size) {
+    if (size > writer->left) {
+        return -1;
+    }
+    memcpy(writer->ptr, data, size);
+    writer->ptr += size;
+    writer->left -= size;
+    return 0;
+}
+
+#    define WRITE_ARG(Writer, Type, Ap)                                   \
+        do {                                                              \
+            Type _value = va_arg((Ap), Type);                             \
+            if (write_arg((Writer), &_value, sizeof(_value))) {           \
+                return -1;                                                \
+            }                                                             \
+        } while (0)
+
+static int write_string_arg(arg_writer_t *writer, const char *str, int limit) {
+    if (!str) {
+        str = "(null)";
+    }
+    size_t length;
+    if (limit >= 0) {
+        const char *terminator =
+                (const char *) memchr(str, '\0', (size_t) limit);
+        length = (terminator ? (size_t) (terminator - str) : (size_t) limit);
+    } else {
+        length = strlen(str);
+    }
+    if (length >= writer->left) {
+        return -1;
+    }
+    memcpy(writer->ptr, str, length);
+    writer->ptr[length] = '\0';
+    writer->ptr += length + 1;
+    writer->left -= length + 1;
+    return 0;
+}
+
+static int encode_conversion(arg_writer_t *writer,
+                             const conversion_t *conversion,
+                             va_list *ap) {
+    int precision = conversion->precision;
+    if (conversion->width_from_arg) {
+        WRITE_ARG(writer, int, *ap);
+    }
+    if (conversion->precision_from_arg) {
+        precision = va_arg(*ap, int);
+        if (write_arg(writer, &precision, sizeof(precision))) {
+            return -1;
+        }
+    }
+
+    switch (conversion->type) {
+    case ARG_NONE:
+        break;
+    case ARG_INT:
+        WRITE_ARG(writer, int, *ap);
+        break;
+    case ARG_UINT:
+        WRITE_ARG(writer, unsigned int, *ap);
+        break;
+    case ARG_LONG:
+        WRITE_ARG(writer, long, *ap);
+        break;
+    case ARG_ULONG:
+        WRITE_ARG(writer, unsigned long, *ap);
+        break;
+    case ARG_LLONG:
+        WRITE_ARG(writer, long long, *ap);
+        break;
+    case ARG_ULLONG:
+        WRITE_ARG(writer, unsigned long long, *ap);
+        break;
+    case ARG_INTMAX:
+        WRITE_ARG(writer, intmax_t, *ap);
+        break;
+    case ARG_UINTMAX:
+        WRITE_ARG(writer, uintmax_t, *ap);
+        break;
+    case ARG_SIZE:
+        WRITE_ARG(writer, size_t, *ap);
+        break;
+    case ARG_PTRDIFF:
+        WRITE_ARG(writer, ptrdiff_t, *ap);
+        break;
+    case ARG_DOUBLE:
+        WRITE_ARG(writer, double, *ap);
+        break;
+    case ARG_LDOUBLE:
+        WRITE_ARG(writer, long double, *ap);
+        break;
+    case ARG_POINTER:
+        WRITE_ARG(writer, void *, *ap);
+        break;
+    case ARG_STRING:
+        return write_string_arg(writer, va_arg(*ap, const char *), precision);
+    }
+    return 0;
+}
+
+int _avs_log_encode_args_v(void *buf,
+                           size_t buf_size,
+                           size_t *out_size,
+                           const char *format,
+                           va_list ap) {
+    arg_writer_t writer = {
+        .ptr = (char *) buf,
+        .left = buf_size
+    };
+    va_list ap_copy;
+    va_copy(ap_copy, ap);
+    int result = 0;
+    const char *ptr = format;
+    while (!result && (ptr = strchr(ptr, '%'))) {
+        conversion_t conversion;
+        if (!(ptr = parse_conversion(ptr, &conversion))) {
+            result = -1;
+        } else {
+            result = encode_conversion(&writer, &conversion, &ap_copy);
+        }
+    }
+    va_end(ap_copy);
+    if (!result) {
+        *out_size = buf_size - writer.left;
+    }
+    return result;
+}
+
+typedef struct {
+    const char *ptr;
+    size_t left;
+} arg_reader_t;
+
+static int read_arg(arg_reader_t *reader, void *out, size_t size) {
+    if (size > reader->left) {
+        return -1;
+    }
+    memcpy(out, reader->ptr, size);
+    reader->ptr += size;
+    reader->left -= size;
+    return 0;
+}
+
+static int read_string_arg(arg_reader_t *reader, const char **out) {
+    const char *terminator =
+            (const char *) memchr(reader->ptr, '\0', reader->left);
+    if (!terminator) {
+        return -1;
+    }
+    *out = reader->ptr;
+    reader->left -= (size_t) (terminator + 1 - reader->ptr);
+    reader->ptr = terminator + 1;
+    return 0;
+}
+
+#    define SNPRINTF_WITH_STARS(Buf, Size, Format, Stars, StarCount, Value) \
+        ((StarCount) == 0                                                   \
+                 ? snprintf((Buf), (Size), (Format), (Value))               \
+                 : (StarCount) == 1                                         \
+                           ? snprintf((Buf), (Size), (Format), (Stars)[0],  \
+                                      (Value))                              \
+                           : snprintf((Buf), (Size), (Format), (Stars)[0],  \
+                                      (Stars)[1], (Value)))
+
+#    define RENDER_ARG(Reader, Type, Buf, Size, Format, Stars, StarCount) \
+        do {                                                              \
+            Type _value;                                                  \
+            if (read_arg((Reader), &_value, sizeof(_value))) {            \
+                return -1;                                                \
+            }                                                             \
+            result = SNPRINTF_WITH_STARS((Buf), (Size), (Format), (Stars), \
+                                         (StarCount), _value);            \
+        } while (0)
+
+/**
+ * Renders a single conversion into @p buf.
+ *
+ * @returns Number of characters that would have been written, as returned by
+ *          snprintf(), or a negative value in case of error.
+ */
+static int render_conversion(char *buf,
+                             size_t buf_size,
+                             arg_reader_t *reader,
+                             const conversion_t *conversion) {
+    if (conversion->type == ARG_NONE) {
+        return snprintf(buf, buf_size, "%%");
+    }
+
+    char format[32];
+    if (conversion->spec_length >= sizeof(format)) {
+        return -1;
+    }
+    memcpy(format, conversion->spec, conversion->spec_length);
+    format[conversion->spec_length] = '\0';
+
+    int stars[2];
+    size_t star_count = 0;
+    if (conversion->width_from_arg
+            && read_arg(reader, &stars[star_count++], sizeof(int))) {
+        return -1;
+    }
+    if (conversion->precision_from_arg
+            && read_arg(reader, &stars[star_count++], sizeof(int))) {
+        return -1;
+    }
+
+    int result = -1;
+    switch (conversion->type) {
+    case ARG_NONE:
+        break;
+    case ARG_INT:
+        RENDER_ARG(reader, int, buf, buf_size, format, stars, star_count);
+        break;
+    case ARG_UINT:
+        RENDER_ARG(reader, unsigned int, buf, buf_size, format, stars,
+                   star_count);
+        break;
+    case ARG_LONG:
+        RENDER_ARG(reader, long, buf, buf_size, format, stars, star_count);
+        break;
+    case ARG_ULONG:
+        RENDER_ARG(reader, unsigned long, buf, buf_size, format, stars,
+                   star_count);
+        break;
+    case ARG_LLONG:
+        RENDER_ARG(reader, long long, buf, buf_size, format, stars,
+                   star_count);
+        break;
+    case ARG_ULLONG:
+        RENDER_ARG(reader, unsigned long long, buf, buf_size, format, stars,
+                   star_count);
+        break;
+    case ARG_INTMAX:
+        RENDER_ARG(reader, intmax_t, buf, buf_size, format, stars, star_count);
+        break;
+    case ARG_UINTMAX:
+        RENDER_ARG(reader, uintmax_t, buf, buf_size, format, stars,
+                   star_count);
+        break;
+    case ARG_SIZE:
+        RENDER_ARG(reader, size_t, buf, buf_size, format, stars, star_count);
+        break;
+    case ARG_PTRDIFF:
+        RENDER_ARG(reader, ptrdiff_t, buf, buf_size, format, stars,
+                   star_count);
+        break;
+    case ARG_DOUBLE:
+        RENDER_ARG(reader, double, buf, buf_size, format, stars, star_count);
+        break;
+    case ARG_LDOUBLE:
+        RENDER_ARG(reader, long double, buf, buf_size, format, stars,
+                   star_count);
+        break;
+    case ARG_POINTER:
+        RENDER_ARG(reader, void *, buf, buf_size, format, stars, star_count);
+        break;
+    case ARG_STRING: {
+        const char *value;
+        if (read_string_arg(reader, &value)) {
+            return -1;
+        }
+        result = SNPRINTF_WITH_STARS(buf, buf_size, format, stars, star_count,
+                                     value);
+        break;
+    }
+    }
+    return result;
+}
+
+int avs_log_render(char *buf,
+                   size_t buf_size,
+                   const char *format,
+                   const void *args,
+                   size_t args_size) {
+    if (!buf_size) {
+        return -1;
+    }
+    arg_reader_t reader = {
+        .ptr = (const char *) args,
+        .left = args_size
+    };
+    char *out = buf;
+    size_t out_left = buf_size;
+    const char *ptr = format;
+    while (*ptr) {
+        int result;
+        const char *next = ptr;
+        if (*ptr == '%') {
+            conversion_t conversion;
+            if (!(next = parse_conversion(ptr, &conversion))) {
+                return -1;
+            }
+            result = render_conversion(out, out_left, &reader, &conversion);
+        } else {
+            if (!(next = strchr(ptr, '%'))) {
+                next = ptr + strlen(ptr);
+            }
+            result = snprintf(out, out_left, "%.*s", (int) (next - ptr), ptr);
+        }
+        if (result < 0) {
+            return -1;
+        }
+        if ((size_t) result >= out_left) {
+            // output truncated, but the remaining arguments are still validated
+            result = (int) out_left - 1;
+        }
+        out += result;
+        out_left -= (size_t) result;
+        ptr = next;
+    }
+    *out = '\0';
+    return 0;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_LOG) &&
+       // !defined(AVS_COMMONS_WITH_EXTERNAL_LOGGER_HEADER) &&
+       // defined(AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER)
@@ -33,9 +33,28 @@
 
 #    include "avs_net_impl.h"
 
+#    if defined(AVS_COMMONS_WITH_AVS_CRYPTO)                           \
+            && defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) \
+            && !defined(AVS_COMMONS_WITHOUT_TLS)
+#        include "avs_tls_server_session_cache.h"
+#    endif // defined(AVS_COMMONS_WITH_AVS_CRYPTO) &&
+           // defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) &&
+           // !defined(AVS_COMMONS_WITHOUT_TLS)
+
+#    if defined(AVS_COMMONS_WITH_AVS_CRYPTO)               \
+            && defined(AVS_COMMONS_NET_WITH_DTLS_LISTENER) \
+            && !defined(AVS_COMMONS_WITHOUT_TLS)           \
+            && !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+#        include "avs_dtls_listener.h"
+#    endif // defined(AVS_COMMONS_WITH_AVS_CRYPTO) &&
+           // defined(AVS_COMMONS_NET_WITH_DTLS_LISTENER) &&
+           // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+           // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+
 VISIBILITY_SOURCE_BEGIN
 
 const avs_time_duration_t AVS_NET_SOCKET_DEFAULT_RECV_TIMEOUT = { 30, 0 };
+const avs_time_duration_t AVS_NET_SOCKET_DEFAULT_RESOLVE_CACHE_TTL = { 60, 0 };
 
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO
 avs_net_security_info_t avs_net_security_info_from_psk(avs_net_psk_info_t psk) {
@@ -140,6 +159,15 @@ avs_error_t avs_net_socket_send(avs_net_socket_t *socket,
     return socket->operations->send(socket, buffer, buffer_length);
 }
 
+avs_error_t avs_net_socket_sendv(avs_net_socket_t *socket,
+                                 const avs_iovec_t *iov,
+                                 size_t iov_count) {
+    if (!socket->operations->sendv) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    return socket->operations->sendv(socket, iov, iov_count);
+}
+
 avs_error_t avs_net_socket_send_to(avs_net_socket_t *socket,
                                    const void *buffer,
                                    size_t buffer_length,
@@ -179,6 +207,39 @@ avs_error_t avs_net_socket_receive_from(avs_net_socket_t *socket,
                                             port, port_size);
 }
 
+avs_error_t
+avs_net_socket_send_to_many(avs_net_socket_t *socket,
+                            const avs_net_outgoing_datagram_t *datagrams,
+                            size_t datagram_count,
+                            size_t *out_sent_count) {
+    size_t sent_count = 0;
+    avs_error_t err = avs_errno(AVS_ENOTSUP);
+    if (socket->operations->send_to_many) {
+        err = socket->operations->send_to_many(socket, datagrams,
+                                               datagram_count, &sent_count);
+    }
+    if (out_sent_count) {
+        *out_sent_count = sent_count;
+    }
+    return err;
+}
+
+avs_error_t
+avs_net_socket_receive_from_many(avs_net_socket_t *socket,
+                                 avs_net_incoming_datagram_t *datagrams,
+                                 size_t datagram_count,
+                                 size_t *out_received_count) {
+    *out_received_count = 0;
+    if (!datagram_count) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (!socket->operations->receive_from_many) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    return socket->operations->receive_from_many(
+            socket, datagrams, datagram_count, out_received_count);
+}
+
 avs_error_t avs_net_socket_bind(avs_net_socket_t *socket,
                                 const char *address,
                                 const char *port) {
@@ -408,6 +469,26 @@ static avs_error_t send_debug(avs_net_socket_t *debug_socket,
     return err;
 }
 
+static avs_error_t sendv_debug(avs_net_socket_t *debug_socket,
+                               const avs_iovec_t *iov,
+                               size_t iov_count) {
+    avs_error_t err = avs_net_socket_sendv(
+            ((avs_net_socket_debug_t *) debug_socket)->socket, iov, iov_count);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "\n----------SEND----------\n");
+        for (size_t i = 0; i < iov_count; ++i) {
+            fwrite(iov[i].base, 1, iov[i].length, communication_log);
+        }
+        fprintf(communication_log, "\n--------SEND-END--------\n");
+        fflush(communication_log);
+    } else if (err.category != AVS_ERRNO_CATEGORY || err.code != AVS_ENOTSUP) {
+        // ENOTSUP only means that the caller will fall back to send(), which
+        // is logged on its own
+        fprintf(communication_log, "\n------SEND-FAILURE------\n");
+    }
+    return err;
+}
+
 static avs_error_t send_to_debug(avs_net_socket_t *debug_socket,
                                  const void *buffer,
                                  size_t buffer_length,
@@ -472,6 +553,65 @@ static avs_error_t receive_from_debug(avs_net_socket_t *debug_socket,
     return err;
 }
 
+static avs_error_t
+send_to_many_debug(avs_net_socket_t *debug_socket,
+                   const avs_net_outgoing_datagram_t *datagrams,
+                   size_t datagram_count,
+                   size_t *out_sent_count) {
+    avs_error_t err = avs_net_socket_send_to_many(
+            ((avs_net_socket_debug_t *) debug_socket)->socket, datagrams,
+            datagram_count, out_sent_count);
+    for (size_t i = 0; i < *out_sent_count; ++i) {
+        char host[NET_MAX_HOSTNAME_SIZE] = "";
+        char port[NET_PORT_SIZE] = "";
+        if (datagrams[i].destination) {
+            avs_net_resolved_endpoint_get_host_port(datagrams[i].destination,
+                                                    host, sizeof(host), port,
+                                                    sizeof(port));
+        }
+        fprintf(communication_log, "\n--------SEND-TO---------\n");
+        fprintf(communication_log, "%s:%s\n", host, port);
+        fprintf(communication_log, "------------------------\n");
+        fwrite(datagrams[i].buffer, 1, datagrams[i].buffer_length,
+               communication_log);
+        fprintf(communication_log, "\n--------SEND-END--------\n");
+    }
+    if (avs_is_err(err)) {
+        fprintf(communication_log, "\n----SEND-TO-FAILURE-----\n");
+    }
+    fflush(communication_log);
+    return err;
+}
+
+static avs_error_t
+receive_from_many_debug(avs_net_socket_t *debug_socket,
+                        avs_net_incoming_datagram_t *datagrams,
+                        size_t datagram_count,
+                        size_t *out_received_count) {
+    avs_error_t err = avs_net_socket_receive_from_many(
+            ((avs_net_socket_debug_t *) debug_socket)->socket, datagrams,
+            datagram_count, out_received_count);
+    if (avs_is_ok(err)) {
+        for (size_t i = 0; i < *out_received_count; ++i) {
+            char host[NET_MAX_HOSTNAME_SIZE] = "";
+            char port[NET_PORT_SIZE] = "";
+            avs_net_resolved_endpoint_get_host_port(&datagrams[i].out_source,
+                                                    host, sizeof(host), port,
+                                                    sizeof(port));
+            fprintf(communication_log, "\n--------RECV-FROM--------\n");
+            fprintf(communication_log, "%s:%s\n", host, port);
+            fprintf(communication_log, "---------------------------\n");
+            fwrite(datagrams[i].buffer, 1, datagrams[i].out_size,
+                   communication_log);
+            fprintf(communication_log, "\n--------RECV-END---------\n");
+        }
+        fflush(communication_log);
+    } else {
+        fprintf(communication_log, "\n----RECV-FROM-FAILURE----\n");
+    }
+    return err;
+}
+
 static avs_error_t bind_debug(avs_net_socket_t *debug_socket,
                               const char *localaddr,
                               const char *port) {
@@ -652,7 +792,8 @@ static const avs_net_socket_v_table_t debug_vtable = {
     shutdown_debug,       cleanup_debug,     system_socket_debug,
     interface_name_debug, remote_host_debug, remote_hostname_debug,
     remote_port_debug,    local_host_debug,  local_port_debug,
-    get_opt_debug,        set_opt_debug
+    get_opt_debug,        set_opt_debug,     sendv_debug,
+    receive_from_many_debug, send_to_many_debug
 };
 
 static avs_error_t create_socket_debug(avs_net_socket_t **debug_socket,
@@ -719,7 +860,7 @@ avs_error_t
 avs_net_dtls_socket_create(avs_net_socket_t **socket,
                            const avs_net_ssl_configuration_t *config) {
 #        ifndef AVS_COMMONS_WITHOUT_TLS
-    if (!config->prng_ctx) {
+    if (!config->prng_ctx && !config->tls_context) {
         LOG(ERROR, _("PRNG ctx MUST NOT be NULL"));
         return avs_errno(AVS_EINVAL);
     }
@@ -738,7 +879,7 @@ avs_error_t
 avs_net_ssl_socket_create(avs_net_socket_t **socket,
                           const avs_net_ssl_configuration_t *config) {
 #        ifndef AVS_COMMONS_WITHOUT_TLS
-    if (!config->prng_ctx) {
+    if (!config->prng_ctx && !config->tls_context) {
         LOG(ERROR, _("PRNG ctx MUST NOT be NULL"));
         return avs_errno(AVS_EINVAL);
     }
@@ -752,6 +893,131 @@ avs_net_ssl_socket_create(avs_net_socket_t **socket,
     return avs_errno(AVS_ENOTSUP);
 #        endif // AVS_COMMONS_WITHOUT_TLS
 }
-#    endif // AVS_COMMONS_WITH_AVS_CRYPTO
+
+avs_error_t
+avs_net_tls_context_create(avs_net_tls_context_t **out_context,
+                           avs_net_socket_type_t socket_type,
+                           const avs_net_ssl_configuration_t *config) {
+#        if !defined(AVS_COMMONS_WITHOUT_TLS) \
+                && !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+    if (!out_context || !config
+            || (socket_type != AVS_NET_SSL_SOCKET
+                && socket_type != AVS_NET_DTLS_SOCKET)) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (!config->prng_ctx) {
+        LOG(ERROR, _("PRNG ctx MUST NOT be NULL"));
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_error_t err = _avs_net_ensure_global_state();
+    if (avs_is_err(err)) {
+        LOG(ERROR, _("avs_net global state initialization error"));
+        return err;
+    }
+    return _avs_net_tls_context_create(out_context, socket_type, config);
+#        else  // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+                // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+    (void) out_context;
+    (void) socket_type;
+    (void) config;
+    LOG(ERROR, _("shared TLS contexts are not supported"));
+    return avs_errno(AVS_ENOTSUP);
+#        endif // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+               // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+}
+
+void avs_net_tls_context_cleanup(avs_net_tls_context_t **context) {
+#        if !defined(AVS_COMMONS_WITHOUT_TLS) \
+                && !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+    if (context) {
+        _avs_net_tls_context_release(context);
+    }
+#        else  // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+                // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+    (void) context;
+#        endif // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+               // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+}
+
+#        ifdef AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE
+avs_error_t avs_net_tls_server_session_cache_create(
+        avs_net_tls_server_session_cache_t **out_cache,
+        const avs_net_tls_server_session_cache_config_t *config) {
+#            ifndef AVS_COMMONS_WITHOUT_TLS
+    if (!out_cache) {
+        return avs_errno(AVS_EINVAL);
+    }
+    return _avs_net_tls_server_session_cache_create(out_cache, config);
+#            else  // AVS_COMMONS_WITHOUT_TLS
+    (void) out_cache;
+    (void) config;
+    LOG(ERROR, _("server session cache is not supported"));
+    return avs_errno(AVS_ENOTSUP);
+#            endif // AVS_COMMONS_WITHOUT_TLS
+}
+
+void avs_net_tls_server_session_cache_cleanup(
+        avs_net_tls_server_session_cache_t **cache) {
+#            ifndef AVS_COMMONS_WITHOUT_TLS
+    _avs_net_tls_server_session_cache_cleanup(cache);
+#            else  // AVS_COMMONS_WITHOUT_TLS
+    (void) cache;
+#            endif // AVS_COMMONS_WITHOUT_TLS
+}
+
+avs_error_t avs_net_tls_server_session_cache_rotate_ticket_keys(
+        avs_net_tls_server_session_cache_t *cache) {
+#            ifndef AVS_COMMONS_WITHOUT_TLS
+    if (!cache) {
+        return avs_errno(AVS_EINVAL);
+    }
+    return _avs_net_tls_server_session_cache_rotate_ticket_keys(cache);
+#            else  // AVS_COMMONS_WITHOUT_TLS
+    (void) cache;
+    return avs_errno(AVS_ENOTSUP);
+#            endif // AVS_COMMONS_WITHOUT_TLS
+}
+
+#            ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+avs_error_t avs_net_tls_server_session_cache_persistence(
+        avs_net_tls_server_session_cache_t *cache,
+        avs_persistence_context_t *ctx) {
+#                ifndef AVS_COMMONS_WITHOUT_TLS
+    if (!cache || !ctx) {
+        return avs_errno(AVS_EINVAL);
+    }
+    return _avs_net_tls_server_session_cache_persistence(cache, ctx);
+#                else  // AVS_COMMONS_WITHOUT_TLS
+    (void) cache;
+    (void) ctx;
+    return avs_errno(AVS_ENOTSUP);
+#                endif // AVS_COMMONS_WITHOUT_TLS
+}
+#            endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
+#        endif     // AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE
+
+#        ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+avs_error_t avs_net_dtls_listener_socket_create(
+        avs_net_socket_t **socket,
+        const avs_net_dtls_listener_configuration_t *config) {
+#            if !defined(AVS_COMMONS_WITHOUT_TLS) \
+                    && !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+    if (!socket || !config) {
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_error_t err = create_bare_socket(
+            socket, _avs_net_create_dtls_listener_socket, config);
+    return init_debug_socket_if_applicable(socket, err);
+#            else  // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+                    // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+    (void) socket;
+    (void) config;
+    LOG(ERROR, _("DTLS listener sockets are not supported"));
+    return avs_errno(AVS_ENOTSUP);
+#            endif // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+                   // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+}
+#        endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+#    endif     // AVS_COMMONS_WITH_AVS_CRYPTO
 
 #endif // AVS_COMMONS_WITH_AVS_NET
@@ -0,0 +1,1132 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET) && defined(AVS_COMMONS_WITH_AVS_CRYPTO) \
+        && defined(AVS_COMMONS_NET_WITH_DTLS_LISTENER)                      \
+        && !defined(AVS_COMMONS_WITHOUT_TLS)                                \
+        && !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
+
+#    include <assert.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_prng.h>
+#    include <avsystem/commons/avs_socket_v_table.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    include "avs_dtls_listener.h"
+
+#    include "avs_net_impl.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#    define DTLS_RECORD_HEADER_SIZE 13
+#    define DTLS_HANDSHAKE_HEADER_SIZE 12
+#    define DTLS_RECORD_SEQUENCE_OFFSET 3
+#    define DTLS_RECORD_SEQUENCE_SIZE 8
+// offset of the Connection ID in a tls12_cid record (RFC 9146, section 4)
+#    define DTLS_CID_OFFSET 11
+
+#    define DTLS_CONTENT_TYPE_HANDSHAKE 22
+#    define DTLS_CONTENT_TYPE_TLS12_CID 25
+#    define DTLS_MAJOR_VERSION 254
+#    define DTLS_1_0_MINOR_VERSION 255
+#    define DTLS_HANDSHAKE_CLIENT_HELLO 1
+#    define DTLS_HANDSHAKE_HELLO_VERIFY_REQUEST 3
+
+#    define DTLS_RANDOM_SIZE 32
+#    define DTLS_MAX_SESSION_ID_SIZE 32
+// client_version, random and session_id of a ClientHello
+#    define CLIENT_HELLO_PARAMS_MAX_SIZE \
+        (2 + DTLS_RANDOM_SIZE + 1 + DTLS_MAX_SESSION_ID_SIZE)
+
+// cookie consists of a big-endian timestamp in seconds, and a truncated MAC
+#    define COOKIE_TIMESTAMP_SIZE 4
+#    define COOKIE_SIZE 32
+
+// record header, handshake header, server_version, cookie length and cookie
+#    define HELLO_VERIFY_REQUEST_SIZE                                 \
+        (DTLS_RECORD_HEADER_SIZE + DTLS_HANDSHAKE_HEADER_SIZE + 2 + 1 \
+         + COOKIE_SIZE)
+
+// maximum number of datagrams received from the system socket at once
+#    define RECEIVE_BATCH_SIZE 16
+
+// number of attempts at generating a Connection ID that is not used yet
+#    define CONNECTION_ID_ATTEMPTS 8
+
+typedef struct queued_datagram_struct queued_datagram_t;
+struct queued_datagram_struct {
+    queued_datagram_t *next;
+    avs_net_resolved_endpoint_t source;
+    size_t size;
+    unsigned char data[];
+};
+
+typedef struct {
+    queued_datagram_t *head;
+    queued_datagram_t *tail;
+    size_t length;
+} datagram_queue_t;
+
+typedef struct dtls_listener_struct dtls_listener_t;
+
+typedef struct dtls_peer_struct dtls_peer_t;
+struct dtls_peer_struct {
+    const avs_net_socket_v_table_t *const operations;
+    // NULL after the peer, or the whole listener, has been closed
+    dtls_listener_t *listener;
+    dtls_peer_t *endpoint_bucket_next;
+    dtls_peer_t *connection_id_bucket_next;
+
+    avs_net_resolved_endpoint_t endpoint;
+    // source address of the most recently received datagram, if different
+    // from endpoint; it is only trusted after the DTLS layer authenticates it
+    bool migration_pending;
+    avs_net_resolved_endpoint_t migration_endpoint;
+    unsigned char connection_id[AVS_NET_DTLS_LISTENER_MAX_CONNECTION_ID_LENGTH];
+
+    datagram_queue_t queue;
+    avs_net_socket_state_t state;
+    avs_time_duration_t recv_timeout;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+};
+
+struct dtls_listener_struct {
+    const avs_net_socket_v_table_t *const operations;
+    avs_net_socket_t *socket;
+    avs_time_duration_t recv_timeout;
+
+    size_t max_peers;
+    size_t max_queued_datagrams;
+    size_t max_datagram_size;
+    size_t connection_id_length;
+    int64_t cookie_lifetime_s;
+    avs_crypto_prng_ctx_t *prng_ctx;
+    unsigned char cookie_secret[AVS_NET_HMAC_SHA256_SIZE];
+
+    // hash tables of peers, chained through endpoint_bucket_next and
+    // connection_id_bucket_next, respectively; bucket_count is a power of two
+    // and connection_id_buckets is NULL if Connection IDs are disabled
+    dtls_peer_t **endpoint_buckets;
+    dtls_peer_t **connection_id_buckets;
+    size_t bucket_count;
+    size_t peer_count;
+
+    // ClientHello messages with valid cookies, waiting for accept
+    datagram_queue_t pending_hellos;
+
+    unsigned char *receive_buffer;
+    avs_net_incoming_datagram_t receive_slots[RECEIVE_BATCH_SIZE];
+};
+
+static void queue_push(datagram_queue_t *queue, queued_datagram_t *datagram) {
+    datagram->next = NULL;
+    if (queue->tail) {
+        queue->tail->next = datagram;
+    } else {
+        queue->head = datagram;
+    }
+    queue->tail = datagram;
+    ++queue->length;
+}
+
+static queued_datagram_t *queue_pop(datagram_queue_t *queue) {
+    queued_datagram_t *datagram = queue->head;
+    if (datagram) {
+        if (!(queue->head = datagram->next)) {
+            queue->tail = NULL;
+        }
+        --queue->length;
+    }
+    return datagram;
+}
+
+static void queue_clear(datagram_queue_t *queue) {
+    queued_datagram_t *datagram;
+    while ((datagram = queue_pop(queue))) {
+        avs_free(datagram);
+    }
+}
+
+static bool endpoint_equal(const avs_net_resolved_endpoint_t *a,
+                           const avs_net_resolved_endpoint_t *b) {
+    return a->size == b->size && !memcmp(a->data.buf, b->data.buf, a->size);
+}
+
+static dtls_peer_t **endpoint_bucket(dtls_listener_t *listener,
+                                     const avs_net_resolved_endpoint_t *ep) {
+    return &listener->endpoint_buckets[_avs_net_fnv1a_hash(ep->data.buf,
+                                                           ep->size)
+                                       & (listener->bucket_count - 1)];
+}
+
+static dtls_peer_t **connection_id_bucket(dtls_listener_t *listener,
+                                          const unsigned char *connection_id) {
+    assert(listener->connection_id_buckets);
+    return &listener->connection_id_buckets
+                    [_avs_net_fnv1a_hash(connection_id,
+                                         listener->connection_id_length)
+                     & (listener->bucket_count - 1)];
+}
+
+static dtls_peer_t *
+find_peer_by_endpoint(dtls_listener_t *listener,
+                      const avs_net_resolved_endpoint_t *endpoint) {
+    for (dtls_peer_t *peer = *endpoint_bucket(listener, endpoint); peer;
+         peer = peer->endpoint_bucket_next) {
+        if (endpoint_equal(&peer->endpoint, endpoint)) {
+            return peer;
+        }
+    }
+    return NULL;
+}
+
+static dtls_peer_t *
+find_peer_by_connection_id(dtls_listener_t *listener,
+                           const unsigned char *connection_id) {
+    for (dtls_peer_t *peer = *connection_id_bucket(listener, connection_id);
+         peer;
+         peer = peer->connection_id_bucket_next) {
+        if (!memcmp(peer->connection_id, connection_id,
+                    listener->connection_id_length)) {
+            return peer;
+        }
+    }
+    return NULL;
+}
+
+static void insert_peer_by_endpoint(dtls_listener_t *listener,
+                                    dtls_peer_t *peer) {
+    dtls_peer_t **bucket = endpoint_bucket(listener, &peer->endpoint);
+    peer->endpoint_bucket_next = *bucket;
+    *bucket = peer;
+}
+
+static void remove_peer_by_endpoint(dtls_listener_t *listener,
+                                    dtls_peer_t *peer) {
+    dtls_peer_t **peer_ptr = endpoint_bucket(listener, &peer->endpoint);
+    while (*peer_ptr != peer) {
+        assert(*peer_ptr);
+        peer_ptr = &(*peer_ptr)->endpoint_bucket_next;
+    }
+    *peer_ptr = peer->endpoint_bucket_next;
+    peer->endpoint_bucket_next = NULL;
+}
+
+static void detach_peer(dtls_peer_t *peer) {
+    dtls_listener_t *listener = peer->listener;
+    if (listener) {
+        remove_peer_by_endpoint(listener, peer);
+        if (listener->connection_id_buckets) {
+            dtls_peer_t **peer_ptr =
+                    connection_id_bucket(listener, peer->connection_id);
+            while (*peer_ptr != peer) {
+                assert(*peer_ptr);
+                peer_ptr = &(*peer_ptr)->connection_id_bucket_next;
+            }
+            *peer_ptr = peer->connection_id_bucket_next;
+            peer->connection_id_bucket_next = NULL;
+        }
+        --listener->peer_count;
+        peer->listener = NULL;
+    }
+    queue_clear(&peer->queue);
+}
+
+static void write_u16(unsigned char *out, uint32_t value) {
+    out[0] = (unsigned char) (value >> 8);
+    out[1] = (unsigned char) value;
+}
+
+static void write_u24(unsigned char *out, uint32_t value) {
+    out[0] = (unsigned char) (value >> 16);
+    write_u16(&out[1], value);
+}
+
+static uint32_t read_u16(const unsigned char *data) {
+    return (uint32_t) data[0] << 8 | data[1];
+}
+
+static uint32_t read_u24(const unsigned char *data) {
+    return (uint32_t) data[0] << 16 | read_u16(&data[1]);
+}
+
+typedef struct {
+    // epoch and sequence number of the record
+    const unsigned char *record_sequence;
+    // client_version, random and session_id
+    const unsigned char *params;
+    size_t params_size;
+    const unsigned char *cookie;
+    size_t cookie_size;
+} client_hello_t;
+
+/**
+ * Parses the beginning of an unfragmented ClientHello message sent in epoch 0,
+ * which is the only kind of datagram considered from unknown peers.
+ */
+static int parse_client_hello(client_hello_t *out,
+                              const unsigned char *data,
+                              size_t size) {
+    if (size < DTLS_RECORD_HEADER_SIZE + DTLS_HANDSHAKE_HEADER_SIZE
+            || data[0] != DTLS_CONTENT_TYPE_HANDSHAKE
+            || data[1] != DTLS_MAJOR_VERSION
+            || data[DTLS_RECORD_SEQUENCE_OFFSET] != 0
+            || data[DTLS_RECORD_SEQUENCE_OFFSET + 1] != 0) {
+        return -1;
+    }
+    size_t record_size = read_u16(&data[DTLS_RECORD_HEADER_SIZE - 2]);
+    if (record_size > size - DTLS_RECORD_HEADER_SIZE
+            || record_size < DTLS_HANDSHAKE_HEADER_SIZE) {
+        return -1;
+    }
+    const unsigned char *message = &data[DTLS_RECORD_HEADER_SIZE];
+    size_t body_size = read_u24(&message[1]);
+    if (message[0] != DTLS_HANDSHAKE_CLIENT_HELLO
+            || read_u24(&message[6]) != 0 // fragment_offset
+            || read_u24(&message[9]) != body_size
+            || body_size > record_size - DTLS_HANDSHAKE_HEADER_SIZE) {
+        return -1;
+    }
+    const unsigned char *body = &message[DTLS_HANDSHAKE_HEADER_SIZE];
+    size_t offset = 2 + DTLS_RANDOM_SIZE;
+    if (body_size <= offset || body[offset] > DTLS_MAX_SESSION_ID_SIZE) {
+        return -1;
+    }
+    offset += 1 + (size_t) body[offset];
+    if (body_size <= offset || body_size - offset - 1 < body[offset]) {
+        return -1;
+    }
+    out->record_sequence = &data[DTLS_RECORD_SEQUENCE_OFFSET];
+    out->params = body;
+    out->params_size = offset;
+    out->cookie = &body[offset + 1];
+    out->cookie_size = body[offset];
+    return 0;
+}
+
+static uint32_t cookie_timestamp_now(void) {
+    int64_t seconds = 0;
+    avs_time_monotonic_to_scalar(&seconds, AVS_TIME_S,
+                                 avs_time_monotonic_now());
+    return (uint32_t) seconds;
+}
+
+/**
+ * The cookie binds the ClientHello parameters to the source address and to the
+ * time it was issued, so that it can be verified without keeping any state.
+ */
+static avs_error_t calculate_cookie(dtls_listener_t *listener,
+                                    uint32_t timestamp,
+                                    const avs_net_resolved_endpoint_t *source,
+                                    const client_hello_t *hello,
+                                    unsigned char out[COOKIE_SIZE]) {
+    unsigned char input[COOKIE_TIMESTAMP_SIZE + 1
+                        + AVS_NET_SOCKET_RAW_RESOLVED_ENDPOINT_MAX_SIZE
+                        + CLIENT_HELLO_PARAMS_MAX_SIZE];
+    size_t input_size = 0;
+    write_u16(&input[input_size], timestamp >> 16);
+    write_u16(&input[input_size + 2], timestamp);
+    input_size += COOKIE_TIMESTAMP_SIZE;
+    input[input_size++] = source->size;
+    memcpy(&input[input_size], source->data.buf, source->size);
+    input_size += source->size;
+    assert(hello->params_size <= CLIENT_HELLO_PARAMS_MAX_SIZE);
+    memcpy(&input[input_size], hello->params, hello->params_size);
+    input_size += hello->params_size;
+
+    unsigned char mac[AVS_NET_HMAC_SHA256_SIZE];
+    avs_error_t err =
+            _avs_net_hmac_sha256(listener->cookie_secret,
+                                 sizeof(listener->cookie_secret), input,
+                                 input_size, mac);
+    if (avs_is_ok(err)) {
+        memcpy(out, input, COOKIE_TIMESTAMP_SIZE);
+        memcpy(&out[COOKIE_TIMESTAMP_SIZE], mac,
+               COOKIE_SIZE - COOKIE_TIMESTAMP_SIZE);
+    }
+    return err;
+}
+
+static bool verify_cookie(dtls_listener_t *listener,
+                          const avs_net_resolved_endpoint_t *source,
+                          const client_hello_t *hello) {
+    if (hello->cookie_size != COOKIE_SIZE) {
+        return false;
+    }
+    uint32_t timestamp = (uint32_t) read_u16(hello->cookie) << 16
+                         | read_u16(&hello->cookie[2]);
+    // unsigned arithmetic, so that wrap-arounds are handled correctly
+    if ((int64_t) (uint32_t) (cookie_timestamp_now() - timestamp)
+            > listener->cookie_lifetime_s) {
+        return false;
+    }
+    unsigned char expected[COOKIE_SIZE];
+    if (avs_is_err(calculate_cookie(listener, timestamp, source, hello,
+                                    expected))) {
+        return false;
+    }
+    // constant-time comparison
+    unsigned char difference = 0;
+    for (size_t i = 0; i < COOKIE_SIZE; ++i) {
+        difference |= (unsigned char) (expected[i] ^ hello->cookie[i]);
+    }
+    return !difference;
+}
+
+static avs_error_t
+send_datagram(dtls_listener_t *listener,
+              const avs_net_resolved_endpoint_t *destination,
+              const void *data,
+              size_t size) {
+    const avs_net_outgoing_datagram_t datagram = {
+        .buffer = data,
+        .buffer_length = size,
+        .destination = destination
+    };
+    size_t sent_count = 0;
+    avs_error_t err = avs_net_socket_send_to_many(listener->socket, &datagram,
+                                                  1, &sent_count);
+    if (avs_is_ok(err) && sent_count != 1) {
+        err = avs_errno(AVS_EIO);
+    }
+    return err;
+}
+
+static void
+send_hello_verify_request(dtls_listener_t *listener,
+                          const avs_net_resolved_endpoint_t *destination,
+                          const client_hello_t *hello) {
+    unsigned char message[HELLO_VERIFY_REQUEST_SIZE];
+    unsigned char *const record = message;
+    unsigned char *const handshake = &record[DTLS_RECORD_HEADER_SIZE];
+    unsigned char *const body = &handshake[DTLS_HANDSHAKE_HEADER_SIZE];
+    const uint32_t body_size = 2 + 1 + COOKIE_SIZE;
+
+    if (avs_is_err(calculate_cookie(listener, cookie_timestamp_now(),
+                                    destination, hello, &body[3]))) {
+        LOG(ERROR, _("could not calculate DTLS cookie"));
+        return;
+    }
+    // the record sequence number is copied from the ClientHello, and the
+    // version is always DTLS 1.0, as mandated by RFC 6347, section 4.2.1
+    record[0] = DTLS_CONTENT_TYPE_HANDSHAKE;
+    record[1] = DTLS_MAJOR_VERSION;
+    record[2] = DTLS_1_0_MINOR_VERSION;
+    memcpy(&record[DTLS_RECORD_SEQUENCE_OFFSET], hello->record_sequence,
+           DTLS_RECORD_SEQUENCE_SIZE);
+    write_u16(&record[DTLS_RECORD_HEADER_SIZE - 2],
+              DTLS_HANDSHAKE_HEADER_SIZE + body_size);
+    // message_seq and fragment_offset are zero
+    memset(handshake, 0, DTLS_HANDSHAKE_HEADER_SIZE);
+    handshake[0] = DTLS_HANDSHAKE_HELLO_VERIFY_REQUEST;
+    write_u24(&handshake[1], body_size);
+    write_u24(&handshake[9], body_size);
+    body[0] = DTLS_MAJOR_VERSION;
+    body[1] = DTLS_1_0_MINOR_VERSION;
+    body[2] = COOKIE_SIZE;
+
+    avs_error_t err =
+            send_datagram(listener, destination, message, sizeof(message));
+    if (avs_is_err(err)) {
+        LOG(DEBUG, _("could not send HelloVerifyRequest"));
+    }
+}
+
+static void enqueue_datagram(dtls_listener_t *listener,
+                             datagram_queue_t *queue,
+                             const avs_net_incoming_datagram_t *received) {
+    if (queue->length >= listener->max_queued_datagrams) {
+        LOG(DEBUG, _("queue full, dropping datagram"));
+        return;
+    }
+    queued_datagram_t *datagram = (queued_datagram_t *) avs_malloc(
+            sizeof(queued_datagram_t) + received->out_size);
+    if (!datagram) {
+        LOG_OOM();
+        return;
+    }
+    datagram->source = received->out_source;
+    datagram->size = received->out_size;
+    memcpy(datagram->data, received->buffer, received->out_size);
+    queue_push(queue, datagram);
+}
+
+static void
+handle_datagram_from_unknown_peer(dtls_listener_t *listener,
+                                  const avs_net_incoming_datagram_t *received) {
+    client_hello_t hello;
+    if (parse_client_hello(&hello, (const unsigned char *) received->buffer,
+                           received->out_size)) {
+        LOG(TRACE, _("dropping datagram from unknown peer"));
+    } else if (!verify_cookie(listener, &received->out_source, &hello)) {
+        send_hello_verify_request(listener, &received->out_source, &hello);
+    } else if (listener->peer_count + listener->pending_hellos.length
+               >= listener->max_peers) {
+        LOG(WARNING, _("DTLS peer limit reached, dropping ClientHello"));
+    } else {
+        enqueue_datagram(listener, &listener->pending_hellos, received);
+    }
+}
+
+static dtls_peer_t *
+find_recipient(dtls_listener_t *listener,
+               const avs_net_incoming_datagram_t *received) {
+    const unsigned char *data = (const unsigned char *) received->buffer;
+    dtls_peer_t *peer = NULL;
+    if (listener->connection_id_buckets
+            && received->out_size
+                           >= DTLS_CID_OFFSET + listener->connection_id_length
+            && data[0] == DTLS_CONTENT_TYPE_TLS12_CID) {
+        peer = find_peer_by_connection_id(listener, &data[DTLS_CID_OFFSET]);
+    }
+    if (!peer) {
+        peer = find_peer_by_endpoint(listener, &received->out_source);
+    }
+    return peer;
+}
+
+static void dispatch_datagram(dtls_listener_t *listener,
+                              const avs_net_incoming_datagram_t *received) {
+    if (received->out_truncated) {
+        LOG(DEBUG, _("dropping truncated datagram"));
+        return;
+    }
+    dtls_peer_t *peer = find_recipient(listener, received);
+    if (peer) {
+        enqueue_datagram(listener, &peer->queue, received);
+    } else {
+        handle_datagram_from_unknown_peer(listener, received);
+    }
+}
+
+/**
+ * Receives all datagrams currently waiting in the system socket, waiting until
+ * @p deadline for at least one, and routes them to the appropriate queues.
+ *
+ * If @p direct_recipient is not NULL, its queue shall be empty, and the first
+ * datagram is received straight into @p direct_buffer , which shall be able to
+ * hold <c>max_datagram_size</c> bytes. If that datagram turns out to be
+ * addressed to @p direct_recipient , it is left there without being queued,
+ * and <c>*out_direct</c> is set to the slot that describes it. Otherwise, it
+ * is routed like any other datagram and <c>*out_direct</c> is set to NULL.
+ */
+static avs_error_t
+receive_datagrams(dtls_listener_t *listener,
+                  avs_time_monotonic_t deadline,
+                  dtls_peer_t *direct_recipient,
+                  void *direct_buffer,
+                  const avs_net_incoming_datagram_t **out_direct) {
+    if (out_direct) {
+        *out_direct = NULL;
+    }
+    avs_net_socket_opt_value_t timeout;
+    timeout.recv_timeout =
+            avs_time_monotonic_diff(deadline, avs_time_monotonic_now());
+    if (avs_time_duration_less(timeout.recv_timeout,
+                               AVS_TIME_DURATION_ZERO)) {
+        timeout.recv_timeout = AVS_TIME_DURATION_ZERO;
+    }
+    avs_error_t err = avs_net_socket_set_opt(
+            listener->socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, timeout);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    for (size_t i = 0; i < RECEIVE_BATCH_SIZE; ++i) {
+        listener->receive_slots[i].buffer =
+                &listener->receive_buffer[i * listener->max_datagram_size];
+        listener->receive_slots[i].buffer_length = listener->max_datagram_size;
+    }
+    if (direct_recipient) {
+        assert(!direct_recipient->queue.head);
+        listener->receive_slots[0].buffer = direct_buffer;
+    }
+    size_t received_count = 0;
+    if (avs_is_err((err = avs_net_socket_receive_from_many(
+                            listener->socket, listener->receive_slots,
+                            RECEIVE_BATCH_SIZE, &received_count)))) {
+        return err;
+    }
+    size_t i = 0;
+    if (direct_recipient && received_count > 0
+            && !listener->receive_slots[0].out_truncated
+            && find_recipient(listener, &listener->receive_slots[0])
+                           == direct_recipient) {
+        *out_direct = &listener->receive_slots[0];
+        i = 1;
+    }
+    for (; i < received_count; ++i) {
+        dispatch_datagram(listener, &listener->receive_slots[i]);
+    }
+    return AVS_OK;
+}
+
+static bool deadline_passed(avs_time_monotonic_t deadline) {
+    return avs_time_monotonic_valid(deadline)
+           && !avs_time_monotonic_before(avs_time_monotonic_now(), deadline);
+}
+
+static avs_error_t send_peer(avs_net_socket_t *peer_,
+                             const void *buffer,
+                             size_t buffer_length) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    if (!peer->listener) {
+        return avs_errno(AVS_EBADF);
+    }
+    avs_error_t err = send_datagram(peer->listener, &peer->endpoint, buffer,
+                                    buffer_length);
+    if (avs_is_ok(err)) {
+        peer->bytes_sent += buffer_length;
+    }
+    return err;
+}
+
+static void update_peer_source(dtls_peer_t *peer,
+                               const avs_net_resolved_endpoint_t *source) {
+    if ((peer->migration_pending = !endpoint_equal(source, &peer->endpoint))) {
+        peer->migration_endpoint = *source;
+    }
+}
+
+static avs_error_t receive_peer(avs_net_socket_t *peer_,
+                                size_t *out_bytes_received,
+                                void *buffer,
+                                size_t buffer_length) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    *out_bytes_received = 0;
+    avs_time_monotonic_t deadline =
+            avs_time_monotonic_add(avs_time_monotonic_now(),
+                                   peer->recv_timeout);
+    queued_datagram_t *datagram;
+    while (!(datagram = queue_pop(&peer->queue))) {
+        if (!peer->listener) {
+            return avs_errno(AVS_EBADF);
+        }
+        // if the caller's buffer can hold any datagram, receive straight into
+        // it, so that the (D)TLS layer gets the record without extra copying
+        bool receive_directly =
+                buffer_length >= peer->listener->max_datagram_size;
+        const avs_net_incoming_datagram_t *direct = NULL;
+        avs_error_t err =
+                receive_datagrams(peer->listener, deadline,
+                                  receive_directly ? peer : NULL, buffer,
+                                  &direct);
+        if (avs_is_err(err)) {
+            return err;
+        }
+        if (direct) {
+            update_peer_source(peer, &direct->out_source);
+            *out_bytes_received = direct->out_size;
+            peer->bytes_received += direct->out_size;
+            return AVS_OK;
+        }
+        if (!peer->queue.head && deadline_passed(deadline)) {
+            return avs_errno(AVS_ETIMEDOUT);
+        }
+    }
+
+    update_peer_source(peer, &datagram->source);
+    *out_bytes_received = AVS_MIN(datagram->size, buffer_length);
+    memcpy(buffer, datagram->data, *out_bytes_received);
+    peer->bytes_received += *out_bytes_received;
+    bool truncated = datagram->size > buffer_length;
+    avs_free(datagram);
+    return truncated ? avs_errno(AVS_EMSGSIZE) : AVS_OK;
+}
+
+static avs_error_t close_peer(avs_net_socket_t *peer_) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    detach_peer(peer);
+    peer->state = AVS_NET_SOCKET_STATE_CLOSED;
+    return AVS_OK;
+}
+
+static avs_error_t shutdown_peer(avs_net_socket_t *peer_) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    detach_peer(peer);
+    peer->state = AVS_NET_SOCKET_STATE_SHUTDOWN;
+    return AVS_OK;
+}
+
+static avs_error_t cleanup_peer(avs_net_socket_t **peer_) {
+    close_peer(*peer_);
+    avs_free(*peer_);
+    *peer_ = NULL;
+    return AVS_OK;
+}
+
+static const void *get_system_peer(avs_net_socket_t *peer_) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    return peer->listener ? avs_net_socket_get_system(peer->listener->socket)
+                          : NULL;
+}
+
+static avs_error_t
+get_interface_peer(avs_net_socket_t *peer_,
+                   avs_net_socket_interface_name_t *if_name) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    if (!peer->listener) {
+        return avs_errno(AVS_EBADF);
+    }
+    return avs_net_socket_interface_name(peer->listener->socket, if_name);
+}
+
+static avs_error_t get_remote_host_peer(avs_net_socket_t *peer_,
+                                        char *out_buffer,
+                                        size_t out_buffer_size) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    return avs_net_resolved_endpoint_get_host_port(
+            &peer->endpoint, out_buffer, out_buffer_size, NULL, 0);
+}
+
+static avs_error_t get_remote_port_peer(avs_net_socket_t *peer_,
+                                        char *out_buffer,
+                                        size_t out_buffer_size) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    return avs_net_resolved_endpoint_get_host_port(&peer->endpoint, NULL, 0,
+                                                   out_buffer,
+                                                   out_buffer_size);
+}
+
+static avs_error_t get_local_host_peer(avs_net_socket_t *peer_,
+                                       char *out_buffer,
+                                       size_t out_buffer_size) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    if (!peer->listener) {
+        return avs_errno(AVS_EBADF);
+    }
+    return avs_net_socket_get_local_host(peer->listener->socket, out_buffer,
+                                         out_buffer_size);
+}
+
+static avs_error_t get_local_port_peer(avs_net_socket_t *peer_,
+                                       char *out_buffer,
+                                       size_t out_buffer_size) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    if (!peer->listener) {
+        return avs_errno(AVS_EBADF);
+    }
+    return avs_net_socket_get_local_port(peer->listener->socket, out_buffer,
+                                         out_buffer_size);
+}
+
+static avs_error_t get_opt_peer(avs_net_socket_t *peer_,
+                                avs_net_socket_opt_key_t option_key,
+                                avs_net_socket_opt_value_t *out_option_value) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_RECV_TIMEOUT:
+        out_option_value->recv_timeout = peer->recv_timeout;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_STATE:
+        out_option_value->state = peer->state;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_BYTES_SENT:
+        out_option_value->bytes_sent = peer->bytes_sent;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_BYTES_RECEIVED:
+        out_option_value->bytes_received = peer->bytes_received;
+        return AVS_OK;
+    case AVS_NET_SOCKET_HAS_BUFFERED_DATA:
+        out_option_value->flag = !!peer->queue.head;
+        return AVS_OK;
+    default:
+        if (!peer->listener) {
+            return avs_errno(AVS_EBADF);
+        }
+        return avs_net_socket_get_opt(peer->listener->socket, option_key,
+                                      out_option_value);
+    }
+}
+
+static avs_error_t set_opt_peer(avs_net_socket_t *peer_,
+                                avs_net_socket_opt_key_t option_key,
+                                avs_net_socket_opt_value_t option_value) {
+    dtls_peer_t *peer = (dtls_peer_t *) peer_;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_RECV_TIMEOUT:
+        peer->recv_timeout = option_value.recv_timeout;
+        return AVS_OK;
+    default:
+        return avs_errno(AVS_EINVAL);
+    }
+}
+
+static const avs_net_socket_v_table_t peer_vtable = {
+    .send = send_peer,
+    .receive = receive_peer,
+    .close = close_peer,
+    .shutdown = shutdown_peer,
+    .cleanup = cleanup_peer,
+    .get_system_socket = get_system_peer,
+    .get_interface_name = get_interface_peer,
+    .get_remote_host = get_remote_host_peer,
+    .get_remote_hostname = get_remote_host_peer,
+    .get_remote_port = get_remote_port_peer,
+    .get_local_host = get_local_host_peer,
+    .get_local_port = get_local_port_peer,
+    .get_opt = get_opt_peer,
+    .set_opt = set_opt_peer
+};
+
+static avs_error_t create_peer(dtls_listener_t *listener,
+                               queued_datagram_t *client_hello,
+                               dtls_peer_t **out_peer) {
+    static const avs_net_socket_v_table_t *const VTABLE_PTR = &peer_vtable;
+    dtls_peer_t *peer = (dtls_peer_t *) avs_calloc(1, sizeof(dtls_peer_t));
+    if (!peer) {
+        LOG_OOM();
+        return avs_errno(AVS_ENOMEM);
+    }
+    memcpy((void *) (intptr_t) &peer->operations, &VTABLE_PTR,
+           sizeof(VTABLE_PTR));
+
+    if (listener->connection_id_buckets) {
+        size_t attempt = 0;
+        do {
+            if (++attempt > CONNECTION_ID_ATTEMPTS
+                    || avs_crypto_prng_bytes(listener->prng_ctx,
+                                             peer->connection_id,
+                                             listener->connection_id_length)) {
+                LOG(ERROR, _("could not generate DTLS Connection ID"));
+                avs_free(peer);
+                return avs_errno(AVS_EIO);
+            }
+        } while (find_peer_by_connection_id(listener, peer->connection_id));
+        dtls_peer_t **bucket =
+                connection_id_bucket(listener, peer->connection_id);
+        peer->connection_id_bucket_next = *bucket;
+        *bucket = peer;
+    }
+    peer->listener = listener;
+    peer->endpoint = client_hello->source;
+    insert_peer_by_endpoint(listener, peer);
+    ++listener->peer_count;
+
+    peer->state = AVS_NET_SOCKET_STATE_ACCEPTED;
+    peer->recv_timeout = AVS_NET_SOCKET_DEFAULT_RECV_TIMEOUT;
+    queue_push(&peer->queue, client_hello);
+    *out_peer = peer;
+    return AVS_OK;
+}
+
+static avs_error_t bind_listener(avs_net_socket_t *listener_,
+                                 const char *address,
+                                 const char *port) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    return avs_net_socket_bind(listener->socket, address, port);
+}
+
+static avs_error_t accept_listener(avs_net_socket_t *listener_,
+                                   avs_net_socket_t *new_socket) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    avs_net_socket_opt_value_t state;
+    avs_error_t err = avs_net_socket_get_opt(listener->socket,
+                                             AVS_NET_SOCKET_OPT_STATE, &state);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    if (state.state != AVS_NET_SOCKET_STATE_BOUND) {
+        LOG(ERROR, _("DTLS listener is not bound"));
+        return avs_errno(AVS_EBADF);
+    }
+
+    avs_time_monotonic_t deadline =
+            avs_time_monotonic_add(avs_time_monotonic_now(),
+                                   listener->recv_timeout);
+    dtls_peer_t *peer = NULL;
+    while (!peer) {
+        queued_datagram_t *client_hello = queue_pop(&listener->pending_hellos);
+        if (!client_hello) {
+            if (avs_is_err((err = receive_datagrams(listener, deadline, NULL,
+                                                     NULL, NULL)))) {
+                return err;
+            }
+            if (!listener->pending_hellos.head && deadline_passed(deadline)) {
+                return avs_errno(AVS_ETIMEDOUT);
+            }
+            continue;
+        }
+        dtls_peer_t *existing = find_peer_by_endpoint(listener,
+                                                      &client_hello->source);
+        if (existing) {
+            // retransmission from a peer accepted in the meantime
+            if (existing->queue.length < listener->max_queued_datagrams) {
+                queue_push(&existing->queue, client_hello);
+            } else {
+                avs_free(client_hello);
+            }
+        } else if (avs_is_err((err = create_peer(listener, client_hello,
+                                                 &peer)))) {
+            avs_free(client_hello);
+            return err;
+        }
+    }
+
+    avs_net_socket_t *peer_socket = (avs_net_socket_t *) peer;
+    if (avs_is_err((err = avs_net_socket_decorate(new_socket, peer_socket)))) {
+        avs_net_socket_cleanup(&peer_socket);
+    }
+    return err;
+}
+
+static avs_error_t close_listener(avs_net_socket_t *listener_) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    for (size_t i = 0; i < listener->bucket_count; ++i) {
+        while (listener->endpoint_buckets[i]) {
+            dtls_peer_t *peer = listener->endpoint_buckets[i];
+            detach_peer(peer);
+            peer->state = AVS_NET_SOCKET_STATE_CLOSED;
+        }
+    }
+    assert(!listener->peer_count);
+    queue_clear(&listener->pending_hellos);
+    return avs_net_socket_close(listener->socket);
+}
+
+static avs_error_t cleanup_listener(avs_net_socket_t **listener_) {
+    dtls_listener_t *listener = (dtls_listener_t *) *listener_;
+    avs_error_t err = close_listener(*listener_);
+    avs_net_socket_cleanup(&listener->socket);
+    avs_free(listener->endpoint_buckets);
+    avs_free(listener->connection_id_buckets);
+    avs_free(listener->receive_buffer);
+    avs_free(listener);
+    *listener_ = NULL;
+    return err;
+}
+
+static const void *get_system_listener(avs_net_socket_t *listener_) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    return avs_net_socket_get_system(listener->socket);
+}
+
+static avs_error_t
+get_interface_listener(avs_net_socket_t *listener_,
+                       avs_net_socket_interface_name_t *if_name) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    return avs_net_socket_interface_name(listener->socket, if_name);
+}
+
+static avs_error_t get_local_host_listener(avs_net_socket_t *listener_,
+                                           char *out_buffer,
+                                           size_t out_buffer_size) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    return avs_net_socket_get_local_host(listener->socket, out_buffer,
+                                         out_buffer_size);
+}
+
+static avs_error_t get_local_port_listener(avs_net_socket_t *listener_,
+                                           char *out_buffer,
+                                           size_t out_buffer_size) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    return avs_net_socket_get_local_port(listener->socket, out_buffer,
+                                         out_buffer_size);
+}
+
+static avs_error_t
+get_opt_listener(avs_net_socket_t *listener_,
+                 avs_net_socket_opt_key_t option_key,
+                 avs_net_socket_opt_value_t *out_option_value) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_RECV_TIMEOUT:
+        out_option_value->recv_timeout = listener->recv_timeout;
+        return AVS_OK;
+    case AVS_NET_SOCKET_HAS_BUFFERED_DATA:
+        out_option_value->flag = !!listener->pending_hellos.head;
+        return AVS_OK;
+    default:
+        return avs_net_socket_get_opt(listener->socket, option_key,
+                                      out_option_value);
+    }
+}
+
+static avs_error_t set_opt_listener(avs_net_socket_t *listener_,
+                                    avs_net_socket_opt_key_t option_key,
+                                    avs_net_socket_opt_value_t option_value) {
+    dtls_listener_t *listener = (dtls_listener_t *) listener_;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_RECV_TIMEOUT:
+        listener->recv_timeout = option_value.recv_timeout;
+        return AVS_OK;
+    default:
+        return avs_net_socket_set_opt(listener->socket, option_key,
+                                      option_value);
+    }
+}
+
+static const avs_net_socket_v_table_t listener_vtable = {
+    .bind = bind_listener,
+    .accept = accept_listener,
+    .close = close_listener,
+    .shutdown = close_listener,
+    .cleanup = cleanup_listener,
+    .get_system_socket = get_system_listener,
+    .get_interface_name = get_interface_listener,
+    .get_local_host = get_local_host_listener,
+    .get_local_port = get_local_port_listener,
+    .get_opt = get_opt_listener,
+    .set_opt = set_opt_listener
+};
+
+avs_error_t _avs_net_create_dtls_listener_socket(
+        avs_net_socket_t **socket, const void *socket_configuration) {
+    static const avs_net_socket_v_table_t *const VTABLE_PTR = &listener_vtable;
+    const avs_net_dtls_listener_configuration_t *config =
+            (const avs_net_dtls_listener_configuration_t *)
+                    socket_configuration;
+    assert(socket);
+    assert(!*socket);
+    if (!config || !config->max_peers || !config->max_queued_datagrams
+            || !config->max_datagram_size
+            || config->max_datagram_size > SIZE_MAX / RECEIVE_BATCH_SIZE
+            || config->connection_id_length
+                           > AVS_NET_DTLS_LISTENER_MAX_CONNECTION_ID_LENGTH
+            || !avs_time_duration_valid(config->cookie_lifetime)
+            || !avs_time_duration_less(AVS_TIME_DURATION_ZERO,
+                                       config->cookie_lifetime)
+            || !config->prng_ctx) {
+        LOG(ERROR, _("invalid DTLS listener configuration"));
+        return avs_errno(AVS_EINVAL);
+    }
+
+    dtls_listener_t *listener =
+            (dtls_listener_t *) avs_calloc(1, sizeof(dtls_listener_t));
+    if (!listener) {
+        LOG_OOM();
+        return avs_errno(AVS_ENOMEM);
+    }
+    memcpy((void *) (intptr_t) &listener->operations, &VTABLE_PTR,
+           sizeof(VTABLE_PTR));
+    listener->recv_timeout = AVS_NET_SOCKET_DEFAULT_RECV_TIMEOUT;
+    listener->max_peers = config->max_peers;
+    listener->max_queued_datagrams = config->max_queued_datagrams;
+    listener->max_datagram_size = config->max_datagram_size;
+    listener->connection_id_length = config->connection_id_length;
+    listener->prng_ctx = config->prng_ctx;
+    avs_time_duration_to_scalar(&listener->cookie_lifetime_s, AVS_TIME_S,
+                                config->cookie_lifetime);
+    // cookies are verified with a granularity of one second
+    listener->cookie_lifetime_s = AVS_MAX(listener->cookie_lifetime_s, 1);
+
+    // aim for load factor of at most 1
+    listener->bucket_count = 1;
+    while (listener->bucket_count < listener->max_peers
+           && listener->bucket_count <= SIZE_MAX / 2) {
+        listener->bucket_count *= 2;
+    }
+
+    avs_net_socket_t *listener_socket = (avs_net_socket_t *) listener;
+    avs_error_t err = AVS_OK;
+    if (!(listener->endpoint_buckets = (dtls_peer_t **) avs_calloc(
+                  listener->bucket_count, sizeof(dtls_peer_t *)))
+            || (listener->connection_id_length
+                && !(listener->connection_id_buckets =
+                             (dtls_peer_t **) avs_calloc(
+                                     listener->bucket_count,
+                                     sizeof(dtls_peer_t *))))
+            || !(listener->receive_buffer = (unsigned char *) avs_malloc(
+                         RECEIVE_BATCH_SIZE * listener->max_datagram_size))) {
+        LOG_OOM();
+        err = avs_errno(AVS_ENOMEM);
+    } else if (avs_crypto_prng_bytes(listener->prng_ctx,
+                                     listener->cookie_secret,
+                                     sizeof(listener->cookie_secret))) {
+        LOG(ERROR, _("could not generate DTLS cookie secret"));
+        err = avs_errno(AVS_EIO);
+    } else {
+        // check early whether the backend supports listeners at all
+        unsigned char mac[AVS_NET_HMAC_SHA256_SIZE];
+        if (avs_is_ok((err = _avs_net_hmac_sha256(
+                               listener->cookie_secret,
+                               sizeof(listener->cookie_secret),
+                               listener->cookie_secret,
+                               sizeof(listener->cookie_secret), mac)))) {
+            err = avs_net_udp_socket_create(&listener->socket,
+                                            &config->backend_configuration);
+        }
+    }
+    if (avs_is_err(err)) {
+        cleanup_listener(&listener_socket);
+        return err;
+    }
+    *socket = listener_socket;
+    return AVS_OK;
+}
+
+bool _avs_net_dtls_listener_is_peer(avs_net_socket_t *socket,
+                                    const unsigned char **out_connection_id,
+                                    size_t *out_connection_id_size) {
+    dtls_peer_t *peer = (dtls_peer_t *) socket;
+    if (!peer || peer->operations != &peer_vtable) {
+        return false;
+    }
+    if (out_connection_id) {
+        *out_connection_id = NULL;
+    }
+    if (out_connection_id_size) {
+        *out_connection_id_size = 0;
+    }
+    if (peer->listener && peer->listener->connection_id_buckets) {
+        if (out_connection_id) {
+            *out_connection_id = peer->connection_id;
+        }
+        if (out_connection_id_size) {
+            *out_connection_id_size = peer->listener->connection_id_length;
+        }
+    }
+    return true;
+}
+
+void _avs_net_dtls_listener_peer_authenticated(avs_net_socket_t *socket) {
+    if (!_avs_net_dtls_listener_is_peer(socket, NULL, NULL)) {
+        return;
+    }
+    dtls_peer_t *peer = (dtls_peer_t *) socket;
+    if (peer->listener && peer->migration_pending) {
+        dtls_peer_t *stale =
+                find_peer_by_endpoint(peer->listener,
+                                      &peer->migration_endpoint);
+        if (stale) {
+            // the address has just been proven to belong to this peer, so the
+            // other one must have lost it, e.g. due to a NAT rebinding
+            assert(stale != peer);
+            LOG(DEBUG, _("closing stale DTLS peer at the migrated-to address"));
+            detach_peer(stale);
+            stale->state = AVS_NET_SOCKET_STATE_CLOSED;
+        }
+        remove_peer_by_endpoint(peer->listener, peer);
+        peer->endpoint = peer->migration_endpoint;
+        insert_peer_by_endpoint(peer->listener, peer);
+        LOG(DEBUG, _("DTLS peer migrated to a new address"));
+    }
+    peer->migration_pending = false;
+}
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/net/dtls_listener.c"
+#    endif // AVS_UNIT_TESTING
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // defined(AVS_COMMONS_WITH_AVS_CRYPTO) &&
+       // defined(AVS_COMMONS_NET_WITH_DTLS_LISTENER) &&
+       // !defined(AVS_COMMONS_WITHOUT_TLS) &&
+       // !defined(AVS_COMMONS_WITH_CUSTOM_TLS)
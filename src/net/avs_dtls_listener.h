@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_NET_DTLS_LISTENER_H
+#define AVS_COMMONS_NET_DTLS_LISTENER_H
+
+#include <avsystem/commons/avs_socket.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+#define AVS_NET_HMAC_SHA256_SIZE 32
+
+/**
+ * Socket constructor, compatible with the other ones declared in
+ * avs_net_impl.h; @p socket_configuration is a pointer to
+ * @ref avs_net_dtls_listener_configuration_t .
+ */
+avs_error_t _avs_net_create_dtls_listener_socket(
+        avs_net_socket_t **socket, const void *socket_configuration);
+
+/**
+ * Checks whether @p socket is a peer socket accepted by a DTLS listener.
+ *
+ * Such sockets are only created after the peer has returned a valid cookie, so
+ * the (D)TLS backend shall continue the handshake from the ClientHello that
+ * contains it, without performing its own HelloVerifyRequest exchange.
+ *
+ * @param out_connection_id      If not NULL, set to the Connection ID that the
+ *                               peer shall use, or NULL if none is assigned.
+ * @param out_connection_id_size If not NULL, set to the length of the
+ *                               Connection ID.
+ */
+bool _avs_net_dtls_listener_is_peer(avs_net_socket_t *socket,
+                                    const unsigned char **out_connection_id,
+                                    size_t *out_connection_id_size);
+
+/**
+ * Notifies the listener that the datagram most recently received through a
+ * peer socket has been authenticated by the DTLS layer, so that further
+ * datagrams may be sent to its source address if the peer has migrated. Any
+ * other peer still bound to that address is closed. Does nothing if @p socket
+ * is not a peer socket.
+ */
+void _avs_net_dtls_listener_peer_authenticated(avs_net_socket_t *socket);
+
+/**
+ * Calculates HMAC-SHA256 of @p data . Implemented by the (D)TLS backend.
+ *
+ * @returns @ref AVS_OK for success, <c>avs_errno(AVS_ENOTSUP)</c> if the
+ *          backend does not support DTLS listeners, or other error condition.
+ */
+avs_error_t _avs_net_hmac_sha256(const void *key,
+                                 size_t key_size,
+                                 const void *data,
+                                 size_t data_size,
+                                 unsigned char out[AVS_NET_HMAC_SHA256_SIZE]);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // AVS_COMMONS_NET_DTLS_LISTENER_H
@@ -17,6 +17,7 @@
 #ifndef NET_H
 #define NET_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <avsystem/commons/avs_socket_v_table.h>
@@ -52,6 +53,20 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 
 #define AVS_NET_RESOLVE_DUMMY_PORT "1337"
 
+/**
+ * Calculates the 32-bit FNV-1a hash of @p data , for selecting hash table
+ * buckets. Not suitable for anything where collisions matter beyond
+ * performance.
+ */
+static inline uint32_t _avs_net_fnv1a_hash(const void *data, size_t size) {
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= ((const unsigned char *) data)[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
 avs_error_t _avs_net_create_tcp_socket(avs_net_socket_t **socket,
                                        const void *socket_configuration);
 avs_error_t _avs_net_create_udp_socket(avs_net_socket_t **socket,
@@ -62,6 +77,14 @@ avs_error_t _avs_net_create_ssl_socket(avs_net_socket_t **socket,
                                        const void *socket_configuration);
 avs_error_t _avs_net_create_dtls_socket(avs_net_socket_t **socket,
                                         const void *socket_configuration);
+
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO
+avs_error_t
+_avs_net_tls_context_create(avs_net_tls_context_t **out_context,
+                            avs_net_socket_type_t socket_type,
+                            const avs_net_ssl_configuration_t *configuration);
+void _avs_net_tls_context_release(avs_net_tls_context_t **context);
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO
 #endif // AVS_COMMONS_WITHOUT_TLS
 
 VISIBILITY_PRIVATE_HEADER_END
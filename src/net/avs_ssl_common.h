@@ -21,6 +21,8 @@
 #    error "This header is not meant to be included from outside"
 #endif
 
+#include <assert.h>
+
 #include <avsystem/commons/avs_memory.h>
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -38,6 +40,10 @@ static avs_error_t
 initialize_ssl_socket(ssl_socket_t *socket,
                       avs_net_socket_type_t backend_type,
                       const avs_net_ssl_configuration_t *configuration);
+static avs_error_t
+initialize_tls_context(avs_net_tls_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration);
+static void cleanup_tls_context(avs_net_tls_context_t *context);
 
 /* avs_net_socket_v_table_t ssl handlers implemented differently per backend */
 static avs_error_t send_ssl(avs_net_socket_t *ssl_socket,
@@ -90,6 +96,75 @@ static avs_error_t ensure_have_backend_socket(ssl_socket_t *socket) {
     return AVS_OK;
 }
 
+static avs_net_socket_type_t
+ssl_socket_type(avs_net_socket_type_t backend_type) {
+    return backend_type == AVS_NET_UDP_SOCKET ? AVS_NET_DTLS_SOCKET
+                                              : AVS_NET_SSL_SOCKET;
+}
+
+/*
+ * Each backend's avs_net_tls_context_struct is required to contain at least the
+ * following fields:
+ *
+ * - avs_mutex_t *mutex;
+ * - size_t refcount;
+ * - avs_net_socket_type_t socket_type;
+ */
+static avs_error_t
+create_tls_context(avs_net_tls_context_t **out_context,
+                   avs_net_socket_type_t socket_type,
+                   const avs_net_ssl_configuration_t *configuration) {
+    avs_net_tls_context_t *context =
+            (avs_net_tls_context_t *) avs_calloc(1, sizeof(*context));
+    if (!context) {
+        LOG_OOM();
+        return avs_errno(AVS_ENOMEM);
+    }
+    context->socket_type = socket_type;
+    context->refcount = 1;
+
+    avs_error_t err = avs_errno(AVS_ENOMEM);
+    if (!avs_mutex_create(&context->mutex)
+            && avs_is_ok((err = initialize_tls_context(context,
+                                                       configuration)))) {
+        *out_context = context;
+        return AVS_OK;
+    }
+    cleanup_tls_context(context);
+    avs_mutex_cleanup(&context->mutex);
+    avs_free(context);
+    return err;
+}
+
+static avs_net_tls_context_t *
+acquire_tls_context(avs_net_tls_context_t *context) {
+    if (avs_mutex_lock(context->mutex)) {
+        AVS_UNREACHABLE("could not lock mutex");
+    }
+    ++context->refcount;
+    avs_mutex_unlock(context->mutex);
+    return context;
+}
+
+static void release_tls_context(avs_net_tls_context_t **context_ptr) {
+    avs_net_tls_context_t *context = *context_ptr;
+    if (!context) {
+        return;
+    }
+    *context_ptr = NULL;
+    if (avs_mutex_lock(context->mutex)) {
+        AVS_UNREACHABLE("could not lock mutex");
+    }
+    assert(context->refcount > 0);
+    bool last_reference = !--context->refcount;
+    avs_mutex_unlock(context->mutex);
+    if (last_reference) {
+        cleanup_tls_context(context);
+        avs_mutex_cleanup(&context->mutex);
+        avs_free(context);
+    }
+}
+
 static avs_error_t create_ssl_socket(avs_net_socket_t **socket,
                                      avs_net_socket_type_t backend_type,
                                      const void *socket_configuration) {
@@ -99,6 +174,14 @@ static avs_error_t create_ssl_socket(avs_net_socket_t **socket,
         LOG(ERROR, _("SSL configuration not specified"));
         return avs_errno(AVS_EINVAL);
     }
+    const avs_net_tls_context_t *tls_context =
+            ((const avs_net_ssl_configuration_t *) socket_configuration)
+                    ->tls_context;
+    if (tls_context
+            && tls_context->socket_type != ssl_socket_type(backend_type)) {
+        LOG(ERROR, _("TLS context was created for a different socket type"));
+        return avs_errno(AVS_EINVAL);
+    }
 
     ssl_socket_t *ssl_sock =
             (ssl_socket_t *) avs_calloc(1, sizeof(ssl_socket_t));
@@ -432,6 +515,18 @@ static avs_error_t get_opt_ssl(avs_net_socket_t *ssl_socket_,
         out_option_value->mtu = mtu;
         return AVS_OK;
     }
+    case AVS_NET_SOCKET_OPT_DTLS_RECORD_OVERHEAD: {
+        if (!socket_is_datagram(ssl_socket)) {
+            return avs_errno(AVS_ENOTSUP);
+        }
+        int header, padding;
+        avs_error_t err = get_dtls_overhead(ssl_socket, &header, &padding);
+        if (avs_is_ok(err)) {
+            /* with block ciphers, between 1 and padding bytes are added */
+            out_option_value->mtu = header + padding;
+        }
+        return err;
+    }
     case AVS_NET_SOCKET_OPT_SESSION_RESUMED:
         out_option_value->flag = is_session_resumed(ssl_socket);
         return AVS_OK;
@@ -476,6 +571,17 @@ avs_error_t _avs_net_create_dtls_socket(avs_net_socket_t **socket,
     return create_ssl_socket(socket, AVS_NET_UDP_SOCKET, socket_configuration);
 }
 
+avs_error_t
+_avs_net_tls_context_create(avs_net_tls_context_t **out_context,
+                            avs_net_socket_type_t socket_type,
+                            const avs_net_ssl_configuration_t *configuration) {
+    return create_tls_context(out_context, socket_type, configuration);
+}
+
+void _avs_net_tls_context_release(avs_net_tls_context_t **context) {
+    release_tls_context(context);
+}
+
 static const avs_net_socket_v_table_t ssl_vtable = {
     .connect = connect_ssl,
     .decorate = decorate_ssl,
@@ -0,0 +1,549 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET) && defined(AVS_COMMONS_WITH_AVS_CRYPTO) \
+        && defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE)           \
+        && !defined(AVS_COMMONS_WITHOUT_TLS)
+
+#    include <assert.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+#    include <avsystem/commons/avs_prng.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    include "avs_tls_server_session_cache.h"
+
+#    include "avs_net_impl.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+// maximum length of a TLS session ID (RFC 5246, section 7.4.1.2)
+#    define SESSION_ID_MAX_SIZE 32
+// maximum size of persisted session data accepted on restore; serialized
+// sessions, including the peer certificate, are well below that
+#    define SESSION_DATA_MAX_SIZE 16384
+
+typedef struct session_entry_struct session_entry_t;
+struct session_entry_struct {
+    session_entry_t *bucket_next;
+    // towards the most recently used entry
+    session_entry_t *lru_prev;
+    // towards the least recently used entry
+    session_entry_t *lru_next;
+    avs_time_real_t expires;
+    size_t id_size;
+    size_t data_size;
+    // id_size bytes of session ID, followed by data_size bytes of session data
+    unsigned char bytes[];
+};
+
+struct avs_net_tls_server_session_cache_struct {
+    avs_mutex_t *mutex;
+    size_t max_sessions;
+    avs_time_duration_t session_lifetime;
+    bool use_session_tickets;
+    avs_time_duration_t ticket_key_rotation_interval;
+    avs_crypto_prng_ctx_t *prng_ctx;
+
+    // hash table of sessions, chained through bucket_next; bucket_count is a
+    // power of two
+    session_entry_t **buckets;
+    size_t bucket_count;
+    session_entry_t *lru_head;
+    session_entry_t *lru_tail;
+    size_t session_count;
+
+    // current key first
+    avs_net_tls_ticket_key_t ticket_keys[AVS_NET_TLS_TICKET_KEYS_MAX];
+    size_t ticket_key_count;
+};
+
+static void cache_lock(avs_net_tls_server_session_cache_t *cache) {
+    if (avs_mutex_lock(cache->mutex)) {
+        AVS_UNREACHABLE("could not lock mutex");
+    }
+}
+
+static void cache_unlock(avs_net_tls_server_session_cache_t *cache) {
+    avs_mutex_unlock(cache->mutex);
+}
+
+static bool duration_positive(avs_time_duration_t duration) {
+    return avs_time_duration_valid(duration)
+           && avs_time_duration_less(AVS_TIME_DURATION_ZERO, duration);
+}
+
+static session_entry_t **
+find_entry_ptr(avs_net_tls_server_session_cache_t *cache,
+               const void *id,
+               size_t id_size) {
+    session_entry_t **entry_ptr =
+            &cache->buckets[_avs_net_fnv1a_hash(id, id_size)
+                            & (cache->bucket_count - 1)];
+    while (*entry_ptr
+           && ((*entry_ptr)->id_size != id_size
+               || memcmp((*entry_ptr)->bytes, id, id_size))) {
+        entry_ptr = &(*entry_ptr)->bucket_next;
+    }
+    return entry_ptr;
+}
+
+static void lru_unlink(avs_net_tls_server_session_cache_t *cache,
+                       session_entry_t *entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void lru_push_front(avs_net_tls_server_session_cache_t *cache,
+                           session_entry_t *entry) {
+    assert(!entry->lru_prev);
+    assert(!entry->lru_next);
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = entry;
+    } else {
+        cache->lru_tail = entry;
+    }
+    cache->lru_head = entry;
+}
+
+static void remove_entry(avs_net_tls_server_session_cache_t *cache,
+                         session_entry_t **entry_ptr) {
+    session_entry_t *entry = *entry_ptr;
+    *entry_ptr = entry->bucket_next;
+    lru_unlink(cache, entry);
+    assert(cache->session_count > 0);
+    --cache->session_count;
+    avs_free(entry);
+}
+
+static void remove_entry_by_id(avs_net_tls_server_session_cache_t *cache,
+                               const void *id,
+                               size_t id_size) {
+    session_entry_t **entry_ptr = find_entry_ptr(cache, id, id_size);
+    if (*entry_ptr) {
+        remove_entry(cache, entry_ptr);
+    }
+}
+
+static void clear_sessions(avs_net_tls_server_session_cache_t *cache) {
+    while (cache->lru_tail) {
+        remove_entry_by_id(cache, cache->lru_tail->bytes,
+                           cache->lru_tail->id_size);
+    }
+    assert(!cache->session_count);
+}
+
+static bool entry_expired(const session_entry_t *entry, avs_time_real_t now) {
+    return !avs_time_real_before(now, entry->expires);
+}
+
+/**
+ * Inserts a new entry as the most recently used one, making room for it if
+ * necessary. The ID MUST NOT be already present in the cache.
+ */
+static void insert_entry(avs_net_tls_server_session_cache_t *cache,
+                         session_entry_t *entry,
+                         avs_time_real_t now) {
+    assert(!*find_entry_ptr(cache, entry->bytes, entry->id_size));
+    // Sessions are inserted with constant lifetime, so the least recently used
+    // ones are the most likely to have expired
+    while (cache->lru_tail
+           && (cache->session_count >= cache->max_sessions
+               || entry_expired(cache->lru_tail, now))) {
+        remove_entry_by_id(cache, cache->lru_tail->bytes,
+                           cache->lru_tail->id_size);
+    }
+    session_entry_t **bucket =
+            &cache->buckets[_avs_net_fnv1a_hash(entry->bytes, entry->id_size)
+                            & (cache->bucket_count - 1)];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    lru_push_front(cache, entry);
+    ++cache->session_count;
+}
+
+static session_entry_t *allocate_entry(size_t id_size, size_t data_size) {
+    if (id_size > SIZE_MAX - sizeof(session_entry_t)
+            || data_size > SIZE_MAX - sizeof(session_entry_t) - id_size) {
+        return NULL;
+    }
+    session_entry_t *entry = (session_entry_t *) avs_calloc(
+            1, sizeof(session_entry_t) + id_size + data_size);
+    if (entry) {
+        entry->id_size = id_size;
+        entry->data_size = data_size;
+    }
+    return entry;
+}
+
+avs_error_t _avs_net_tls_server_session_cache_create(
+        avs_net_tls_server_session_cache_t **out_cache,
+        const avs_net_tls_server_session_cache_config_t *config) {
+    assert(out_cache);
+    assert(!*out_cache);
+    if (!config || !duration_positive(config->session_lifetime)
+            || (!config->max_sessions && !config->use_session_tickets)
+            || (config->use_session_tickets && !config->prng_ctx)) {
+        LOG(ERROR, _("invalid server session cache configuration"));
+        return avs_errno(AVS_EINVAL);
+    }
+
+    avs_net_tls_server_session_cache_t *cache =
+            (avs_net_tls_server_session_cache_t *) avs_calloc(1,
+                                                              sizeof(*cache));
+    if (!cache) {
+        LOG_OOM();
+        return avs_errno(AVS_ENOMEM);
+    }
+    cache->max_sessions = config->max_sessions;
+    cache->session_lifetime = config->session_lifetime;
+    cache->use_session_tickets = config->use_session_tickets;
+    cache->ticket_key_rotation_interval =
+            duration_positive(config->ticket_key_rotation_interval)
+                    ? config->ticket_key_rotation_interval
+                    : config->session_lifetime;
+    cache->prng_ctx = config->prng_ctx;
+
+    // aim for load factor of at most 1
+    cache->bucket_count = 1;
+    while (cache->bucket_count < cache->max_sessions
+           && cache->bucket_count <= SIZE_MAX / 2) {
+        cache->bucket_count *= 2;
+    }
+    if (!(cache->buckets = (session_entry_t **) avs_calloc(
+                  cache->bucket_count, sizeof(*cache->buckets)))
+            || avs_mutex_create(&cache->mutex)) {
+        LOG_OOM();
+        avs_free(cache->buckets);
+        avs_free(cache);
+        return avs_errno(AVS_ENOMEM);
+    }
+    *out_cache = cache;
+    return AVS_OK;
+}
+
+void _avs_net_tls_server_session_cache_cleanup(
+        avs_net_tls_server_session_cache_t **cache) {
+    if (!cache || !*cache) {
+        return;
+    }
+    clear_sessions(*cache);
+    avs_free((*cache)->buckets);
+    avs_mutex_cleanup(&(*cache)->mutex);
+    // do not leave the ticket keys in freed memory
+    memset((*cache)->ticket_keys, 0, sizeof((*cache)->ticket_keys));
+    avs_free(*cache);
+    *cache = NULL;
+}
+
+static avs_error_t rotate_ticket_keys_unlocked(
+        avs_net_tls_server_session_cache_t *cache, avs_time_real_t now) {
+    avs_net_tls_ticket_key_t new_key;
+    if (avs_crypto_prng_bytes(cache->prng_ctx, new_key.name,
+                              sizeof(new_key.name))
+            || avs_crypto_prng_bytes(cache->prng_ctx, new_key.cipher_key,
+                                     sizeof(new_key.cipher_key))
+            || avs_crypto_prng_bytes(cache->prng_ctx, new_key.hmac_key,
+                                     sizeof(new_key.hmac_key))) {
+        LOG(ERROR, _("could not generate session ticket key"));
+        return avs_errno(AVS_EIO);
+    }
+    new_key.created = now;
+    memmove(&cache->ticket_keys[1], &cache->ticket_keys[0],
+            (AVS_NET_TLS_TICKET_KEYS_MAX - 1) * sizeof(cache->ticket_keys[0]));
+    cache->ticket_keys[0] = new_key;
+    if (cache->ticket_key_count < AVS_NET_TLS_TICKET_KEYS_MAX) {
+        ++cache->ticket_key_count;
+    }
+    memset(&new_key, 0, sizeof(new_key));
+    LOG(DEBUG, _("session ticket key rotated"));
+    return AVS_OK;
+}
+
+avs_error_t _avs_net_tls_server_session_cache_rotate_ticket_keys(
+        avs_net_tls_server_session_cache_t *cache) {
+    if (!cache->use_session_tickets) {
+        LOG(ERROR, _("session tickets are not enabled"));
+        return avs_errno(AVS_EINVAL);
+    }
+    cache_lock(cache);
+    avs_error_t err = rotate_ticket_keys_unlocked(cache, avs_time_real_now());
+    cache_unlock(cache);
+    return err;
+}
+
+bool _avs_net_tls_server_session_cache_stateful(
+        const avs_net_tls_server_session_cache_t *cache) {
+    return cache->max_sessions > 0;
+}
+
+bool _avs_net_tls_server_session_cache_tickets_enabled(
+        const avs_net_tls_server_session_cache_t *cache) {
+    return cache->use_session_tickets;
+}
+
+avs_time_duration_t _avs_net_tls_server_session_cache_lifetime(
+        const avs_net_tls_server_session_cache_t *cache) {
+    return cache->session_lifetime;
+}
+
+avs_error_t _avs_net_tls_server_session_cache_store(
+        avs_net_tls_server_session_cache_t *cache,
+        const void *id,
+        size_t id_size,
+        const void *data,
+        size_t data_size) {
+    if (!cache->max_sessions) {
+        return AVS_OK;
+    }
+    session_entry_t *entry = allocate_entry(id_size, data_size);
+    if (!entry) {
+        LOG_OOM();
+        return avs_errno(AVS_ENOMEM);
+    }
+    memcpy(entry->bytes, id, id_size);
+    memcpy(entry->bytes + id_size, data, data_size);
+
+    avs_time_real_t now = avs_time_real_now();
+    entry->expires = avs_time_real_add(now, cache->session_lifetime);
+
+    cache_lock(cache);
+    remove_entry_by_id(cache, id, id_size);
+    insert_entry(cache, entry, now);
+    cache_unlock(cache);
+    return AVS_OK;
+}
+
+avs_error_t _avs_net_tls_server_session_cache_retrieve(
+        avs_net_tls_server_session_cache_t *cache,
+        const void *id,
+        size_t id_size,
+        void **out_data,
+        size_t *out_data_size) {
+    avs_error_t err = avs_errno(AVS_ENOENT);
+    cache_lock(cache);
+    session_entry_t **entry_ptr = find_entry_ptr(cache, id, id_size);
+    if (*entry_ptr && entry_expired(*entry_ptr, avs_time_real_now())) {
+        remove_entry(cache, entry_ptr);
+    } else if (*entry_ptr) {
+        session_entry_t *entry = *entry_ptr;
+        lru_unlink(cache, entry);
+        lru_push_front(cache, entry);
+        if (!(*out_data = avs_malloc(AVS_MAX(entry->data_size, 1)))) {
+            LOG_OOM();
+            err = avs_errno(AVS_ENOMEM);
+        } else {
+            memcpy(*out_data, entry->bytes + entry->id_size, entry->data_size);
+            *out_data_size = entry->data_size;
+            err = AVS_OK;
+        }
+    }
+    cache_unlock(cache);
+    return err;
+}
+
+void _avs_net_tls_server_session_cache_remove(
+        avs_net_tls_server_session_cache_t *cache,
+        const void *id,
+        size_t id_size) {
+    cache_lock(cache);
+    remove_entry_by_id(cache, id, id_size);
+    cache_unlock(cache);
+}
+
+avs_error_t _avs_net_tls_server_session_cache_ticket_keys(
+        avs_net_tls_server_session_cache_t *cache,
+        avs_net_tls_ticket_key_t out_keys[AVS_NET_TLS_TICKET_KEYS_MAX],
+        size_t *out_count) {
+    if (!cache->use_session_tickets) {
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_error_t err = AVS_OK;
+    cache_lock(cache);
+    avs_time_real_t now = avs_time_real_now();
+    avs_time_real_t rotation_time =
+            avs_time_real_add(cache->ticket_keys[0].created,
+                              cache->ticket_key_rotation_interval);
+    if (!cache->ticket_key_count || !avs_time_real_before(now, rotation_time)) {
+        err = rotate_ticket_keys_unlocked(cache, now);
+    }
+    if (avs_is_ok(err) || cache->ticket_key_count) {
+        // if rotation failed, keep using the old keys
+        memcpy(out_keys, cache->ticket_keys,
+               cache->ticket_key_count * sizeof(*out_keys));
+        *out_count = cache->ticket_key_count;
+        err = AVS_OK;
+    }
+    cache_unlock(cache);
+    return err;
+}
+
+#    ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+static avs_error_t persist_time(avs_persistence_context_t *ctx,
+                                avs_time_real_t *value) {
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_i64(
+                                ctx, &value->since_real_epoch.seconds)))
+            || avs_is_err((err = avs_persistence_i32(
+                                   ctx,
+                                   &value->since_real_epoch.nanoseconds))));
+    return err;
+}
+
+static avs_error_t
+persist_ticket_keys(avs_persistence_context_t *ctx,
+                    avs_net_tls_server_session_cache_t *cache) {
+    uint32_t count = (uint32_t) cache->ticket_key_count;
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    if (avs_is_ok(err) && count > AVS_NET_TLS_TICKET_KEYS_MAX) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    avs_net_tls_ticket_key_t keys[AVS_NET_TLS_TICKET_KEYS_MAX];
+    memcpy(keys, cache->ticket_keys, sizeof(keys));
+    for (uint32_t i = 0; avs_is_ok(err) && i < count; ++i) {
+        (void) (avs_is_err((err = avs_persistence_bytes(ctx, keys[i].name,
+                                                        sizeof(keys[i].name))))
+                || avs_is_err((err = avs_persistence_bytes(
+                                       ctx, keys[i].cipher_key,
+                                       sizeof(keys[i].cipher_key))))
+                || avs_is_err((err = avs_persistence_bytes(
+                                       ctx, keys[i].hmac_key,
+                                       sizeof(keys[i].hmac_key))))
+                || avs_is_err((err = persist_time(ctx, &keys[i].created))));
+    }
+    if (avs_is_ok(err)
+            && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE
+            && cache->use_session_tickets) {
+        memcpy(cache->ticket_keys, keys, sizeof(keys));
+        cache->ticket_key_count = count;
+    }
+    memset(keys, 0, sizeof(keys));
+    return err;
+}
+
+static avs_error_t store_sessions(avs_persistence_context_t *ctx,
+                                  avs_net_tls_server_session_cache_t *cache) {
+    avs_time_real_t now = avs_time_real_now();
+    uint32_t count = 0;
+    for (session_entry_t *entry = cache->lru_head; entry;
+         entry = entry->lru_next) {
+        if (!entry_expired(entry, now)) {
+            ++count;
+        }
+    }
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    // least recently used first, so that the order is retained on restore
+    for (session_entry_t *entry = cache->lru_tail; avs_is_ok(err) && entry;
+         entry = entry->lru_prev) {
+        if (entry_expired(entry, now)) {
+            continue;
+        }
+        uint32_t id_size = (uint32_t) entry->id_size;
+        uint32_t data_size = (uint32_t) entry->data_size;
+        (void) (avs_is_err((err = persist_time(ctx, &entry->expires)))
+                || avs_is_err((err = avs_persistence_u32(ctx, &id_size)))
+                || avs_is_err((err = avs_persistence_u32(ctx, &data_size)))
+                || avs_is_err((err = avs_persistence_bytes(
+                                       ctx, entry->bytes,
+                                       entry->id_size + entry->data_size))));
+    }
+    return err;
+}
+
+static avs_error_t restore_sessions(avs_persistence_context_t *ctx,
+                                    avs_net_tls_server_session_cache_t *cache) {
+    clear_sessions(cache);
+    avs_time_real_t now = avs_time_real_now();
+    uint32_t count;
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    for (uint32_t i = 0; avs_is_ok(err) && i < count; ++i) {
+        avs_time_real_t expires;
+        uint32_t id_size;
+        uint32_t data_size;
+        session_entry_t *entry = NULL;
+        if (avs_is_err((err = persist_time(ctx, &expires)))
+                || avs_is_err((err = avs_persistence_u32(ctx, &id_size)))
+                || avs_is_err((err = avs_persistence_u32(ctx, &data_size)))) {
+            break;
+        }
+        if (id_size > SESSION_ID_MAX_SIZE
+                || data_size > SESSION_DATA_MAX_SIZE) {
+            LOG(ERROR, _("invalid persisted session size"));
+            err = avs_errno(AVS_EBADMSG);
+            break;
+        }
+        if (!(entry = allocate_entry(id_size, data_size))) {
+            LOG_OOM();
+            err = avs_errno(AVS_ENOMEM);
+            break;
+        }
+        entry->expires = expires;
+        if (avs_is_ok((err = avs_persistence_bytes(ctx, entry->bytes,
+                                                   entry->id_size
+                                                           + entry->data_size)))
+                // sessions are stored least recently used first; the ones
+                // that would be evicted right away are not inserted at all
+                && count - i <= cache->max_sessions
+                && !entry_expired(entry, now)
+                && !*find_entry_ptr(cache, entry->bytes, entry->id_size)) {
+            insert_entry(cache, entry, now);
+        } else {
+            avs_free(entry);
+        }
+    }
+    return err;
+}
+
+avs_error_t _avs_net_tls_server_session_cache_persistence(
+        avs_net_tls_server_session_cache_t *cache,
+        avs_persistence_context_t *ctx) {
+    avs_error_t err;
+    cache_lock(cache);
+    (void) (avs_is_err((err = avs_persistence_magic_string(ctx, "TSC1")))
+            || avs_is_err((err = persist_ticket_keys(ctx, cache)))
+            || avs_is_err(
+                       (err = avs_persistence_direction(ctx)
+                                              == AVS_PERSISTENCE_STORE
+                                      ? store_sessions(ctx, cache)
+                                      : restore_sessions(ctx, cache))));
+    cache_unlock(cache);
+    return err;
+}
+#    endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/net/tls_server_session_cache.c"
+#    endif // AVS_UNIT_TESTING
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // defined(AVS_COMMONS_WITH_AVS_CRYPTO) &&
+       // defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) &&
+       // !defined(AVS_COMMONS_WITHOUT_TLS)
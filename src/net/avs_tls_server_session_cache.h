@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_NET_TLS_SERVER_SESSION_CACHE_H
+#define AVS_COMMONS_NET_TLS_SERVER_SESSION_CACHE_H
+
+#include <avsystem/commons/avs_socket.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+#define AVS_NET_TLS_TICKET_KEY_NAME_SIZE 16
+#define AVS_NET_TLS_TICKET_KEY_SECRET_SIZE 32
+
+/**
+ * Session ticket key material. It is generated independently of the backend;
+ * each backend uses the parts required by its ticket format.
+ */
+typedef struct {
+    /** Random key identifier, included in each ticket in plain text */
+    unsigned char name[AVS_NET_TLS_TICKET_KEY_NAME_SIZE];
+    /** Key for the ticket encryption cipher (AES-256) */
+    unsigned char cipher_key[AVS_NET_TLS_TICKET_KEY_SECRET_SIZE];
+    /** Key for the ticket MAC, for backends that do not use AEAD ciphers */
+    unsigned char hmac_key[AVS_NET_TLS_TICKET_KEY_SECRET_SIZE];
+    avs_time_real_t created;
+} avs_net_tls_ticket_key_t;
+
+/**
+ * Maximum number of ticket keys accepted at a time: the current one and the
+ * previous one.
+ */
+#define AVS_NET_TLS_TICKET_KEYS_MAX 2
+
+avs_error_t _avs_net_tls_server_session_cache_create(
+        avs_net_tls_server_session_cache_t **out_cache,
+        const avs_net_tls_server_session_cache_config_t *config);
+
+void _avs_net_tls_server_session_cache_cleanup(
+        avs_net_tls_server_session_cache_t **cache);
+
+avs_error_t _avs_net_tls_server_session_cache_rotate_ticket_keys(
+        avs_net_tls_server_session_cache_t *cache);
+
+#ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+avs_error_t _avs_net_tls_server_session_cache_persistence(
+        avs_net_tls_server_session_cache_t *cache,
+        avs_persistence_context_t *ctx);
+#endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
+
+/**
+ * @returns Whether sessions shall be stored in the cache by session ID.
+ */
+bool _avs_net_tls_server_session_cache_stateful(
+        const avs_net_tls_server_session_cache_t *cache);
+
+/**
+ * @returns Whether session tickets shall be issued and accepted.
+ */
+bool _avs_net_tls_server_session_cache_tickets_enabled(
+        const avs_net_tls_server_session_cache_t *cache);
+
+avs_time_duration_t _avs_net_tls_server_session_cache_lifetime(
+        const avs_net_tls_server_session_cache_t *cache);
+
+/**
+ * Stores serialized session data under a given session ID, replacing any
+ * session previously stored under the same ID.
+ */
+avs_error_t _avs_net_tls_server_session_cache_store(
+        avs_net_tls_server_session_cache_t *cache,
+        const void *id,
+        size_t id_size,
+        const void *data,
+        size_t data_size);
+
+/**
+ * Retrieves a copy of the session data stored under a given session ID.
+ *
+ * @param out_data Pointer to a variable that will be set to a newly allocated
+ *                 copy of the data, that shall be freed using @ref avs_free .
+ *
+ * @returns @ref AVS_OK for success, <c>avs_errno(AVS_ENOENT)</c> if there is no
+ *          such session or it has expired, or other error condition.
+ */
+avs_error_t _avs_net_tls_server_session_cache_retrieve(
+        avs_net_tls_server_session_cache_t *cache,
+        const void *id,
+        size_t id_size,
+        void **out_data,
+        size_t *out_data_size);
+
+void _avs_net_tls_server_session_cache_remove(
+        avs_net_tls_server_session_cache_t *cache,
+        const void *id,
+        size_t id_size);
+
+/**
+ * Retrieves the currently valid session ticket keys, generating a new one first
+ * if the rotation interval has elapsed.
+ *
+ * @param out_keys  Array that will be filled with the keys; the first one
+ *                  shall be used for issuing new tickets.
+ * @param out_count Variable that will be set to the number of keys written to
+ *                  @p out_keys .
+ */
+avs_error_t _avs_net_tls_server_session_cache_ticket_keys(
+        avs_net_tls_server_session_cache_t *cache,
+        avs_net_tls_ticket_key_t out_keys[AVS_NET_TLS_TICKET_KEYS_MAX],
+        size_t *out_count);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // AVS_COMMONS_NET_TLS_SERVER_SESSION_CACHE_H
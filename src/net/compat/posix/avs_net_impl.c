@@ -18,6 +18,12 @@
 
 #include <avsystem/commons/avs_commons_config.h>
 
+#if (defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG)     \
+     || defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG)) \
+        && !defined(_GNU_SOURCE)
+#    define _GNU_SOURCE // for recvmmsg() and sendmmsg()
+#endif
+
 #if defined(AVS_COMMONS_WITH_AVS_NET) \
         && defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
 
@@ -42,6 +48,7 @@
 
 #    include <assert.h>
 #    include <inttypes.h>
+#    include <limits.h>
 #    include <stdarg.h>
 #    include <stdio.h>
 #    include <string.h>
@@ -51,6 +58,12 @@
 #        include <ifaddrs.h>
 #    endif
 
+#    if defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG) \
+            && defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT)
+#        define WITH_UDP_GSO
+#        include <netinet/udp.h>
+#    endif
+
 #    include "avs_compat.h"
 
 VISIBILITY_SOURCE_BEGIN
@@ -152,6 +165,16 @@ static avs_error_t send_to_net(avs_net_socket_t *socket,
                                size_t buffer_length,
                                const char *host,
                                const char *port);
+static avs_error_t
+send_to_many_net(avs_net_socket_t *net_socket,
+                 const avs_net_outgoing_datagram_t *datagrams,
+                 size_t datagram_count,
+                 size_t *out_sent_count);
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG
+static avs_error_t sendv_net(avs_net_socket_t *net_socket,
+                             const avs_iovec_t *iov,
+                             size_t iov_count);
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG
 static avs_error_t receive_net(avs_net_socket_t *net_socket_,
                                size_t *out,
                                void *buffer,
@@ -165,6 +188,11 @@ static avs_error_t receive_from_net(avs_net_socket_t *net_socket,
                                     char *port,
                                     size_t port_size);
 static avs_error_t
+receive_from_many_net(avs_net_socket_t *net_socket,
+                      avs_net_incoming_datagram_t *datagrams,
+                      size_t datagram_count,
+                      size_t *out_received_count);
+static avs_error_t
 bind_net(avs_net_socket_t *net_socket, const char *localaddr, const char *port);
 static avs_error_t accept_net(avs_net_socket_t *server_net_socket,
                               avs_net_socket_t *new_net_socket);
@@ -215,9 +243,21 @@ static const avs_net_socket_v_table_t net_vtable = {
     .get_local_host = local_host_net,
     .get_local_port = local_port_net,
     .get_opt = get_opt_net,
-    .set_opt = set_opt_net
+    .set_opt = set_opt_net,
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG
+    .sendv = sendv_net,
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG
+    .receive_from_many = receive_from_many_net,
+    .send_to_many = send_to_many_net
 };
 
+typedef struct {
+    char host[NET_MAX_HOSTNAME_SIZE];
+    char port[NET_PORT_SIZE];
+    sockaddr_endpoint_union_t address;
+    avs_time_monotonic_t expires;
+} resolve_cache_entry_t;
+
 typedef struct {
     const avs_net_socket_v_table_t *const operations;
     sockfd_t socket;
@@ -231,6 +271,11 @@ typedef struct {
     uint64_t bytes_sent;
 
     avs_time_duration_t recv_timeout;
+    bool udp_segmentation;
+
+    /* send_to() destinations, most recently used first; allocated lazily */
+    resolve_cache_entry_t *resolve_cache;
+    size_t resolve_cache_count;
 } net_socket_impl_t;
 
 #    ifdef WITH_AVS_V4MAPPED
@@ -420,6 +465,8 @@ static void close_net_raw(net_socket_impl_t *net_socket) {
     }
     net_socket->remote_hostname[0] = '\0';
     net_socket->remote_port[0] = '\0';
+    // a re-created socket may use a different address family
+    net_socket->resolve_cache_count = 0;
 }
 
 static avs_error_t close_net(avs_net_socket_t *net_socket_) {
@@ -430,6 +477,7 @@ static avs_error_t close_net(avs_net_socket_t *net_socket_) {
 
 static avs_error_t cleanup_net(avs_net_socket_t **net_socket) {
     close_net(*net_socket);
+    avs_free(((net_socket_impl_t *) *net_socket)->resolve_cache);
     avs_free(*net_socket);
     *net_socket = NULL;
     return AVS_OK;
@@ -1362,6 +1410,115 @@ static avs_error_t send_net(avs_net_socket_t *net_socket_,
     }
 }
 
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG
+/* Number of iovec structures that sendv_net() keeps on stack */
+#        define NET_SENDV_STACK_IOV_COUNT 16
+
+/* Maximum number of iovec structures accepted by a single sendmsg() call */
+#        ifdef IOV_MAX
+#            define NET_SENDV_IOV_MAX IOV_MAX
+#        else // IOV_MAX
+/* minimum value guaranteed by POSIX (_XOPEN_IOV_MAX) */
+#            define NET_SENDV_IOV_MAX 16
+#        endif // IOV_MAX
+
+typedef struct {
+    struct msghdr msg;
+    size_t bytes_sent;
+} sendmsg_internal_arg_t;
+
+static avs_error_t sendmsg_internal(sockfd_t sockfd, void *arg_) {
+    sendmsg_internal_arg_t *arg = (sendmsg_internal_arg_t *) arg_;
+    ssize_t result = sendmsg(sockfd, &arg->msg, MSG_NOSIGNAL);
+    if (result < 0) {
+        return failure_from_errno();
+    }
+    arg->bytes_sent = (size_t) result;
+    return AVS_OK;
+}
+
+static void advance_msg_iov(struct msghdr *msg, size_t bytes_sent) {
+    while (msg->msg_iovlen > 0 && bytes_sent >= msg->msg_iov->iov_len) {
+        bytes_sent -= msg->msg_iov->iov_len;
+        ++msg->msg_iov;
+        --msg->msg_iovlen;
+    }
+    if (bytes_sent) {
+        assert(msg->msg_iovlen > 0);
+        msg->msg_iov->iov_base = (char *) msg->msg_iov->iov_base + bytes_sent;
+        msg->msg_iov->iov_len -= bytes_sent;
+    }
+}
+
+static avs_error_t sendv_net(avs_net_socket_t *net_socket_,
+                             const avs_iovec_t *iov,
+                             size_t iov_count) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_TCP_SOCKET
+            && iov_count > NET_SENDV_IOV_MAX) {
+        /* a datagram has to be sent in a single sendmsg() call, so let the
+         * caller fall back to send() on a linear buffer */
+        LOG(DEBUG, _("too many blocks for a single datagram: ") "%lu",
+            (unsigned long) iov_count);
+        return avs_errno(AVS_ENOTSUP);
+    }
+    struct iovec stack_iov[NET_SENDV_STACK_IOV_COUNT];
+    struct iovec *msg_iov = stack_iov;
+    if (iov_count > AVS_ARRAY_SIZE(stack_iov)
+            && !(msg_iov = (struct iovec *) avs_malloc(iov_count
+                                                       * sizeof(*msg_iov)))) {
+        LOG_OOM();
+        return avs_errno(AVS_ENOMEM);
+    }
+    size_t total_length = 0;
+    for (size_t i = 0; i < iov_count; ++i) {
+        msg_iov[i].iov_base = (void *) (intptr_t) iov[i].base;
+        msg_iov[i].iov_len = iov[i].length;
+        total_length += iov[i].length;
+    }
+    sendmsg_internal_arg_t arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.msg.msg_iov = msg_iov;
+    size_t iov_left = iov_count;
+
+    avs_error_t err = AVS_OK;
+    size_t bytes_sent = 0;
+    /* send at least one datagram, even if zero-length - hence do..while */
+    do {
+        /* for stream sockets, larger vectors are sent in batches */
+        size_t iov_batch = AVS_MIN(iov_left, (size_t) NET_SENDV_IOV_MAX);
+        arg.msg.msg_iovlen = iov_batch;
+        if (avs_is_err((err = call_when_ready(&net_socket->socket,
+                                              NET_SEND_TIMEOUT,
+                                              AVS_POLLOUT | AVS_POLLERR,
+                                              sendmsg_internal, &arg)))) {
+            LOG(ERROR, _("send failed"));
+            break;
+        } else if (total_length != 0 && arg.bytes_sent == 0) {
+            LOG(ERROR, _("send returned 0"));
+            break;
+        }
+        bytes_sent += arg.bytes_sent;
+        net_socket->bytes_sent += arg.bytes_sent;
+        advance_msg_iov(&arg.msg, arg.bytes_sent);
+        iov_left -= iov_batch - (size_t) arg.msg.msg_iovlen;
+        /* call sendmsg() multiple times only if the socket is
+         * stream-oriented */
+    } while (net_socket->type == AVS_NET_TCP_SOCKET
+             && bytes_sent < total_length);
+
+    if (msg_iov != stack_iov) {
+        avs_free(msg_iov);
+    }
+    if (avs_is_ok(err) && bytes_sent < total_length) {
+        LOG(ERROR, _("sending fail (") "%lu" _("/") "%lu" _(")"),
+            (unsigned long) bytes_sent, (unsigned long) total_length);
+        err = avs_errno(AVS_EIO);
+    }
+    return err;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG
+
 typedef struct {
     const void *data;
     size_t data_length;
@@ -1406,6 +1563,168 @@ static avs_error_t send_to_resolved(net_socket_impl_t *net_socket,
     return err;
 }
 
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON
+/**
+ * Parses a port number that consists of decimal digits only. Unlike strtol(),
+ * does not accept leading whitespace or a sign. An empty or NULL string is
+ * treated as port 0.
+ */
+static int parse_port_number(const char *port, uint16_t *out_port) {
+    uint16_t result = 0;
+    for (const char *ch = port; ch && *ch; ++ch) {
+        if (*ch < '0' || *ch > '9') {
+            return -1;
+        }
+        unsigned digit = (unsigned) (*ch - '0');
+        if (result > (UINT16_MAX - digit) / 10) {
+            return -1;
+        }
+        result = (uint16_t) (result * 10 + digit);
+    }
+    *out_port = result;
+    return 0;
+}
+
+/**
+ * Converts a numeric IP address literal directly into an endpoint usable with
+ * the already created socket, without calling getaddrinfo(). The results are
+ * the same as would be used by the generic code in send_to_net().
+ *
+ * @returns 0 on success, or a non-zero value if @p host is not a numeric
+ *          literal or cannot be used with the socket as-is; full resolution
+ *          shall then be performed instead.
+ */
+static int resolve_numeric_for_socket(net_socket_impl_t *net_socket,
+                                      const char *host,
+                                      const char *port,
+                                      sockaddr_endpoint_union_t *out) {
+    if (!host || net_socket->socket == INVALID_SOCKET) {
+        return -1;
+    }
+    uint16_t port_num;
+    if (parse_port_number(port, &port_num)) {
+        return -1;
+    }
+    avs_net_af_t socket_family =
+            get_avs_af(get_socket_family(net_socket->socket));
+    avs_net_af_t address_family = net_socket->configuration.address_family;
+
+    sockaddr_union_t addr;
+    memset(&addr, 0, sizeof(addr));
+    socklen_t addrlen = 0;
+#        ifdef AVS_COMMONS_NET_WITH_IPV4
+    struct in_addr addr4;
+    if (inet_pton(AF_INET, host, &addr4) == 1) {
+        if (address_family == AVS_NET_AF_INET6) {
+            return -1;
+        }
+        if (socket_family == AVS_NET_AF_INET4) {
+            addr.addr_in.sin_family = AF_INET;
+            addr.addr_in.sin_port = htons(port_num);
+            addr.addr_in.sin_addr = addr4;
+            addrlen = (socklen_t) sizeof(addr.addr_in);
+        }
+#            ifdef WITH_AVS_V4MAPPED
+        else if (socket_family == AVS_NET_AF_INET6) {
+            addr.addr_in6.sin6_family = AF_INET6;
+            addr.addr_in6.sin6_port = htons(port_num);
+            addr.addr_in6.sin6_addr.s6_addr[10] = 0xFF;
+            addr.addr_in6.sin6_addr.s6_addr[11] = 0xFF;
+            memcpy(&addr.addr_in6.sin6_addr.s6_addr[12], &addr4, 4);
+            addrlen = (socklen_t) sizeof(addr.addr_in6);
+        }
+#            endif // WITH_AVS_V4MAPPED
+    }
+#        endif // AVS_COMMONS_NET_WITH_IPV4
+#        ifdef AVS_COMMONS_NET_WITH_IPV6
+    if (!addrlen && address_family != AVS_NET_AF_INET4
+            && socket_family == AVS_NET_AF_INET6
+            && inet_pton(AF_INET6, host, &addr.addr_in6.sin6_addr) == 1) {
+        addr.addr_in6.sin6_family = AF_INET6;
+        addr.addr_in6.sin6_port = htons(port_num);
+        addrlen = (socklen_t) sizeof(addr.addr_in6);
+    }
+#        endif // AVS_COMMONS_NET_WITH_IPV6
+
+    if (!addrlen || addrlen > (socklen_t) sizeof(out->api_ep.data)) {
+        return -1;
+    }
+    out->api_ep.size = (uint8_t) addrlen;
+    memcpy(out->api_ep.data.buf, &addr, (size_t) addrlen);
+    return 0;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON
+
+static void resolve_cache_remove(net_socket_impl_t *net_socket, size_t index) {
+    assert(index < net_socket->resolve_cache_count);
+    memmove(&net_socket->resolve_cache[index],
+            &net_socket->resolve_cache[index + 1],
+            (net_socket->resolve_cache_count - index - 1)
+                    * sizeof(*net_socket->resolve_cache));
+    --net_socket->resolve_cache_count;
+}
+
+static int resolve_cache_get(net_socket_impl_t *net_socket,
+                             const char *host,
+                             const char *port,
+                             sockaddr_endpoint_union_t *out) {
+    avs_time_monotonic_t now = avs_time_monotonic_now();
+    for (size_t i = 0; i < net_socket->resolve_cache_count; ++i) {
+        resolve_cache_entry_t *entry = &net_socket->resolve_cache[i];
+        if (strcmp(entry->host, host) || strcmp(entry->port, port)) {
+            continue;
+        }
+        if (!avs_time_monotonic_before(now, entry->expires)) {
+            resolve_cache_remove(net_socket, i);
+            return -1;
+        }
+        // move to front
+        resolve_cache_entry_t tmp = *entry;
+        memmove(&net_socket->resolve_cache[1], &net_socket->resolve_cache[0],
+                i * sizeof(*net_socket->resolve_cache));
+        net_socket->resolve_cache[0] = tmp;
+        *out = tmp.address;
+        return 0;
+    }
+    return -1;
+}
+
+static void resolve_cache_store(net_socket_impl_t *net_socket,
+                                const char *host,
+                                const char *port,
+                                const sockaddr_endpoint_union_t *address) {
+    const size_t cache_size = net_socket->configuration.resolve_cache_size;
+    if (!cache_size || strlen(host) >= NET_MAX_HOSTNAME_SIZE
+            || strlen(port) >= NET_PORT_SIZE) {
+        return;
+    }
+    if (!net_socket->resolve_cache) {
+        net_socket->resolve_cache = (resolve_cache_entry_t *) avs_calloc(
+                cache_size, sizeof(*net_socket->resolve_cache));
+        if (!net_socket->resolve_cache) {
+            LOG_OOM();
+            return;
+        }
+    }
+    if (net_socket->resolve_cache_count < cache_size) {
+        ++net_socket->resolve_cache_count;
+    }
+    // the least recently used entry, if any, is dropped at the end
+    memmove(&net_socket->resolve_cache[1], &net_socket->resolve_cache[0],
+            (net_socket->resolve_cache_count - 1)
+                    * sizeof(*net_socket->resolve_cache));
+
+    avs_time_duration_t ttl = net_socket->configuration.resolve_cache_ttl;
+    if (!avs_time_duration_less(AVS_TIME_DURATION_ZERO, ttl)) {
+        ttl = AVS_NET_SOCKET_DEFAULT_RESOLVE_CACHE_TTL;
+    }
+    resolve_cache_entry_t *entry = &net_socket->resolve_cache[0];
+    strcpy(entry->host, host);
+    strcpy(entry->port, port);
+    entry->address = *address;
+    entry->expires = avs_time_monotonic_add(avs_time_monotonic_now(), ttl);
+}
+
 static avs_error_t send_to_net(avs_net_socket_t *net_socket_,
                                const void *buffer,
                                size_t buffer_length,
@@ -1414,7 +1733,35 @@ static avs_error_t send_to_net(avs_net_socket_t *net_socket_,
     net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
     avs_net_addrinfo_t *info = NULL;
 
-    avs_error_t err = avs_errno(AVS_EADDRNOTAVAIL);
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON
+    sockaddr_endpoint_union_t numeric_address;
+    if (!resolve_numeric_for_socket(net_socket, host, port,
+                                    &numeric_address)) {
+        return send_to_resolved(net_socket, buffer, buffer_length,
+                                &numeric_address);
+    }
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON
+
+    if (!host) {
+        host = "";
+    }
+    if (!port) {
+        port = "";
+    }
+    avs_error_t err;
+    sockaddr_endpoint_union_t cached_address;
+    if (!resolve_cache_get(net_socket, host, port, &cached_address)) {
+        err = send_to_resolved(net_socket, buffer, buffer_length,
+                               &cached_address);
+        if (err.category != AVS_ERRNO_CATEGORY
+                || err.code != AVS_ENETUNREACH) {
+            return err;
+        }
+        // the entry has been moved to front by resolve_cache_get()
+        resolve_cache_remove(net_socket, 0);
+    }
+
+    err = avs_errno(AVS_EADDRNOTAVAIL);
     if ((info = resolve_addrinfo_for_socket(net_socket, host, port, false,
                                             PREFERRED_FAMILY_ONLY))) {
         sockaddr_endpoint_union_t address;
@@ -1422,6 +1769,9 @@ static avs_error_t send_to_net(avs_net_socket_t *net_socket_,
             err = send_to_resolved(net_socket, buffer, buffer_length, &address);
             if (err.category != AVS_ERRNO_CATEGORY
                     || err.code != AVS_ENETUNREACH) {
+                if (avs_is_ok(err)) {
+                    resolve_cache_store(net_socket, host, port, &address);
+                }
                 avs_net_addrinfo_delete(&info);
                 return err;
             }
@@ -1435,6 +1785,9 @@ static avs_error_t send_to_net(avs_net_socket_t *net_socket_,
             err = send_to_resolved(net_socket, buffer, buffer_length, &address);
             if (err.category != AVS_ERRNO_CATEGORY
                     || err.code != AVS_ENETUNREACH) {
+                if (avs_is_ok(err)) {
+                    resolve_cache_store(net_socket, host, port, &address);
+                }
                 avs_net_addrinfo_delete(&info);
                 return err;
             }
@@ -1447,6 +1800,202 @@ static avs_error_t send_to_net(avs_net_socket_t *net_socket_,
     return avs_errno(AVS_EADDRNOTAVAIL);
 }
 
+typedef struct {
+    const avs_net_outgoing_datagram_t *datagrams;
+    size_t datagram_count;
+    size_t sent_count;
+    size_t bytes_sent;
+    bool gso;
+    /* set if the failed send attempt used UDP_SEGMENT */
+    bool gso_failed;
+} send_many_internal_arg_t;
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+/* Maximum number of messages passed to a single sendmmsg() call */
+#        define NET_SEND_MANY_BATCH_SIZE 16
+/* Maximum number of datagrams passed to a single sendmmsg() call; may be
+ * greater than NET_SEND_MANY_BATCH_SIZE when UDP GSO is in use */
+#        define NET_SEND_MANY_IOV_COUNT 64
+
+#        ifdef WITH_UDP_GSO
+/* Kernel limit on the number of segments in a single GSO buffer */
+#            define NET_GSO_MAX_SEGMENTS 64
+/* Stay well below the 64 KiB limit of a single IP packet, including headers */
+#            define NET_GSO_MAX_PAYLOAD 65000
+
+static bool same_destination(const avs_net_outgoing_datagram_t *a,
+                             const avs_net_outgoing_datagram_t *b) {
+    if (!a->destination || !b->destination) {
+        return a->destination == b->destination;
+    }
+    return a->destination->size == b->destination->size
+           && !memcmp(a->destination->data.buf, b->destination->data.buf,
+                      a->destination->size);
+}
+
+/**
+ * Returns the number of datagrams, starting at @p datagrams , that can be sent
+ * as a single GSO buffer: all must have the same destination and the same
+ * length, except for the last one, which may be shorter.
+ */
+static size_t gso_run_length(const avs_net_outgoing_datagram_t *datagrams,
+                             size_t max_count) {
+    size_t segment_size = datagrams[0].buffer_length;
+    size_t total_size = segment_size;
+    size_t count = 1;
+    if (segment_size == 0 || segment_size > UINT16_MAX) {
+        return 1;
+    }
+    while (count < AVS_MIN(max_count, NET_GSO_MAX_SEGMENTS)) {
+        const avs_net_outgoing_datagram_t *next = &datagrams[count];
+        if (next->buffer_length == 0 || next->buffer_length > segment_size
+                || total_size + next->buffer_length > NET_GSO_MAX_PAYLOAD
+                || !same_destination(&datagrams[0], next)) {
+            break;
+        }
+        total_size += next->buffer_length;
+        ++count;
+        if (next->buffer_length < segment_size) {
+            break;
+        }
+    }
+    return count;
+}
+#        endif // WITH_UDP_GSO
+
+static avs_error_t send_many_internal(sockfd_t sockfd, void *arg_) {
+    send_many_internal_arg_t *arg = (send_many_internal_arg_t *) arg_;
+    const avs_net_outgoing_datagram_t *datagrams =
+            &arg->datagrams[arg->sent_count];
+    size_t datagram_count = arg->datagram_count - arg->sent_count;
+    struct mmsghdr msgs[NET_SEND_MANY_BATCH_SIZE];
+    size_t msg_datagram_counts[NET_SEND_MANY_BATCH_SIZE];
+    struct iovec iov[NET_SEND_MANY_IOV_COUNT];
+#        ifdef WITH_UDP_GSO
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        avs_max_align_t align;
+    } control[NET_SEND_MANY_BATCH_SIZE];
+#        endif // WITH_UDP_GSO
+
+    size_t msg_count = 0;
+    size_t iov_count = 0;
+    memset(msgs, 0, sizeof(msgs));
+    while (msg_count < AVS_ARRAY_SIZE(msgs) && iov_count < AVS_ARRAY_SIZE(iov)
+           && datagram_count > 0) {
+        struct msghdr *hdr = &msgs[msg_count].msg_hdr;
+        size_t count = 1;
+#        ifdef WITH_UDP_GSO
+        if (arg->gso) {
+            count = gso_run_length(
+                    datagrams,
+                    AVS_MIN(datagram_count, AVS_ARRAY_SIZE(iov) - iov_count));
+        }
+        if (count > 1) {
+            memset(&control[msg_count], 0, sizeof(control[msg_count]));
+            hdr->msg_control = control[msg_count].buf;
+            hdr->msg_controllen = sizeof(control[msg_count].buf);
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segment_size = (uint16_t) datagrams[0].buffer_length;
+            memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+        }
+#        endif // WITH_UDP_GSO
+        hdr->msg_iov = &iov[iov_count];
+        hdr->msg_iovlen = count;
+        for (size_t i = 0; i < count; ++i) {
+            iov[iov_count].iov_base = (void *) (intptr_t) datagrams[i].buffer;
+            iov[iov_count].iov_len = datagrams[i].buffer_length;
+            ++iov_count;
+        }
+        if (datagrams[0].destination) {
+            hdr->msg_name = (void *) (intptr_t) datagrams[0]
+                                    .destination->data.buf;
+            hdr->msg_namelen = datagrams[0].destination->size;
+        }
+        msg_datagram_counts[msg_count++] = count;
+        datagrams += count;
+        datagram_count -= count;
+    }
+
+    int result = sendmmsg(sockfd, msgs, (unsigned) msg_count, MSG_NOSIGNAL);
+    if (result < 0) {
+        arg->gso_failed = (msg_datagram_counts[0] > 1);
+        return failure_from_errno();
+    }
+    for (size_t i = 0; i < (size_t) result; ++i) {
+        arg->sent_count += msg_datagram_counts[i];
+        arg->bytes_sent += msgs[i].msg_len;
+    }
+    return AVS_OK;
+}
+#    else  // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+static avs_error_t send_many_internal(sockfd_t sockfd, void *arg_) {
+    send_many_internal_arg_t *arg = (send_many_internal_arg_t *) arg_;
+    const avs_net_outgoing_datagram_t *datagram =
+            &arg->datagrams[arg->sent_count];
+    ssize_t result;
+    if (datagram->destination) {
+        result = sendto(sockfd, datagram->buffer, datagram->buffer_length,
+                        MSG_NOSIGNAL,
+                        (const struct sockaddr *) &datagram->destination->data,
+                        datagram->destination->size);
+    } else {
+        result = send(sockfd, datagram->buffer, datagram->buffer_length,
+                      MSG_NOSIGNAL);
+    }
+    if (result < 0) {
+        return failure_from_errno();
+    }
+    if ((size_t) result != datagram->buffer_length) {
+        return avs_errno(AVS_EIO);
+    }
+    ++arg->sent_count;
+    arg->bytes_sent += (size_t) result;
+    return AVS_OK;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+
+static avs_error_t
+send_to_many_net(avs_net_socket_t *net_socket_,
+                 const avs_net_outgoing_datagram_t *datagrams,
+                 size_t datagram_count,
+                 size_t *out_sent_count) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+
+    send_many_internal_arg_t arg = {
+        .datagrams = datagrams,
+        .datagram_count = datagram_count,
+        .gso = net_socket->udp_segmentation
+    };
+    avs_error_t err = AVS_OK;
+    while (arg.sent_count < datagram_count) {
+        arg.gso_failed = false;
+        err = call_when_ready(&net_socket->socket, NET_SEND_TIMEOUT,
+                              AVS_POLLOUT | AVS_POLLERR, send_many_internal,
+                              &arg);
+        if (avs_is_err(err) && arg.gso_failed) {
+            /* e.g. the segment size exceeds the MTU, or the network device
+             * cannot offload checksums - retry without segmentation */
+            LOG(DEBUG, _("UDP GSO send failed, falling back to sendmmsg()"));
+            arg.gso = false;
+            continue;
+        }
+        if (avs_is_err(err)) {
+            LOG(ERROR, _("send failed"));
+            break;
+        }
+    }
+    net_socket->bytes_sent += arg.bytes_sent;
+    *out_sent_count = arg.sent_count;
+    return err;
+}
+
 typedef struct {
     avs_net_socket_type_t socket_type;
     size_t bytes_received;
@@ -1585,6 +2134,116 @@ static avs_error_t receive_from_net(avs_net_socket_t *net_socket_,
     return err;
 }
 
+typedef struct {
+    avs_net_incoming_datagram_t *datagrams;
+    size_t datagram_count;
+    size_t received_count;
+    /* set if there are no more datagrams queued in the socket */
+    bool drained;
+} recv_many_internal_arg_t;
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+/* Maximum number of datagrams received by a single recvmmsg() call */
+#        define NET_RECV_MANY_BATCH_SIZE 16
+
+static avs_error_t recv_many_internal(sockfd_t sockfd, void *arg_) {
+    recv_many_internal_arg_t *arg = (recv_many_internal_arg_t *) arg_;
+    avs_net_incoming_datagram_t *datagrams =
+            &arg->datagrams[arg->received_count];
+    struct mmsghdr msgs[NET_RECV_MANY_BATCH_SIZE];
+    struct iovec iov[NET_RECV_MANY_BATCH_SIZE];
+    size_t count = AVS_MIN(arg->datagram_count - arg->received_count,
+                           AVS_ARRAY_SIZE(msgs));
+    memset(msgs, 0, count * sizeof(*msgs));
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = datagrams[i].buffer;
+        iov[i].iov_len = datagrams[i].buffer_length;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = datagrams[i].out_source.data.buf;
+        msgs[i].msg_hdr.msg_namelen =
+                (socklen_t) sizeof(datagrams[i].out_source.data.buf);
+    }
+
+    errno = 0;
+    /* the socket is non-blocking, so this returns as soon as the queue is
+     * drained, after receiving at least one datagram */
+    int result = recvmmsg(sockfd, msgs, (unsigned) count, 0, NULL);
+    if (result < 0) {
+        return failure_from_errno();
+    }
+    for (size_t i = 0; i < (size_t) result; ++i) {
+        datagrams[i].out_size =
+                AVS_MIN((size_t) msgs[i].msg_len, datagrams[i].buffer_length);
+        datagrams[i].out_truncated = !!(msgs[i].msg_hdr.msg_flags & MSG_TRUNC);
+        datagrams[i].out_source.size = (uint8_t) msgs[i].msg_hdr.msg_namelen;
+    }
+    arg->received_count += (size_t) result;
+    arg->drained = ((size_t) result < count);
+    return AVS_OK;
+}
+#    else  // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+static avs_error_t recv_many_internal(sockfd_t sockfd, void *arg_) {
+    recv_many_internal_arg_t *arg = (recv_many_internal_arg_t *) arg_;
+    avs_net_incoming_datagram_t *datagram =
+            &arg->datagrams[arg->received_count];
+    sockaddr_union_t src_addr;
+    socklen_t src_addr_length = 0;
+    recvfrom_internal_arg_t recv_arg = {
+        .socket_type = AVS_NET_UDP_SOCKET,
+        .buffer = datagram->buffer,
+        .buffer_length = datagram->buffer_length,
+        .src_addr = &src_addr,
+        .src_addr_length = &src_addr_length
+    };
+    avs_error_t err = recvfrom_internal(sockfd, &recv_arg);
+    datagram->out_truncated =
+            (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_EMSGSIZE);
+    if (avs_is_err(err) && !datagram->out_truncated) {
+        return err;
+    }
+    datagram->out_size = recv_arg.bytes_received;
+    src_addr_length = AVS_MIN(src_addr_length,
+                              (socklen_t) sizeof(datagram->out_source.data));
+    memcpy(datagram->out_source.data.buf, &src_addr, src_addr_length);
+    datagram->out_source.size = (uint8_t) src_addr_length;
+    ++arg->received_count;
+    return AVS_OK;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+
+static avs_error_t
+receive_from_many_net(avs_net_socket_t *net_socket_,
+                      avs_net_incoming_datagram_t *datagrams,
+                      size_t datagram_count,
+                      size_t *out_received_count) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+
+    recv_many_internal_arg_t arg = {
+        .datagrams = datagrams,
+        .datagram_count = datagram_count
+    };
+    avs_error_t err =
+            call_when_ready(&net_socket->socket, net_socket->recv_timeout,
+                            AVS_POLLIN | AVS_POLLERR, recv_many_internal, &arg);
+    /* pick up the datagrams that are already queued, without waiting; any
+     * error at this point (most likely AVS_EAGAIN) just ends the batch */
+    while (avs_is_ok(err) && !arg.drained
+           && arg.received_count < datagram_count
+           && net_socket->socket != INVALID_SOCKET) {
+        err = recv_many_internal(net_socket->socket, &arg);
+    }
+
+    for (size_t i = 0; i < arg.received_count; ++i) {
+        net_socket->bytes_received += datagrams[i].out_size;
+    }
+    *out_received_count = arg.received_count;
+    return arg.received_count > 0 ? AVS_OK : err;
+}
+
 static avs_error_t try_bind(net_socket_impl_t *net_socket,
                             avs_net_af_t family,
                             const char *localaddr,
@@ -2061,6 +2720,9 @@ static avs_error_t get_opt_net(avs_net_socket_t *net_socket_,
         out_option_value->addr_family =
                 net_socket->configuration.address_family;
         return AVS_OK;
+    case AVS_NET_SOCKET_OPT_UDP_SEGMENTATION:
+        out_option_value->flag = net_socket->udp_segmentation;
+        return AVS_OK;
     default:
         LOG(DEBUG,
             _("get_opt_net: unknown or unsupported option key: ")
@@ -2106,6 +2768,18 @@ static avs_error_t set_opt_net(avs_net_socket_t *net_socket_,
             net_socket->configuration.address_family = option_value.addr_family;
             return AVS_OK;
         }
+    case AVS_NET_SOCKET_OPT_UDP_SEGMENTATION:
+#    ifdef WITH_UDP_GSO
+        if (net_socket->type == AVS_NET_UDP_SOCKET) {
+            net_socket->udp_segmentation = option_value.flag;
+            return AVS_OK;
+        }
+#    endif // WITH_UDP_GSO
+        if (!option_value.flag) {
+            return AVS_OK;
+        }
+        LOG(DEBUG, _("set_opt_net: UDP segmentation not supported"));
+        return avs_errno(AVS_ENOTSUP);
     default:
         LOG(DEBUG,
             _("set_opt_net: unknown or unsupported option key: ")
@@ -2233,5 +2907,9 @@ void _avs_net_cleanup_global_compat_state(void) {
 #    endif // HAVE_GLOBAL_COMPAT_STATE
 }
 
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/net/compat/posix/net_impl.c"
+#    endif // AVS_UNIT_TESTING
+
 #endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
        // defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
@@ -55,6 +55,7 @@
 
 #    include <avsystem/commons/avs_errno_map.h>
 #    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
 #    include <avsystem/commons/avs_prng.h>
 #    include <avsystem/commons/avs_utils.h>
 
@@ -73,6 +74,39 @@
            // defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA512_C) &&
            // defined(MBEDTLS_PK_WRITE_C)
 
+#    if defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) \
+            && defined(MBEDTLS_SSL_SRV_C)                      \
+            && MBEDTLS_VERSION_NUMBER >= 0x02130000
+// mbedtls_ssl_session_save() and mbedtls_ssl_session_load() are available
+// since Mbed TLS 2.19
+#        define WITH_SERVER_SESSION_CACHE
+#        include "../avs_tls_server_session_cache.h"
+// mbedtls_ssl_ticket_rotate() is available since Mbed TLS 3.2
+#        if defined(MBEDTLS_SSL_TICKET_C)               \
+                && defined(MBEDTLS_SSL_SESSION_TICKETS) \
+                && MBEDTLS_VERSION_NUMBER >= 0x03020000
+#            include <mbedtls/platform_util.h>
+#            include <mbedtls/ssl_ticket.h>
+#            define WITH_SERVER_SESSION_TICKETS
+#        endif // defined(MBEDTLS_SSL_TICKET_C) &&
+               // defined(MBEDTLS_SSL_SESSION_TICKETS) &&
+               // MBEDTLS_VERSION_NUMBER >= 0x03020000
+#    endif     // defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) &&
+               // defined(MBEDTLS_SSL_SRV_C) &&
+               // MBEDTLS_VERSION_NUMBER >= 0x02130000
+
+#    ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+#        include <mbedtls/md.h>
+
+#        include "../avs_dtls_listener.h"
+#        if defined(MBEDTLS_SSL_PROTO_DTLS) && defined(MBEDTLS_SSL_SRV_C) \
+                && defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+#            define WITH_DTLS_LISTENER
+#        endif // defined(MBEDTLS_SSL_PROTO_DTLS) &&
+               // defined(MBEDTLS_SSL_SRV_C) &&
+               // defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+#    endif     // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+
 #    include "../avs_net_impl.h"
 
 #    include "crypto/mbedtls/avs_mbedtls_private.h"
@@ -117,9 +151,31 @@ typedef struct {
     dane_verify_state_t dane_verify_state;
 #        endif // WITH_DANE_SUPPORT
     mbedtls_x509_crt *noauth_dummy_ca_cert;
+#        ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    // if not NULL, ca_cert/ca_crl are borrowed from the PKI cache
+    avs_crypto_pki_cache_entry_t *ca_cert_cache_entry;
+    avs_crypto_pki_cache_entry_t *ca_crl_cache_entry;
+#        endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
 } ssl_socket_certs_t;
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 
+struct avs_net_tls_context_struct {
+    avs_mutex_t *mutex;
+    size_t refcount;
+    avs_net_socket_type_t socket_type;
+
+    /// Context-level subset of the configuration the context was created
+    /// from; all data it refers to is owned by the context
+    avs_net_ssl_configuration_t configuration;
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_crypto_psk_key_info_t *psk_key;
+    avs_crypto_psk_identity_info_t *psk_identity;
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+    ssl_socket_certs_t certs;
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+};
+
 typedef struct {
     const avs_net_socket_v_table_t *const operations;
     struct {
@@ -136,6 +192,8 @@ typedef struct {
     size_t session_resumption_buffer_size;
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
     avs_net_security_mode_t security_mode;
+    /// Shared context, if used; cert_security is then borrowed from it
+    avs_net_tls_context_t *tls_context;
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
     ssl_socket_certs_t cert_security;
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
@@ -152,6 +210,16 @@ typedef struct {
 #    ifdef MBEDTLS_SSL_DTLS_CONNECTION_ID
     bool use_connection_id;
 #    endif // MBEDTLS_SSL_DTLS_CONNECTION_ID
+#    ifdef WITH_SERVER_SESSION_CACHE
+    /// Not owned; NULL if server-side session resumption is not configured
+    avs_net_tls_server_session_cache_t *server_session_cache;
+#        ifdef WITH_SERVER_SESSION_TICKETS
+    /// Loaded with the keys shared through server_session_cache before each
+    /// server-side handshake
+    mbedtls_ssl_ticket_context ticket_context;
+    bool ticket_context_valid;
+#        endif // WITH_SERVER_SESSION_TICKETS
+#    endif     // WITH_SERVER_SESSION_CACHE
 } ssl_socket_t;
 
 static bool is_ssl_started(ssl_socket_t *socket) {
@@ -739,9 +807,11 @@ static avs_error_t initialize_cert_security(ssl_socket_t *socket) {
         memset(&empty_chain_info, 0, sizeof(empty_chain_info));
 
         avs_error_t err;
-        if (avs_is_err((err = _avs_crypto_mbedtls_load_certs(
-                                &socket->cert_security.noauth_dummy_ca_cert,
-                                &empty_chain_info)))) {
+        if (!socket->cert_security.noauth_dummy_ca_cert
+                && avs_is_err((err = _avs_crypto_mbedtls_load_certs(
+                                       &socket->cert_security
+                                                .noauth_dummy_ca_cert,
+                                       &empty_chain_info)))) {
             return err;
         }
         mbedtls_ssl_conf_verify(&socket->config, noauth_cert_cb, socket);
@@ -876,6 +946,171 @@ static int fake_session_cache_set(void *socket_,
 }
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
+#    ifdef WITH_SERVER_SESSION_CACHE
+#        if MBEDTLS_VERSION_NUMBER >= 0x03000000
+static int server_session_cache_get(void *socket_,
+                                    unsigned char const *session_id,
+                                    size_t session_id_len,
+                                    mbedtls_ssl_session *session) {
+#        else  // MBEDTLS_VERSION_NUMBER >= 0x03000000
+static int server_session_cache_get(void *socket_,
+                                    mbedtls_ssl_session *session) {
+    const unsigned char *session_id = session->id;
+    size_t session_id_len = session->id_len;
+#        endif // MBEDTLS_VERSION_NUMBER >= 0x03000000
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    void *data = NULL;
+    size_t data_size = 0;
+    if (avs_is_err(_avs_net_tls_server_session_cache_retrieve(
+                socket->server_session_cache, session_id, session_id_len,
+                &data, &data_size))) {
+        return -1;
+    }
+    int result = mbedtls_ssl_session_load(
+            session, (const unsigned char *) data, data_size);
+    avs_free(data);
+    if (!result) {
+        // Mbed TLS resumes the session if, and only if, it is found
+        socket->flags.session_fresh = false;
+    }
+    return result;
+}
+
+#        if MBEDTLS_VERSION_NUMBER >= 0x03000000
+static int server_session_cache_set(void *socket_,
+                                    unsigned char const *session_id,
+                                    size_t session_id_len,
+                                    const mbedtls_ssl_session *session) {
+#        else  // MBEDTLS_VERSION_NUMBER >= 0x03000000
+static int server_session_cache_set(void *socket_,
+                                    const mbedtls_ssl_session *session) {
+    const unsigned char *session_id = session->id;
+    size_t session_id_len = session->id_len;
+#        endif // MBEDTLS_VERSION_NUMBER >= 0x03000000
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    // See fake_session_cache_set() - this is called for fresh sessions only
+    socket->flags.session_fresh = true;
+
+    size_t data_size = 0;
+    int result = mbedtls_ssl_session_save(session, NULL, 0, &data_size);
+    if (result != MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        return result ? result : -1;
+    }
+    unsigned char *data = (unsigned char *) avs_malloc(data_size);
+    if (!data) {
+        LOG_OOM();
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    if (!(result = mbedtls_ssl_session_save(session, data, data_size,
+                                            &data_size))
+            && avs_is_err(_avs_net_tls_server_session_cache_store(
+                       socket->server_session_cache, session_id,
+                       session_id_len, data, data_size))) {
+        result = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    avs_free(data);
+    return result;
+}
+
+#        ifdef WITH_SERVER_SESSION_TICKETS
+static int server_ticket_write(void *socket_,
+                               const mbedtls_ssl_session *session,
+                               unsigned char *start,
+                               const unsigned char *end,
+                               size_t *tlen,
+                               uint32_t *lifetime) {
+    return mbedtls_ssl_ticket_write(&((ssl_socket_t *) socket_)->ticket_context,
+                                    session, start, end, tlen, lifetime);
+}
+
+static int server_ticket_parse(void *socket_,
+                               mbedtls_ssl_session *session,
+                               unsigned char *buf,
+                               size_t len) {
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    int result = mbedtls_ssl_ticket_parse(&socket->ticket_context, session,
+                                          buf, len);
+    if (!result) {
+        socket->flags.session_fresh = false;
+    }
+    return result;
+}
+
+static uint32_t server_ticket_lifetime(ssl_socket_t *socket) {
+    int64_t lifetime_s;
+    if (avs_time_duration_to_scalar(
+                &lifetime_s, AVS_TIME_S,
+                _avs_net_tls_server_session_cache_lifetime(
+                        socket->server_session_cache))
+            || lifetime_s <= 0) {
+        return 1;
+    }
+    return (uint32_t) AVS_MIN(lifetime_s, UINT32_MAX);
+}
+
+static avs_error_t update_server_ticket_keys(ssl_socket_t *socket) {
+    avs_net_tls_ticket_key_t keys[AVS_NET_TLS_TICKET_KEYS_MAX];
+    size_t key_count = 0;
+    avs_error_t err = _avs_net_tls_server_session_cache_ticket_keys(
+            socket->server_session_cache, keys, &key_count);
+    // mbedtls_ssl_ticket_rotate() replaces the inactive key and activates it,
+    // so the previous key is installed first, and the current one last. Only
+    // the first MBEDTLS_SSL_TICKET_KEY_NAME_BYTES bytes of the name are used.
+    for (size_t i = key_count; avs_is_ok(err) && i-- > 0;) {
+        int result = mbedtls_ssl_ticket_rotate(
+                &socket->ticket_context, keys[i].name, sizeof(keys[i].name),
+                keys[i].cipher_key, sizeof(keys[i].cipher_key),
+                server_ticket_lifetime(socket));
+        if (result) {
+            LOG(ERROR, _("mbedtls_ssl_ticket_rotate() failed: ") "%d", result);
+            err = avs_errno(AVS_EPROTO);
+        }
+    }
+    mbedtls_platform_zeroize(keys, sizeof(keys));
+    return err;
+}
+#        endif // WITH_SERVER_SESSION_TICKETS
+
+static avs_error_t
+configure_server_session_cache(ssl_socket_t *socket,
+                               avs_net_tls_server_session_cache_t *cache,
+                               avs_crypto_mbedtls_prng_cb_t *random_cb,
+                               void *random_cb_arg) {
+    socket->server_session_cache = cache;
+    if (_avs_net_tls_server_session_cache_stateful(cache)) {
+        // NOTE: This replaces fake_session_cache_set(), which is irrelevant
+        // for server-side sockets anyway
+        mbedtls_ssl_conf_session_cache(&socket->config, socket,
+                                       server_session_cache_get,
+                                       server_session_cache_set);
+    }
+    if (_avs_net_tls_server_session_cache_tickets_enabled(cache)) {
+#        ifdef WITH_SERVER_SESSION_TICKETS
+        mbedtls_ssl_ticket_init(&socket->ticket_context);
+        socket->ticket_context_valid = true;
+        int result = mbedtls_ssl_ticket_setup(
+                &socket->ticket_context, random_cb, random_cb_arg,
+                MBEDTLS_CIPHER_AES_256_GCM, server_ticket_lifetime(socket));
+        if (result) {
+            LOG(ERROR, _("mbedtls_ssl_ticket_setup() failed: ") "%d", result);
+            return avs_errno(AVS_ENOTSUP);
+        }
+        mbedtls_ssl_conf_session_tickets_cb(&socket->config,
+                                            server_ticket_write,
+                                            server_ticket_parse, socket);
+#        else  // WITH_SERVER_SESSION_TICKETS
+        (void) random_cb;
+        (void) random_cb_arg;
+        LOG(WARNING,
+            _("Server-side session tickets require Mbed TLS 3.2 or newer "
+              "with MBEDTLS_SSL_TICKET_C; only session ID based resumption "
+              "will be available"));
+#        endif // WITH_SERVER_SESSION_TICKETS
+    }
+    return AVS_OK;
+}
+#    endif // WITH_SERVER_SESSION_CACHE
+
 static int socket_set_dtls_handshake_timeouts(
         ssl_socket_t *socket,
         const avs_net_dtls_handshake_timeouts_t *dtls_handshake_timeouts) {
@@ -1002,6 +1237,20 @@ configure_ssl(ssl_socket_t *socket,
                                    fake_session_cache_set);
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
+    if (configuration->server_session_cache) {
+#    ifdef WITH_SERVER_SESSION_CACHE
+        avs_error_t err = configure_server_session_cache(
+                socket, configuration->server_session_cache, random_cb,
+                random_cb_arg);
+        if (avs_is_err(err)) {
+            return err;
+        }
+#    else  // WITH_SERVER_SESSION_CACHE
+        LOG(ERROR, _("Server session cache is not supported"));
+        return avs_errno(AVS_ENOTSUP);
+#    endif // WITH_SERVER_SESSION_CACHE
+    }
+
     avs_free(socket->effective_ciphersuites);
     if (!(socket->effective_ciphersuites =
                   init_ciphersuites(socket, &configuration->ciphersuites))) {
@@ -1037,6 +1286,90 @@ configure_ssl(ssl_socket_t *socket,
     return AVS_OK;
 }
 
+#    ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+avs_error_t _avs_net_hmac_sha256(const void *key,
+                                 size_t key_size,
+                                 const void *data,
+                                 size_t data_size,
+                                 unsigned char out[AVS_NET_HMAC_SHA256_SIZE]) {
+#        ifdef WITH_DTLS_LISTENER
+    const mbedtls_md_info_t *md_info =
+            mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    int result;
+    if (!md_info
+            || (result = mbedtls_md_hmac(md_info, (const unsigned char *) key,
+                                         key_size, (const unsigned char *) data,
+                                         data_size, out))) {
+        LOG(ERROR, _("could not calculate HMAC-SHA256"));
+        return avs_errno(AVS_EPROTO);
+    }
+    return AVS_OK;
+#        else  // WITH_DTLS_LISTENER
+    (void) key;
+    (void) key_size;
+    (void) data;
+    (void) data_size;
+    (void) out;
+    LOG(ERROR, _("DTLS listeners require DTLS server and cookie support"));
+    return avs_errno(AVS_ENOTSUP);
+#        endif // WITH_DTLS_LISTENER
+}
+#    endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+
+#    ifdef WITH_DTLS_LISTENER
+static int listener_cookie_write_cb(void *socket_,
+                                    unsigned char **p,
+                                    unsigned char *end,
+                                    const unsigned char *cli_id,
+                                    size_t cli_id_len) {
+    (void) socket_;
+    (void) p;
+    (void) end;
+    (void) cli_id;
+    (void) cli_id_len;
+    // HelloVerifyRequests are only ever sent by the listener
+    return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+}
+
+static int listener_cookie_check_cb(void *socket_,
+                                    const unsigned char *cookie,
+                                    size_t cookie_len,
+                                    const unsigned char *cli_id,
+                                    size_t cli_id_len) {
+    (void) cookie;
+    (void) cookie_len;
+    (void) cli_id;
+    (void) cli_id_len;
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    // the listener only passes ClientHellos with valid cookies to its peers
+    return _avs_net_dtls_listener_is_peer(socket->backend_socket, NULL, NULL)
+                   ? 0
+                   : MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+}
+
+static avs_error_t configure_listener_peer(ssl_socket_t *socket) {
+    // NOTE: This replaces the default dummy callbacks, which reject all
+    // cookies, with ones that behave the same unless the backend socket is a
+    // listener peer.
+    mbedtls_ssl_conf_dtls_cookies(&socket->config, listener_cookie_write_cb,
+                                  listener_cookie_check_cb, socket);
+#        ifdef MBEDTLS_SSL_DTLS_CONNECTION_ID
+    size_t connection_id_length = 0;
+    if (_avs_net_dtls_listener_is_peer(socket->backend_socket, NULL,
+                                       &connection_id_length)
+            && connection_id_length > 0) {
+        if (mbedtls_ssl_conf_cid(&socket->config, connection_id_length,
+                                 MBEDTLS_SSL_UNEXPECTED_CID_IGNORE)) {
+            LOG(ERROR, _("cannot configure CID"));
+            return avs_errno(AVS_ENOTSUP);
+        }
+        socket->use_connection_id = true;
+    }
+#        endif // MBEDTLS_SSL_DTLS_CONNECTION_ID
+    return AVS_OK;
+}
+#    endif // WITH_DTLS_LISTENER
+
 static avs_error_t update_ssl_endpoint_config(ssl_socket_t *socket,
                                               int *out_endpoint) {
     avs_net_socket_opt_value_t state_opt;
@@ -1061,6 +1394,20 @@ static avs_error_t update_ssl_endpoint_config(ssl_socket_t *socket,
         mbedtls_ssl_conf_session_tickets(&socket->config,
                                          MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
 #    endif // MBEDTLS_SSL_SESSION_TICKETS
+#    ifdef WITH_SERVER_SESSION_TICKETS
+        // pick up keys rotated since the previous handshake
+        if (socket->ticket_context_valid
+                && avs_is_err(update_server_ticket_keys(socket))) {
+            LOG(WARNING, _("Could not load shared session ticket keys"));
+        }
+#    endif // WITH_SERVER_SESSION_TICKETS
+#    ifdef WITH_DTLS_LISTENER
+        if (transport_for_socket_type(socket->backend_type)
+                        == MBEDTLS_SSL_TRANSPORT_DATAGRAM
+                && avs_is_err((err = configure_listener_peer(socket)))) {
+            return err;
+        }
+#    endif // WITH_DTLS_LISTENER
     } else {
         LOG(ERROR, _("initialize_ssl_config: invalid socket state"));
         return avs_errno(AVS_EINVAL);
@@ -1149,8 +1496,10 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
     if (avs_is_err((err = init_ssl_context(socket)))) {
         goto finish;
     }
-#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+    // Cleared below, or by the server session cache callbacks, if an existing
+    // session is resumed
     socket->flags.session_fresh = true;
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
     if (socket->session_resumption_buffer
             && endpoint == MBEDTLS_SSL_IS_CLIENT) {
         bool ctx_freed = false;
@@ -1193,14 +1542,38 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
         // > A server willing to use CIDs will respond with a "connection_id"
         // > extension in the ServerHello, containing the CID it wishes the
         // > client to use when sending messages towards it.
+        const unsigned char *own_cid = NULL;
+        size_t own_cid_len = 0;
+#            ifdef WITH_DTLS_LISTENER
+        // peers of a DTLS listener are assigned CIDs by the listener, which
+        // uses them to route incoming records
+        (void) _avs_net_dtls_listener_is_peer(socket->backend_socket, &own_cid,
+                                              &own_cid_len);
+#            endif // WITH_DTLS_LISTENER
         if (socket->use_connection_id
                 && mbedtls_ssl_set_cid(get_context(socket),
-                                       MBEDTLS_SSL_CID_ENABLED, NULL, 0)) {
-            LOG(ERROR, _("cannot initialize CID to an empty value"));
+                                       MBEDTLS_SSL_CID_ENABLED, own_cid,
+                                       own_cid_len)) {
+            LOG(ERROR, _("cannot initialize CID"));
             err = avs_errno(AVS_EIO);
             goto finish;
         }
 #        endif // MBEDTLS_SSL_DTLS_CONNECTION_ID
+#        ifdef WITH_DTLS_LISTENER
+        char peer_host[NET_MAX_HOSTNAME_SIZE];
+        if (endpoint == MBEDTLS_SSL_IS_SERVER
+                && avs_is_ok(avs_net_socket_get_remote_host(
+                           socket->backend_socket, peer_host,
+                           sizeof(peer_host)))
+                && mbedtls_ssl_set_client_transport_id(
+                           get_context(socket),
+                           (const unsigned char *) peer_host,
+                           strlen(peer_host))) {
+            LOG(ERROR, _("cannot set client transport ID"));
+            err = avs_errno(AVS_ENOMEM);
+            goto finish;
+        }
+#        endif // WITH_DTLS_LISTENER
     }
 #    endif // defined(MBEDTLS_SSL_PROTO_DTLS)
 
@@ -1253,9 +1626,10 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
             // configuration.
             try_save_session(socket);
         }
-#    else  // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-        socket->flags.session_fresh = true;
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+#    ifdef WITH_DTLS_LISTENER
+        _avs_net_dtls_listener_peer_authenticated(socket->backend_socket);
+#    endif // WITH_DTLS_LISTENER
         if (socket->flags.session_fresh) {
             LOG(TRACE, _("handshake success: new session started"));
         } else {
@@ -1393,6 +1767,9 @@ static avs_error_t receive_ssl(avs_net_socket_t *socket_,
         }
     } else {
         *out_bytes_received = (size_t) result;
+#    ifdef WITH_DTLS_LISTENER
+        _avs_net_dtls_listener_peer_authenticated(socket->backend_socket);
+#    endif // WITH_DTLS_LISTENER
         if (transport_for_socket_type(socket->backend_type)
                         == MBEDTLS_SSL_TRANSPORT_DATAGRAM
                 && mbedtls_ssl_get_bytes_avail(get_context(socket)) > 0) {
@@ -1404,17 +1781,39 @@ static avs_error_t receive_ssl(avs_net_socket_t *socket_,
 }
 
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
-static void cleanup_security_cert(ssl_socket_certs_t *certs) {
+static void cleanup_ca_certs(ssl_socket_certs_t *certs) {
+#        ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    if (certs->ca_cert_cache_entry) {
+        _avs_crypto_pki_cache_release(&certs->ca_cert_cache_entry);
+        certs->ca_cert = NULL;
+        return;
+    }
+#        endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
     _avs_crypto_mbedtls_x509_crt_cleanup(&certs->ca_cert);
+}
+
+static void cleanup_ca_crls(ssl_socket_certs_t *certs) {
+#        ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    if (certs->ca_crl_cache_entry) {
+        _avs_crypto_pki_cache_release(&certs->ca_crl_cache_entry);
+        certs->ca_crl = NULL;
+        return;
+    }
+#        endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
     _avs_crypto_mbedtls_x509_crl_cleanup(&certs->ca_crl);
+}
+
+static void cleanup_security_cert(ssl_socket_certs_t *certs) {
+    cleanup_ca_certs(certs);
+    cleanup_ca_crls(certs);
     _avs_crypto_mbedtls_x509_crt_cleanup(&certs->client_cert);
     _avs_crypto_mbedtls_pk_context_cleanup(&certs->client_key);
 #        ifdef WITH_DANE_SUPPORT
     // NOTE: Not freeing dane_ta_certs, as it is supposed to be on the
     // ca_cert chain, so has been freed together with ca_cert
     avs_free((void *) (intptr_t) (const void *) certs->dane_tlsa.array_ptr);
-    _avs_crypto_mbedtls_x509_crt_cleanup(&certs->noauth_dummy_ca_cert);
 #        endif // WITH_DANE_SUPPORT
+    _avs_crypto_mbedtls_x509_crt_cleanup(&certs->noauth_dummy_ca_cert);
 }
 #    else // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 #        define cleanup_security_cert(...) (void) 0
@@ -1427,11 +1826,23 @@ static avs_error_t cleanup_ssl(avs_net_socket_t **socket_) {
     avs_error_t err = close_ssl(*socket_);
     add_err(&err, avs_net_socket_cleanup(&(*socket)->backend_socket));
 
-    if ((*socket)->security_mode == AVS_NET_SECURITY_CERTIFICATE) {
+    if ((*socket)->tls_context) {
+#    ifdef WITH_DANE_SUPPORT
+        // Only the TLSA records are owned by the socket in this case
+        avs_free((void *) (intptr_t) (const void *) (*socket)
+                         ->cert_security.dane_tlsa.array_ptr);
+#    endif // WITH_DANE_SUPPORT
+        release_tls_context(&(*socket)->tls_context);
+    } else if ((*socket)->security_mode == AVS_NET_SECURITY_CERTIFICATE) {
         cleanup_security_cert(&(*socket)->cert_security);
     }
     avs_free((*socket)->effective_ciphersuites);
 
+#    ifdef WITH_SERVER_SESSION_TICKETS
+    if ((*socket)->ticket_context_valid) {
+        mbedtls_ssl_ticket_free(&(*socket)->ticket_context);
+    }
+#    endif // WITH_SERVER_SESSION_TICKETS
     mbedtls_ssl_config_free(&(*socket)->config);
 
     avs_free(*socket);
@@ -1565,6 +1976,35 @@ static avs_error_t rebuild_client_cert_chain(mbedtls_x509_crt *trust_store,
     }
 }
 
+static avs_error_t load_ca_certs(ssl_socket_certs_t *certs,
+                                 const avs_net_certificate_info_t *cert_info) {
+    assert(!certs->ca_cert);
+#        ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    // DANE trust anchors are appended to the trust store chain, so it cannot
+    // be shared in that case
+    if (!cert_info->dane) {
+        return _avs_crypto_mbedtls_load_certs_cached(
+                &certs->ca_cert_cache_entry, &certs->ca_cert,
+                &cert_info->trusted_certs);
+    }
+#        endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    return _avs_crypto_mbedtls_load_certs(&certs->ca_cert,
+                                          &cert_info->trusted_certs);
+}
+
+static avs_error_t load_ca_crls(ssl_socket_certs_t *certs,
+                                const avs_net_certificate_info_t *cert_info) {
+    assert(!certs->ca_crl);
+#        ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    return _avs_crypto_mbedtls_load_crls_cached(
+            &certs->ca_crl_cache_entry, &certs->ca_crl,
+            &cert_info->cert_revocation_lists);
+#        else  // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+    return _avs_crypto_mbedtls_load_crls(&certs->ca_crl,
+                                         &cert_info->cert_revocation_lists);
+#        endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+}
+
 static avs_error_t
 configure_ssl_certs(ssl_socket_certs_t *certs,
                     const avs_net_certificate_info_t *cert_info,
@@ -1573,11 +2013,9 @@ configure_ssl_certs(ssl_socket_certs_t *certs,
 
     avs_error_t err = AVS_OK;
 
-    mbedtls_x509_crt *ca_certs = NULL;
     if ((cert_info->server_cert_validation
          || cert_info->rebuild_client_cert_chain)
-            && avs_is_err((err = _avs_crypto_mbedtls_load_certs(
-                                   &ca_certs, &cert_info->trusted_certs)))) {
+            && avs_is_err((err = load_ca_certs(certs, cert_info)))) {
         LOG(ERROR, _("could not load CA chain"));
     }
 
@@ -1588,12 +2026,13 @@ configure_ssl_certs(ssl_socket_certs_t *certs,
                                     &certs->client_cert,
                                     &cert_info->client_cert)))) {
                 LOG(ERROR, _("could not load client certificate"));
-            } else if (cert_info->rebuild_client_cert_chain && ca_certs
+            } else if (cert_info->rebuild_client_cert_chain && certs->ca_cert
                        && certs->client_cert
                        && _avs_crypto_mbedtls_x509_crt_present(
                                   certs->client_cert)
                        && avs_is_err((err = rebuild_client_cert_chain(
-                                              ca_certs, certs->client_cert)))) {
+                                              certs->ca_cert,
+                                              certs->client_cert)))) {
                 LOG(ERROR, _("could not rebuild client certificate chain"));
             }
             if (avs_is_ok(err)
@@ -1610,12 +2049,7 @@ configure_ssl_certs(ssl_socket_certs_t *certs,
 
     if (avs_is_ok(err)) {
         if (cert_info->server_cert_validation) {
-            assert(!certs->ca_cert);
-            certs->ca_cert = ca_certs;
-            ca_certs = NULL;
-            if (avs_is_err((err = _avs_crypto_mbedtls_load_crls(
-                                    &certs->ca_crl,
-                                    &cert_info->cert_revocation_lists)))) {
+            if (avs_is_err((err = load_ca_crls(certs, cert_info)))) {
                 LOG(ERROR, _("could not load CRLs"));
             }
         } else {
@@ -1623,7 +2057,11 @@ configure_ssl_certs(ssl_socket_certs_t *certs,
         }
     }
 
-    _avs_crypto_mbedtls_x509_crt_cleanup(&ca_certs);
+    if (!cert_info->server_cert_validation) {
+        // the CA chain might have been loaded just to rebuild the client
+        // certificate chain; it is not used as a trust store in that case
+        cleanup_ca_certs(certs);
+    }
 
     if (cert_info->dane) {
 #        ifdef WITH_DANE_SUPPORT
@@ -1657,6 +2095,119 @@ static inline avs_error_t configure_ssl_certs_impl(void) {
 #        define configure_ssl_certs(...) configure_ssl_certs_impl()
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 
+static avs_error_t
+initialize_tls_context(avs_net_tls_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration) {
+    context->configuration.version = configuration->version;
+    context->configuration.security.mode = configuration->security.mode;
+    context->configuration.additional_configuration_clb =
+            configuration->additional_configuration_clb;
+    context->configuration.use_connection_id =
+            configuration->use_connection_id;
+    context->configuration.prng_ctx = configuration->prng_ctx;
+    context->configuration.server_session_cache =
+            configuration->server_session_cache;
+
+    if (configuration->ciphersuites.num_ids > 0) {
+        if (!(context->configuration.ciphersuites.ids =
+                      (uint32_t *) avs_malloc(
+                              configuration->ciphersuites.num_ids
+                              * sizeof(*configuration->ciphersuites.ids)))) {
+            LOG_OOM();
+            return avs_errno(AVS_ENOMEM);
+        }
+        context->configuration.ciphersuites.num_ids =
+                configuration->ciphersuites.num_ids;
+        memcpy(context->configuration.ciphersuites.ids,
+               configuration->ciphersuites.ids,
+               configuration->ciphersuites.num_ids
+                       * sizeof(*configuration->ciphersuites.ids));
+    }
+
+    avs_error_t err;
+    switch (configuration->security.mode) {
+    case AVS_NET_SECURITY_PSK:
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+        if (avs_is_ok((err = avs_crypto_psk_key_info_copy(
+                               &context->psk_key,
+                               configuration->security.data.psk.key)))
+                && avs_is_ok((err = avs_crypto_psk_identity_info_copy(
+                                      &context->psk_identity,
+                                      configuration->security.data.psk
+                                              .identity)))) {
+            context->configuration.security.data.psk.key = *context->psk_key;
+            context->configuration.security.data.psk.identity =
+                    *context->psk_identity;
+        }
+#    else  // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+        LOG(ERROR, _("PSK support disabled"));
+        err = avs_errno(AVS_ENOTSUP);
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+        break;
+    case AVS_NET_SECURITY_CERTIFICATE:
+        if (configuration->security.data.cert.dane) {
+            // DANE trust anchors are appended to the trust store per socket
+            LOG(ERROR, _("DANE is not supported with shared TLS contexts"));
+            err = avs_errno(AVS_ENOTSUP);
+            break;
+        }
+        err = configure_ssl_certs(&context->certs,
+                                  &configuration->security.data.cert,
+                                  configuration->prng_ctx);
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+        if (avs_is_ok(err) && !context->certs.ca_cert
+                && !context->certs.ca_crl) {
+            // See initialize_cert_security() for why this is necessary
+            avs_crypto_certificate_chain_info_t empty_chain_info;
+            memset(&empty_chain_info, 0, sizeof(empty_chain_info));
+            err = _avs_crypto_mbedtls_load_certs(
+                    &context->certs.noauth_dummy_ca_cert, &empty_chain_info);
+        }
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+        break;
+    default:
+        AVS_UNREACHABLE("invalid enum value");
+        err = avs_errno(AVS_EINVAL);
+    }
+    return err;
+}
+
+static void cleanup_tls_context(avs_net_tls_context_t *context) {
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_free(context->psk_key);
+    context->psk_key = NULL;
+    avs_free(context->psk_identity);
+    context->psk_identity = NULL;
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    cleanup_security_cert(&context->certs);
+    avs_free(context->configuration.ciphersuites.ids);
+    context->configuration.ciphersuites.ids = NULL;
+}
+
+static avs_error_t
+initialize_ssl_socket_with_context(ssl_socket_t *socket,
+                                   const avs_net_ssl_configuration_t *config) {
+    socket->tls_context = acquire_tls_context(config->tls_context);
+
+    const avs_net_ssl_configuration_t *context_config =
+            &socket->tls_context->configuration;
+    avs_net_ssl_configuration_t configuration = *config;
+    configuration.version = context_config->version;
+    configuration.security = context_config->security;
+    configuration.ciphersuites = context_config->ciphersuites;
+    configuration.additional_configuration_clb =
+            context_config->additional_configuration_clb;
+    configuration.use_connection_id = context_config->use_connection_id;
+    configuration.prng_ctx = context_config->prng_ctx;
+    configuration.server_session_cache = context_config->server_session_cache;
+
+    socket->security_mode = configuration.security.mode;
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+    socket->cert_security = socket->tls_context->certs;
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+    return configure_ssl(socket, &configuration);
+}
+
 static avs_error_t
 initialize_ssl_socket(ssl_socket_t *socket,
                       avs_net_socket_type_t backend_type,
@@ -1669,6 +2220,10 @@ initialize_ssl_socket(ssl_socket_t *socket,
     socket->backend_type = backend_type;
     socket->backend_configuration = configuration->backend_configuration;
 
+    if (configuration->tls_context) {
+        return initialize_ssl_socket_with_context(socket, configuration);
+    }
+
     socket->security_mode = configuration->security.mode;
     switch (configuration->security.mode) {
     case AVS_NET_SECURITY_PSK:
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#ifdef AVS_UNIT_TESTING
+#    define _GNU_SOURCE // for popen() and mkstemp() in tests
+#endif                  // AVS_UNIT_TESTING
+
 // NOTE: OpenSSL headers sometimes (depending on a version) contain some of the
 // symbols poisoned via inclusion of avs_commons_init.h. Therefore they must
 // be included before poison.
@@ -41,6 +45,7 @@
 
 #    include <avsystem/commons/avs_errno_map.h>
 #    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
 #    include <avsystem/commons/avs_stream_membuf.h>
 #    include <avsystem/commons/avs_time.h>
 
@@ -80,6 +85,25 @@ VISIBILITY_SOURCE_BEGIN
 #        define WITH_DANE_SUPPORT
 #    endif
 
+#    if defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) \
+            && OPENSSL_VERSION_NUMBER_GE(1, 1, 0)
+#        define WITH_SERVER_SESSION_CACHE
+#        include "../avs_tls_server_session_cache.h"
+#        if OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+#            include <openssl/core_names.h>
+#        endif
+#    endif
+
+#    ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+#        include "../avs_dtls_listener.h"
+// DTLSv1_listen() is required to continue a handshake after a cookie exchange
+// performed by the listener
+#        if defined(AVS_COMMONS_NET_WITH_DTLS) \
+                && OPENSSL_VERSION_NUMBER_GE(1, 1, 0)
+#            define WITH_DTLS_LISTENER
+#        endif
+#    endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+
 typedef enum {
     SSL_VERIFY_DISABLED = 0,
     SSL_VERIFY_TRUSTSTORE,
@@ -87,11 +111,33 @@ typedef enum {
     SSL_VERIFY_DANE_OPPORTUNISTIC
 } ssl_verify_mode_t;
 
+struct avs_net_tls_context_struct {
+    avs_mutex_t *mutex;
+    size_t refcount;
+    avs_net_socket_type_t socket_type;
+
+    SSL_CTX *ctx;
+    ssl_verify_mode_t verify_mode;
+
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_crypto_psk_key_info_t *psk_key;
+    avs_crypto_psk_identity_info_t *psk_identity;
+#    endif
+
+    /// Set of ciphersuites configured by user
+    avs_net_socket_tls_ciphersuites_t enabled_ciphersuites;
+
+#    ifdef WITH_SERVER_SESSION_CACHE
+    /// Not owned; NULL if server-side session resumption is not configured
+    avs_net_tls_server_session_cache_t *server_session_cache;
+#    endif // WITH_SERVER_SESSION_CACHE
+};
+
 typedef struct {
     const avs_net_socket_v_table_t *const operations;
-    SSL_CTX *ctx;
+    /// Either a private context, or a reference to a shared one
+    avs_net_tls_context_t *context;
     SSL *ssl;
-    ssl_verify_mode_t verify_mode;
     avs_error_t bio_error;
     avs_time_real_t next_deadline;
     avs_net_socket_type_t backend_type;
@@ -103,18 +149,11 @@ typedef struct {
     avs_net_socket_configuration_t backend_configuration;
     avs_net_resolved_endpoint_t endpoint_buffer;
 
-#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-    avs_crypto_psk_key_info_t *psk_key;
-    avs_crypto_psk_identity_info_t *psk_identity;
-#    endif
-
 #    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
     void *session_resumption_buffer;
     size_t session_resumption_buffer_size;
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
-    /// Set of ciphersuites configured by user
-    avs_net_socket_tls_ciphersuites_t enabled_ciphersuites;
     /// Non empty, when custom server hostname shall be used.
     char server_name_indication[256];
 
@@ -443,6 +482,9 @@ static long avs_bio_ctrl(BIO *bio, int command, long intarg, void *ptrarg) {
             return 0;
         }
     case BIO_CTRL_DGRAM_GET_PEER:
+        if (!sock->backend_configuration.preferred_endpoint) {
+            return 0;
+        }
         memcpy(ptrarg, sock->backend_configuration.preferred_endpoint->data.buf,
                sock->backend_configuration.preferred_endpoint->size);
         return sock->backend_configuration.preferred_endpoint->size;
@@ -626,7 +668,31 @@ static avs_error_t ssl_handshake(ssl_socket_t *socket) {
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
         result = SSL_connect(socket->ssl);
     } else if (state_opt.state == AVS_NET_SOCKET_STATE_ACCEPTED) {
-        result = SSL_accept(socket->ssl);
+#    ifdef WITH_SERVER_SESSION_CACHE
+        // NOTE: Not set on the SSL_CTX, as it would also prevent connected
+        // sockets sharing the context from using tickets issued by servers.
+        if (socket->context->server_session_cache
+                && !_avs_net_tls_server_session_cache_tickets_enabled(
+                           socket->context->server_session_cache)) {
+            SSL_set_options(socket->ssl, SSL_OP_NO_TICKET);
+        }
+#    endif // WITH_SERVER_SESSION_CACHE
+        result = 1;
+#    ifdef WITH_DTLS_LISTENER
+        if (_avs_net_dtls_listener_is_peer(socket->backend_socket, NULL,
+                                           NULL)) {
+            // The listener has already verified the cookie. DTLSv1_listen()
+            // consumes the ClientHello that contains it and sets up the
+            // handshake state as if the exchange was performed by OpenSSL.
+            BIO_ADDR *client_addr = BIO_ADDR_new();
+            result = client_addr ? DTLSv1_listen(socket->ssl, client_addr)
+                                 : -1;
+            BIO_ADDR_free(client_addr);
+        }
+#    endif // WITH_DTLS_LISTENER
+        if (result > 0) {
+            result = SSL_accept(socket->ssl);
+        }
     } else {
         LOG(ERROR, _("ssl_handshake: invalid socket state"));
         return avs_errno(AVS_EBADF);
@@ -772,7 +838,7 @@ ids_to_ciphersuite_lists(ssl_socket_t *socket,
         } else
 #    endif // OPENSSL_VERSION_NUMBER_GE(1, 1, 1)
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-                if (socket->psk_key) {
+                if (socket->context->psk_key) {
             if (!strstr(name, "PSK")) {
                 LOG(DEBUG, _("ignoring non-PSK cipher ID: 0x") "%04x",
                     suites->ids[i]);
@@ -825,9 +891,198 @@ finish:
     return err;
 }
 
+#    ifdef WITH_SERVER_SESSION_CACHE
+static int server_new_session_cb(SSL *ssl, SSL_SESSION *sess) {
+    ssl_socket_t *socket = (ssl_socket_t *) SSL_get_app_data(ssl);
+    int serialized_size = i2d_SSL_SESSION(sess, NULL);
+    if (serialized_size <= 0) {
+        return 0;
+    }
+    unsigned char *buf = (unsigned char *) avs_malloc((size_t) serialized_size);
+    if (!buf) {
+        LOG_OOM();
+        return 0;
+    }
+    unsigned int id_size;
+    const unsigned char *id = SSL_SESSION_get_id(sess, &id_size);
+    if (i2d_SSL_SESSION(sess, &(unsigned char *) { buf }) == serialized_size
+            && avs_is_err(_avs_net_tls_server_session_cache_store(
+                       socket->context->server_session_cache, id, id_size,
+                       buf, (size_t) serialized_size))) {
+        LOG(WARNING, _("Could not store session in the server session cache"));
+    }
+    avs_free(buf);
+    // We do not keep the reference to sess
+    return 0;
+}
+
+static SSL_SESSION *server_get_session_cb(SSL *ssl,
+                                          const unsigned char *id,
+                                          int id_size,
+                                          int *copy) {
+    ssl_socket_t *socket = (ssl_socket_t *) SSL_get_app_data(ssl);
+    void *data = NULL;
+    size_t data_size = 0;
+    *copy = 0;
+    if (id_size <= 0
+            || avs_is_err(_avs_net_tls_server_session_cache_retrieve(
+                       socket->context->server_session_cache, id,
+                       (size_t) id_size, &data, &data_size))) {
+        return NULL;
+    }
+    const unsigned char *ptr = (const unsigned char *) data;
+    SSL_SESSION *session =
+            d2i_SSL_SESSION(NULL, &ptr, (long) AVS_MIN(data_size, LONG_MAX));
+    avs_free(data);
+    return session;
+}
+
+static void server_remove_session_cb(SSL_CTX *ctx, SSL_SESSION *sess) {
+    avs_net_tls_context_t *context =
+            (avs_net_tls_context_t *) SSL_CTX_get_app_data(ctx);
+    unsigned int id_size;
+    const unsigned char *id = SSL_SESSION_get_id(sess, &id_size);
+    _avs_net_tls_server_session_cache_remove(context->server_session_cache,
+                                             id, id_size);
+}
+
+#        if OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+typedef EVP_MAC_CTX ticket_mac_ctx_t;
+#        else  // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+typedef HMAC_CTX ticket_mac_ctx_t;
+#        endif // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+
+static int init_ticket_mac(ticket_mac_ctx_t *mac_ctx,
+                           const avs_net_tls_ticket_key_t *key) {
+#        if OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY,
+                                          (void *) (intptr_t) key->hmac_key,
+                                          sizeof(key->hmac_key)),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                                         (char *) (intptr_t) "SHA256", 0),
+        OSSL_PARAM_construct_end()
+    };
+    return EVP_MAC_CTX_set_params(mac_ctx, params) ? 0 : -1;
+#        else  // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+    return HMAC_Init_ex(mac_ctx, key->hmac_key, sizeof(key->hmac_key),
+                        EVP_sha256(), NULL)
+                   ? 0
+                   : -1;
+#        endif // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+}
+
+/**
+ * Implements RFC 5077 ticket protection using keys shared through the server
+ * session cache: AES-256-CBC encryption and HMAC-SHA256 authentication, i.e.
+ * the same scheme that OpenSSL uses by default. OpenSSL always passes a 16-byte
+ * key_name buffer, matching AVS_NET_TLS_TICKET_KEY_NAME_SIZE.
+ *
+ * @returns -1 on error, 0 if the ticket key is unknown (full handshake will be
+ *          performed), 1 on success, 2 if the ticket was decrypted using the
+ *          previous key and shall be renewed.
+ */
+static int ticket_key_cb(SSL *ssl,
+                         unsigned char *key_name,
+                         unsigned char *iv,
+                         EVP_CIPHER_CTX *cipher_ctx,
+                         ticket_mac_ctx_t *mac_ctx,
+                         int enc) {
+    ssl_socket_t *socket = (ssl_socket_t *) SSL_get_app_data(ssl);
+    avs_net_tls_ticket_key_t keys[AVS_NET_TLS_TICKET_KEYS_MAX];
+    size_t key_count = 0;
+    if (avs_is_err(_avs_net_tls_server_session_cache_ticket_keys(
+                socket->context->server_session_cache, keys, &key_count))
+            || !key_count) {
+        return -1;
+    }
+
+    int result = -1;
+    if (enc) {
+        memcpy(key_name, keys[0].name, AVS_NET_TLS_TICKET_KEY_NAME_SIZE);
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) == 1
+                && EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL,
+                                      keys[0].cipher_key, iv)
+                && !init_ticket_mac(mac_ctx, &keys[0])) {
+            result = 1;
+        }
+    } else {
+        result = 0;
+        for (size_t i = 0; i < key_count; ++i) {
+            if (!memcmp(key_name, keys[i].name,
+                        AVS_NET_TLS_TICKET_KEY_NAME_SIZE)) {
+                if (init_ticket_mac(mac_ctx, &keys[i])
+                        || !EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(),
+                                               NULL, keys[i].cipher_key, iv)) {
+                    result = -1;
+                } else {
+                    result = (i == 0 ? 1 : 2);
+                }
+                break;
+            }
+        }
+    }
+    OPENSSL_cleanse(keys, sizeof(keys));
+    return result;
+}
+
+static avs_error_t
+configure_server_session_cache(avs_net_tls_context_t *context,
+                               avs_net_tls_server_session_cache_t *cache) {
+    // NOTE: The cache is consulted only by the server side of the connection,
+    // so the client-side settings from enable_session_cache() are retained.
+    static const unsigned char SESSION_ID_CONTEXT[] = "avs_commons";
+    if (!SSL_CTX_set_session_id_context(context->ctx, SESSION_ID_CONTEXT,
+                                        sizeof(SESSION_ID_CONTEXT) - 1)) {
+        log_openssl_error();
+        return avs_errno(AVS_ENOMEM);
+    }
+    context->server_session_cache = cache;
+    SSL_CTX_set_app_data(context->ctx, context);
+
+    int64_t lifetime_s;
+    if (!avs_time_duration_to_scalar(
+                &lifetime_s, AVS_TIME_S,
+                _avs_net_tls_server_session_cache_lifetime(cache))
+            && lifetime_s > 0) {
+        SSL_CTX_set_timeout(context->ctx, (long) AVS_MIN(lifetime_s, LONG_MAX));
+    }
+
+    long cache_mode = SSL_CTX_get_session_cache_mode(context->ctx)
+                      & ~(long) SSL_SESS_CACHE_SERVER;
+    if (_avs_net_tls_server_session_cache_stateful(cache)) {
+        cache_mode |= SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL;
+#        ifndef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+        // Otherwise new_session_cb() dispatches to server_new_session_cb()
+        SSL_CTX_sess_set_new_cb(context->ctx, server_new_session_cb);
+#        endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+        SSL_CTX_sess_set_get_cb(context->ctx, server_get_session_cb);
+        SSL_CTX_sess_set_remove_cb(context->ctx, server_remove_session_cb);
+    }
+    SSL_CTX_set_session_cache_mode(context->ctx, cache_mode);
+
+    if (_avs_net_tls_server_session_cache_tickets_enabled(cache)) {
+#        if OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(context->ctx, ticket_key_cb);
+#        else  // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+        SSL_CTX_set_tlsext_ticket_key_cb(context->ctx, ticket_key_cb);
+#        endif // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+    }
+    return AVS_OK;
+}
+#    endif // WITH_SERVER_SESSION_CACHE
+
 #    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 static int new_session_cb(SSL *ssl, SSL_SESSION *sess) {
+#        ifdef WITH_SERVER_SESSION_CACHE
+    if (SSL_is_server(ssl)) {
+        return server_new_session_cb(ssl, sess);
+    }
+#        endif // WITH_SERVER_SESSION_CACHE
     ssl_socket_t *socket = (ssl_socket_t *) SSL_get_app_data(ssl);
+    if (!socket->session_resumption_buffer_size) {
+        return 0;
+    }
 
     int result = 0;
     int serialized_size = i2d_SSL_SESSION(sess, NULL);
@@ -848,19 +1103,16 @@ static int new_session_cb(SSL *ssl, SSL_SESSION *sess) {
     return 0;
 }
 
-static void enable_session_cache(ssl_socket_t *socket) {
-    avs_net_socket_opt_value_t state_opt;
-    if (avs_is_ok(avs_net_socket_get_opt((avs_net_socket_t *) socket,
-                                         AVS_NET_SOCKET_OPT_STATE, &state_opt))
-            && state_opt.state == AVS_NET_SOCKET_STATE_CONNECTED) {
-        SSL_CTX_set_session_cache_mode(
-                socket->ctx,
-                SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
-        SSL_CTX_sess_set_new_cb(socket->ctx, new_session_cb);
-    } else {
-        SSL_CTX_set_session_cache_mode(socket->ctx, SSL_SESS_CACHE_OFF);
-        SSL_CTX_sess_set_new_cb(socket->ctx, NULL);
-    }
+static void enable_session_cache(avs_net_tls_context_t *context) {
+    // NOTE: The SSL_CTX may be shared between multiple sockets, so it is
+    // configured once for all of them. Client-side caching only affects
+    // connected sockets - accepted ones only use the server session cache,
+    // if configured - and new_session_cb() ignores sockets without a session
+    // resumption buffer.
+    SSL_CTX_set_session_cache_mode(context->ctx,
+                                   SSL_SESS_CACHE_CLIENT
+                                           | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(context->ctx, new_session_cb);
 }
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
@@ -893,10 +1145,11 @@ static unsigned int dtls_timer_cb(SSL *ssl, unsigned int timer_us) {
 
 static avs_error_t fix_socket_ciphersuites(ssl_socket_t *socket) {
     avs_error_t err = AVS_OK;
-    if (socket->enabled_ciphersuites.num_ids > 0) {
+    if (socket->context->enabled_ciphersuites.num_ids > 0) {
         char *legacy_ciphersuites_string = NULL;
         char *session_ciphersuites_string = NULL;
-        err = ids_to_ciphersuite_lists(socket, &socket->enabled_ciphersuites,
+        err = ids_to_ciphersuite_lists(socket,
+                                       &socket->context->enabled_ciphersuites,
                                        &legacy_ciphersuites_string,
                                        &session_ciphersuites_string);
         if (avs_is_err(err)) {
@@ -911,7 +1164,7 @@ static avs_error_t fix_socket_ciphersuites(ssl_socket_t *socket) {
         avs_free(session_ciphersuites_string);
     }
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-    else if (socket->psk_key) {
+    else if (socket->context->psk_key) {
         err = configure_ciphersuite_lists(socket, "PSK",
                                           TLS_DEFAULT_CIPHERSUITES);
     }
@@ -928,11 +1181,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
     BIO *bio = NULL;
     LOG(TRACE, _("start_ssl(socket=") "%p" _(")"), (void *) socket);
 
-#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-    enable_session_cache(socket);
-#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-
-    socket->ssl = SSL_new(socket->ctx);
+    socket->ssl = SSL_new(socket->context->ctx);
     if (!socket->ssl) {
         return avs_errno(AVS_ENOMEM);
     }
@@ -951,12 +1200,12 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
         host = socket->server_name_indication;
     }
 
-    bool verification = (socket->verify_mode != SSL_VERIFY_DISABLED);
+    bool verification = (socket->context->verify_mode != SSL_VERIFY_DISABLED);
 
     int result = 0;
 #    ifdef WITH_DANE_SUPPORT
-    if (socket->verify_mode == SSL_VERIFY_DANE_ENFORCED
-            || socket->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
+    if (socket->context->verify_mode == SSL_VERIFY_DANE_ENFORCED
+            || socket->context->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
         // NOTE: SSL_dane_enable() calls SSL_set_tlsext_host_name() internally
         if (SSL_dane_enable(socket->ssl, host) <= 0) {
             LOG(ERROR, _("cannot setup DANE extension"));
@@ -967,7 +1216,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
         for (size_t i = 0;
              i < socket->dane_tlsa_array_field.array_element_count;
              ++i) {
-            if (socket->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC
+            if (socket->context->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC
                     && (socket->dane_tlsa_array_field.array_ptr[i]
                                         .certificate_usage
                                 == AVS_NET_SOCKET_DANE_CA_CONSTRAINT
@@ -999,7 +1248,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
             }
         }
 
-        if (socket->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
+        if (socket->context->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
             if (have_usable_tlsa_records) {
                 SSL_set_verify(socket->ssl, SSL_VERIFY_PEER, NULL);
             } else {
@@ -1219,13 +1468,13 @@ static avs_error_t rebuild_client_cert_chain(SSL_CTX *ctx, X509 *first_cert) {
 }
 
 static avs_error_t
-configure_ssl_certs(ssl_socket_t *socket,
+configure_ssl_certs(avs_net_tls_context_t *context,
                     const avs_net_certificate_info_t *cert_info) {
     LOG(TRACE, _("configure_ssl_certs"));
 
     if (cert_info->dane) {
 #        ifdef WITH_DANE_SUPPORT
-        if (SSL_CTX_dane_enable(socket->ctx) <= 0) {
+        if (SSL_CTX_dane_enable(context->ctx) <= 0) {
             LOG(ERROR, _("could not enable DANE"));
             log_openssl_error();
             return avs_errno(AVS_EPROTO);
@@ -1239,11 +1488,11 @@ configure_ssl_certs(ssl_socket_t *socket,
     if (cert_info->server_cert_validation
             || cert_info->rebuild_client_cert_chain) {
         if (!cert_info->ignore_system_trust_store
-                && !SSL_CTX_set_default_verify_paths(socket->ctx)) {
+                && !SSL_CTX_set_default_verify_paths(context->ctx)) {
             LOG(WARNING, _("could not set default CA verify paths"));
             log_openssl_error();
         }
-        X509_STORE *store = SSL_CTX_get_cert_store(socket->ctx);
+        X509_STORE *store = SSL_CTX_get_cert_store(context->ctx);
         avs_error_t err;
         if (avs_is_err((err = _avs_crypto_openssl_load_ca_certs(
                                 store, &cert_info->trusted_certs)))) {
@@ -1259,21 +1508,21 @@ configure_ssl_certs(ssl_socket_t *socket,
 
     if (cert_info->server_cert_validation) {
         if (cert_info->dane) {
-            socket->verify_mode = SSL_VERIFY_DANE_ENFORCED;
+            context->verify_mode = SSL_VERIFY_DANE_ENFORCED;
         } else {
-            socket->verify_mode = SSL_VERIFY_TRUSTSTORE;
+            context->verify_mode = SSL_VERIFY_TRUSTSTORE;
         }
     } else {
         if (cert_info->dane) {
-            socket->verify_mode = SSL_VERIFY_DANE_OPPORTUNISTIC;
+            context->verify_mode = SSL_VERIFY_DANE_OPPORTUNISTIC;
         }
         LOG(DEBUG, _("Server authentication disabled"));
-        SSL_CTX_set_verify(socket->ctx, SSL_VERIFY_NONE, NULL);
+        SSL_CTX_set_verify(context->ctx, SSL_VERIFY_NONE, NULL);
     }
 
     if (cert_info->client_cert.desc.source != AVS_CRYPTO_DATA_SOURCE_EMPTY) {
         load_cert_ctx_t load_cert_ctx = {
-            .ctx = socket->ctx
+            .ctx = context->ctx
         };
         avs_error_t err = _avs_crypto_openssl_load_client_certs(
                 &cert_info->client_cert, load_cert, &load_cert_ctx);
@@ -1284,7 +1533,7 @@ configure_ssl_certs(ssl_socket_t *socket,
             if (avs_is_ok((err = _avs_crypto_openssl_load_private_key(
                                    &key, &cert_info->client_key)))) {
                 assert(key);
-                if (SSL_CTX_use_PrivateKey(socket->ctx, key) != 1) {
+                if (SSL_CTX_use_PrivateKey(context->ctx, key) != 1) {
                     log_openssl_error();
                     err = avs_errno(AVS_EPROTO);
                 }
@@ -1296,7 +1545,7 @@ configure_ssl_certs(ssl_socket_t *socket,
                        && cert_info->rebuild_client_cert_chain
                        && avs_is_err(
                                   (err = rebuild_client_cert_chain(
-                                           socket->ctx,
+                                           context->ctx,
                                            load_cert_ctx.first_cert_loaded)))) {
                 LOG(ERROR, _("could not rebuild client certificate chain"));
             }
@@ -1310,9 +1559,9 @@ configure_ssl_certs(ssl_socket_t *socket,
 }
 #    else
 static avs_error_t
-configure_ssl_certs(ssl_socket_t *socket,
+configure_ssl_certs(avs_net_tls_context_t *context,
                     const avs_net_certificate_info_t *cert_info) {
-    (void) socket;
+    (void) context;
     (void) cert_info;
     LOG(ERROR, _("X.509 support disabled"));
     return avs_errno(AVS_ENOTSUP);
@@ -1330,44 +1579,48 @@ static unsigned int psk_client_cb(SSL *ssl,
 
     (void) hint;
 
-    if (!socket || !socket->psk_key
-            || socket->psk_key->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER
-            || max_psk_len < socket->psk_key->desc.info.buffer.buffer_size
-            || !socket->psk_identity
-            || socket->psk_identity->desc.source
+    if (!socket) {
+        return 0;
+    }
+    const avs_net_tls_context_t *context = socket->context;
+    if (!context->psk_key
+            || context->psk_key->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER
+            || max_psk_len < context->psk_key->desc.info.buffer.buffer_size
+            || !context->psk_identity
+            || context->psk_identity->desc.source
                            != AVS_CRYPTO_DATA_SOURCE_BUFFER
             || max_identity_len
-                           < socket->psk_identity->desc.info.buffer.buffer_size
+                           < context->psk_identity->desc.info.buffer.buffer_size
                                          + 1) {
         return 0;
     }
 
-    memcpy(psk, socket->psk_key->desc.info.buffer.buffer,
-           socket->psk_key->desc.info.buffer.buffer_size);
-    memcpy(identity, socket->psk_identity->desc.info.buffer.buffer,
-           socket->psk_identity->desc.info.buffer.buffer_size);
-    identity[socket->psk_identity->desc.info.buffer.buffer_size] = '\0';
+    memcpy(psk, context->psk_key->desc.info.buffer.buffer,
+           context->psk_key->desc.info.buffer.buffer_size);
+    memcpy(identity, context->psk_identity->desc.info.buffer.buffer,
+           context->psk_identity->desc.info.buffer.buffer_size);
+    identity[context->psk_identity->desc.info.buffer.buffer_size] = '\0';
 
-    return (unsigned int) socket->psk_key->desc.info.buffer.buffer_size;
+    return (unsigned int) context->psk_key->desc.info.buffer.buffer_size;
 }
 
-static avs_error_t configure_ssl_psk(ssl_socket_t *socket,
+static avs_error_t configure_ssl_psk(avs_net_tls_context_t *context,
                                      const avs_net_psk_info_t *psk) {
     LOG(TRACE, _("configure_ssl_psk"));
 
     avs_error_t err;
-    if (avs_is_ok((
-                err = avs_crypto_psk_key_info_copy(&socket->psk_key, psk->key)))
+    if (avs_is_ok((err = avs_crypto_psk_key_info_copy(&context->psk_key,
+                                                      psk->key)))
             && avs_is_ok((err = avs_crypto_psk_identity_info_copy(
-                                  &socket->psk_identity, psk->identity)))) {
-        SSL_CTX_set_psk_client_callback(socket->ctx, psk_client_cb);
+                                  &context->psk_identity, psk->identity)))) {
+        SSL_CTX_set_psk_client_callback(context->ctx, psk_client_cb);
     }
     return err;
 }
 #    else
-static avs_error_t configure_ssl_psk(ssl_socket_t *socket,
+static avs_error_t configure_ssl_psk(avs_net_tls_context_t *context,
                                      const avs_net_psk_info_t *psk) {
-    (void) socket;
+    (void) context;
     (void) psk;
     LOG(ERROR, _("PSK not supported in this version of OpenSSL"));
     return avs_errno(AVS_ENOTSUP);
@@ -1408,37 +1661,12 @@ configure_ssl(ssl_socket_t *socket,
         _("configure_ssl(socket=") "%p" _(", configuration=") "%p" _(")"),
         (void *) socket, (const void *) configuration);
 
-    if (!configuration) {
-        LOG(WARNING, _("configuration not provided"));
-        return AVS_OK;
-    }
-
     socket->backend_configuration = configuration->backend_configuration;
     if (!socket->backend_configuration.preferred_endpoint) {
         socket->backend_configuration.preferred_endpoint =
                 &socket->endpoint_buffer;
     }
 
-    ERR_clear_error();
-    SSL_CTX_set_options(socket->ctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
-    SSL_CTX_set_verify(socket->ctx, SSL_VERIFY_PEER, NULL);
-
-    avs_error_t err;
-    switch (configuration->security.mode) {
-    case AVS_NET_SECURITY_PSK:
-        err = configure_ssl_psk(socket, &configuration->security.data.psk);
-        break;
-    case AVS_NET_SECURITY_CERTIFICATE:
-        err = configure_ssl_certs(socket, &configuration->security.data.cert);
-        break;
-    default:
-        AVS_UNREACHABLE("invalid enum value");
-        err = avs_errno(AVS_EBADF);
-    }
-    if (avs_is_err(err)) {
-        return err;
-    }
-
     if (socket_set_dtls_handshake_timeouts(
                 socket, configuration->dtls_handshake_timeouts)) {
         LOG(ERROR, _("Invalid DTLS handshake timeouts passed"));
@@ -1466,27 +1694,6 @@ configure_ssl(ssl_socket_t *socket,
         memcpy(socket->server_name_indication,
                configuration->server_name_indication, len + 1);
     }
-
-    if (configuration->ciphersuites.num_ids > 0) {
-        if (!(socket->enabled_ciphersuites.ids = (uint32_t *) avs_malloc(
-                      configuration->ciphersuites.num_ids
-                      * sizeof(*configuration->ciphersuites.ids)))) {
-            LOG_OOM();
-            return avs_errno(AVS_ENOMEM);
-        }
-        socket->enabled_ciphersuites.num_ids =
-                configuration->ciphersuites.num_ids;
-        memcpy(socket->enabled_ciphersuites.ids,
-               configuration->ciphersuites.ids,
-               configuration->ciphersuites.num_ids
-                       * sizeof(*configuration->ciphersuites.ids));
-    }
-
-    if (configuration->additional_configuration_clb
-            && configuration->additional_configuration_clb(socket->ctx)) {
-        LOG(ERROR, _("Error while setting additional SSL configuration"));
-        return avs_errno(AVS_EPIPE);
-    }
     return AVS_OK;
 }
 
@@ -1568,20 +1775,9 @@ static avs_error_t cleanup_ssl(avs_net_socket_t **socket_) {
     ssl_socket_t **socket = (ssl_socket_t **) socket_;
     LOG(TRACE, _("cleanup_ssl(*socket=") "%p" _(")"), (void *) *socket);
 
-#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-    avs_free((*socket)->psk_key);
-    (*socket)->psk_key = NULL;
-    avs_free((*socket)->psk_identity);
-    (*socket)->psk_identity = NULL;
-#    endif
-
     avs_error_t err = close_ssl(*socket_);
     add_err(&err, avs_net_socket_cleanup(&(*socket)->backend_socket));
-    if ((*socket)->ctx) {
-        SSL_CTX_free((*socket)->ctx);
-        (*socket)->ctx = NULL;
-    }
-    avs_free((*socket)->enabled_ciphersuites.ids);
+    release_tls_context(&(*socket)->context);
 #    ifdef WITH_DANE_SUPPORT
     avs_free((void *) (intptr_t) (const void *) (*socket)
                      ->dane_tlsa_array_field.array_ptr);
@@ -1768,6 +1964,139 @@ make_ssl_context(SSL_CTX **out_ctx, bool dtls, avs_net_ssl_version_t version) {
 }
 #    endif
 
+#    ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+avs_error_t _avs_net_hmac_sha256(const void *key,
+                                 size_t key_size,
+                                 const void *data,
+                                 size_t data_size,
+                                 unsigned char out[AVS_NET_HMAC_SHA256_SIZE]) {
+#        ifdef WITH_DTLS_LISTENER
+    unsigned int out_size = AVS_NET_HMAC_SHA256_SIZE;
+    if (key_size > INT_MAX
+            || !HMAC(EVP_sha256(), key, (int) key_size,
+                     (const unsigned char *) data, data_size, out, &out_size)
+            || out_size != AVS_NET_HMAC_SHA256_SIZE) {
+        log_openssl_error();
+        return avs_errno(AVS_EPROTO);
+    }
+    return AVS_OK;
+#        else  // WITH_DTLS_LISTENER
+    (void) key;
+    (void) key_size;
+    (void) data;
+    (void) data_size;
+    (void) out;
+    LOG(ERROR, _("DTLS listeners require DTLS support and OpenSSL >= 1.1.0"));
+    return avs_errno(AVS_ENOTSUP);
+#        endif // WITH_DTLS_LISTENER
+}
+#    endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+
+#    ifdef WITH_DTLS_LISTENER
+static int verify_listener_cookie_cb(SSL *ssl,
+                                     const unsigned char *cookie,
+                                     unsigned int cookie_len) {
+    (void) cookie;
+    (void) cookie_len;
+    ssl_socket_t *socket = (ssl_socket_t *) SSL_get_app_data(ssl);
+    // cookies are only ever verified by DTLSv1_listen(), called for sockets
+    // accepted by a listener, which has already checked the cookie
+    return socket
+           && _avs_net_dtls_listener_is_peer(socket->backend_socket, NULL,
+                                             NULL);
+}
+#    endif // WITH_DTLS_LISTENER
+
+static avs_error_t
+initialize_tls_context(avs_net_tls_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration) {
+    avs_error_t err = make_ssl_context(
+            &context->ctx, context->socket_type == AVS_NET_DTLS_SOCKET,
+            configuration->version);
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    ERR_clear_error();
+    SSL_CTX_set_options(context->ctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
+    SSL_CTX_set_verify(context->ctx, SSL_VERIFY_PEER, NULL);
+#    ifdef WITH_DTLS_LISTENER
+    if (context->socket_type == AVS_NET_DTLS_SOCKET) {
+        SSL_CTX_set_cookie_verify_cb(context->ctx, verify_listener_cookie_cb);
+    }
+#    endif // WITH_DTLS_LISTENER
+
+    switch (configuration->security.mode) {
+    case AVS_NET_SECURITY_PSK:
+        err = configure_ssl_psk(context, &configuration->security.data.psk);
+        break;
+    case AVS_NET_SECURITY_CERTIFICATE:
+        err = configure_ssl_certs(context, &configuration->security.data.cert);
+        break;
+    default:
+        AVS_UNREACHABLE("invalid enum value");
+        err = avs_errno(AVS_EBADF);
+    }
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+    enable_session_cache(context);
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+
+    if (configuration->server_session_cache) {
+#    ifdef WITH_SERVER_SESSION_CACHE
+        if (avs_is_err((err = configure_server_session_cache(
+                                context,
+                                configuration->server_session_cache)))) {
+            return err;
+        }
+#    else  // WITH_SERVER_SESSION_CACHE
+        LOG(ERROR, _("Server session cache is not supported"));
+        return avs_errno(AVS_ENOTSUP);
+#    endif // WITH_SERVER_SESSION_CACHE
+    }
+
+    if (configuration->ciphersuites.num_ids > 0) {
+        if (!(context->enabled_ciphersuites.ids = (uint32_t *) avs_malloc(
+                      configuration->ciphersuites.num_ids
+                      * sizeof(*configuration->ciphersuites.ids)))) {
+            LOG_OOM();
+            return avs_errno(AVS_ENOMEM);
+        }
+        context->enabled_ciphersuites.num_ids =
+                configuration->ciphersuites.num_ids;
+        memcpy(context->enabled_ciphersuites.ids,
+               configuration->ciphersuites.ids,
+               configuration->ciphersuites.num_ids
+                       * sizeof(*configuration->ciphersuites.ids));
+    }
+
+    if (configuration->additional_configuration_clb
+            && configuration->additional_configuration_clb(context->ctx)) {
+        LOG(ERROR, _("Error while setting additional SSL configuration"));
+        return avs_errno(AVS_EPIPE);
+    }
+    return AVS_OK;
+}
+
+static void cleanup_tls_context(avs_net_tls_context_t *context) {
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_free(context->psk_key);
+    context->psk_key = NULL;
+    avs_free(context->psk_identity);
+    context->psk_identity = NULL;
+#    endif
+
+    if (context->ctx) {
+        SSL_CTX_free(context->ctx);
+        context->ctx = NULL;
+    }
+    avs_free(context->enabled_ciphersuites.ids);
+    context->enabled_ciphersuites.ids = NULL;
+}
+
 static avs_error_t
 initialize_ssl_socket(ssl_socket_t *socket,
                       avs_net_socket_type_t backend_type,
@@ -1776,14 +2105,16 @@ initialize_ssl_socket(ssl_socket_t *socket,
             &ssl_vtable;
     socket->backend_type = backend_type;
 
-    avs_error_t err = make_ssl_context(&socket->ctx, socket_is_datagram(socket),
-                                       configuration->version);
-    if (avs_is_ok(err)
-            && avs_is_err((err = configure_ssl(socket, configuration)))) {
-        SSL_CTX_free(socket->ctx);
-        socket->ctx = NULL;
+    avs_error_t err = AVS_OK;
+    if (configuration->tls_context) {
+        socket->context = acquire_tls_context(configuration->tls_context);
+    } else {
+        err = create_tls_context(&socket->context,
+                                 ssl_socket_type(backend_type), configuration);
+    }
+    if (avs_is_ok(err)) {
+        err = configure_ssl(socket, configuration);
     }
-
     return err;
 }
 
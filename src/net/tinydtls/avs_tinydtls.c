@@ -24,6 +24,7 @@
 
 #    include <avsystem/commons/avs_errno.h>
 #    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
 
 #    define uthash_malloc(Size) avs_malloc(Size)
 #    define uthash_free(Ptr, Size) avs_free(Ptr)
@@ -34,6 +35,10 @@
 
 #    include "../avs_net_impl.h"
 
+#    ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+#        include "../avs_dtls_listener.h"
+#    endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+
 VISIBILITY_SOURCE_BEGIN
 
 typedef struct {
@@ -42,6 +47,16 @@ typedef struct {
     size_t *out_bytes_read;
 } ssl_read_context_t;
 
+struct avs_net_tls_context_struct {
+    avs_mutex_t *mutex;
+    size_t refcount;
+    avs_net_socket_type_t socket_type;
+
+    avs_ssl_additional_configuration_clb_t *additional_configuration_clb;
+    avs_crypto_psk_key_info_t *psk_key;
+    avs_crypto_psk_identity_info_t *psk_identity;
+};
+
 typedef struct {
     const avs_net_socket_v_table_t *const operations;
     dtls_context_t *ctx;
@@ -53,6 +68,8 @@ typedef struct {
 
     ssl_read_context_t *read_ctx;
 
+    /// Shared context, if used; psk_key and psk_identity are then borrowed
+    avs_net_tls_context_t *tls_context;
     avs_crypto_psk_key_info_t *psk_key;
     avs_crypto_psk_identity_info_t *psk_identity;
 } ssl_socket_t;
@@ -69,6 +86,22 @@ void _avs_net_cleanup_global_ssl_state(void) {
     // do nothing
 }
 
+#    ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+avs_error_t _avs_net_hmac_sha256(const void *key,
+                                 size_t key_size,
+                                 const void *data,
+                                 size_t data_size,
+                                 unsigned char out[AVS_NET_HMAC_SHA256_SIZE]) {
+    (void) key;
+    (void) key_size;
+    (void) data;
+    (void) data_size;
+    (void) out;
+    LOG(ERROR, _("DTLS listeners are not supported by the tinyDTLS backend"));
+    return avs_errno(AVS_ENOTSUP);
+}
+#    endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
+
 static avs_error_t get_dtls_overhead(ssl_socket_t *socket,
                                      int *out_header,
                                      int *out_padding_size) {
@@ -177,12 +210,16 @@ static avs_error_t cleanup_ssl(avs_net_socket_t **socket_) {
     ssl_socket_t *socket = *(ssl_socket_t **) socket_;
     LOG(TRACE, _("cleanup_ssl(*socket=") "%p" _(")"), (void *) socket);
 
+    if (socket->tls_context) {
+        release_tls_context(&socket->tls_context);
+    } else {
 #    ifdef DTLS_PSK
-    avs_free(socket->psk_key);
+        avs_free(socket->psk_key);
+        avs_free(socket->psk_identity);
+#    endif
+    }
     socket->psk_key = NULL;
-    avs_free(socket->psk_identity);
     socket->psk_identity = NULL;
-#    endif
     avs_error_t err = close_ssl(*socket_);
     add_err(&err, avs_net_socket_cleanup(&socket->backend_socket));
     avs_free(socket);
@@ -309,29 +346,71 @@ configure_ssl_certs(ssl_socket_t *socket,
     return avs_errno(AVS_ENOTSUP);
 }
 
+static avs_error_t
+initialize_tls_context(avs_net_tls_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration) {
+    if (configuration->security.mode != AVS_NET_SECURITY_PSK) {
+        LOG(ERROR, _("support for certificate mode is not yet implemented"));
+        return avs_errno(AVS_ENOTSUP);
+    }
+#    ifndef DTLS_PSK
+    LOG(ERROR, _("support for psk is disabled"));
+    return avs_errno(AVS_ENOTSUP);
+#    else
+    context->additional_configuration_clb =
+            configuration->additional_configuration_clb;
+
+    const avs_net_psk_info_t *psk = &configuration->security.data.psk;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_crypto_psk_key_info_copy(&context->psk_key,
+                                                           psk->key)))
+            || avs_is_err((err = avs_crypto_psk_identity_info_copy(
+                                   &context->psk_identity, psk->identity))));
+    return err;
+#    endif /* DTLS_PSK */
+}
+
+static void cleanup_tls_context(avs_net_tls_context_t *context) {
+    avs_free(context->psk_key);
+    context->psk_key = NULL;
+    avs_free(context->psk_identity);
+    context->psk_identity = NULL;
+}
+
 static avs_error_t
 configure_ssl(ssl_socket_t *socket,
               const avs_net_ssl_configuration_t *configuration) {
     socket->backend_configuration = configuration->backend_configuration;
 
-    avs_error_t err;
-    switch (configuration->security.mode) {
-    case AVS_NET_SECURITY_PSK:
-        err = configure_ssl_psk(socket, &configuration->security.data.psk);
-        break;
-    case AVS_NET_SECURITY_CERTIFICATE:
-        err = configure_ssl_certs(socket, &configuration->security.data.cert);
-        break;
-    default:
-        AVS_UNREACHABLE("invalid enum value");
-        err = avs_errno(AVS_EINVAL);
+    avs_ssl_additional_configuration_clb_t *additional_configuration_clb =
+            configuration->additional_configuration_clb;
+    avs_error_t err = AVS_OK;
+    if (configuration->tls_context) {
+        socket->tls_context = acquire_tls_context(configuration->tls_context);
+        socket->psk_key = socket->tls_context->psk_key;
+        socket->psk_identity = socket->tls_context->psk_identity;
+        additional_configuration_clb =
+                socket->tls_context->additional_configuration_clb;
+    } else {
+        switch (configuration->security.mode) {
+        case AVS_NET_SECURITY_PSK:
+            err = configure_ssl_psk(socket, &configuration->security.data.psk);
+            break;
+        case AVS_NET_SECURITY_CERTIFICATE:
+            err = configure_ssl_certs(socket,
+                                      &configuration->security.data.cert);
+            break;
+        default:
+            AVS_UNREACHABLE("invalid enum value");
+            err = avs_errno(AVS_EINVAL);
+        }
     }
     if (avs_is_err(err)) {
         return err;
     }
 
-    if (configuration->additional_configuration_clb
-            && configuration->additional_configuration_clb(socket->ctx)) {
+    if (additional_configuration_clb
+            && additional_configuration_clb(socket->ctx)) {
         LOG(ERROR, _("Error while setting additional SSL configuration"));
         return avs_errno(AVS_EPIPE);
     }
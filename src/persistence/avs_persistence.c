@@ -377,6 +377,28 @@ restore_list(avs_persistence_context_t *ctx,
 }
 
 #    ifdef AVS_COMMONS_WITH_AVS_RBTREE
+static avs_error_t append_restored_element(AVS_RBTREE_ELEM(void) **elems_ptr,
+                                           size_t *count_ptr,
+                                           size_t *capacity_ptr,
+                                           AVS_RBTREE_ELEM(void) element) {
+    if (*count_ptr == *capacity_ptr) {
+        size_t new_capacity = *capacity_ptr ? 2 * *capacity_ptr : 16;
+        if (new_capacity < *capacity_ptr
+                || new_capacity > SIZE_MAX / sizeof(**elems_ptr)) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        AVS_RBTREE_ELEM(void) *new_elems = (AVS_RBTREE_ELEM(void) *)
+                avs_realloc(*elems_ptr, new_capacity * sizeof(**elems_ptr));
+        if (!new_elems) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        *elems_ptr = new_elems;
+        *capacity_ptr = new_capacity;
+    }
+    (*elems_ptr)[(*count_ptr)++] = element;
+    return AVS_OK;
+}
+
 static avs_error_t
 restore_tree(avs_persistence_context_t *ctx,
              AVS_RBTREE(void) tree,
@@ -387,17 +409,43 @@ restore_tree(avs_persistence_context_t *ctx,
     assert(cleanup);
     uint32_t count;
     avs_error_t err = restore_u32(ctx, &count);
+    AVS_RBTREE_ELEM(void) *elems = NULL;
+    size_t elems_count = 0;
+    size_t elems_capacity = 0;
     while (avs_is_ok(err) && count--) {
         AVS_RBTREE_ELEM(void) element = NULL;
         if (avs_is_ok((err = handler(ctx, &element, handler_user_ptr)))
-                && element && AVS_RBTREE_INSERT(tree, element) != element) {
-            err = avs_errno(AVS_EBADMSG);
+                && element) {
+            err = append_restored_element(&elems, &elems_count,
+                                          &elems_capacity, element);
         }
         if (avs_is_err(err) && element) {
             cleanup(element);
             AVS_RBTREE_ELEM_DELETE_DETACHED(&element);
         }
     }
+    if (avs_is_ok(err)) {
+        // persist_tree() stores elements in order, so the tree can be built
+        // in linear time; otherwise, fall back to inserting them one by one
+        if (!AVS_RBTREE_BUILD_FROM_SORTED(tree, elems, elems_count)) {
+            elems_count = 0;
+        } else {
+            for (size_t i = 0; avs_is_ok(err) && i < elems_count; ++i) {
+                if (AVS_RBTREE_INSERT(tree, elems[i]) == elems[i]) {
+                    elems[i] = NULL;
+                } else {
+                    err = avs_errno(AVS_EBADMSG);
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < elems_count; ++i) {
+        if (elems[i]) {
+            cleanup(elems[i]);
+            AVS_RBTREE_ELEM_DELETE_DETACHED(&elems[i]);
+        }
+    }
+    avs_free(elems);
     if (avs_is_err(err)) {
         AVS_RBTREE_CLEAR(tree) {
             cleanup(*tree);
@@ -638,8 +686,16 @@ avs_error_t avs_persistence_custom_allocated_sorted_set(
     return avs_persistence_custom_allocated_tree(ctx, sorted_set, handler,
                                                  handler_user_ptr, cleanup);
 #        else  // AVS_COMMONS_WITH_AVS_RBTREE
-    return avs_persistence_custom_allocated_list(ctx, sorted_set, handler,
-                                                 handler_user_ptr, cleanup);
+    if (!ctx || !sorted_set) {
+        return avs_errno(AVS_EBADF);
+    }
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE
+            && *sorted_set) {
+        LOG(ERROR, "Cannot restore to a non-empty sorted set");
+        return avs_errno(AVS_EINVAL);
+    }
+    return ctx->vtable->handle_sorted_set(ctx, sorted_set, handler,
+                                          handler_user_ptr, cleanup);
 #        endif // AVS_COMMONS_WITH_AVS_RBTREE
 }
 #    endif /* defined(AVS_COMMONS_WITH_AVS_SORTED_SET) || \
@@ -719,8 +775,13 @@ avs_error_t avs_persistence_sorted_set(
     return avs_persistence_tree(ctx, sorted_set, element_size, handler,
                                 handler_user_ptr, cleanup);
 #        else  // AVS_COMMONS_WITH_AVS_RBTREE
-    return avs_persistence_list(ctx, sorted_set, element_size, handler,
-                                handler_user_ptr, cleanup);
+    persistence_collection_state_t state = {
+        .element_size = element_size,
+        .handler = handler,
+        .handler_user_ptr = handler_user_ptr
+    };
+    return avs_persistence_custom_allocated_sorted_set(
+            ctx, sorted_set, persistence_list_handler, &state, cleanup);
 #        endif // AVS_COMMONS_WITH_AVS_RBTREE
 }
 #    endif /* defined(AVS_COMMONS_WITH_AVS_SORTED_SET) || \
@@ -22,29 +22,105 @@
 #    include <avsystem/commons/avs_rbtree.h>
 
 #    include <assert.h>
+#    include <stdbool.h>
+#    include <stdint.h>
+#    include <string.h>
 
 VISIBILITY_SOURCE_BEGIN
 
-enum rb_color { DETACHED = 0x50DD, RED = 0x50DE, BLACK = 0x50DF };
+/**
+ * DETACHED_POOLED is used for detached nodes allocated from an
+ * avs_rbtree_pool_t. The parent pointer of such node points to the pool
+ * instead of being NULL.
+ */
+enum rb_color {
+    DETACHED_POOLED = 0x50DC,
+    DETACHED = 0x50DD,
+    RED = 0x50DE,
+    BLACK = 0x50DF
+};
+
+#    ifdef AVS_COMMONS_RBTREE_WITH_COMPACT_NODES
+/**
+ * The color is stored in the two least significant bits of the parent pointer,
+ * which are always zero, as all elements are aligned to rb_value_align_t.
+ */
+struct rb_node {
+    uintptr_t parent_and_color;
+    void *left;
+    void *right;
+#        ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+    size_t subtree_size;
+#        endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+};
 
+/**
+ * avs_max_align_t includes long double, which would cause the header to be
+ * padded back to its non-compact size on many 64-bit platforms.
+ */
+typedef union {
+    void *ptr;
+    void (*fptr)(void);
+    intmax_t i;
+    double d;
+} rb_value_align_t;
+
+AVS_STATIC_ASSERT(AVS_ALIGNOF(rb_value_align_t) >= 4,
+                  rb_node_pointers_have_two_spare_bits);
+AVS_STATIC_ASSERT((DETACHED_POOLED & 3) == 0 && (DETACHED & 3) == 1
+                          && (RED & 3) == 2 && (BLACK & 3) == 3,
+                  rb_color_low_bits_are_unique);
+#    else  // AVS_COMMONS_RBTREE_WITH_COMPACT_NODES
 struct rb_node {
     enum rb_color color;
     void *parent;
     void *left;
     void *right;
+#        ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+    size_t subtree_size;
+#        endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
 };
 
+typedef avs_max_align_t rb_value_align_t;
+#    endif // AVS_COMMONS_RBTREE_WITH_COMPACT_NODES
+
 struct rb_node_space {
     struct rb_node node;
-    avs_max_align_t value;
+    rb_value_align_t value;
 };
 
 struct rb_tree {
     size_t size;
     avs_rbtree_element_comparator_t *cmp;
+    avs_rbtree_pool_t *pool;
+    struct rb_tree *next_in_pool;
     void *root;
 };
 
+typedef struct rb_pool_slab {
+    union {
+        struct rb_pool_slab *next;
+        avs_max_align_t align;
+    } header;
+} rb_pool_slab_t;
+
+/**
+ * Node slots are carved out of slabs in allocation order; freed slots are put
+ * on a free list. Slabs are only released when the whole pool is deleted.
+ */
+struct avs_rbtree_pool_struct {
+    size_t elem_size;
+    size_t slot_size;
+    size_t slots_per_slab;
+    rb_pool_slab_t *first_slab;
+    rb_pool_slab_t *last_slab;
+    rb_pool_slab_t *current_slab;
+    char *current_slot;
+    char *current_slab_end;
+    void *free_slots;
+    struct rb_tree *trees;
+};
+
 #    define _AVS_NODE_SPACE__ offsetof(struct rb_node_space, value)
 
 #    define _AVS_RB_NODE(elem) \
@@ -73,13 +149,76 @@ struct rb_tree {
 #    define _AVS_RB_RIGHT(elem) (*_AVS_RB_RIGHT_PTR(elem))
 #    define _AVS_RB_RIGHT_CONST(elem) (*_AVS_RB_RIGHT_PTR_CONST(elem))
 
-#    define _AVS_RB_PARENT_PTR(elem) \
-        ((AVS_TYPEOF_PTR(elem) *) &(_AVS_RB_NODE(elem)->parent))
-#    define _AVS_RB_PARENT_PTR_CONST(elem) \
-        ((AVS_TYPEOF_PTR(elem) const *) &(_AVS_RB_NODE_CONST(elem)->parent))
+#    ifdef AVS_COMMONS_RBTREE_WITH_COMPACT_NODES
+#        define _AVS_RB_COLOR_MASK ((uintptr_t) 3)
+
+#        define _AVS_RB_PARENT_AND_COLOR(elem) \
+            (_AVS_RB_NODE_CONST(elem)->parent_and_color)
+
+#        define _AVS_RB_PARENT(elem)                                \
+            ((AVS_TYPEOF_PTR(elem)) (_AVS_RB_PARENT_AND_COLOR(elem) \
+                                     & ~_AVS_RB_COLOR_MASK))
+#        define _AVS_RB_PARENT_CONST(elem) _AVS_RB_PARENT(elem)
+
+#        define _AVS_RB_COLOR(elem)                                   \
+            ((enum rb_color) (DETACHED_POOLED                         \
+                              | (int) (_AVS_RB_PARENT_AND_COLOR(elem) \
+                                       & _AVS_RB_COLOR_MASK)))
 
-#    define _AVS_RB_PARENT(elem) (*_AVS_RB_PARENT_PTR(elem))
-#    define _AVS_RB_PARENT_CONST(elem) (*_AVS_RB_PARENT_PTR_CONST(elem))
+static void rb_set_parent(void *elem, void *parent) {
+    struct rb_node *node = _AVS_RB_NODE(elem);
+    assert(!((uintptr_t) parent & _AVS_RB_COLOR_MASK));
+    node->parent_and_color = (uintptr_t) parent
+                             | (node->parent_and_color & _AVS_RB_COLOR_MASK);
+}
+
+static void rb_set_color(void *elem, enum rb_color color) {
+    struct rb_node *node = _AVS_RB_NODE(elem);
+    node->parent_and_color = (node->parent_and_color & ~_AVS_RB_COLOR_MASK)
+                             | ((uintptr_t) color & _AVS_RB_COLOR_MASK);
+}
+#    else // AVS_COMMONS_RBTREE_WITH_COMPACT_NODES
+#        define _AVS_RB_PARENT(elem) \
+            ((AVS_TYPEOF_PTR(elem)) _AVS_RB_NODE(elem)->parent)
+#        define _AVS_RB_PARENT_CONST(elem) \
+            ((AVS_TYPEOF_PTR(elem)) _AVS_RB_NODE_CONST(elem)->parent)
+
+#        define _AVS_RB_COLOR(elem) (_AVS_RB_NODE(elem)->color)
+
+static void rb_set_parent(void *elem, void *parent) {
+    _AVS_RB_NODE(elem)->parent = parent;
+}
+
+static void rb_set_color(void *elem, enum rb_color color) {
+    _AVS_RB_NODE(elem)->color = color;
+}
+#    endif // AVS_COMMONS_RBTREE_WITH_COMPACT_NODES
+
+#    ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+#        define _AVS_RB_SUBTREE_SIZE(elem) (_AVS_RB_NODE(elem)->subtree_size)
+
+static size_t rb_subtree_size(AVS_RBTREE_ELEM(void) elem) {
+    return elem ? _AVS_RB_SUBTREE_SIZE(elem) : 0;
+}
+
+static void rb_update_subtree_size(AVS_RBTREE_ELEM(void) elem) {
+    _AVS_RB_SUBTREE_SIZE(elem) = 1 + rb_subtree_size(_AVS_RB_LEFT(elem))
+                                 + rb_subtree_size(_AVS_RB_RIGHT(elem));
+}
+
+/**
+ * Recalculates subtree sizes of @p elem and all its ancestors, after a node
+ * has been added to or removed from the subtree rooted at @p elem.
+ */
+static void rb_update_subtree_sizes_upwards(AVS_RBTREE_ELEM(void) elem) {
+    for (; elem; elem = _AVS_RB_PARENT(elem)) {
+        rb_update_subtree_size(elem);
+    }
+}
+#    else // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+#        define rb_update_subtree_size(elem) ((void) (elem))
+#        define rb_update_subtree_sizes_upwards(elem) ((void) (elem))
+#    endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
 
 enum rb_color _avs_rb_node_color(void *elem);
 
@@ -93,20 +232,29 @@ static void test_rb_dealloc(void *ptr);
 #        define _AVS_RB_DEALLOC test_rb_dealloc
 #    endif
 
+static avs_rbtree_pool_t *rb_detached_node_pool(AVS_RBTREE_ELEM(void) elem) {
+    if (_AVS_RB_COLOR(elem) == DETACHED_POOLED) {
+        return (avs_rbtree_pool_t *) _AVS_RB_PARENT(elem);
+    }
+    return NULL;
+}
+
+static AVS_RBTREE_CONST(void) rb_tree_const(AVS_RBTREE(void) tree) {
+    return (AVS_RBTREE_CONST(void))(intptr_t) tree;
+}
+
 #    ifndef NDEBUG
 static int rb_is_cleanup_in_progress(AVS_RBTREE_CONST(void) tree) {
     return *tree && (_AVS_RB_PARENT_CONST(*tree) != NULL);
 }
 
 static int rb_is_node_detached(AVS_RBTREE_ELEM(void) elem) {
-    return _AVS_RB_NODE(elem)->color == DETACHED && _AVS_RB_PARENT(elem) == NULL
+    return (_AVS_RB_COLOR(elem) == DETACHED_POOLED
+            || (_AVS_RB_COLOR(elem) == DETACHED
+                && _AVS_RB_PARENT(elem) == NULL))
            && _AVS_RB_LEFT(elem) == NULL && _AVS_RB_RIGHT(elem) == NULL;
 }
 
-static AVS_RBTREE_CONST(void) rb_tree_const(AVS_RBTREE(void) tree) {
-    return (AVS_RBTREE_CONST(void))(intptr_t) tree;
-}
-
 static int rb_is_node_owner(AVS_RBTREE(void) tree, AVS_RBTREE_ELEM(void) elem) {
     while (elem && elem != _AVS_RB_TREE(tree)->root) {
         elem = _AVS_RB_PARENT(elem);
@@ -125,9 +273,9 @@ enum rb_color _avs_rb_node_color(AVS_RBTREE_ELEM(void) elem) {
     } else {
         /* checking the color of a detached node is pointless, so
          * this function should never be called on one */
-        assert(_AVS_RB_NODE(elem)->color == RED
-               || _AVS_RB_NODE(elem)->color == BLACK);
-        return _AVS_RB_NODE(elem)->color;
+        assert(_AVS_RB_COLOR(elem) == RED
+               || _AVS_RB_COLOR(elem) == BLACK);
+        return _AVS_RB_COLOR(elem);
     }
 }
 
@@ -144,10 +292,148 @@ AVS_RBTREE(void) avs_rbtree_new__(avs_rbtree_element_comparator_t *cmp) {
     return &tree->root;
 }
 
+AVS_RBTREE(void)
+avs_rbtree_new_with_pool__(avs_rbtree_element_comparator_t *cmp,
+                           avs_rbtree_pool_t *pool) {
+    assert(pool);
+    AVS_RBTREE(void) result = avs_rbtree_new__(cmp);
+    if (result) {
+        struct rb_tree *tree = _AVS_RB_TREE(result);
+        tree->pool = pool;
+        tree->next_in_pool = pool->trees;
+        pool->trees = tree;
+    }
+    return result;
+}
+
+avs_rbtree_pool_t *avs_rbtree_pool_new__(size_t elem_size,
+                                         size_t elems_per_slab) {
+    if (!elem_size || !elems_per_slab) {
+        return NULL;
+    }
+
+    size_t slot_size = _AVS_NODE_SPACE__ + elem_size;
+    /* keep subsequent slots aligned */
+    slot_size +=
+            (sizeof(rb_value_align_t) - slot_size % sizeof(rb_value_align_t))
+            % sizeof(rb_value_align_t);
+    if (slot_size < elem_size
+            || elems_per_slab
+                           > (SIZE_MAX - sizeof(rb_pool_slab_t)) / slot_size) {
+        return NULL;
+    }
+
+    avs_rbtree_pool_t *pool =
+            (avs_rbtree_pool_t *) _AVS_RB_ALLOC(sizeof(avs_rbtree_pool_t));
+    if (pool) {
+        pool->elem_size = elem_size;
+        pool->slot_size = slot_size;
+        pool->slots_per_slab = elems_per_slab;
+    }
+    return pool;
+}
+
+void avs_rbtree_pool_clear__(avs_rbtree_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    for (struct rb_tree *tree = pool->trees; tree; tree = tree->next_in_pool) {
+        tree->root = NULL;
+        tree->size = 0;
+    }
+    pool->current_slab = NULL;
+    pool->current_slot = NULL;
+    pool->current_slab_end = NULL;
+    pool->free_slots = NULL;
+}
+
+void avs_rbtree_pool_delete__(avs_rbtree_pool_t **pool_ptr) {
+    if (!pool_ptr || !*pool_ptr) {
+        return;
+    }
+
+    AVS_ASSERT(!(*pool_ptr)->trees,
+               "avs_rbtree_pool_delete__ called on a pool still in use");
+    rb_pool_slab_t *slab = (*pool_ptr)->first_slab;
+    while (slab) {
+        rb_pool_slab_t *next = slab->header.next;
+        _AVS_RB_DEALLOC(slab);
+        slab = next;
+    }
+    _AVS_RB_DEALLOC(*pool_ptr);
+    *pool_ptr = NULL;
+}
+
+static void *rb_pool_alloc(avs_rbtree_pool_t *pool) {
+    char *slot;
+    if (pool->free_slots) {
+        slot = (char *) pool->free_slots;
+        pool->free_slots = *(void **) pool->free_slots;
+    } else {
+        if (pool->current_slot == pool->current_slab_end) {
+            rb_pool_slab_t *slab = pool->current_slab
+                                           ? pool->current_slab->header.next
+                                           : pool->first_slab;
+            if (!slab) {
+                if (!(slab = (rb_pool_slab_t *) _AVS_RB_ALLOC(
+                              sizeof(rb_pool_slab_t)
+                              + pool->slots_per_slab * pool->slot_size))) {
+                    return NULL;
+                }
+                if (pool->last_slab) {
+                    pool->last_slab->header.next = slab;
+                } else {
+                    pool->first_slab = slab;
+                }
+                pool->last_slab = slab;
+            }
+            pool->current_slab = slab;
+            pool->current_slot = (char *) slab + sizeof(rb_pool_slab_t);
+            pool->current_slab_end =
+                    pool->current_slot
+                    + pool->slots_per_slab * pool->slot_size;
+        }
+        slot = pool->current_slot;
+        pool->current_slot += pool->slot_size;
+    }
+    memset(slot, 0, pool->slot_size);
+    return slot;
+}
+
+static void rb_pool_free(avs_rbtree_pool_t *pool, void *slot) {
+    *(void **) slot = pool->free_slots;
+    pool->free_slots = slot;
+}
+
+AVS_RBTREE_ELEM(void) avs_rbtree_pool_elem_new__(avs_rbtree_pool_t *pool,
+                                                 size_t elem_size) {
+    assert(pool);
+    AVS_ASSERT(elem_size <= pool->elem_size,
+               "element too large for the RB-tree pool");
+    if (elem_size > pool->elem_size) {
+        return NULL;
+    }
+
+    char *node = (char *) rb_pool_alloc(pool);
+    if (!node) {
+        return NULL;
+    }
+
+    AVS_RBTREE_ELEM(void) elem = node + _AVS_NODE_SPACE__;
+    rb_set_color(elem, DETACHED_POOLED);
+    rb_set_parent(elem, pool);
+    return elem;
+}
+
 void avs_rbtree_elem_delete__(AVS_RBTREE_ELEM(void) *node_ptr) {
     if (node_ptr && *node_ptr) {
         assert(rb_is_node_detached(*node_ptr));
-        _AVS_RB_DEALLOC(_AVS_RB_NODE(*node_ptr));
+        avs_rbtree_pool_t *pool = rb_detached_node_pool(*node_ptr);
+        if (pool) {
+            rb_pool_free(pool, _AVS_RB_NODE(*node_ptr));
+        } else {
+            _AVS_RB_DEALLOC(_AVS_RB_NODE(*node_ptr));
+        }
         *node_ptr = NULL;
     }
 }
@@ -161,10 +447,32 @@ void avs_rbtree_delete__(AVS_RBTREE(void) *tree_ptr) {
 
     assert(!**tree_ptr); /* should only be called on empty trees */
     tree = _AVS_RB_TREE(*tree_ptr);
+    if (tree->pool) {
+        struct rb_tree **tree_it = &tree->pool->trees;
+        while (*tree_it != tree) {
+            assert(*tree_it);
+            tree_it = &(*tree_it)->next_in_pool;
+        }
+        *tree_it = tree->next_in_pool;
+    }
     _AVS_RB_DEALLOC(tree);
     *tree_ptr = NULL;
 }
 
+/**
+ * Puts an element that has just been unlinked from @p tree into the detached
+ * state.
+ */
+static void rb_mark_detached(struct rb_tree *tree, AVS_RBTREE_ELEM(void) elem) {
+    if (tree->pool) {
+        rb_set_color(elem, DETACHED_POOLED);
+        rb_set_parent(elem, tree->pool);
+    } else {
+        rb_set_color(elem, DETACHED);
+        rb_set_parent(elem, NULL);
+    }
+}
+
 static void rb_subtree_delete(AVS_RBTREE_ELEM(void) elem) {
     if (elem) {
         rb_subtree_delete(_AVS_RB_LEFT(elem));
@@ -197,8 +505,9 @@ static AVS_RBTREE_ELEM(void) rb_subtree_clone(AVS_RBTREE_ELEM(void) node,
         return NULL;
     }
 
-    _AVS_RB_NODE(clone)->color = _AVS_RB_NODE(node)->color;
-    _AVS_RB_PARENT(clone) = new_parent;
+    rb_set_color(clone, _AVS_RB_COLOR(node));
+    rb_set_parent(clone, new_parent);
+    rb_update_subtree_size(clone);
     memcpy(clone, node, elem_size);
     return clone;
 }
@@ -226,15 +535,14 @@ size_t avs_rbtree_size__(AVS_RBTREE_CONST(void) tree) {
 }
 
 AVS_RBTREE_ELEM(void) avs_rbtree_elem_new_buffer__(size_t elem_size) {
-    struct rb_node *node =
-            (struct rb_node *) _AVS_RB_ALLOC(_AVS_NODE_SPACE__ + elem_size);
+    char *node = (char *) _AVS_RB_ALLOC(_AVS_NODE_SPACE__ + elem_size);
     if (!node) {
         return NULL;
     }
 
-    node->color = DETACHED;
-
-    return (char *) node + _AVS_NODE_SPACE__;
+    AVS_RBTREE_ELEM(void) elem = node + _AVS_NODE_SPACE__;
+    rb_set_color(elem, DETACHED);
+    return elem;
 }
 
 static AVS_RBTREE_ELEM(void) *
@@ -392,16 +700,19 @@ static void rb_rotate_left(struct rb_tree *tree, AVS_RBTREE_ELEM(void) root) {
     assert(pivot);
 
     *own_parent_ptr = pivot;
-    _AVS_RB_PARENT(pivot) = parent;
+    rb_set_parent(pivot, parent);
 
     grandchild = _AVS_RB_LEFT(pivot);
     _AVS_RB_LEFT(pivot) = root;
-    _AVS_RB_PARENT(root) = pivot;
+    rb_set_parent(root, pivot);
 
     _AVS_RB_RIGHT(root) = grandchild;
     if (grandchild) {
-        _AVS_RB_PARENT(grandchild) = root;
+        rb_set_parent(grandchild, root);
     }
+
+    rb_update_subtree_size(root);
+    rb_update_subtree_size(pivot);
 }
 
 /**
@@ -428,16 +739,19 @@ static void rb_rotate_right(struct rb_tree *tree, AVS_RBTREE_ELEM(void) root) {
     assert(pivot);
 
     *own_parent_ptr = pivot;
-    _AVS_RB_PARENT(pivot) = parent;
+    rb_set_parent(pivot, parent);
 
     grandchild = _AVS_RB_RIGHT(pivot);
     _AVS_RB_RIGHT(pivot) = root;
-    _AVS_RB_PARENT(root) = pivot;
+    rb_set_parent(root, pivot);
 
     _AVS_RB_LEFT(root) = grandchild;
     if (grandchild) {
-        _AVS_RB_PARENT(grandchild) = root;
+        rb_set_parent(grandchild, root);
     }
+
+    rb_update_subtree_size(root);
+    rb_update_subtree_size(pivot);
 }
 
 static void rb_insert_fix(struct rb_tree *tree, AVS_RBTREE_ELEM(void) elem) {
@@ -447,11 +761,11 @@ static void rb_insert_fix(struct rb_tree *tree, AVS_RBTREE_ELEM(void) elem) {
 
     /* case 1 */
     if (elem == tree->root) {
-        _AVS_RB_NODE(elem)->color = BLACK;
+        rb_set_color(elem, BLACK);
         return;
     }
 
-    _AVS_RB_NODE(elem)->color = RED;
+    rb_set_color(elem, RED);
 
     /* case 2 */
     parent = _AVS_RB_PARENT(elem);
@@ -465,9 +779,9 @@ static void rb_insert_fix(struct rb_tree *tree, AVS_RBTREE_ELEM(void) elem) {
     uncle = rb_sibling(parent, grandparent);
 
     if (_avs_rb_node_color(uncle) == RED) {
-        _AVS_RB_NODE(parent)->color = BLACK;
-        _AVS_RB_NODE(uncle)->color = BLACK;
-        _AVS_RB_NODE(grandparent)->color = RED;
+        rb_set_color(parent, BLACK);
+        rb_set_color(uncle, BLACK);
+        rb_set_color(grandparent, RED);
         rb_insert_fix(tree, grandparent);
         return;
     }
@@ -486,8 +800,8 @@ static void rb_insert_fix(struct rb_tree *tree, AVS_RBTREE_ELEM(void) elem) {
     parent = _AVS_RB_PARENT(elem);
     assert(grandparent == _AVS_RB_PARENT(parent));
 
-    _AVS_RB_NODE(parent)->color = BLACK;
-    _AVS_RB_NODE(grandparent)->color = RED;
+    rb_set_color(parent, BLACK);
+    rb_set_color(grandparent, RED);
     if (elem == _AVS_RB_LEFT(parent)) {
         rb_rotate_right(tree, grandparent);
     } else {
@@ -506,6 +820,8 @@ AVS_RBTREE_ELEM(void) avs_rbtree_attach__(AVS_RBTREE(void) tree_,
     assert(tree_);
     assert(elem);
     assert(rb_is_node_detached(elem));
+    AVS_ASSERT(rb_detached_node_pool(elem) == tree->pool,
+               "element not allocated from the pool used by the tree");
 
     dst = rb_find_ptr(tree, elem, &parent);
     assert(dst);
@@ -515,14 +831,84 @@ AVS_RBTREE_ELEM(void) avs_rbtree_attach__(AVS_RBTREE(void) tree_,
         return *dst;
     } else {
         *dst = elem;
-        _AVS_RB_PARENT(elem) = parent;
+        rb_set_parent(elem, parent);
         ++tree->size;
+        rb_update_subtree_sizes_upwards(elem);
     }
 
     rb_insert_fix(tree, elem);
     return elem;
 }
 
+/**
+ * Builds a balanced subtree out of sorted @p elems by recursively splitting
+ * them in half. Subtree sizes differ by at most one, so all levels except the
+ * deepest one (@p red_depth) are full - coloring only the nodes on that level
+ * red yields equal black height on all paths.
+ */
+static AVS_RBTREE_ELEM(void) rb_build_subtree(AVS_RBTREE_ELEM(void) *elems,
+                                              size_t count,
+                                              AVS_RBTREE_ELEM(void) parent,
+                                              size_t depth,
+                                              size_t red_depth) {
+    if (!count) {
+        return NULL;
+    }
+
+    size_t mid = count / 2;
+    AVS_RBTREE_ELEM(void) elem = elems[mid];
+    rb_set_color(elem, depth == red_depth ? RED : BLACK);
+    rb_set_parent(elem, parent);
+    _AVS_RB_LEFT(elem) =
+            rb_build_subtree(elems, mid, elem, depth + 1, red_depth);
+    _AVS_RB_RIGHT(elem) = rb_build_subtree(elems + mid + 1, count - mid - 1,
+                                           elem, depth + 1, red_depth);
+    rb_update_subtree_size(elem);
+    return elem;
+}
+
+static void rb_build(struct rb_tree *tree,
+                     AVS_RBTREE_ELEM(void) *elems,
+                     size_t count) {
+    /* number of levels that are completely filled */
+    size_t full_levels = 0;
+    while (full_levels < sizeof(size_t) * 8 - 1
+           && ((size_t) 1 << (full_levels + 1)) - 1 <= count) {
+        ++full_levels;
+    }
+
+    tree->root = rb_build_subtree(elems, count, NULL, 0, full_levels);
+    tree->size = count;
+}
+
+int avs_rbtree_build_from_sorted__(AVS_RBTREE(void) tree_,
+                                   AVS_RBTREE_ELEM(void) *elems,
+                                   size_t count) {
+    struct rb_tree *tree = _AVS_RB_TREE(tree_);
+
+    AVS_ASSERT(!rb_is_cleanup_in_progress(rb_tree_const(tree_)),
+               "avs_rbtree_build_from_sorted__ called while tree deletion in "
+               "progress");
+    assert(tree_);
+    assert(elems || !count);
+
+    if (tree->root) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        assert(elems[i]);
+        assert(rb_is_node_detached(elems[i]));
+        AVS_ASSERT(rb_detached_node_pool(elems[i]) == tree->pool,
+                   "element not allocated from the pool used by the tree");
+        if (i > 0 && tree->cmp(elems[i - 1], elems[i]) >= 0) {
+            return -1;
+        }
+    }
+
+    rb_build(tree, elems, count);
+    return 0;
+}
+
 static AVS_RBTREE_ELEM(void) rb_min(AVS_RBTREE_ELEM(void) root) {
     AVS_RBTREE_ELEM(void) min = root;
     AVS_RBTREE_ELEM(void) left = root;
@@ -574,6 +960,9 @@ AVS_RBTREE_ELEM(void) avs_rbtree_elem_next__(AVS_RBTREE_ELEM(void) elem) {
     if (right) {
         return rb_min(right);
     }
+    if (rb_detached_node_pool(elem)) {
+        return NULL;
+    }
 
     parent = _AVS_RB_PARENT(elem);
     curr = elem;
@@ -593,6 +982,9 @@ AVS_RBTREE_ELEM(void) avs_rbtree_elem_prev__(AVS_RBTREE_ELEM(void) elem) {
     if (left) {
         return rb_max(left);
     }
+    if (rb_detached_node_pool(elem)) {
+        return NULL;
+    }
 
     parent = _AVS_RB_PARENT(elem);
     curr = elem;
@@ -638,37 +1030,45 @@ static void rb_swap_nodes(struct rb_tree *tree,
     /* simply swapping pointers in case where one node is a parent of
      * another would set parent pointer of the former parent to itself */
     if (_AVS_RB_PARENT(a) == b) {
-        _AVS_RB_PARENT(a) = a;
+        rb_set_parent(a, a);
     } else if (_AVS_RB_PARENT(b) == a) {
-        _AVS_RB_PARENT(b) = b;
+        rb_set_parent(b, b);
     }
 
     swap(a_parent_ptr, b_parent_ptr);
-    swap(_AVS_RB_PARENT_PTR(a), _AVS_RB_PARENT_PTR(b));
+    AVS_RBTREE_ELEM(void) a_parent = _AVS_RB_PARENT(a);
+    rb_set_parent(a, _AVS_RB_PARENT(b));
+    rb_set_parent(b, a_parent);
 
     swap(_AVS_RB_LEFT_PTR(a), _AVS_RB_LEFT_PTR(b));
     if (_AVS_RB_LEFT(a)) {
         AVS_RBTREE_ELEM(void) left = _AVS_RB_LEFT(a);
-        _AVS_RB_PARENT(left) = a;
+        rb_set_parent(left, a);
     }
     if (_AVS_RB_LEFT(b)) {
         AVS_RBTREE_ELEM(void) left = _AVS_RB_LEFT(b);
-        _AVS_RB_PARENT(left) = b;
+        rb_set_parent(left, b);
     }
 
     swap(_AVS_RB_RIGHT_PTR(a), _AVS_RB_RIGHT_PTR(b));
     if (_AVS_RB_RIGHT(a)) {
         AVS_RBTREE_ELEM(void) right = _AVS_RB_RIGHT(a);
-        _AVS_RB_PARENT(right) = a;
+        rb_set_parent(right, a);
     }
     if (_AVS_RB_RIGHT(b)) {
         AVS_RBTREE_ELEM(void) right = _AVS_RB_RIGHT(b);
-        _AVS_RB_PARENT(right) = b;
+        rb_set_parent(right, b);
     }
 
     col = _avs_rb_node_color(a);
-    _AVS_RB_NODE(a)->color = _avs_rb_node_color(b);
-    _AVS_RB_NODE(b)->color = col;
+    rb_set_color(a, _avs_rb_node_color(b));
+    rb_set_color(b, col);
+
+#    ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+    size_t a_size = _AVS_RB_SUBTREE_SIZE(a);
+    _AVS_RB_SUBTREE_SIZE(a) = _AVS_RB_SUBTREE_SIZE(b);
+    _AVS_RB_SUBTREE_SIZE(b) = a_size;
+#    endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
 }
 
 static void rb_detach_fix(struct rb_tree *tree,
@@ -686,8 +1086,8 @@ static void rb_detach_fix(struct rb_tree *tree,
     /* case 2 */
     sibling = rb_sibling(elem, parent);
     if (_avs_rb_node_color(sibling) == RED) {
-        _AVS_RB_NODE(parent)->color = RED;
-        _AVS_RB_NODE(sibling)->color = BLACK;
+        rb_set_color(parent, RED);
+        rb_set_color(sibling, BLACK);
 
         if (elem == _AVS_RB_LEFT(parent)) {
             rb_rotate_left(tree, parent);
@@ -705,7 +1105,7 @@ static void rb_detach_fix(struct rb_tree *tree,
     if (_avs_rb_node_color(parent) == BLACK
             && _avs_rb_node_color(_AVS_RB_LEFT(sibling)) == BLACK
             && _avs_rb_node_color(_AVS_RB_RIGHT(sibling)) == BLACK) {
-        _AVS_RB_NODE(sibling)->color = RED;
+        rb_set_color(sibling, RED);
         rb_detach_fix(tree, parent, _AVS_RB_PARENT(parent));
         return;
     }
@@ -714,8 +1114,8 @@ static void rb_detach_fix(struct rb_tree *tree,
     if (_avs_rb_node_color(parent) == RED
             && _avs_rb_node_color(_AVS_RB_LEFT(sibling)) == BLACK
             && _avs_rb_node_color(_AVS_RB_RIGHT(sibling)) == BLACK) {
-        _AVS_RB_NODE(sibling)->color = RED;
-        _AVS_RB_NODE(parent)->color = BLACK;
+        rb_set_color(sibling, RED);
+        rb_set_color(parent, BLACK);
         return;
     }
 
@@ -724,33 +1124,33 @@ static void rb_detach_fix(struct rb_tree *tree,
             && _avs_rb_node_color(_AVS_RB_RIGHT(sibling)) == BLACK) {
         assert(_avs_rb_node_color(_AVS_RB_LEFT(sibling)) == RED);
 
-        _AVS_RB_NODE(sibling)->color = RED;
-        _AVS_RB_NODE(_AVS_RB_LEFT(sibling))->color = BLACK;
+        rb_set_color(sibling, RED);
+        rb_set_color(_AVS_RB_LEFT(sibling), BLACK);
         rb_rotate_right(tree, sibling);
     } else if (elem == _AVS_RB_RIGHT(parent)
                && _avs_rb_node_color(_AVS_RB_LEFT(sibling)) == BLACK) {
         assert(_avs_rb_node_color(_AVS_RB_RIGHT(sibling)) == RED);
 
-        _AVS_RB_NODE(sibling)->color = RED;
-        _AVS_RB_NODE(_AVS_RB_RIGHT(sibling))->color = BLACK;
+        rb_set_color(sibling, RED);
+        rb_set_color(_AVS_RB_RIGHT(sibling), BLACK);
         rb_rotate_left(tree, sibling);
     }
 
     /* case 6 */
     sibling = rb_sibling(elem, parent);
 
-    _AVS_RB_NODE(sibling)->color = _avs_rb_node_color(parent);
-    _AVS_RB_NODE(parent)->color = BLACK;
+    rb_set_color(sibling, _avs_rb_node_color(parent));
+    rb_set_color(parent, BLACK);
 
     if (elem == _AVS_RB_LEFT(parent)) {
         assert(_AVS_RB_RIGHT(sibling));
 
-        _AVS_RB_NODE(_AVS_RB_RIGHT(sibling))->color = BLACK;
+        rb_set_color(_AVS_RB_RIGHT(sibling), BLACK);
         rb_rotate_left(tree, parent);
     } else {
         assert(_AVS_RB_LEFT(sibling));
 
-        _AVS_RB_NODE(_AVS_RB_LEFT(sibling))->color = BLACK;
+        rb_set_color(_AVS_RB_LEFT(sibling), BLACK);
         rb_rotate_right(tree, parent);
     }
 }
@@ -794,24 +1194,24 @@ AVS_RBTREE_ELEM(void) avs_rbtree_detach__(AVS_RBTREE(void) tree_,
 
     if (child) {
         assert(_AVS_RB_PARENT(child) == elem);
-        _AVS_RB_PARENT(child) = parent;
+        rb_set_parent(child, parent);
     }
 
     *rb_own_parent_ptr(tree, elem) = child;
     elem_color = _avs_rb_node_color(elem);
-    _AVS_RB_NODE(elem)->color = DETACHED;
-    _AVS_RB_PARENT(elem) = NULL;
+    rb_mark_detached(tree, elem);
     _AVS_RB_LEFT(elem) = NULL;
     _AVS_RB_RIGHT(elem) = NULL;
     assert(tree->size > 0u);
     --tree->size;
+    rb_update_subtree_sizes_upwards(parent);
 
     assert(elem_color == BLACK || _avs_rb_node_color(child) == BLACK);
     if (elem_color == RED || _avs_rb_node_color(child) == RED) {
         if (child) {
             /* if elem is red, child is already black
              * if child is red, we need to repaint it */
-            _AVS_RB_NODE(child)->color = BLACK;
+            rb_set_color(child, BLACK);
         }
 
         return elem;
@@ -862,9 +1262,8 @@ AVS_RBTREE_ELEM(void) avs_rbtree_cleanup_next__(AVS_RBTREE(void) tree) {
     next = rb_postorder_next(*tree);
     curr_ptr = rb_own_parent_ptr(_AVS_RB_TREE(tree), *tree);
 
-    _AVS_RB_NODE(*tree)->color = DETACHED;
-    _AVS_RB_PARENT(*tree) = NULL;
-    assert(AVS_RBTREE_SIZE(tree) > 0u);
+    rb_mark_detached(_AVS_RB_TREE(tree), *tree);
+    assert(_AVS_RB_TREE(tree)->size > 0u);
     --_AVS_RB_TREE(tree)->size;
     /* at this point, child nodes should be cleaned up */
     assert(_AVS_RB_LEFT(*tree) == NULL);
@@ -875,6 +1274,288 @@ AVS_RBTREE_ELEM(void) avs_rbtree_cleanup_next__(AVS_RBTREE(void) tree) {
     return *tree = next;
 }
 
+int avs_rbtree_merge__(AVS_RBTREE(void) dst_, AVS_RBTREE(void) src_) {
+    struct rb_tree *dst = _AVS_RB_TREE(dst_);
+    struct rb_tree *src = _AVS_RB_TREE(src_);
+
+    AVS_ASSERT(!rb_is_cleanup_in_progress(rb_tree_const(dst_))
+                       && !rb_is_cleanup_in_progress(rb_tree_const(src_)),
+               "avs_rbtree_merge__ called while tree deletion in progress");
+    assert(dst_ != src_);
+    AVS_ASSERT(dst->pool == src->pool,
+               "cannot move elements between trees using different pools");
+
+    if (!src->root) {
+        return 0;
+    }
+    if (!dst->root) {
+        dst->root = src->root;
+        dst->size = src->size;
+        src->root = NULL;
+        src->size = 0;
+        return 0;
+    }
+
+    /* the buffer below holds dst->size + 2 * src->size elements */
+    const size_t max_elems = SIZE_MAX / sizeof(AVS_RBTREE_ELEM(void));
+    if (src->size > max_elems / 2 || dst->size > max_elems - 2 * src->size) {
+        return -1;
+    }
+    size_t total = dst->size + src->size;
+    /* merged elements, followed by elements that will remain in src */
+    AVS_RBTREE_ELEM(void) *elems = (AVS_RBTREE_ELEM(void) *) _AVS_RB_ALLOC(
+            (total + src->size) * sizeof(*elems));
+    if (!elems) {
+        return -1;
+    }
+    AVS_RBTREE_ELEM(void) *leftover = elems + total;
+    size_t merged_count = 0;
+    size_t leftover_count = 0;
+
+    AVS_RBTREE_ELEM(void) a = rb_min(dst->root);
+    AVS_RBTREE_ELEM(void) b = rb_min(src->root);
+    while (a || b) {
+        int cmp = !a ? 1 : !b ? -1 : dst->cmp(a, b);
+        if (cmp <= 0) {
+            elems[merged_count++] = a;
+            a = avs_rbtree_elem_next__(a);
+            if (cmp == 0) {
+                leftover[leftover_count++] = b;
+                b = avs_rbtree_elem_next__(b);
+            }
+        } else {
+            elems[merged_count++] = b;
+            b = avs_rbtree_elem_next__(b);
+        }
+    }
+
+    rb_build(dst, elems, merged_count);
+    rb_build(src, leftover, leftover_count);
+    _AVS_RB_DEALLOC(elems);
+    return 0;
+}
+
+int avs_rbtree_partition__(AVS_RBTREE(void) tree_,
+                           AVS_RBTREE_CONST(void) other_,
+                           AVS_RBTREE(void) out_,
+                           int move_common) {
+    struct rb_tree *tree = _AVS_RB_TREE(tree_);
+    struct rb_tree *other = _AVS_RB_TREE((AVS_RBTREE(void)) (intptr_t) other_);
+    struct rb_tree *out = _AVS_RB_TREE(out_);
+
+    AVS_ASSERT(!rb_is_cleanup_in_progress(rb_tree_const(tree_))
+                       && !rb_is_cleanup_in_progress(other_)
+                       && !rb_is_cleanup_in_progress(rb_tree_const(out_)),
+               "avs_rbtree_partition__ called while tree deletion in progress");
+    assert(tree_ != out_);
+    AVS_ASSERT(tree->pool == out->pool,
+               "cannot move elements between trees using different pools");
+
+    if (out->root) {
+        return -1;
+    }
+    if (!tree->root) {
+        return 0;
+    }
+
+    size_t count = tree->size;
+    AVS_RBTREE_ELEM(void) *elems =
+            (AVS_RBTREE_ELEM(void) *) _AVS_RB_ALLOC(count * sizeof(*elems));
+    if (!elems) {
+        return -1;
+    }
+    /* elements to keep are stored from the front, elements to move - from the
+     * back, in reverse order */
+    size_t kept_count = 0;
+    size_t moved_count = 0;
+
+    AVS_RBTREE_ELEM(void) b = rb_min(other->root);
+    for (AVS_RBTREE_ELEM(void) a = rb_min(tree->root); a;
+         a = avs_rbtree_elem_next__(a)) {
+        int cmp = -1;
+        while (b && (cmp = tree->cmp(b, a)) < 0) {
+            b = avs_rbtree_elem_next__(b);
+        }
+        if ((b && cmp == 0) == !!move_common) {
+            elems[count - ++moved_count] = a;
+        } else {
+            elems[kept_count++] = a;
+        }
+    }
+    for (size_t i = 0; i < moved_count / 2; ++i) {
+        swap(&elems[kept_count + i], &elems[count - 1 - i]);
+    }
+
+    rb_build(tree, elems, kept_count);
+    rb_build(out, elems + kept_count, moved_count);
+    _AVS_RB_DEALLOC(elems);
+    return 0;
+}
+
+/**
+ * Moves elements from @p first up to, but not including, @p end from @p tree
+ * into empty @p out by rebuilding both trees from scratch.
+ */
+static int rb_detach_range_rebuild(struct rb_tree *tree,
+                                   AVS_RBTREE_ELEM(void) first,
+                                   AVS_RBTREE_ELEM(void) end,
+                                   struct rb_tree *out) {
+    size_t count = tree->size;
+    AVS_RBTREE_ELEM(void) *elems =
+            (AVS_RBTREE_ELEM(void) *) _AVS_RB_ALLOC(count * sizeof(*elems));
+    if (!elems) {
+        return -1;
+    }
+    size_t first_index = 0;
+    size_t end_index = count;
+    size_t i = 0;
+    for (AVS_RBTREE_ELEM(void) elem = rb_min(tree->root); elem;
+         elem = avs_rbtree_elem_next__(elem), ++i) {
+        if (elem == first) {
+            first_index = i;
+        } else if (elem == end) {
+            end_index = i;
+        }
+        elems[i] = elem;
+    }
+    assert(i == count);
+    assert(first_index < end_index);
+
+    rb_build(out, elems + first_index, end_index - first_index);
+    memmove(elems + first_index, elems + end_index,
+            (count - end_index) * sizeof(*elems));
+    rb_build(tree, elems, count - (end_index - first_index));
+    _AVS_RB_DEALLOC(elems);
+    return 0;
+}
+
+int avs_rbtree_detach_range__(AVS_RBTREE(void) tree_,
+                              const void *lower_value,
+                              const void *upper_value,
+                              AVS_RBTREE(void) out_) {
+    struct rb_tree *tree = _AVS_RB_TREE(tree_);
+    struct rb_tree *out = _AVS_RB_TREE(out_);
+
+    AVS_ASSERT(!rb_is_cleanup_in_progress(rb_tree_const(tree_))
+                       && !rb_is_cleanup_in_progress(rb_tree_const(out_)),
+               "avs_rbtree_detach_range__ called while tree deletion in "
+               "progress");
+    assert(tree_ != out_);
+    assert(lower_value);
+    assert(upper_value);
+    AVS_ASSERT(tree->pool == out->pool,
+               "cannot move elements between trees using different pools");
+
+    if (out->root) {
+        return -1;
+    }
+    if (tree->cmp(lower_value, upper_value) > 0) {
+        return 0;
+    }
+    AVS_RBTREE_ELEM(void) first =
+            avs_rbtree_lower_bound__(rb_tree_const(tree_), lower_value);
+    AVS_RBTREE_ELEM(void) end =
+            avs_rbtree_upper_bound__(rb_tree_const(tree_), upper_value);
+    if (first == end) {
+        return 0;
+    }
+
+    /* rebuilding is only worth it if the range covers most of the tree;
+     * otherwise, the elements are detached one by one in O(log n) each */
+    size_t count = 0;
+    for (AVS_RBTREE_ELEM(void) elem = first; elem != end;
+         elem = avs_rbtree_elem_next__(elem)) {
+        if (++count > tree->size / 2) {
+            return rb_detach_range_rebuild(tree, first, end, out);
+        }
+    }
+    while (first != end) {
+        AVS_RBTREE_ELEM(void) next = avs_rbtree_elem_next__(first);
+        avs_rbtree_detach__(tree_, first);
+        avs_rbtree_attach__(out_, first);
+        first = next;
+    }
+    return 0;
+}
+
+#    ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+AVS_RBTREE_ELEM(void) avs_rbtree_nth__(AVS_RBTREE_CONST(void) tree,
+                                       size_t index) {
+    AVS_ASSERT(!rb_is_cleanup_in_progress(tree),
+               "avs_rbtree_nth__ called while tree deletion in progress");
+    assert(tree);
+
+    AVS_RBTREE_ELEM(void) curr = *(AVS_RBTREE(void)) (intptr_t) tree;
+    while (curr) {
+        size_t left_size = rb_subtree_size(_AVS_RB_LEFT(curr));
+        if (index < left_size) {
+            curr = _AVS_RB_LEFT(curr);
+        } else if (index == left_size) {
+            return curr;
+        } else {
+            index -= left_size + 1;
+            curr = _AVS_RB_RIGHT(curr);
+        }
+    }
+    return NULL;
+}
+
+size_t avs_rbtree_rank__(AVS_RBTREE_ELEM(const void) elem) {
+    AVS_RBTREE_ELEM(void) curr = (AVS_RBTREE_ELEM(void)) (intptr_t) elem;
+
+    assert(elem);
+    AVS_ASSERT(!rb_is_node_detached(curr),
+               "cannot get rank of a detached node");
+
+    size_t rank = rb_subtree_size(_AVS_RB_LEFT(curr));
+    for (AVS_RBTREE_ELEM(void) parent = _AVS_RB_PARENT(curr); parent;
+         curr = parent, parent = _AVS_RB_PARENT(parent)) {
+        if (_AVS_RB_RIGHT(parent) == curr) {
+            rank += rb_subtree_size(_AVS_RB_LEFT(parent)) + 1;
+        }
+    }
+    return rank;
+}
+
+/**
+ * Returns the number of elements in @p tree that are less than @p value, or,
+ * if @p inclusive is true, less or equal to it.
+ */
+static size_t rb_count_less(struct rb_tree *tree,
+                            const void *value,
+                            bool inclusive) {
+    size_t result = 0;
+    AVS_RBTREE_ELEM(void) curr = tree->root;
+    while (curr) {
+        int cmp = tree->cmp(value, curr);
+        if (cmp < 0 || (cmp == 0 && !inclusive)) {
+            curr = _AVS_RB_LEFT(curr);
+        } else {
+            result += rb_subtree_size(_AVS_RB_LEFT(curr)) + 1;
+            curr = _AVS_RB_RIGHT(curr);
+        }
+    }
+    return result;
+}
+
+size_t avs_rbtree_count_range__(AVS_RBTREE_CONST(void) tree_,
+                                const void *lower_value,
+                                const void *upper_value) {
+    struct rb_tree *tree = _AVS_RB_TREE((AVS_RBTREE(void)) (intptr_t) tree_);
+
+    AVS_ASSERT(
+            !rb_is_cleanup_in_progress(tree_),
+            "avs_rbtree_count_range__ called while tree deletion in progress");
+    assert(tree_);
+    assert(lower_value);
+    assert(upper_value);
+
+    size_t below_lower = rb_count_less(tree, lower_value, false);
+    size_t up_to_upper = rb_count_less(tree, upper_value, true);
+    return up_to_upper > below_lower ? up_to_upper - below_lower : 0;
+}
+#    endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+
 #    ifdef AVS_UNIT_TESTING
 #        include "tests/rbtree/test_rbtree.c"
 #    endif
@@ -24,6 +24,7 @@
 #    include <string.h>
 
 #    include <avsystem/commons/avs_list.h>
+#    include <avsystem/commons/avs_memory.h>
 #    include <avsystem/commons/avs_sched.h>
 #    include <avsystem/commons/avs_utils.h>
 
@@ -55,6 +56,17 @@ struct avs_sched_job_struct {
     /** Instant in time at which the job is scheduled. */
     avs_time_monotonic_t instant;
 
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
+    /**
+     * Sequence number assigned when the job is put into the queue. Used to
+     * preserve FIFO ordering of jobs scheduled for the same instant.
+     */
+    uint64_t seq;
+
+    /** Current position of the job in the scheduler's heap array. */
+    size_t heap_index;
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
+
 #    ifdef AVS_COMMONS_WITH_INTERNAL_LOGS
     struct {
         /** File from which AVS_SCHED*() was called. */
@@ -96,8 +108,24 @@ struct avs_sched_struct {
     avs_condvar_t *task_condvar;
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
+    /**
+     * Scheduled jobs, organized as a binary min-heap ordered by (instant, seq).
+     */
+    avs_sched_job_t **heap;
+
+    /** Number of jobs currently stored in @ref avs_sched_struct::heap . */
+    size_t heap_size;
+
+    /** Number of elements allocated for @ref avs_sched_struct::heap . */
+    size_t heap_capacity;
+
+    /** Sequence number that will be assigned to the next queued job. */
+    uint64_t next_seq;
+#    else  // AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
     /** Scheduled jobs. */
     AVS_LIST(avs_sched_job_t) jobs;
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
 
     /**
      * A flag that prevents scheduling new jobs while the scheduler is shutting
@@ -139,6 +167,232 @@ void _avs_sched_cleanup_global_state(void) {
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 }
 
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
+
+#        define SCHED_HEAP_INITIAL_CAPACITY 8
+
+static avs_sched_job_t *job_new(size_t size) {
+    return (avs_sched_job_t *) avs_calloc(1, size);
+}
+
+static void job_delete(avs_sched_job_t **job_ptr) {
+    avs_free(*job_ptr);
+    *job_ptr = NULL;
+}
+
+static bool job_before(const avs_sched_job_t *a, const avs_sched_job_t *b) {
+    if (avs_time_monotonic_before(a->instant, b->instant)) {
+        return true;
+    } else if (avs_time_monotonic_before(b->instant, a->instant)) {
+        return false;
+    }
+    return a->seq < b->seq;
+}
+
+static void heap_put(avs_sched_t *sched, size_t index, avs_sched_job_t *job) {
+    sched->heap[index] = job;
+    job->heap_index = index;
+}
+
+static void heap_sift_up(avs_sched_t *sched, size_t index) {
+    avs_sched_job_t *job = sched->heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!job_before(job, sched->heap[parent])) {
+            break;
+        }
+        heap_put(sched, index, sched->heap[parent]);
+        index = parent;
+    }
+    heap_put(sched, index, job);
+}
+
+static void heap_sift_down(avs_sched_t *sched, size_t index) {
+    avs_sched_job_t *job = sched->heap[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= sched->heap_size) {
+            break;
+        }
+        if (child + 1 < sched->heap_size
+                && job_before(sched->heap[child + 1], sched->heap[child])) {
+            ++child;
+        }
+        if (!job_before(sched->heap[child], job)) {
+            break;
+        }
+        heap_put(sched, index, sched->heap[child]);
+        index = child;
+    }
+    heap_put(sched, index, job);
+}
+
+static avs_sched_job_t *queue_front(avs_sched_t *sched) {
+    return sched->heap_size ? sched->heap[0] : NULL;
+}
+
+/**
+ * Ensures that @ref queue_insert can be called without allocating memory.
+ */
+static int queue_reserve(avs_sched_t *sched) {
+    if (sched->heap_size < sched->heap_capacity) {
+        return 0;
+    }
+    size_t new_capacity = sched->heap_capacity ? 2 * sched->heap_capacity
+                                               : SCHED_HEAP_INITIAL_CAPACITY;
+    if (new_capacity < sched->heap_capacity
+            || new_capacity > SIZE_MAX / sizeof(*sched->heap)) {
+        return -1;
+    }
+    avs_sched_job_t **new_heap = (avs_sched_job_t **) avs_realloc(
+            sched->heap, new_capacity * sizeof(*sched->heap));
+    if (!new_heap) {
+        return -1;
+    }
+    sched->heap = new_heap;
+    sched->heap_capacity = new_capacity;
+    return 0;
+}
+
+static void queue_insert(avs_sched_t *sched, avs_sched_job_t *job) {
+    assert(sched->heap_size < sched->heap_capacity);
+    job->seq = sched->next_seq++;
+    heap_put(sched, sched->heap_size++, job);
+    heap_sift_up(sched, job->heap_index);
+}
+
+static void queue_remove(avs_sched_t *sched, avs_sched_job_t *job) {
+    size_t index = job->heap_index;
+    assert(index < sched->heap_size);
+    assert(sched->heap[index] == job);
+    avs_sched_job_t *last = sched->heap[--sched->heap_size];
+    if (last == job) {
+        return;
+    }
+    heap_put(sched, index, last);
+    if (index > 0 && job_before(last, sched->heap[(index - 1) / 2])) {
+        heap_sift_up(sched, index);
+    } else {
+        heap_sift_down(sched, index);
+    }
+}
+
+/**
+ * Checks whether @p job, retrieved from @p handle_ptr before locking the
+ * scheduler mutex, is still in the queue. Jobs cannot be looked up by address
+ * here, as the job might have been already executed and freed by another
+ * thread. However, the handle is always cleared before the job is removed from
+ * the queue, so the job is still there if and only if the handle still points
+ * to it.
+ */
+static bool queue_has_job(avs_sched_t *sched,
+                          avs_sched_handle_t *handle_ptr,
+                          avs_sched_job_t *job) {
+    nonfailing_mutex_lock(g_handle_access_mutex);
+    bool result = (*handle_ptr == job && job->sched == sched);
+    avs_mutex_unlock(g_handle_access_mutex);
+    return result;
+}
+
+static bool queue_detach(avs_sched_t *sched,
+                         avs_sched_handle_t *handle_ptr,
+                         avs_sched_job_t *job) {
+    if (!queue_has_job(sched, handle_ptr, job)) {
+        return false;
+    }
+    queue_remove(sched, job);
+    return true;
+}
+
+static void queue_clear(avs_sched_t *sched) {
+    while (sched->heap_size) {
+        avs_sched_job_t *job = sched->heap[--sched->heap_size];
+        if (job->handle_ptr) {
+            *job->handle_ptr = NULL;
+        }
+        job_delete(&job);
+    }
+    avs_free(sched->heap);
+    sched->heap = NULL;
+    sched->heap_capacity = 0;
+}
+
+#        define QUEUE_FOREACH(Job, Sched)                                \
+            for (size_t _queue_index = 0;                               \
+                 _queue_index < (Sched)->heap_size                      \
+                 && ((Job) = (Sched)->heap[_queue_index], true);        \
+                 ++_queue_index)
+
+#    else // AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
+
+static avs_sched_job_t *job_new(size_t size) {
+    return (avs_sched_job_t *) AVS_LIST_NEW_BUFFER(size);
+}
+
+static void job_delete(avs_sched_job_t **job_ptr) {
+    // make sure that the task is detached
+    assert(!AVS_LIST_NEXT(*job_ptr));
+    AVS_LIST_DELETE(job_ptr);
+}
+
+static avs_sched_job_t *queue_front(avs_sched_t *sched) {
+    return sched->jobs;
+}
+
+static int queue_reserve(avs_sched_t *sched) {
+    (void) sched;
+    return 0;
+}
+
+static void queue_insert(avs_sched_t *sched, avs_sched_job_t *job) {
+    AVS_LIST(avs_sched_job_t) *insert_ptr = &sched->jobs;
+    while (*insert_ptr
+           && !avs_time_monotonic_before(job->instant,
+                                         (*insert_ptr)->instant)) {
+        AVS_LIST_ADVANCE_PTR(&insert_ptr);
+    }
+    AVS_LIST_INSERT(insert_ptr, job);
+}
+
+static void queue_remove(avs_sched_t *sched, avs_sched_job_t *job) {
+    AVS_LIST(avs_sched_job_t) *job_ptr =
+            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
+    assert(job_ptr);
+    AVS_LIST_DETACH(job_ptr);
+}
+
+static bool queue_has_job(avs_sched_t *sched,
+                          avs_sched_handle_t *handle_ptr,
+                          avs_sched_job_t *job) {
+    (void) handle_ptr;
+    return AVS_LIST_FIND_PTR(&sched->jobs, job) != NULL;
+}
+
+static bool queue_detach(avs_sched_t *sched,
+                         avs_sched_handle_t *handle_ptr,
+                         avs_sched_job_t *job) {
+    (void) handle_ptr;
+    AVS_LIST(avs_sched_job_t) *job_ptr =
+            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
+    if (!job_ptr) {
+        return false;
+    }
+    AVS_LIST_DETACH(job_ptr);
+    return true;
+}
+
+static void queue_clear(avs_sched_t *sched) {
+    AVS_LIST_CLEAR(&sched->jobs) {
+        if (sched->jobs->handle_ptr) {
+            *sched->jobs->handle_ptr = NULL;
+        }
+    }
+}
+
+#        define QUEUE_FOREACH(Job, Sched) AVS_LIST_FOREACH(Job, (Sched)->jobs)
+
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP_QUEUE
+
 #    define SCHED_LOG(Sched, Level, ...)                          \
         LOG(Level, "Scheduler \"%s\": " AVS_VARARG0(__VA_ARGS__), \
             ((Sched)->name ? (Sched)->name                        \
@@ -232,11 +486,7 @@ void avs_sched_cleanup(avs_sched_t **sched_ptr) {
     avs_sched_run(*sched_ptr);
 
     nonfailing_mutex_lock(g_handle_access_mutex);
-    AVS_LIST_CLEAR(&(*sched_ptr)->jobs) {
-        if ((*sched_ptr)->jobs->handle_ptr) {
-            *(*sched_ptr)->jobs->handle_ptr = NULL;
-        }
-    }
+    queue_clear(*sched_ptr);
     avs_mutex_unlock(g_handle_access_mutex);
 
     avs_condvar_cleanup(&(*sched_ptr)->task_condvar);
@@ -254,8 +504,9 @@ void *avs_sched_data(avs_sched_t *sched) {
 
 static avs_time_monotonic_t sched_time_of_next_locked(avs_sched_t *sched) {
     assert(sched);
-    if (sched->jobs) {
-        return sched->jobs->instant;
+    avs_sched_job_t *front = queue_front(sched);
+    if (front) {
+        return front->instant;
     }
     return AVS_TIME_MONOTONIC_INVALID;
 }
@@ -307,33 +558,31 @@ int avs_sched_wait_until_next(avs_sched_t *sched,
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 }
 
-static AVS_LIST(avs_sched_job_t) fetch_job(avs_sched_t *sched,
-                                           avs_time_monotonic_t deadline) {
-    AVS_LIST(avs_sched_job_t) result = NULL;
+static avs_sched_job_t *fetch_job(avs_sched_t *sched,
+                                  avs_time_monotonic_t deadline) {
+    avs_sched_job_t *result = NULL;
     nonfailing_mutex_lock(sched->mutex);
-    if (sched->jobs
-            && !avs_time_monotonic_before(deadline, sched->jobs->instant)) {
-        if (sched->jobs->handle_ptr) {
+    avs_sched_job_t *front = queue_front(sched);
+    if (front && !avs_time_monotonic_before(deadline, front->instant)) {
+        if (front->handle_ptr) {
             nonfailing_mutex_lock(g_handle_access_mutex);
-            assert(*sched->jobs->handle_ptr == sched->jobs);
-            *sched->jobs->handle_ptr = NULL;
+            assert(*front->handle_ptr == front);
+            *front->handle_ptr = NULL;
             avs_mutex_unlock(g_handle_access_mutex);
-            sched->jobs->handle_ptr = NULL;
+            front->handle_ptr = NULL;
         }
-        result = AVS_LIST_DETACH(&sched->jobs);
+        queue_remove(sched, front);
+        result = front;
     }
     avs_mutex_unlock(sched->mutex);
     return result;
 }
 
-static void execute_job(avs_sched_t *sched, AVS_LIST(avs_sched_job_t) job) {
-    // make sure that the task is detached
-    assert(!AVS_LIST_NEXT(job));
-
+static void execute_job(avs_sched_t *sched, avs_sched_job_t *job) {
     SCHED_LOG(sched, TRACE, _("executing job") "%s", JOB_LOG_ID(job));
 
     job->clb(sched, job->clb_data);
-    AVS_LIST_DELETE(&job);
+    job_delete(&job);
 }
 
 void avs_sched_run(avs_sched_t *sched) {
@@ -341,7 +590,7 @@ void avs_sched_run(avs_sched_t *sched) {
     avs_time_monotonic_t now = avs_time_monotonic_now();
 
     uint32_t tasks_executed = 0;
-    AVS_LIST(avs_sched_job_t) job = NULL;
+    avs_sched_job_t *job = NULL;
     while ((job = fetch_job(sched, now))) {
         assert(job->sched == sched);
         execute_job(sched, job);
@@ -364,16 +613,6 @@ void avs_sched_run(avs_sched_t *sched) {
 #    endif // AVS_COMMONS_WITH_INTERNAL_TRACE
 }
 
-static void schedule_job(avs_sched_t *sched, avs_sched_job_t *job) {
-    AVS_LIST(avs_sched_job_t) *insert_ptr = &sched->jobs;
-    while (*insert_ptr
-           && !avs_time_monotonic_before(job->instant,
-                                         (*insert_ptr)->instant)) {
-        AVS_LIST_ADVANCE_PTR(&insert_ptr);
-    }
-    AVS_LIST_INSERT(insert_ptr, job);
-}
-
 static int sched_at_locked(avs_sched_t *sched,
                            avs_sched_handle_t *out_handle,
                            avs_time_monotonic_t instant,
@@ -397,9 +636,9 @@ static int sched_at_locked(avs_sched_t *sched,
         return -1;
     }
 
-    AVS_LIST(avs_sched_job_t) job = (avs_sched_job_t *) AVS_LIST_NEW_BUFFER(
-            sizeof(avs_sched_job_t) + clb_data_size);
-    if (!job) {
+    avs_sched_job_t *job = NULL;
+    if (queue_reserve(sched)
+            || !(job = job_new(sizeof(avs_sched_job_t) + clb_data_size))) {
         SCHED_LOG(sched, ERROR, _("out of memory"));
         return -1;
     }
@@ -423,22 +662,20 @@ static int sched_at_locked(avs_sched_t *sched,
             AVS_ASSERT((*out_handle)->sched == sched,
                        "Replacing handles used by a different scheduler is "
                        "not supported");
-            AVS_LIST(avs_sched_job_t) *job_ptr =
-                    (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(
-                            &sched->jobs, *out_handle);
-            AVS_ASSERT(job_ptr, "dangling handle detected");
+            avs_sched_job_t *old_job = *out_handle;
             SCHED_LOG(sched, TRACE,
                       _("cancelling job") "%s" _(
                               " due to reschedule policy for job") "%s",
-                      JOB_LOG_ID(*job_ptr),
+                      JOB_LOG_ID(old_job),
                       JOB_LOG_ID_EXPLICIT(log_file, log_line, log_name));
-            AVS_LIST_DELETE(job_ptr);
+            queue_remove(sched, old_job);
+            job_delete(&old_job);
         }
         *out_handle = job;
         avs_mutex_unlock(g_handle_access_mutex);
     }
 
-    schedule_job(sched, job);
+    queue_insert(sched, job);
 #    ifdef AVS_COMMONS_WITH_INTERNAL_TRACE
     avs_time_duration_t remaining =
             avs_time_monotonic_diff(instant, avs_time_monotonic_now());
@@ -516,11 +753,9 @@ void avs_sched_del(avs_sched_handle_t *handle_ptr) {
 
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (!job_ptr) {
+    if (!queue_detach(sched, handle_ptr, job)) {
 #    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
+        AVS_UNREACHABLE("dangling handle detected");
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
            // Job might have been removed by another thread, don't do anything
     } else {
@@ -530,7 +765,7 @@ void avs_sched_del(avs_sched_handle_t *handle_ptr) {
         *job->handle_ptr = NULL;
         avs_mutex_unlock(g_handle_access_mutex);
 
-        AVS_LIST_DELETE(job_ptr);
+        job_delete(&job);
     }
     avs_mutex_unlock(sched->mutex);
 }
@@ -555,11 +790,9 @@ void avs_sched_detach(avs_sched_handle_t *handle_ptr) {
 
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (!job_ptr) {
+    if (!queue_has_job(sched, handle_ptr, job)) {
 #    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
+        AVS_UNREACHABLE("dangling handle detected");
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
            // Job might have been removed by another thread, don't do anything
     } else {
@@ -585,8 +818,8 @@ int avs_sched_leap_time(avs_sched_t *sched, avs_time_duration_t diff) {
     SCHED_LOG(sched, INFO, _("moving all jobs by ") "%s" _(" s"),
               AVS_TIME_DURATION_AS_STRING(diff));
 
-    AVS_LIST(avs_sched_job_t) job;
-    AVS_LIST_FOREACH(job, sched->jobs) {
+    avs_sched_job_t *job;
+    QUEUE_FOREACH(job, sched) {
         job->instant = avs_time_monotonic_add(job->instant, diff);
     }
     avs_condvar_notify_all(sched->task_condvar);
@@ -622,20 +855,16 @@ int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
     int retval = 0;
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (job_ptr) {
-        SCHED_LOG(sched, TRACE, _("rescheduling job") "%s",
-                  JOB_LOG_ID(*job_ptr));
+    if (queue_detach(sched, handle_ptr, job)) {
+        SCHED_LOG(sched, TRACE, _("rescheduling job") "%s", JOB_LOG_ID(job));
 
-        avs_sched_job_t *detached_job = AVS_LIST_DETACH(job_ptr);
-        detached_job->instant = instant;
+        job->instant = instant;
 
-        schedule_job(sched, detached_job);
+        queue_insert(sched, job);
         avs_condvar_notify_all(sched->task_condvar);
     } else {
 #    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
+        AVS_UNREACHABLE("dangling handle detected");
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
         retval = -1;
     }
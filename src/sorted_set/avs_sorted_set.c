@@ -22,17 +22,30 @@
 #    include <avsystem/commons/avs_sorted_set.h>
 
 #    include <assert.h>
+#    include <stdint.h>
+#    include <string.h>
 
 VISIBILITY_SOURCE_BEGIN
 
+/*
+ * Elements are kept on an AVS_LIST, so that iteration works exactly as on
+ * a plain list. Additionally, a sorted array of pointers to all the elements
+ * is maintained, so that lookups require only O(log n) comparisons.
+ */
 struct sorted_set {
     avs_sorted_set_element_comparator_t *cmp;
+    void **index;
+    size_t size;
+    size_t capacity;
     void *head;
 };
 
 #    define _AVS_SORTED_SET(ptr) \
         AVS_CONTAINER_OF((ptr), struct sorted_set, head)
 
+#    define _AVS_SORTED_SET_CONST(ptr) \
+        AVS_CONTAINER_OF((ptr), const struct sorted_set, head)
+
 AVS_SORTED_SET(void)
 avs_sorted_set_new__(avs_sorted_set_element_comparator_t *cmp) {
     struct sorted_set *ss =
@@ -47,42 +60,46 @@ avs_sorted_set_new__(avs_sorted_set_element_comparator_t *cmp) {
     return &ss->head;
 }
 
+/**
+ * Returns the index of the first element that is not less than @p value
+ * (if @p upper is false) or greater than @p value (if @p upper is true).
+ */
+static size_t
+find_position(const struct sorted_set *ss, const void *value, bool upper) {
+    size_t lower_idx = 0;
+    size_t upper_idx = ss->size;
+    while (lower_idx < upper_idx) {
+        size_t middle = lower_idx + (upper_idx - lower_idx) / 2;
+        int cmp = ss->cmp(value, ss->index[middle]);
+        if (cmp > 0 || (upper && cmp == 0)) {
+            lower_idx = middle + 1;
+        } else {
+            upper_idx = middle;
+        }
+    }
+    return lower_idx;
+}
+
 AVS_SORTED_SET_ELEM(void)
 avs_sorted_set_lower_bound__(AVS_SORTED_SET_CONST(void) sorted_set,
                              const void *value) {
-    AVS_SORTED_SET_ELEM(void) curr;
-
     assert(sorted_set);
     assert(value);
 
-    curr = *(AVS_SORTED_SET(void)) (intptr_t) sorted_set;
-    while (curr) {
-        if (_AVS_SORTED_SET(sorted_set)->cmp(value, curr) <= 0) {
-            return curr;
-        }
-        curr = AVS_LIST_NEXT(curr);
-    }
-
-    return NULL;
+    const struct sorted_set *ss = _AVS_SORTED_SET_CONST(sorted_set);
+    size_t pos = find_position(ss, value, false);
+    return pos < ss->size ? ss->index[pos] : NULL;
 }
 
 AVS_SORTED_SET_ELEM(void)
 avs_sorted_set_upper_bound__(AVS_SORTED_SET_CONST(void) sorted_set,
                              const void *value) {
-    AVS_SORTED_SET_ELEM(void) curr;
-
     assert(sorted_set);
     assert(value);
 
-    curr = *(AVS_SORTED_SET(void)) (intptr_t) sorted_set;
-    while (curr) {
-        if (_AVS_SORTED_SET(sorted_set)->cmp(value, curr) < 0) {
-            return curr;
-        }
-        curr = AVS_LIST_NEXT(curr);
-    }
-
-    return NULL;
+    const struct sorted_set *ss = _AVS_SORTED_SET_CONST(sorted_set);
+    size_t pos = find_position(ss, value, true);
+    return pos < ss->size ? ss->index[pos] : NULL;
 }
 
 AVS_SORTED_SET_ELEM(void) avs_sorted_set_first__(AVS_SORTED_SET_CONST(void)
@@ -100,79 +117,101 @@ AVS_SORTED_SET_ELEM(void) avs_sorted_set_last__(AVS_SORTED_SET_CONST(void)
         return NULL;
     }
 
-    AVS_SORTED_SET_ELEM(void) curr = _AVS_SORTED_SET(sorted_set)->head;
-    while (curr && AVS_LIST_NEXT(curr)) {
-        curr = AVS_LIST_NEXT(curr);
-    }
+    const struct sorted_set *ss = _AVS_SORTED_SET_CONST(sorted_set);
+    return ss->size ? ss->index[ss->size - 1] : NULL;
+}
+
+size_t avs_sorted_set_size__(AVS_SORTED_SET_CONST(void) sorted_set) {
+    return sorted_set ? _AVS_SORTED_SET_CONST(sorted_set)->size : 0;
+}
 
-    return curr;
+static int reserve_index(struct sorted_set *ss) {
+    if (ss->size < ss->capacity) {
+        return 0;
+    }
+    size_t new_capacity = ss->capacity ? 2 * ss->capacity : 8;
+    if (new_capacity > SIZE_MAX / sizeof(void *)) {
+        return -1;
+    }
+    void **new_index =
+            (void **) avs_realloc(ss->index, new_capacity * sizeof(void *));
+    if (!new_index) {
+        return -1;
+    }
+    ss->index = new_index;
+    ss->capacity = new_capacity;
+    return 0;
 }
 
 AVS_SORTED_SET_ELEM(void)
 avs_sorted_set_insert__(AVS_SORTED_SET(void) sorted_set, void *insert_ptr) {
-    AVS_SORTED_SET_ELEM(void) tmp = NULL;
-
     if (!sorted_set) {
         return NULL;
     }
 
-    tmp = avs_sorted_set_find__(sorted_set, insert_ptr);
-    if (tmp) {
+    struct sorted_set *ss = _AVS_SORTED_SET(sorted_set);
+    size_t pos = find_position(ss, insert_ptr, false);
+    if (pos < ss->size && ss->cmp(insert_ptr, ss->index[pos]) == 0) {
         /* already present */
-        return tmp;
-    }
-
-    if (*sorted_set
-            && _AVS_SORTED_SET(sorted_set)
-                               ->cmp(insert_ptr,
-                                     _AVS_SORTED_SET(sorted_set)->head)
-                           > 0) {
-        /* find place to add element and add it */
-        AVS_SORTED_SET_ELEM(void) curr = _AVS_SORTED_SET(sorted_set)->head;
-
-        while (AVS_LIST_NEXT(curr)) {
-            if (_AVS_SORTED_SET(sorted_set)
-                        ->cmp(insert_ptr, AVS_LIST_NEXT(curr))
-                    <= 0) {
-                break;
-            }
-            curr = AVS_LIST_NEXT(curr);
-        }
-        return AVS_LIST_INSERT(&AVS_LIST_NEXT(curr), insert_ptr);
+        return ss->index[pos];
+    }
+    if (reserve_index(ss)) {
+        return NULL;
+    }
+
+    if (pos > 0) {
+        AVS_LIST_INSERT(&AVS_LIST_NEXT(ss->index[pos - 1]), insert_ptr);
     } else {
-        /* add as a first element*/
-        *sorted_set = AVS_LIST_INSERT(sorted_set, insert_ptr);
-        return *sorted_set;
+        AVS_LIST_INSERT(sorted_set, insert_ptr);
     }
+    memmove(&ss->index[pos + 1], &ss->index[pos],
+            (ss->size - pos) * sizeof(void *));
+    ss->index[pos] = insert_ptr;
+    ++ss->size;
+    return insert_ptr;
 }
 
 AVS_SORTED_SET_ELEM(void) avs_sorted_set_find__(AVS_SORTED_SET(void) sorted_set,
                                                 const void *element) {
-    AVS_SORTED_SET_ELEM(void) curr;
-
     assert(sorted_set);
     assert(element);
 
-    curr = *(AVS_SORTED_SET(void)) (intptr_t) sorted_set;
-    while (curr) {
-        int cmp = _AVS_SORTED_SET(sorted_set)->cmp(element, curr);
-
-        if (cmp == 0) {
-            return curr;
-        } else if (cmp < 0) {
-            /*
-             * The elements are sorted, all of the elements on the list from
-             * this point will be bigger then the element we are looking for.
-             */
-            break;
-        } else {
-            curr = AVS_LIST_NEXT(curr);
-        }
+    const struct sorted_set *ss = _AVS_SORTED_SET(sorted_set);
+    size_t pos = find_position(ss, element, false);
+    if (pos < ss->size && ss->cmp(element, ss->index[pos]) == 0) {
+        return ss->index[pos];
     }
-
     return NULL;
 }
 
+AVS_SORTED_SET_ELEM(void)
+avs_sorted_set_detach__(AVS_SORTED_SET(void) sorted_set, void *elem) {
+    assert(sorted_set);
+    assert(elem);
+
+    struct sorted_set *ss = _AVS_SORTED_SET(sorted_set);
+    size_t pos = find_position(ss, elem, false);
+    if (pos >= ss->size || ss->index[pos] != elem) {
+        return NULL;
+    }
+
+    if (pos > 0) {
+        AVS_LIST_DETACH(&AVS_LIST_NEXT(ss->index[pos - 1]));
+    } else {
+        AVS_LIST_DETACH(sorted_set);
+    }
+    --ss->size;
+    memmove(&ss->index[pos], &ss->index[pos + 1],
+            (ss->size - pos) * sizeof(void *));
+    return elem;
+}
+
+void avs_sorted_set_clear_index__(AVS_SORTED_SET(void) sorted_set) {
+    if (sorted_set) {
+        _AVS_SORTED_SET(sorted_set)->size = 0;
+    }
+}
+
 void avs_sorted_set_delete__(AVS_SORTED_SET(void) *sorted_set_ptr) {
     struct sorted_set *ss;
 
@@ -182,12 +221,13 @@ void avs_sorted_set_delete__(AVS_SORTED_SET(void) *sorted_set_ptr) {
 
     assert(!**sorted_set_ptr); /* should only be called on empty sorted_set */
     ss = _AVS_SORTED_SET(*sorted_set_ptr);
+    avs_free(ss->index);
     avs_free(ss);
     *sorted_set_ptr = NULL;
 }
 
-#    ifdef AVS_UNIT_TESTING
-#        include "tests/sorted_set/test_sorted_set.c"
-#    endif
-
 #endif // AVS_COMMONS_WITH_AVS_RBTREE
+
+#ifdef AVS_UNIT_TESTING
+#    include "tests/sorted_set/test_sorted_set.c"
+#endif
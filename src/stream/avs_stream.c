@@ -62,6 +62,25 @@ avs_error_t avs_stream_write(avs_stream_t *stream,
     return err;
 }
 
+avs_error_t avs_stream_writev(avs_stream_t *stream,
+                              const avs_iovec_t *iov,
+                              size_t iov_count) {
+    const avs_stream_v_table_extension_writev_t *ext =
+            (const avs_stream_v_table_extension_writev_t *)
+                    avs_stream_v_table_find_extension(
+                            stream, AVS_STREAM_V_TABLE_EXTENSION_WRITEV);
+    if (ext) {
+        return ext->writev(stream, iov, iov_count);
+    }
+    avs_error_t err = AVS_OK;
+    for (size_t i = 0; avs_is_ok(err) && i < iov_count; ++i) {
+        if (iov[i].length) {
+            err = avs_stream_write(stream, iov[i].base, iov[i].length);
+        }
+    }
+    return err;
+}
+
 avs_error_t avs_stream_finish_message(avs_stream_t *stream) {
     if (!stream->vtable->finish_message) {
         return avs_errno(AVS_ENOTSUP);
@@ -198,15 +217,20 @@ avs_error_t avs_stream_read_reliably(avs_stream_t *stream,
 }
 
 avs_error_t avs_stream_ignore_to_end(avs_stream_t *stream) {
-    char tmp_char;
-    avs_error_t err;
-    do {
-        err = avs_stream_getch(stream, &tmp_char, NULL);
-    } while (avs_is_ok(err));
-    if (avs_is_eof(err)) {
-        return AVS_OK;
+    char buf[AVS_STREAM_STACK_BUFFER_SIZE];
+    size_t bytes_read;
+    bool message_finished = false;
+    while (!message_finished) {
+        avs_error_t err = avs_stream_read(stream, &bytes_read,
+                                          &message_finished, buf, sizeof(buf));
+        if (avs_is_err(err)) {
+            return avs_is_eof(err) ? AVS_OK : err;
+        }
+        if (!bytes_read) {
+            break;
+        }
     }
-    return err;
+    return AVS_OK;
 }
 
 avs_error_t avs_stream_getch(avs_stream_t *stream,
@@ -228,8 +252,56 @@ typedef struct getline_provider_struct {
     avs_error_t (*peek)(struct getline_provider_struct *self,
                         size_t offset,
                         char *out_value);
+    /**
+     * Consumes up to @p buffer_length bytes that precede the next '\0', '\r'
+     * or '\n' character, copying them into @p buffer. Reports zero bytes if
+     * the stream does not expose a read window, in which case the data shall
+     * be processed byte by byte.
+     */
+    avs_error_t (*read_plain)(struct getline_provider_struct *self,
+                              char *buffer,
+                              size_t buffer_length,
+                              size_t *out_bytes_read,
+                              bool *out_message_finished);
 } getline_provider_t;
 
+static size_t plain_span_length(const char *data, size_t length) {
+    static const char SPECIAL_CHARS[] = { '\n', '\r', '\0' };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(SPECIAL_CHARS); ++i) {
+        const char *special =
+                (const char *) memchr(data, SPECIAL_CHARS[i], length);
+        if (special) {
+            length = (size_t) (special - data);
+        }
+    }
+    return length;
+}
+
+static avs_error_t peek_plain_span(avs_stream_t *stream,
+                                   size_t offset,
+                                   size_t max_length,
+                                   const char **out_data,
+                                   size_t *out_length) {
+    *out_length = 0;
+    avs_error_t err =
+            avs_stream_peek_window(stream, offset, out_data, out_length);
+    if (avs_is_eof(err)
+            || (err.category == AVS_ERRNO_CATEGORY
+                && (err.code == AVS_ENOTSUP || err.code == AVS_ENOBUFS))) {
+        // the window is not available (e.g. the data is beyond the buffered
+        // part), but peek() may still cope with it - let the byte-by-byte
+        // path handle that; other errors come from the underlying I/O, and
+        // retrying them would e.g. wait for another receive timeout
+        *out_length = 0;
+        return AVS_OK;
+    } else if (avs_is_err(err)) {
+        return err;
+    }
+    *out_length =
+            plain_span_length(*out_data, AVS_MIN(*out_length, max_length));
+    return AVS_OK;
+}
+
 static avs_error_t validate_line_finished(getline_provider_t *provider,
                                           char last_read_char) {
     if (last_read_char == '\n') {
@@ -281,6 +353,17 @@ static avs_error_t getline_helper(getline_provider_t *provider,
     avs_error_t err = AVS_OK;
     *out_message_finished = false;
     while (avs_is_ok(err) && *out_bytes_read < buffer_length - 1) {
+        size_t plain_bytes = 0;
+        err = provider->read_plain(provider, &buffer[*out_bytes_read],
+                                   buffer_length - 1 - *out_bytes_read,
+                                   &plain_bytes, out_message_finished);
+        if (avs_is_err(err)) {
+            break;
+        } else if (plain_bytes) {
+            *out_bytes_read += plain_bytes;
+            tmp_char = buffer[*out_bytes_read - 1];
+            continue;
+        }
         err = provider->getch(provider, &tmp_char, out_message_finished);
         if (avs_is_err(err)) {
             break;
@@ -327,6 +410,25 @@ static avs_error_t getline_reader_peek_func(getline_provider_t *self_,
     return avs_stream_peek(self->stream, offset, out_value);
 }
 
+static avs_error_t getline_reader_read_plain_func(getline_provider_t *self_,
+                                                  char *buffer,
+                                                  size_t buffer_length,
+                                                  size_t *out_bytes_read,
+                                                  bool *out_message_finished) {
+    getline_reader_provider_t *self =
+            AVS_CONTAINER_OF(self_, getline_reader_provider_t, vtable);
+    const char *data;
+    size_t length;
+    *out_bytes_read = 0;
+    avs_error_t err =
+            peek_plain_span(self->stream, 0, buffer_length, &data, &length);
+    if (avs_is_err(err) || !length) {
+        return err;
+    }
+    return avs_stream_read(self->stream, out_bytes_read, out_message_finished,
+                           buffer, length);
+}
+
 avs_error_t avs_stream_getline(avs_stream_t *stream,
                                size_t *out_bytes_read,
                                bool *out_message_finished,
@@ -340,7 +442,8 @@ avs_error_t avs_stream_getline(avs_stream_t *stream,
     getline_reader_provider_t provider = {
         .vtable = {
             .getch = getline_reader_getch_func,
-            .peek = getline_reader_peek_func
+            .peek = getline_reader_peek_func,
+            .read_plain = getline_reader_read_plain_func
         },
         .stream = stream
     };
@@ -378,6 +481,24 @@ static avs_error_t getline_peeker_peek_func(getline_provider_t *self_,
     return avs_stream_peek(self->stream, self->offset + offset, out_value);
 }
 
+static avs_error_t getline_peeker_read_plain_func(getline_provider_t *self_,
+                                                  char *buffer,
+                                                  size_t buffer_length,
+                                                  size_t *out_bytes_read,
+                                                  bool *out_message_finished) {
+    (void) out_message_finished;
+    getline_peeker_provider_t *self =
+            AVS_CONTAINER_OF(self_, getline_peeker_provider_t, vtable);
+    const char *data;
+    avs_error_t err = peek_plain_span(self->stream, self->offset,
+                                      buffer_length, &data, out_bytes_read);
+    if (avs_is_ok(err) && *out_bytes_read) {
+        memcpy(buffer, data, *out_bytes_read);
+        self->offset += *out_bytes_read;
+    }
+    return err;
+}
+
 avs_error_t avs_stream_peekline(avs_stream_t *stream,
                                 size_t offset,
                                 size_t *out_bytes_peeked,
@@ -391,7 +512,8 @@ avs_error_t avs_stream_peekline(avs_stream_t *stream,
     getline_peeker_provider_t provider = {
         .vtable = {
             .getch = getline_peeker_getch_func,
-            .peek = getline_peeker_peek_func
+            .peek = getline_peeker_peek_func,
+            .read_plain = getline_peeker_read_plain_func
         },
         .stream = stream,
         .offset = offset
@@ -406,19 +528,61 @@ avs_error_t avs_stream_peekline(avs_stream_t *stream,
     return err;
 }
 
+static avs_error_t copy_chunk_bounced(avs_stream_t *output_stream,
+                                      avs_stream_t *input_stream,
+                                      size_t *out_bytes_read,
+                                      bool *out_message_finished) {
+    char buf[AVS_STREAM_STACK_BUFFER_SIZE];
+    avs_error_t err = avs_stream_read(input_stream, out_bytes_read,
+                                      out_message_finished, buf, sizeof(buf));
+    if (avs_is_ok(err) && *out_bytes_read) {
+        err = avs_stream_write(output_stream, buf, *out_bytes_read);
+    }
+    return err;
+}
+
+static avs_error_t copy_chunk_in_place(
+        const avs_stream_v_table_extension_write_window_t *window_ext,
+        avs_stream_t *output_stream,
+        avs_stream_t *input_stream,
+        size_t *out_bytes_read,
+        bool *out_message_finished) {
+    void *window;
+    size_t window_length = 0;
+    if (avs_is_err(window_ext->reserve(output_stream,
+                                       AVS_STREAM_STACK_BUFFER_SIZE, &window,
+                                       &window_length))
+            || !window_length) {
+        // let avs_stream_write() deal with whatever the problem is
+        return copy_chunk_bounced(output_stream, input_stream, out_bytes_read,
+                                  out_message_finished);
+    }
+    avs_error_t err = avs_stream_read(input_stream, out_bytes_read,
+                                      out_message_finished, window,
+                                      window_length);
+    if (avs_is_ok(err) && *out_bytes_read) {
+        err = window_ext->commit(output_stream, *out_bytes_read);
+    }
+    return err;
+}
+
 avs_error_t avs_stream_copy(avs_stream_t *output_stream,
                             avs_stream_t *input_stream) {
-    char buf[AVS_STREAM_STACK_BUFFER_SIZE];
+    const avs_stream_v_table_extension_write_window_t *window_ext =
+            (const avs_stream_v_table_extension_write_window_t *)
+                    avs_stream_v_table_find_extension(
+                            output_stream,
+                            AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW);
     size_t bytes_read;
     bool message_finished = false;
     while (!message_finished) {
-        avs_error_t err;
-        if (avs_is_err((err = avs_stream_read(input_stream, &bytes_read,
-                                              &message_finished, buf,
-                                              sizeof(buf))))
-                || (bytes_read
-                    && avs_is_err((err = avs_stream_write(output_stream, buf,
-                                                          bytes_read))))) {
+        avs_error_t err =
+                window_ext ? copy_chunk_in_place(window_ext, output_stream,
+                                                 input_stream, &bytes_read,
+                                                 &message_finished)
+                           : copy_chunk_bounced(output_stream, input_stream,
+                                                &bytes_read, &message_finished);
+        if (avs_is_err(err)) {
             return err;
         }
         if (!bytes_read && !message_finished) {
@@ -477,6 +641,45 @@ avs_error_t avs_stream_offset(avs_stream_t *stream, avs_off_t *out_offset) {
     return avs_errno(AVS_ENOTSUP);
 }
 
+avs_error_t avs_stream_peek_window(avs_stream_t *stream,
+                                   size_t offset,
+                                   const char **out_data,
+                                   size_t *out_length) {
+    const avs_stream_v_table_extension_read_window_t *ext =
+            (const avs_stream_v_table_extension_read_window_t *)
+                    avs_stream_v_table_find_extension(
+                            stream, AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW);
+    if (ext) {
+        return ext->peek_window(stream, offset, out_data, out_length);
+    }
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t avs_stream_write_reserve(avs_stream_t *stream,
+                                     size_t size_hint,
+                                     void **out_ptr,
+                                     size_t *out_length) {
+    const avs_stream_v_table_extension_write_window_t *ext =
+            (const avs_stream_v_table_extension_write_window_t *)
+                    avs_stream_v_table_find_extension(
+                            stream, AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW);
+    if (ext) {
+        return ext->reserve(stream, size_hint, out_ptr, out_length);
+    }
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t avs_stream_write_commit(avs_stream_t *stream, size_t length) {
+    const avs_stream_v_table_extension_write_window_t *ext =
+            (const avs_stream_v_table_extension_write_window_t *)
+                    avs_stream_v_table_find_extension(
+                            stream, AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW);
+    if (ext) {
+        return ext->commit(stream, length);
+    }
+    return avs_errno(AVS_ENOTSUP);
+}
+
 #    ifdef AVS_UNIT_TESTING
 #        include "tests/stream/test_stream_generic.c"
 #    endif
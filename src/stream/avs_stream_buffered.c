@@ -66,19 +66,68 @@ static avs_error_t flush_data(buffered_stream_t *stream,
 
 static avs_error_t fetch_data(buffered_stream_t *stream,
                               size_t *out_bytes_read) {
-    char *insert_ptr = avs_buffer_raw_insert_ptr(stream->in_buffer);
-    size_t bytes_to_read = avs_buffer_space_left(stream->in_buffer);
+    // in_buffer is a ring buffer, so the data is never moved. avs_stream_read()
+    // never discards data that does not fit, so the second free span is only
+    // filled if the first one is not enough and more data is already there.
+    avs_buffer_span_t spans[2];
+    avs_buffer_free_spans(stream->in_buffer, spans);
+
+    *out_bytes_read = 0;
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(spans) && spans[i].length; ++i) {
+        if (i > 0
+                && (stream->message_finished
+                    || !avs_stream_nonblock_read_ready(
+                               stream->underlying_stream))) {
+            break;
+        }
+        size_t bytes_read;
+        avs_error_t err = avs_stream_read(stream->underlying_stream,
+                                          &bytes_read,
+                                          &stream->message_finished,
+                                          spans[i].base, spans[i].length);
+        if (avs_is_err(err)) {
+            return err;
+        }
+        assert(bytes_read <= spans[i].length);
+        avs_buffer_advance_ptr(stream->in_buffer, bytes_read);
+        *out_bytes_read += bytes_read;
+        if (bytes_read < spans[i].length) {
+            break;
+        }
+    }
+    return AVS_OK;
+}
 
-    avs_error_t err = avs_stream_read(stream->underlying_stream, out_bytes_read,
-                                      &stream->message_finished, insert_ptr,
-                                      bytes_to_read);
-    if (avs_is_err(err)) {
-        return err;
+static size_t consume_from_in_buffer(buffered_stream_t *stream,
+                                     char *buffer,
+                                     size_t buffer_length) {
+    avs_iovec_t spans[2];
+    avs_buffer_data_spans(stream->in_buffer, spans);
+    size_t bytes_read = 0;
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(spans); ++i) {
+        size_t chunk = AVS_MIN(spans[i].length, buffer_length - bytes_read);
+        if (chunk) {
+            memcpy(buffer + bytes_read, spans[i].base, chunk);
+            bytes_read += chunk;
+        }
     }
+    avs_buffer_consume_bytes(stream->in_buffer, bytes_read);
+    return bytes_read;
+}
 
-    assert(*out_bytes_read <= avs_buffer_capacity(stream->in_buffer));
-    avs_buffer_advance_ptr(stream->in_buffer, *out_bytes_read);
-    return AVS_OK;
+static const char *in_buffer_window(buffered_stream_t *stream,
+                                    size_t offset,
+                                    size_t *out_length) {
+    avs_iovec_t spans[2];
+    avs_buffer_data_spans(stream->in_buffer, spans);
+    size_t i = 0;
+    if (offset >= spans[0].length) {
+        offset -= spans[0].length;
+        i = 1;
+    }
+    assert(offset < spans[i].length);
+    *out_length = spans[i].length - offset;
+    return (const char *) spans[i].base + offset;
 }
 
 static avs_error_t stream_buffered_write_some(avs_stream_t *stream_,
@@ -123,6 +172,35 @@ static avs_error_t stream_buffered_write_some(avs_stream_t *stream_,
     return AVS_OK;
 }
 
+static avs_error_t stream_buffered_write_reserve(avs_stream_t *stream_,
+                                                 size_t size_hint,
+                                                 void **out_ptr,
+                                                 size_t *out_length) {
+    buffered_stream_t *stream = (buffered_stream_t *) stream_;
+    if (!stream->out_buffer) {
+        return avs_stream_write_reserve(stream->underlying_stream, size_hint,
+                                        out_ptr, out_length);
+    }
+    *out_ptr = avs_buffer_raw_insert_ptr(stream->out_buffer);
+    *out_length = avs_buffer_space_left(stream->out_buffer);
+    return AVS_OK;
+}
+
+static avs_error_t stream_buffered_write_commit(avs_stream_t *stream_,
+                                                size_t length) {
+    buffered_stream_t *stream = (buffered_stream_t *) stream_;
+    if (!stream->out_buffer) {
+        return avs_stream_write_commit(stream->underlying_stream, length);
+    }
+    if (avs_buffer_advance_ptr(stream->out_buffer, length)) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (length && avs_buffer_space_left(stream->out_buffer) == 0) {
+        return flush_data(stream, &(size_t) { 0 });
+    }
+    return AVS_OK;
+}
+
 static avs_error_t stream_buffered_read(avs_stream_t *stream_,
                                         size_t *out_bytes_read,
                                         bool *out_message_finished,
@@ -157,11 +235,7 @@ static avs_error_t stream_buffered_read(avs_stream_t *stream_,
     }
 
     bytes_read =
-            AVS_MIN(avs_buffer_data_size(stream->in_buffer), buffer_length);
-    if (bytes_read) {
-        memcpy(buffer, avs_buffer_data(stream->in_buffer), bytes_read);
-        avs_buffer_consume_bytes(stream->in_buffer, bytes_read);
-    }
+            consume_from_in_buffer(stream, (char *) buffer, buffer_length);
 
 finish:
     if (out_bytes_read) {
@@ -197,34 +271,23 @@ static avs_error_t stream_buffered_finish_message(avs_stream_t *stream_) {
     return avs_is_ok(err) ? backend_err : err;
 }
 
-static avs_error_t
-stream_buffered_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
-    buffered_stream_t *stream = (buffered_stream_t *) stream_;
-    if (!stream->in_buffer) {
-        return avs_stream_peek(stream->underlying_stream, offset, out_value);
-    }
-
-    if (offset < avs_buffer_capacity(stream->in_buffer)) {
-        while (offset >= avs_buffer_data_size(stream->in_buffer)) {
-            size_t bytes_read;
-            avs_error_t err = fetch_data(stream, &bytes_read);
-            if (avs_is_err(err)) {
-                LOG(ERROR, _("cannot peek - read error"));
-                return err;
-            } else if (bytes_read == 0) {
-                LOG(ERROR, _("cannot peek - 0 bytes read"));
-                return stream->message_finished ? AVS_EOF
-                                                : avs_errno(AVS_ENOBUFS);
-            }
+static avs_error_t fill_in_buffer(buffered_stream_t *stream, size_t offset) {
+    assert(offset < avs_buffer_capacity(stream->in_buffer));
+    while (offset >= avs_buffer_data_size(stream->in_buffer)) {
+        size_t bytes_read;
+        avs_error_t err = fetch_data(stream, &bytes_read);
+        if (avs_is_err(err)) {
+            LOG(ERROR, _("cannot peek - read error"));
+            return err;
+        } else if (bytes_read == 0) {
+            LOG(ERROR, _("cannot peek - 0 bytes read"));
+            return stream->message_finished ? AVS_EOF : avs_errno(AVS_ENOBUFS);
         }
-        *out_value = avs_buffer_data(stream->in_buffer)[offset];
-        return AVS_OK;
     }
+    return AVS_OK;
+}
 
-    avs_error_t err =
-            avs_stream_peek(stream->underlying_stream,
-                            offset - avs_buffer_data_size(stream->in_buffer),
-                            out_value);
+static avs_error_t map_underlying_peek_err(avs_error_t err) {
     if (avs_is_err(err)) {
         LOG(ERROR,
             _("cannot peek - buffer is too small and underlying stream's ")
@@ -237,6 +300,50 @@ stream_buffered_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
     return err;
 }
 
+static avs_error_t
+stream_buffered_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
+    buffered_stream_t *stream = (buffered_stream_t *) stream_;
+    if (!stream->in_buffer) {
+        return avs_stream_peek(stream->underlying_stream, offset, out_value);
+    }
+
+    if (offset < avs_buffer_capacity(stream->in_buffer)) {
+        avs_error_t err = fill_in_buffer(stream, offset);
+        if (avs_is_ok(err)) {
+            *out_value = *in_buffer_window(stream, offset, &(size_t) { 0 });
+        }
+        return err;
+    }
+
+    return map_underlying_peek_err(avs_stream_peek(
+            stream->underlying_stream,
+            offset - avs_buffer_data_size(stream->in_buffer), out_value));
+}
+
+static avs_error_t stream_buffered_peek_window(avs_stream_t *stream_,
+                                               size_t offset,
+                                               const char **out_data,
+                                               size_t *out_length) {
+    buffered_stream_t *stream = (buffered_stream_t *) stream_;
+    if (!stream->in_buffer) {
+        return avs_stream_peek_window(stream->underlying_stream, offset,
+                                      out_data, out_length);
+    }
+
+    if (offset < avs_buffer_capacity(stream->in_buffer)) {
+        avs_error_t err = fill_in_buffer(stream, offset);
+        if (avs_is_ok(err)) {
+            *out_data = in_buffer_window(stream, offset, out_length);
+        }
+        return err;
+    }
+
+    return map_underlying_peek_err(avs_stream_peek_window(
+            stream->underlying_stream,
+            offset - avs_buffer_data_size(stream->in_buffer), out_data,
+            out_length));
+}
+
 static avs_error_t stream_buffered_close(avs_stream_t *stream_) {
     buffered_stream_t *stream = (buffered_stream_t *) stream_;
     avs_error_t err = AVS_OK;
@@ -270,7 +377,17 @@ static const avs_stream_v_table_t buffered_stream_vtable = {
     .read = stream_buffered_read,
     .peek = stream_buffered_peek,
     .reset = stream_buffered_reset,
-    .close = stream_buffered_close
+    .close = stream_buffered_close,
+    .extension_list =
+            (const avs_stream_v_table_extension_t[]) {
+                    { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+                      &(const avs_stream_v_table_extension_read_window_t) {
+                              stream_buffered_peek_window } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW,
+                      &(const avs_stream_v_table_extension_write_window_t) {
+                              stream_buffered_write_reserve,
+                              stream_buffered_write_commit } },
+                    AVS_STREAM_V_TABLE_EXTENSION_NULL }
 };
 
 int avs_stream_buffered_create(avs_stream_t **inout_stream,
@@ -296,7 +413,7 @@ int avs_stream_buffered_create(avs_stream_t **inout_stream,
     }
 
     if ((in_buffer_size > 0
-         && avs_buffer_create(&stream->in_buffer, in_buffer_size))
+         && avs_buffer_create_ring(&stream->in_buffer, in_buffer_size))
             || (out_buffer_size > 0
                 && avs_buffer_create(&stream->out_buffer, out_buffer_size))) {
         avs_buffer_free(&stream->in_buffer);
@@ -31,6 +31,7 @@
 #    include <avsystem/commons/avs_stream_v_table.h>
 
 #    include "avs_stream_common.h"
+#    include "avs_stream_file_mmap.h"
 
 #    define MODULE_NAME avs_stream
 #    include <avs_x_log_config.h>
@@ -212,6 +213,155 @@ static const avs_stream_v_table_t file_stream_vtable = {
                     AVS_STREAM_V_TABLE_EXTENSION_NULL }
 };
 
+#    ifdef AVS_COMMONS_STREAM_WITH_FILE_MMAP
+typedef struct {
+    const void *const vtable;
+    const char *data;
+    size_t size;
+    size_t offset;
+} file_mmap_stream_t;
+
+static avs_error_t stream_file_mmap_write_some(avs_stream_t *stream,
+                                               const void *buffer,
+                                               size_t *inout_data_length) {
+    (void) stream;
+    (void) buffer;
+    (void) inout_data_length;
+    return avs_errno(AVS_EBADF);
+}
+
+static avs_error_t stream_file_mmap_read(avs_stream_t *stream_,
+                                         size_t *out_bytes_read,
+                                         bool *out_message_finished,
+                                         void *buffer,
+                                         size_t buffer_length) {
+    file_mmap_stream_t *file = (file_mmap_stream_t *) stream_;
+    size_t bytes_left =
+            file->offset < file->size ? file->size - file->offset : 0;
+    size_t bytes_read = AVS_MIN(bytes_left, buffer_length);
+    if (bytes_read) {
+        memcpy(buffer, file->data + file->offset, bytes_read);
+        file->offset += bytes_read;
+    }
+    if (out_bytes_read) {
+        *out_bytes_read = bytes_read;
+    }
+    if (out_message_finished) {
+        *out_message_finished = (bytes_read == bytes_left);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t stream_file_mmap_peek_window(avs_stream_t *stream_,
+                                                size_t offset,
+                                                const char **out_data,
+                                                size_t *out_length) {
+    file_mmap_stream_t *file = (file_mmap_stream_t *) stream_;
+    if (file->offset >= file->size || offset >= file->size - file->offset) {
+        return AVS_EOF;
+    }
+    *out_data = file->data + file->offset + offset;
+    *out_length = file->size - file->offset - offset;
+    return AVS_OK;
+}
+
+static avs_error_t
+stream_file_mmap_peek(avs_stream_t *stream, size_t offset, char *out_value) {
+    const char *data;
+    size_t length;
+    avs_error_t err =
+            stream_file_mmap_peek_window(stream, offset, &data, &length);
+    if (avs_is_ok(err)) {
+        *out_value = *data;
+    }
+    return err;
+}
+
+static avs_error_t stream_file_mmap_reset(avs_stream_t *stream) {
+    ((file_mmap_stream_t *) stream)->offset = 0;
+    return AVS_OK;
+}
+
+static avs_error_t stream_file_mmap_close(avs_stream_t *stream) {
+    file_mmap_stream_t *file = (file_mmap_stream_t *) stream;
+    return _avs_stream_file_munmap(file->data, file->size);
+}
+
+static avs_error_t stream_file_mmap_offset(avs_stream_t *stream,
+                                           avs_off_t *out_offset) {
+    size_t offset = ((file_mmap_stream_t *) stream)->offset;
+    if (offset > LONG_MAX) {
+        return avs_errno(AVS_E2BIG);
+    }
+    *out_offset = (avs_off_t) offset;
+    return AVS_OK;
+}
+
+static avs_error_t stream_file_mmap_seek(avs_stream_t *stream,
+                                         avs_off_t offset_from_start) {
+    if (offset_from_start < 0
+            || (unsigned long) offset_from_start > SIZE_MAX) {
+        return avs_errno(AVS_ERANGE);
+    }
+    ((file_mmap_stream_t *) stream)->offset = (size_t) offset_from_start;
+    return AVS_OK;
+}
+
+static avs_error_t stream_file_mmap_length(avs_stream_t *stream,
+                                           avs_off_t *out_length) {
+    size_t size = ((file_mmap_stream_t *) stream)->size;
+    if (size > LONG_MAX) {
+        return avs_errno(AVS_E2BIG);
+    }
+    *out_length = (avs_off_t) size;
+    return AVS_OK;
+}
+
+static const avs_stream_v_table_t file_mmap_stream_vtable = {
+    .write_some = stream_file_mmap_write_some,
+    .read = stream_file_mmap_read,
+    .peek = stream_file_mmap_peek,
+    .reset = stream_file_mmap_reset,
+    .close = stream_file_mmap_close,
+    .finish_message = _avs_stream_empty_finish_message,
+    .extension_list =
+            (const avs_stream_v_table_extension_t[]) {
+                    { AVS_STREAM_V_TABLE_EXTENSION_OFFSET,
+                      &(const avs_stream_v_table_extension_offset_t) {
+                              stream_file_mmap_offset } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_FILE,
+                      &(const avs_stream_v_table_extension_file_t) {
+                              stream_file_mmap_length,
+                              stream_file_mmap_seek } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+                      &(const avs_stream_v_table_extension_read_window_t) {
+                              stream_file_mmap_peek_window } },
+                    AVS_STREAM_V_TABLE_EXTENSION_NULL }
+};
+
+static avs_stream_t *file_mmap_create(const char *path) {
+    const char *data;
+    size_t size;
+    avs_error_t err = _avs_stream_file_mmap(path, &data, &size);
+    if (avs_is_err(err)) {
+        LOG(DEBUG, _("cannot map ") "%s" _(", falling back to regular reads"),
+            path);
+        return NULL;
+    }
+    file_mmap_stream_t *file =
+            (file_mmap_stream_t *) avs_calloc(1, sizeof(file_mmap_stream_t));
+    if (!file) {
+        _avs_stream_file_munmap(data, size);
+        return NULL;
+    }
+    const void *vtable = &file_mmap_stream_vtable;
+    memcpy((void *) (intptr_t) &file->vtable, &vtable, sizeof(void *));
+    file->data = data;
+    file->size = size;
+    return (avs_stream_t *) file;
+}
+#    endif // AVS_COMMONS_STREAM_WITH_FILE_MMAP
+
 avs_stream_t *avs_stream_file_create(const char *path, uint8_t mode) {
     avs_stream_file_t *file =
             (avs_stream_file_t *) avs_calloc(1, sizeof(avs_stream_file_t));
@@ -221,6 +371,17 @@ avs_stream_t *avs_stream_file_create(const char *path, uint8_t mode) {
     }
     memcpy((void *) (intptr_t) &file->vtable, &vtable, sizeof(void *));
 
+    if (mode == (AVS_STREAM_FILE_READ | AVS_STREAM_FILE_MMAP)) {
+#    ifdef AVS_COMMONS_STREAM_WITH_FILE_MMAP
+        avs_stream_t *mapped = file_mmap_create(path);
+        if (mapped) {
+            avs_free(file);
+            return mapped;
+        }
+#    endif // AVS_COMMONS_STREAM_WITH_FILE_MMAP
+        mode = AVS_STREAM_FILE_READ;
+    }
+
     if (mode == (AVS_STREAM_FILE_READ | AVS_STREAM_FILE_WRITE)) {
         file->fp = fopen(path, "w+b");
     } else if (mode == AVS_STREAM_FILE_READ) {
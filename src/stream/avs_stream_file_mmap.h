@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_STREAM_FILE_MMAP_H
+#define AVS_COMMONS_STREAM_FILE_MMAP_H
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_STREAM_WITH_FILE) \
+        && defined(AVS_COMMONS_STREAM_WITH_FILE_MMAP)
+
+#    include <avsystem/commons/avs_errno.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Maps the whole file at @p path into memory, read-only.
+ *
+ * Empty files are not mapped; in that case <c>*out_data</c> is set to NULL
+ * and <c>*out_size</c> to 0.
+ */
+avs_error_t _avs_stream_file_mmap(const char *path,
+                                  const char **out_data,
+                                  size_t *out_size);
+
+/**
+ * Unmaps memory previously mapped by @ref _avs_stream_file_mmap.
+ */
+avs_error_t _avs_stream_file_munmap(const char *data, size_t size);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // defined(AVS_COMMONS_STREAM_WITH_FILE) &&
+       // defined(AVS_COMMONS_STREAM_WITH_FILE_MMAP)
+
+#endif /* AVS_COMMONS_STREAM_FILE_MMAP_H */
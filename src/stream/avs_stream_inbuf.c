@@ -73,10 +73,29 @@ inbuf_stream_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
     return AVS_OK;
 }
 
+static avs_error_t inbuf_stream_peek_window(avs_stream_t *stream_,
+                                            size_t offset,
+                                            const char **out_data,
+                                            size_t *out_length) {
+    avs_stream_inbuf_t *stream = (avs_stream_inbuf_t *) stream_;
+
+    if (stream->buffer_offset + offset >= stream->buffer_size) {
+        return AVS_EOF;
+    }
+    *out_data = (const char *) stream->buffer + stream->buffer_offset + offset;
+    *out_length = stream->buffer_size - stream->buffer_offset - offset;
+    return AVS_OK;
+}
+
 static const avs_stream_v_table_t inbuf_stream_vtable = {
     .peek = inbuf_stream_peek,
     .read = inbuf_stream_read,
-    .extension_list = AVS_STREAM_V_TABLE_NO_EXTENSIONS
+    .extension_list =
+            (const avs_stream_v_table_extension_t[]) {
+                    { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+                      &(const avs_stream_v_table_extension_read_window_t) {
+                              inbuf_stream_peek_window } },
+                    AVS_STREAM_V_TABLE_EXTENSION_NULL }
 };
 
 const avs_stream_inbuf_t AVS_STREAM_INBUF_STATIC_INITIALIZER = {
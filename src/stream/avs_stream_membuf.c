@@ -80,6 +80,29 @@ avs_error_t avs_stream_membuf_take_ownership(avs_stream_t *stream,
     return avs_errno(AVS_ENOTSUP);
 }
 
+avs_error_t avs_stream_membuf_take_ownership_iov(avs_stream_t *stream,
+                                                 avs_iovec_t **out_iov,
+                                                 size_t *out_iov_count) {
+    const avs_stream_v_table_extension_membuf_iov_t *ext =
+            (const avs_stream_v_table_extension_membuf_iov_t *)
+                    avs_stream_v_table_find_extension(
+                            stream, AVS_STREAM_V_TABLE_EXTENSION_MEMBUF_IOV);
+    if (ext) {
+        return ext->take_ownership_iov(stream, out_iov, out_iov_count);
+    }
+    return avs_errno(AVS_ENOTSUP);
+}
+
+void avs_stream_membuf_iov_free(avs_iovec_t **iov, size_t iov_count) {
+    if (*iov) {
+        for (size_t i = 0; i < iov_count; ++i) {
+            avs_free((void *) (intptr_t) (*iov)[i].base);
+        }
+        avs_free(*iov);
+        *iov = NULL;
+    }
+}
+
 static void defragment_membuf(avs_stream_membuf_t *stream) {
     if (stream->index_read) {
         size_t used = stream->index_write - stream->index_read;
@@ -134,6 +157,34 @@ static avs_error_t stream_membuf_write_some(avs_stream_t *stream_,
     return AVS_OK;
 }
 
+static avs_error_t stream_membuf_write_reserve(avs_stream_t *stream_,
+                                               size_t size_hint,
+                                               void **out_ptr,
+                                               size_t *out_length) {
+    avs_stream_membuf_t *stream = (avs_stream_membuf_t *) stream_;
+    if (stream->buffer_size - stream->index_write < size_hint) {
+        defragment_membuf(stream);
+    }
+    if (stream->buffer_size - stream->index_write < size_hint) {
+        avs_error_t err =
+                realloc_membuf(stream, 2 * stream->buffer_size + size_hint);
+        if (avs_is_err(err) && stream->buffer_size == stream->index_write) {
+            return err;
+        }
+    }
+    *out_ptr = stream->buffer + stream->index_write;
+    *out_length = stream->buffer_size - stream->index_write;
+    return AVS_OK;
+}
+
+static avs_error_t stream_membuf_write_commit(avs_stream_t *stream_,
+                                              size_t length) {
+    avs_stream_membuf_t *stream = (avs_stream_membuf_t *) stream_;
+    assert(length <= stream->buffer_size - stream->index_write);
+    stream->index_write += length;
+    return AVS_OK;
+}
+
 static avs_error_t stream_membuf_read(avs_stream_t *stream_,
                                       size_t *out_bytes_read,
                                       bool *out_message_finished,
@@ -174,6 +225,19 @@ stream_membuf_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
     return AVS_OK;
 }
 
+static avs_error_t stream_membuf_peek_window(avs_stream_t *stream_,
+                                             size_t offset,
+                                             const char **out_data,
+                                             size_t *out_length) {
+    avs_stream_membuf_t *stream = (avs_stream_membuf_t *) stream_;
+    if (stream->index_read + offset >= stream->index_write) {
+        return AVS_EOF;
+    }
+    *out_data = stream->buffer + stream->index_read + offset;
+    *out_length = stream->index_write - stream->index_read - offset;
+    return AVS_OK;
+}
+
 static avs_error_t stream_membuf_reset(avs_stream_t *stream_) {
     avs_stream_membuf_t *stream = (avs_stream_membuf_t *) stream_;
     stream->index_read = 0;
@@ -241,6 +305,29 @@ static avs_error_t stream_membuf_take_ownership(avs_stream_t *stream_,
     return AVS_OK;
 }
 
+static avs_error_t stream_membuf_take_ownership_iov(avs_stream_t *stream_,
+                                                    avs_iovec_t **out_iov,
+                                                    size_t *out_iov_count) {
+    avs_stream_membuf_t *stream = (avs_stream_membuf_t *) stream_;
+    if (stream->index_read == stream->index_write) {
+        *out_iov = NULL;
+        *out_iov_count = 0;
+        return stream_membuf_reset(stream_);
+    }
+    avs_iovec_t *iov = (avs_iovec_t *) avs_malloc(sizeof(*iov));
+    if (!iov) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    defragment_membuf(stream);
+    iov->base = stream->buffer;
+    iov->length = stream->index_write;
+    stream->buffer = NULL;
+    stream->buffer_size = 0;
+    *out_iov = iov;
+    *out_iov_count = 1;
+    return stream_membuf_reset(stream_);
+}
+
 static const avs_stream_v_table_t membuf_stream_vtable = {
     .write_some = stream_membuf_write_some,
     .read = stream_membuf_read,
@@ -258,6 +345,16 @@ static const avs_stream_v_table_t membuf_stream_vtable = {
                               stream_membuf_ensure_free_bytes,
                               stream_membuf_fit,
                               stream_membuf_take_ownership } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_MEMBUF_IOV,
+                      &(const avs_stream_v_table_extension_membuf_iov_t) {
+                              stream_membuf_take_ownership_iov } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+                      &(const avs_stream_v_table_extension_read_window_t) {
+                              stream_membuf_peek_window } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW,
+                      &(const avs_stream_v_table_extension_write_window_t) {
+                              stream_membuf_write_reserve,
+                              stream_membuf_write_commit } },
                     AVS_STREAM_V_TABLE_EXTENSION_NULL }
 };
 
@@ -0,0 +1,488 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#ifdef AVS_COMMONS_WITH_AVS_STREAM
+
+#    include <assert.h>
+#    include <string.h>
+
+#    include <limits.h>
+
+#    include <avsystem/commons/avs_errno.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_stream_membuf.h>
+#    include <avsystem/commons/avs_stream_v_table.h>
+
+#    include "avs_stream_common.h"
+
+#    define MODULE_NAME avs_stream
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+struct avs_stream_membuf_chunk_pool_struct {
+    size_t chunk_size;
+    size_t max_free_chunks;
+    size_t free_chunks_count;
+    /* singly linked list of unused chunks; the link is stored in the chunk */
+    void *free_chunks;
+};
+
+typedef struct {
+    const void *const vtable;
+    avs_stream_membuf_chunk_pool_t *pool;
+    size_t chunk_size;
+    /* chunks[first_chunk .. first_chunk + chunks_count) are in use */
+    char **chunks;
+    size_t chunks_capacity;
+    size_t first_chunk;
+    size_t chunks_count;
+    /* offset of the first unread byte in chunks[first_chunk] */
+    size_t read_offset;
+    size_t data_size;
+} chunked_membuf_t;
+
+avs_stream_membuf_chunk_pool_t *
+avs_stream_membuf_chunk_pool_create(size_t chunk_size, size_t max_free_chunks) {
+    if (chunk_size < sizeof(void *)) {
+        LOG(ERROR, _("chunk size too small"));
+        return NULL;
+    }
+    avs_stream_membuf_chunk_pool_t *pool =
+            (avs_stream_membuf_chunk_pool_t *) avs_calloc(
+                    1, sizeof(avs_stream_membuf_chunk_pool_t));
+    if (!pool) {
+        LOG_OOM();
+        return NULL;
+    }
+    pool->chunk_size = chunk_size;
+    pool->max_free_chunks = max_free_chunks;
+    return pool;
+}
+
+void avs_stream_membuf_chunk_pool_free(avs_stream_membuf_chunk_pool_t **pool) {
+    if (*pool) {
+        while ((*pool)->free_chunks) {
+            void *chunk = (*pool)->free_chunks;
+            memcpy(&(*pool)->free_chunks, chunk, sizeof(void *));
+            avs_free(chunk);
+        }
+        avs_free(*pool);
+        *pool = NULL;
+    }
+}
+
+static char *chunk_alloc(chunked_membuf_t *stream) {
+    avs_stream_membuf_chunk_pool_t *pool = stream->pool;
+    if (pool && pool->free_chunks) {
+        char *chunk = (char *) pool->free_chunks;
+        memcpy(&pool->free_chunks, chunk, sizeof(void *));
+        --pool->free_chunks_count;
+        return chunk;
+    }
+    return (char *) avs_malloc(stream->chunk_size);
+}
+
+static void chunk_release(chunked_membuf_t *stream, char *chunk) {
+    avs_stream_membuf_chunk_pool_t *pool = stream->pool;
+    if (pool && pool->free_chunks_count < pool->max_free_chunks) {
+        memcpy(chunk, &pool->free_chunks, sizeof(void *));
+        pool->free_chunks = chunk;
+        ++pool->free_chunks_count;
+    } else {
+        avs_free(chunk);
+    }
+}
+
+static size_t write_offset(const chunked_membuf_t *stream) {
+    return stream->read_offset + stream->data_size;
+}
+
+/* Number of chunks that contain at least one byte of unread data */
+static size_t chunks_in_use(const chunked_membuf_t *stream) {
+    if (!stream->data_size) {
+        return 0;
+    }
+    return (write_offset(stream) + stream->chunk_size - 1) / stream->chunk_size;
+}
+
+static avs_error_t append_chunk(chunked_membuf_t *stream) {
+    size_t end = stream->first_chunk + stream->chunks_count;
+    if (end == stream->chunks_capacity) {
+        if (stream->first_chunk) {
+            memmove(stream->chunks, stream->chunks + stream->first_chunk,
+                    stream->chunks_count * sizeof(*stream->chunks));
+            stream->first_chunk = 0;
+        } else {
+            size_t new_capacity = 2 * stream->chunks_capacity + 1;
+            char **new_chunks = (char **) avs_realloc(
+                    stream->chunks, new_capacity * sizeof(*stream->chunks));
+            if (!new_chunks) {
+                return avs_errno(AVS_ENOMEM);
+            }
+            stream->chunks = new_chunks;
+            stream->chunks_capacity = new_capacity;
+        }
+        end = stream->first_chunk + stream->chunks_count;
+    }
+    if (!(stream->chunks[end] = chunk_alloc(stream))) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    ++stream->chunks_count;
+    return AVS_OK;
+}
+
+static void release_chunks_from(chunked_membuf_t *stream, size_t count) {
+    while (stream->chunks_count > count) {
+        --stream->chunks_count;
+        chunk_release(stream, stream->chunks[stream->first_chunk
+                                             + stream->chunks_count]);
+    }
+    if (!stream->chunks_count) {
+        stream->first_chunk = 0;
+    }
+}
+
+static char *chunk_at(const chunked_membuf_t *stream, size_t offset) {
+    return stream->chunks[stream->first_chunk + offset / stream->chunk_size]
+           + offset % stream->chunk_size;
+}
+
+static avs_error_t chunked_membuf_write_reserve(avs_stream_t *stream_,
+                                                size_t size_hint,
+                                                void **out_ptr,
+                                                size_t *out_length) {
+    (void) size_hint;
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    size_t offset = write_offset(stream);
+    if (offset == stream->chunks_count * stream->chunk_size) {
+        avs_error_t err = append_chunk(stream);
+        if (avs_is_err(err)) {
+            return err;
+        }
+    }
+    *out_ptr = chunk_at(stream, offset);
+    *out_length = stream->chunk_size - offset % stream->chunk_size;
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_write_commit(avs_stream_t *stream_,
+                                               size_t length) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    assert(length
+           <= stream->chunk_size - write_offset(stream) % stream->chunk_size);
+    stream->data_size += length;
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_write_some(avs_stream_t *stream,
+                                             const void *buffer,
+                                             size_t *inout_data_length) {
+    size_t written = 0;
+    while (written < *inout_data_length) {
+        void *ptr;
+        size_t length;
+        avs_error_t err = chunked_membuf_write_reserve(
+                stream, *inout_data_length - written, &ptr, &length);
+        if (avs_is_err(err)) {
+            if (!written) {
+                return err;
+            }
+            break;
+        }
+        length = AVS_MIN(length, *inout_data_length - written);
+        memcpy(ptr, (const char *) buffer + written, length);
+        chunked_membuf_write_commit(stream, length);
+        written += length;
+    }
+    *inout_data_length = written;
+    return AVS_OK;
+}
+
+static void consume_bytes(chunked_membuf_t *stream, size_t count) {
+    assert(count <= stream->data_size);
+    stream->data_size -= count;
+    stream->read_offset += count;
+    while (stream->read_offset >= stream->chunk_size) {
+        chunk_release(stream, stream->chunks[stream->first_chunk]);
+        ++stream->first_chunk;
+        --stream->chunks_count;
+        stream->read_offset -= stream->chunk_size;
+    }
+    if (!stream->data_size) {
+        // the current chunk may be reused from its beginning
+        stream->read_offset = 0;
+    }
+}
+
+static avs_error_t chunked_membuf_read(avs_stream_t *stream_,
+                                       size_t *out_bytes_read,
+                                       bool *out_message_finished,
+                                       void *buffer,
+                                       size_t buffer_length) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    if (!buffer && buffer_length) {
+        return avs_errno(AVS_EINVAL);
+    }
+    size_t bytes_left = stream->data_size;
+    size_t bytes_read = AVS_MIN(bytes_left, buffer_length);
+    for (size_t copied = 0; copied < bytes_read;) {
+        size_t offset = stream->read_offset + copied;
+        size_t length = AVS_MIN(bytes_read - copied,
+                                stream->chunk_size
+                                        - offset % stream->chunk_size);
+        memcpy((char *) buffer + copied, chunk_at(stream, offset), length);
+        copied += length;
+    }
+    consume_bytes(stream, bytes_read);
+    if (out_bytes_read) {
+        *out_bytes_read = bytes_read;
+    }
+    if (out_message_finished) {
+        *out_message_finished = (bytes_read == bytes_left);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_peek_window(avs_stream_t *stream_,
+                                              size_t offset,
+                                              const char **out_data,
+                                              size_t *out_length) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    if (offset >= stream->data_size) {
+        return AVS_EOF;
+    }
+    size_t absolute_offset = stream->read_offset + offset;
+    *out_data = chunk_at(stream, absolute_offset);
+    *out_length = AVS_MIN(stream->data_size - offset,
+                          stream->chunk_size
+                                  - absolute_offset % stream->chunk_size);
+    return AVS_OK;
+}
+
+static avs_error_t
+chunked_membuf_peek(avs_stream_t *stream, size_t offset, char *out_value) {
+    const char *data;
+    size_t length;
+    avs_error_t err =
+            chunked_membuf_peek_window(stream, offset, &data, &length);
+    if (avs_is_ok(err)) {
+        *out_value = *data;
+    }
+    return err;
+}
+
+static avs_error_t chunked_membuf_reset(avs_stream_t *stream_) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    stream->read_offset = 0;
+    stream->data_size = 0;
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_close(avs_stream_t *stream_) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    chunked_membuf_reset(stream_);
+    release_chunks_from(stream, 0);
+    avs_free(stream->chunks);
+    stream->chunks = NULL;
+    stream->chunks_capacity = 0;
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_offset(avs_stream_t *stream_,
+                                         avs_off_t *out_offset) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    if (stream->data_size > LONG_MAX) {
+        return avs_errno(AVS_E2BIG);
+    }
+    *out_offset = (avs_off_t) stream->data_size;
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_ensure_free_bytes(avs_stream_t *stream_,
+                                                    size_t additional_size) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    if (additional_size > SIZE_MAX - write_offset(stream)
+                                  - (stream->chunk_size - 1)) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    size_t required_chunks =
+            (write_offset(stream) + additional_size + stream->chunk_size - 1)
+            / stream->chunk_size;
+    while (stream->chunks_count < required_chunks) {
+        avs_error_t err = append_chunk(stream);
+        if (avs_is_err(err)) {
+            return err;
+        }
+    }
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_fit(avs_stream_t *stream_) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    // spare chunks are released; the stored data is never moved
+    release_chunks_from(stream, chunks_in_use(stream));
+    if (stream->first_chunk) {
+        memmove(stream->chunks, stream->chunks + stream->first_chunk,
+                stream->chunks_count * sizeof(*stream->chunks));
+        stream->first_chunk = 0;
+    }
+    if (stream->chunks_capacity > stream->chunks_count) {
+        if (!stream->chunks_count) {
+            avs_free(stream->chunks);
+            stream->chunks = NULL;
+        } else {
+            char **new_chunks = (char **) avs_realloc(
+                    stream->chunks,
+                    stream->chunks_count * sizeof(*stream->chunks));
+            if (!new_chunks) {
+                return avs_errno(AVS_ENOMEM);
+            }
+            stream->chunks = new_chunks;
+        }
+        stream->chunks_capacity = stream->chunks_count;
+    }
+    return AVS_OK;
+}
+
+static avs_error_t chunked_membuf_take_ownership(avs_stream_t *stream_,
+                                                 void **out_ptr,
+                                                 size_t *out_size) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    char *buffer = NULL;
+    size_t size = stream->data_size;
+    if (size) {
+        if (!(buffer = (char *) avs_malloc(size))) {
+            LOG_OOM();
+            return avs_errno(AVS_ENOMEM);
+        }
+        chunked_membuf_read(stream_, NULL, NULL, buffer, size);
+    }
+    *out_ptr = buffer;
+    if (out_size) {
+        *out_size = size;
+    }
+    // the stream is empty now, so releasing everything cannot fail
+    return chunked_membuf_close(stream_);
+}
+
+static avs_error_t chunked_membuf_take_ownership_iov(avs_stream_t *stream_,
+                                                     avs_iovec_t **out_iov,
+                                                     size_t *out_iov_count) {
+    chunked_membuf_t *stream = (chunked_membuf_t *) stream_;
+    size_t count = chunks_in_use(stream);
+    // the only step that can fail is done before touching the stream, so
+    // that it is left intact on error
+    avs_iovec_t *iov = NULL;
+    if (count && !(iov = (avs_iovec_t *) avs_malloc(count * sizeof(*iov)))) {
+        LOG_OOM();
+        return avs_errno(AVS_ENOMEM);
+    }
+    if (count) {
+        char *first = stream->chunks[stream->first_chunk];
+        size_t first_length =
+                AVS_MIN(stream->data_size,
+                        stream->chunk_size - stream->read_offset);
+        // the returned blocks need to be freeable, so the unread part of the
+        // first chunk is moved to its beginning
+        memmove(first, first + stream->read_offset, first_length);
+        size_t remaining = stream->data_size;
+        for (size_t i = 0; i < count; ++i) {
+            iov[i].base = stream->chunks[stream->first_chunk + i];
+            iov[i].length =
+                    AVS_MIN(remaining, i ? stream->chunk_size : first_length);
+            remaining -= iov[i].length;
+        }
+        assert(!remaining);
+        // ownership of the chunks is transferred to the caller
+        stream->first_chunk += count;
+        stream->chunks_count -= count;
+    }
+    *out_iov = iov;
+    *out_iov_count = count;
+    // only spare chunks are left, so releasing everything cannot fail
+    return chunked_membuf_close(stream_);
+}
+
+static const avs_stream_v_table_t chunked_membuf_vtable = {
+    .write_some = chunked_membuf_write_some,
+    .read = chunked_membuf_read,
+    .peek = chunked_membuf_peek,
+    .reset = chunked_membuf_reset,
+    .finish_message = _avs_stream_empty_finish_message,
+    .close = chunked_membuf_close,
+    .extension_list =
+            (const avs_stream_v_table_extension_t[]) {
+                    { AVS_STREAM_V_TABLE_EXTENSION_OFFSET,
+                      &(const avs_stream_v_table_extension_offset_t) {
+                              chunked_membuf_offset } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_MEMBUF,
+                      &(const avs_stream_v_table_extension_membuf_t) {
+                              chunked_membuf_ensure_free_bytes,
+                              chunked_membuf_fit,
+                              chunked_membuf_take_ownership } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_MEMBUF_IOV,
+                      &(const avs_stream_v_table_extension_membuf_iov_t) {
+                              chunked_membuf_take_ownership_iov } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+                      &(const avs_stream_v_table_extension_read_window_t) {
+                              chunked_membuf_peek_window } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW,
+                      &(const avs_stream_v_table_extension_write_window_t) {
+                              chunked_membuf_write_reserve,
+                              chunked_membuf_write_commit } },
+                    AVS_STREAM_V_TABLE_EXTENSION_NULL }
+};
+
+static avs_stream_t *create_chunked(avs_stream_membuf_chunk_pool_t *pool,
+                                    size_t chunk_size) {
+    if (!chunk_size) {
+        LOG(ERROR, _("chunk size cannot be zero"));
+        return NULL;
+    }
+    chunked_membuf_t *membuf =
+            (chunked_membuf_t *) avs_calloc(1, sizeof(chunked_membuf_t));
+    const void *vtable = &chunked_membuf_vtable;
+    if (!membuf) {
+        LOG_OOM();
+        return NULL;
+    }
+    memcpy((void *) (intptr_t) &membuf->vtable, &vtable, sizeof(void *));
+    membuf->pool = pool;
+    membuf->chunk_size = chunk_size;
+    return (avs_stream_t *) membuf;
+}
+
+avs_stream_t *avs_stream_membuf_chunked_create(size_t chunk_size) {
+    return create_chunked(NULL, chunk_size);
+}
+
+avs_stream_t *avs_stream_membuf_chunked_create_with_pool(
+        avs_stream_membuf_chunk_pool_t *pool) {
+    if (!pool) {
+        LOG(ERROR, _("chunk pool cannot be NULL"));
+        return NULL;
+    }
+    return create_chunked(pool, pool->chunk_size);
+}
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/stream/test_stream_membuf_chunked.c"
+#    endif
+
+#endif // AVS_COMMONS_WITH_AVS_STREAM
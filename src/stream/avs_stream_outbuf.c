@@ -45,6 +45,28 @@ static avs_error_t outbuf_stream_write_some(avs_stream_t *stream_,
     return AVS_OK;
 }
 
+static avs_error_t outbuf_stream_write_reserve(avs_stream_t *stream_,
+                                               size_t size_hint,
+                                               void **out_ptr,
+                                               size_t *out_length) {
+    (void) size_hint;
+    avs_stream_outbuf_t *stream = (avs_stream_outbuf_t *) stream_;
+    if (stream->message_finished) {
+        return avs_errno(AVS_EBADF);
+    }
+    *out_ptr = (char *) stream->buffer + stream->buffer_offset;
+    *out_length = stream->buffer_size - stream->buffer_offset;
+    return AVS_OK;
+}
+
+static avs_error_t outbuf_stream_write_commit(avs_stream_t *stream_,
+                                              size_t length) {
+    avs_stream_outbuf_t *stream = (avs_stream_outbuf_t *) stream_;
+    assert(length <= stream->buffer_size - stream->buffer_offset);
+    stream->buffer_offset += length;
+    return AVS_OK;
+}
+
 static avs_error_t outbuf_stream_finish(avs_stream_t *stream) {
     ((avs_stream_outbuf_t *) stream)->message_finished = 1;
     return AVS_OK;
@@ -75,6 +97,10 @@ static const avs_stream_v_table_t outbuf_stream_vtable = {
                     { AVS_STREAM_V_TABLE_EXTENSION_OFFSET,
                       &(const avs_stream_v_table_extension_offset_t) {
                               outbuf_stream_offset } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW,
+                      &(const avs_stream_v_table_extension_write_window_t) {
+                              outbuf_stream_write_reserve,
+                              outbuf_stream_write_commit } },
                     AVS_STREAM_V_TABLE_EXTENSION_NULL }
 };
 
@@ -0,0 +1,413 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// rename() is declared in stdio.h, which is otherwise poisoned
+#define AVS_SUPPRESS_POISONING
+
+#include <avsystem/commons/avs_commons_config.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_STREAM)         \
+        && defined(AVS_COMMONS_STREAM_WITH_FILE) \
+        && defined(AVS_COMMONS_STREAM_WITH_FILE_FD)
+
+#    include <avs_commons_posix_init.h>
+
+#    include <assert.h>
+#    include <errno.h>
+#    include <stdio.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_errno_map.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_stream_file.h>
+#    include <avsystem/commons/avs_stream_v_table.h>
+
+#    define MODULE_NAME avs_stream
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+#    define TMP_SUFFIX ".tmp"
+
+typedef struct {
+    const void *const vtable;
+    int fd;
+    uint8_t flags;
+    bool committed;
+    /* total number of bytes accepted, including the ones still buffered */
+    avs_off_t offset;
+    avs_off_t preallocated_size;
+    char *buffer;
+    size_t buffer_size;
+    size_t buffer_used;
+    char *path;
+    /* NULL unless AVS_STREAM_FILE_FD_ATOMIC is used */
+    char *tmp_path;
+} file_fd_stream_t;
+
+static avs_error_t errno_error(void) {
+    avs_errno_t err = avs_map_errno(errno);
+    return avs_errno(err ? err : AVS_EIO);
+}
+
+/**
+ * Writes @p length bytes, retrying short writes. @p out_written is set to the
+ * number of bytes that actually reached the file, also in case of an error.
+ */
+static avs_error_t
+write_all(int fd, const char *data, size_t length, size_t *out_written) {
+    *out_written = 0;
+    while (*out_written < length) {
+        ssize_t written =
+                write(fd, data + *out_written, length - *out_written);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno_error();
+        }
+        *out_written += (size_t) written;
+    }
+    return AVS_OK;
+}
+
+static avs_error_t flush_buffer(file_fd_stream_t *file) {
+    size_t written;
+    avs_error_t err =
+            write_all(file->fd, file->buffer, file->buffer_used, &written);
+    // keep only the bytes that have not been written, so that they are not
+    // duplicated in the file when flushing is retried
+    file->buffer_used -= written;
+    if (file->buffer_used) {
+        memmove(file->buffer, file->buffer + written, file->buffer_used);
+    }
+    return err;
+}
+
+static avs_error_t sync_fd(int fd) {
+#    ifdef AVS_COMMONS_STREAM_FILE_FD_HAVE_FDATASYNC
+    if (fdatasync(fd)) {
+#    else  // AVS_COMMONS_STREAM_FILE_FD_HAVE_FDATASYNC
+    if (fsync(fd)) {
+#    endif // AVS_COMMONS_STREAM_FILE_FD_HAVE_FDATASYNC
+        return errno_error();
+    }
+    return AVS_OK;
+}
+
+/**
+ * Synchronizes the directory containing @p path, so that a rename performed on
+ * it survives a crash. Not all filesystems support that, so failures to sync
+ * are not treated as errors.
+ */
+static void sync_parent_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    char *dir_path = NULL;
+    int fd;
+    if (!slash) {
+        fd = open(".", O_RDONLY);
+    } else {
+        size_t length = (slash == path) ? 1 : (size_t) (slash - path);
+        if (!(dir_path = (char *) avs_malloc(length + 1))) {
+            return;
+        }
+        memcpy(dir_path, path, length);
+        dir_path[length] = '\0';
+        fd = open(dir_path, O_RDONLY);
+    }
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    avs_free(dir_path);
+}
+
+static avs_error_t truncate_preallocated(file_fd_stream_t *file) {
+    if (file->preallocated_size > file->offset
+            && ftruncate(file->fd, (off_t) file->offset)) {
+        return errno_error();
+    }
+    file->preallocated_size = 0;
+    return AVS_OK;
+}
+
+static avs_error_t
+stream_file_fd_write_some(avs_stream_t *stream_,
+                          const void *buffer,
+                          size_t *inout_data_length) {
+    file_fd_stream_t *file = (file_fd_stream_t *) stream_;
+    if (file->committed) {
+        return avs_errno(AVS_EBADF);
+    }
+    const char *data = (const char *) buffer;
+    size_t left = *inout_data_length;
+    avs_error_t err = AVS_OK;
+
+    // on failure, *inout_data_length is set to the number of bytes that were
+    // accepted (either written or buffered), i.e. by how much the offset moved
+    if (file->buffer_used > 0) {
+        size_t chunk = AVS_MIN(left, file->buffer_size - file->buffer_used);
+        memcpy(file->buffer + file->buffer_used, data, chunk);
+        file->buffer_used += chunk;
+        file->offset += (avs_off_t) chunk;
+        data += chunk;
+        left -= chunk;
+        if (file->buffer_used == file->buffer_size
+                && avs_is_err((err = flush_buffer(file)))) {
+            goto finish;
+        }
+    }
+    if (left >= file->buffer_size) {
+        // keep writes aligned to multiples of the buffer size
+        size_t direct = left - left % file->buffer_size;
+        size_t written;
+        err = write_all(file->fd, data, direct, &written);
+        file->offset += (avs_off_t) written;
+        data += written;
+        left -= written;
+        if (avs_is_err(err)) {
+            goto finish;
+        }
+    }
+    if (left > 0) {
+        memcpy(file->buffer, data, left);
+        file->buffer_used = left;
+        file->offset += (avs_off_t) left;
+        left = 0;
+    }
+finish:
+    *inout_data_length -= left;
+    return err;
+}
+
+static avs_error_t stream_file_fd_finish_message(avs_stream_t *stream_) {
+    file_fd_stream_t *file = (file_fd_stream_t *) stream_;
+    if (file->committed) {
+        return AVS_OK;
+    }
+    avs_error_t err;
+    if (avs_is_err((err = flush_buffer(file)))
+            || avs_is_err((err = truncate_preallocated(file)))) {
+        return err;
+    }
+    if (!file->tmp_path) {
+        return (file->flags & AVS_STREAM_FILE_FD_SYNC) ? sync_fd(file->fd)
+                                                        : AVS_OK;
+    }
+
+    if (avs_is_err((err = sync_fd(file->fd)))) {
+        return err;
+    }
+    int fd = file->fd;
+    file->fd = -1;
+    if (close(fd)) {
+        err = errno_error();
+    } else if (rename(file->tmp_path, file->path)) {
+        err = errno_error();
+    }
+    if (avs_is_err(err)) {
+        LOG(ERROR, _("could not commit ") "%s", file->path);
+        unlink(file->tmp_path);
+    } else if (file->flags & AVS_STREAM_FILE_FD_SYNC) {
+        sync_parent_dir(file->path);
+    }
+    file->committed = true;
+    return err;
+}
+
+static avs_error_t stream_file_fd_read(avs_stream_t *stream,
+                                       size_t *out_bytes_read,
+                                       bool *out_message_finished,
+                                       void *buffer,
+                                       size_t buffer_length) {
+    (void) stream;
+    (void) out_bytes_read;
+    (void) out_message_finished;
+    (void) buffer;
+    (void) buffer_length;
+    return avs_errno(AVS_EBADF);
+}
+
+static avs_error_t
+stream_file_fd_peek(avs_stream_t *stream, size_t offset, char *out_value) {
+    (void) stream;
+    (void) offset;
+    (void) out_value;
+    return avs_errno(AVS_EBADF);
+}
+
+static avs_error_t stream_file_fd_reset(avs_stream_t *stream) {
+    (void) stream;
+    return AVS_OK;
+}
+
+static avs_error_t stream_file_fd_close(avs_stream_t *stream_) {
+    file_fd_stream_t *file = (file_fd_stream_t *) stream_;
+    avs_error_t err = AVS_OK;
+    if (file->fd >= 0) {
+        if (file->tmp_path) {
+            // not committed - discard the data
+            unlink(file->tmp_path);
+        } else if (avs_is_ok((err = flush_buffer(file)))) {
+            err = truncate_preallocated(file);
+        }
+        if (close(file->fd) && avs_is_ok(err)) {
+            err = errno_error();
+        }
+        file->fd = -1;
+    }
+    avs_free(file->buffer);
+    avs_free(file->path);
+    avs_free(file->tmp_path);
+    return err;
+}
+
+static avs_error_t stream_file_fd_offset(avs_stream_t *stream,
+                                         avs_off_t *out_offset) {
+    *out_offset = ((file_fd_stream_t *) stream)->offset;
+    return AVS_OK;
+}
+
+static avs_error_t stream_file_fd_write_reserve(avs_stream_t *stream,
+                                                size_t size_hint,
+                                                void **out_ptr,
+                                                size_t *out_length) {
+    (void) size_hint;
+    file_fd_stream_t *file = (file_fd_stream_t *) stream;
+    if (file->committed) {
+        return avs_errno(AVS_EBADF);
+    }
+    *out_ptr = file->buffer + file->buffer_used;
+    *out_length = file->buffer_size - file->buffer_used;
+    return AVS_OK;
+}
+
+static avs_error_t stream_file_fd_write_commit(avs_stream_t *stream,
+                                               size_t length) {
+    file_fd_stream_t *file = (file_fd_stream_t *) stream;
+    assert(length <= file->buffer_size - file->buffer_used);
+    file->buffer_used += length;
+    file->offset += (avs_off_t) length;
+    if (file->buffer_used == file->buffer_size) {
+        return flush_buffer(file);
+    }
+    return AVS_OK;
+}
+
+static const avs_stream_v_table_t file_fd_stream_vtable = {
+    .write_some = stream_file_fd_write_some,
+    .finish_message = stream_file_fd_finish_message,
+    .read = stream_file_fd_read,
+    .peek = stream_file_fd_peek,
+    .reset = stream_file_fd_reset,
+    .close = stream_file_fd_close,
+    .extension_list =
+            (const avs_stream_v_table_extension_t[]) {
+                    { AVS_STREAM_V_TABLE_EXTENSION_OFFSET,
+                      &(const avs_stream_v_table_extension_offset_t) {
+                              stream_file_fd_offset } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW,
+                      &(const avs_stream_v_table_extension_write_window_t) {
+                              stream_file_fd_write_reserve,
+                              stream_file_fd_write_commit } },
+                    AVS_STREAM_V_TABLE_EXTENSION_NULL }
+};
+
+static void preallocate(file_fd_stream_t *file, avs_off_t size) {
+#    ifdef AVS_COMMONS_STREAM_FILE_FD_HAVE_POSIX_FALLOCATE
+    int result = posix_fallocate(file->fd, 0, (off_t) size);
+    if (result) {
+        // e.g. EOPNOTSUPP on filesystems that do not support it
+        LOG(DEBUG, _("posix_fallocate() failed: ") "%s", strerror(result));
+    } else {
+        file->preallocated_size = size;
+    }
+#    else  // AVS_COMMONS_STREAM_FILE_FD_HAVE_POSIX_FALLOCATE
+    (void) file;
+    (void) size;
+#    endif // AVS_COMMONS_STREAM_FILE_FD_HAVE_POSIX_FALLOCATE
+}
+
+static char *duplicate_path(const char *path, const char *suffix) {
+    size_t path_length = strlen(path);
+    size_t suffix_length = strlen(suffix);
+    char *result = (char *) avs_malloc(path_length + suffix_length + 1);
+    if (result) {
+        memcpy(result, path, path_length);
+        memcpy(result + path_length, suffix, suffix_length + 1);
+    }
+    return result;
+}
+
+avs_stream_t *avs_stream_file_fd_create(
+        const char *path, const avs_stream_file_fd_config_t *config) {
+    static const avs_stream_file_fd_config_t DEFAULT_CONFIG = { 0 };
+    if (!config) {
+        config = &DEFAULT_CONFIG;
+    }
+    if (config->preallocate_size < 0) {
+        LOG(ERROR, _("invalid preallocation size"));
+        return NULL;
+    }
+    file_fd_stream_t *file =
+            (file_fd_stream_t *) avs_calloc(1, sizeof(file_fd_stream_t));
+    if (!file) {
+        LOG_OOM();
+        return NULL;
+    }
+    const void *vtable = &file_fd_stream_vtable;
+    memcpy((void *) (intptr_t) &file->vtable, &vtable, sizeof(void *));
+    const char *open_path;
+    file->fd = -1;
+    file->flags = config->flags;
+    file->buffer_size = config->write_buffer_size
+                                ? config->write_buffer_size
+                                : AVS_STREAM_FILE_FD_DEFAULT_WRITE_BUFFER_SIZE;
+    if (!(file->buffer = (char *) avs_malloc(file->buffer_size))
+            || !(file->path = duplicate_path(path, ""))
+            || ((config->flags & AVS_STREAM_FILE_FD_ATOMIC)
+                && !(file->tmp_path = duplicate_path(path, TMP_SUFFIX)))) {
+        LOG_OOM();
+        goto error;
+    }
+
+    open_path = file->tmp_path ? file->tmp_path : file->path;
+    do {
+        file->fd = open(open_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    } while (file->fd < 0 && errno == EINTR);
+    if (file->fd < 0) {
+        LOG(ERROR, _("could not open ") "%s", open_path);
+        goto error;
+    }
+    if (config->preallocate_size > 0) {
+        preallocate(file, config->preallocate_size);
+    }
+    return (avs_stream_t *) file;
+error:
+    avs_free(file->buffer);
+    avs_free(file->path);
+    avs_free(file->tmp_path);
+    avs_free(file);
+    return NULL;
+}
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/stream/test_stream_file_fd.c"
+#    endif // AVS_UNIT_TESTING
+
+#endif // defined(AVS_COMMONS_WITH_AVS_STREAM) &&
+       // defined(AVS_COMMONS_STREAM_WITH_FILE) &&
+       // defined(AVS_COMMONS_STREAM_WITH_FILE_FD)
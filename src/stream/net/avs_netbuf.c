@@ -20,6 +20,7 @@
         && defined(AVS_COMMONS_WITH_AVS_BUFFER) \
         && defined(AVS_COMMONS_WITH_AVS_NET)
 
+#    include <assert.h>
 #    include <stdio.h>
 #    include <string.h>
 
@@ -80,6 +81,92 @@ static avs_error_t buffered_netstream_write_some(avs_stream_t *stream_,
     }
 }
 
+static avs_error_t buffered_netstream_write_reserve(avs_stream_t *stream_,
+                                                    size_t size_hint,
+                                                    void **out_ptr,
+                                                    size_t *out_length) {
+    (void) size_hint;
+    buffered_netstream_t *stream = (buffered_netstream_t *) stream_;
+    *out_ptr = avs_buffer_raw_insert_ptr(stream->out_buffer);
+    *out_length = avs_buffer_space_left(stream->out_buffer);
+    return AVS_OK;
+}
+
+static avs_error_t buffered_netstream_write_commit(avs_stream_t *stream_,
+                                                   size_t length) {
+    buffered_netstream_t *stream = (buffered_netstream_t *) stream_;
+    if (avs_buffer_advance_ptr(stream->out_buffer, length)) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (length && avs_buffer_space_left(stream->out_buffer) == 0) {
+        return out_buffer_flush(stream);
+    }
+    return AVS_OK;
+}
+
+/* Number of data blocks that buffered_netstream_writev() keeps on stack */
+#    define NETBUF_STACK_IOV_COUNT 8
+
+static avs_error_t send_sequentially(buffered_netstream_t *stream,
+                                     const avs_iovec_t *iov,
+                                     size_t iov_count) {
+    avs_error_t err = out_buffer_flush(stream);
+    for (size_t i = 0; avs_is_ok(err) && i < iov_count; ++i) {
+        if (iov[i].length) {
+            err = avs_net_socket_send(stream->socket, iov[i].base,
+                                      iov[i].length);
+        }
+    }
+    return err;
+}
+
+static avs_error_t buffered_netstream_writev(avs_stream_t *stream_,
+                                             const avs_iovec_t *iov,
+                                             size_t iov_count) {
+    buffered_netstream_t *stream = (buffered_netstream_t *) stream_;
+    size_t space_left = avs_buffer_space_left(stream->out_buffer);
+    size_t total_length = 0;
+    for (size_t i = 0; i < iov_count; ++i) {
+        total_length += iov[i].length;
+    }
+    if (total_length <= space_left) {
+        for (size_t i = 0; i < iov_count; ++i) {
+            if (iov[i].length
+                    && avs_buffer_append_bytes(stream->out_buffer, iov[i].base,
+                                               iov[i].length)) {
+                return avs_errno(AVS_ENOBUFS);
+            }
+        }
+        if (total_length && total_length == space_left) {
+            return out_buffer_flush(stream);
+        }
+        return AVS_OK;
+    }
+
+    // send the already buffered data and the new blocks in a single call
+    avs_iovec_t stack_iov[NETBUF_STACK_IOV_COUNT];
+    avs_iovec_t *all_iov = stack_iov;
+    if (iov_count + 1 > AVS_ARRAY_SIZE(stack_iov)
+            && !(all_iov = (avs_iovec_t *) avs_malloc((iov_count + 1)
+                                                      * sizeof(*all_iov)))) {
+        return send_sequentially(stream, iov, iov_count);
+    }
+    all_iov[0].base = avs_buffer_data(stream->out_buffer);
+    all_iov[0].length = avs_buffer_data_size(stream->out_buffer);
+    memcpy(&all_iov[1], iov, iov_count * sizeof(*iov));
+    avs_error_t err =
+            avs_net_socket_sendv(stream->socket, all_iov, iov_count + 1);
+    if (all_iov != stack_iov) {
+        avs_free(all_iov);
+    }
+    if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ENOTSUP) {
+        return send_sequentially(stream, iov, iov_count);
+    } else if (avs_is_ok(err)) {
+        avs_buffer_reset(stream->out_buffer);
+    }
+    return err;
+}
+
 static size_t buffered_netstream_nonblock_write_ready(avs_stream_t *stream) {
     return avs_buffer_space_left(((buffered_netstream_t *) stream)->out_buffer);
 }
@@ -92,12 +179,17 @@ static void return_data_from_buffer(avs_buffer_t *in_buffer,
                                     size_t *out_bytes_read,
                                     void *buffer,
                                     size_t buffer_length) {
-    *out_bytes_read = avs_buffer_data_size(in_buffer);
-    if (buffer_length < *out_bytes_read) {
-        *out_bytes_read = buffer_length;
+    avs_iovec_t spans[2];
+    avs_buffer_data_spans(in_buffer, spans);
+    *out_bytes_read = 0;
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(spans); ++i) {
+        size_t chunk =
+                AVS_MIN(spans[i].length, buffer_length - *out_bytes_read);
+        if (chunk) {
+            memcpy((char *) buffer + *out_bytes_read, spans[i].base, chunk);
+            *out_bytes_read += chunk;
+        }
     }
-
-    memcpy(buffer, avs_buffer_data(in_buffer), *out_bytes_read);
     if (avs_buffer_consume_bytes(in_buffer, *out_bytes_read)) {
         AVS_UNREACHABLE();
     }
@@ -124,10 +216,17 @@ static avs_error_t in_buffer_read_some(buffered_netstream_t *stream,
         return avs_errno(AVS_ENOBUFS);
     }
 
-    avs_error_t err =
-            avs_net_socket_receive(stream->socket, out_bytes_read,
-                                   avs_buffer_raw_insert_ptr(in_buffer),
-                                   space_left);
+    // in_buffer is a ring buffer, so the data is normally never moved. However,
+    // the socket may be datagram-based, in which case receiving into just the
+    // first free span could truncate the datagram - so if the free space is
+    // split, make it contiguous first.
+    avs_buffer_span_t spans[2];
+    if (avs_buffer_free_spans(in_buffer, spans) > 1) {
+        spans[0].base = avs_buffer_raw_insert_ptr(in_buffer);
+        spans[0].length = space_left;
+    }
+    avs_error_t err = avs_net_socket_receive(stream->socket, out_bytes_read,
+                                             spans[0].base, spans[0].length);
     if (avs_is_ok(err)) {
         avs_buffer_advance_ptr(in_buffer, *out_bytes_read);
     }
@@ -263,27 +362,61 @@ static bool buffered_netstream_nonblock_read_ready(avs_stream_t *stream_) {
            && avs_buffer_data_size(stream->in_buffer) > 0;
 }
 
+static avs_error_t fill_in_buffer(buffered_netstream_t *stream,
+                                  size_t offset) {
+    if (offset >= avs_buffer_capacity(stream->in_buffer)) {
+        LOG(ERROR, _("cannot peek - buffer is too small"));
+        return avs_errno(AVS_EINVAL);
+    }
+    while (offset >= avs_buffer_data_size(stream->in_buffer)) {
+        size_t bytes_read;
+        avs_error_t err = in_buffer_read_some(stream, &bytes_read);
+        if (avs_is_err(err)) {
+            LOG(ERROR, _("cannot peek - read error"));
+            return err;
+        } else if (bytes_read == 0) {
+            LOG(ERROR, _("cannot peek - 0 bytes read"));
+            return AVS_EOF;
+        }
+    }
+    return AVS_OK;
+}
+
+static const char *in_buffer_window(buffered_netstream_t *stream,
+                                    size_t offset,
+                                    size_t *out_length) {
+    avs_iovec_t spans[2];
+    avs_buffer_data_spans(stream->in_buffer, spans);
+    size_t i = 0;
+    if (offset >= spans[0].length) {
+        offset -= spans[0].length;
+        i = 1;
+    }
+    assert(offset < spans[i].length);
+    *out_length = spans[i].length - offset;
+    return (const char *) spans[i].base + offset;
+}
+
 static avs_error_t
 buffered_netstream_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
     buffered_netstream_t *stream = (buffered_netstream_t *) stream_;
-    if (offset < avs_buffer_capacity(stream->in_buffer)) {
-        while (offset >= avs_buffer_data_size(stream->in_buffer)) {
-            size_t bytes_read;
-            avs_error_t err = in_buffer_read_some(stream, &bytes_read);
-            if (avs_is_err(err)) {
-                LOG(ERROR, _("cannot peek - read error"));
-                return err;
-            } else if (bytes_read == 0) {
-                LOG(ERROR, _("cannot peek - 0 bytes read"));
-                return AVS_EOF;
-            }
-        }
-        *out_value = avs_buffer_data(stream->in_buffer)[offset];
-        return AVS_OK;
-    } else {
-        LOG(ERROR, _("cannot peek - buffer is too small"));
-        return avs_errno(AVS_EINVAL);
+    avs_error_t err = fill_in_buffer(stream, offset);
+    if (avs_is_ok(err)) {
+        *out_value = *in_buffer_window(stream, offset, &(size_t) { 0 });
+    }
+    return err;
+}
+
+static avs_error_t buffered_netstream_peek_window(avs_stream_t *stream_,
+                                                  size_t offset,
+                                                  const char **out_data,
+                                                  size_t *out_length) {
+    buffered_netstream_t *stream = (buffered_netstream_t *) stream_;
+    avs_error_t err = fill_in_buffer(stream, offset);
+    if (avs_is_ok(err)) {
+        *out_data = in_buffer_window(stream, offset, out_length);
     }
+    return err;
 }
 
 static avs_error_t buffered_netstream_reset(avs_stream_t *stream_) {
@@ -334,6 +467,16 @@ static const avs_stream_v_table_t buffered_netstream_vtable = {
                       &(const avs_stream_v_table_extension_nonblock_t) {
                               buffered_netstream_nonblock_read_ready,
                               buffered_netstream_nonblock_write_ready } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+                      &(const avs_stream_v_table_extension_read_window_t) {
+                              buffered_netstream_peek_window } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_WRITE_WINDOW,
+                      &(const avs_stream_v_table_extension_write_window_t) {
+                              buffered_netstream_write_reserve,
+                              buffered_netstream_write_commit } },
+                    { AVS_STREAM_V_TABLE_EXTENSION_WRITEV,
+                      &(const avs_stream_v_table_extension_writev_t) {
+                              buffered_netstream_writev } },
                     AVS_STREAM_V_TABLE_EXTENSION_NULL }
 };
 
@@ -355,7 +498,7 @@ int avs_stream_netbuf_create(avs_stream_t **stream_,
             &buffered_netstream_vtable;
 
     stream->socket = socket;
-    if (avs_buffer_create(&stream->in_buffer, in_buffer_size)) {
+    if (avs_buffer_create_ring(&stream->in_buffer, in_buffer_size)) {
         LOG(ERROR, _("cannot create input buffer"));
         goto buffered_netstream_create_error;
     }
@@ -397,9 +540,12 @@ int avs_stream_netbuf_transfer(avs_stream_t *destination_,
                             avs_buffer_data_size(source->out_buffer));
     avs_buffer_reset(source->out_buffer);
 
-    avs_buffer_append_bytes(destination->in_buffer,
-                            avs_buffer_data(source->in_buffer),
-                            avs_buffer_data_size(source->in_buffer));
+    avs_iovec_t spans[2];
+    avs_buffer_data_spans(source->in_buffer, spans);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(spans); ++i) {
+        avs_buffer_append_bytes(destination->in_buffer, spans[i].base,
+                                spans[i].length);
+    }
 
     avs_buffer_reset(source->in_buffer);
 
@@ -425,6 +571,10 @@ void avs_stream_netbuf_set_recv_timeout(avs_stream_t *str,
                            timeout_opt);
 }
 
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/stream/test_stream_netbuf.c"
+#    endif
+
 #endif // defined(AVS_COMMONS_WITH_AVS_STREAM) &&
        // defined(AVS_COMMONS_WITH_AVS_BUFFER) &&
        // defined(AVS_COMMONS_WITH_AVS_NET)
@@ -23,6 +23,15 @@
 VISIBILITY_SOURCE_BEGIN
 
 void avs_cleanup_global_state(void) {
+#    if defined(AVS_COMMONS_WITH_AVS_CRYPTO)                  \
+            && defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE) \
+            && !defined(AVS_COMMONS_WITHOUT_TLS)
+    void _avs_crypto_pki_cache_cleanup_global_state(void);
+    _avs_crypto_pki_cache_cleanup_global_state();
+#    endif // defined(AVS_COMMONS_WITH_AVS_CRYPTO) &&
+           // defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE) &&
+           // !defined(AVS_COMMONS_WITHOUT_TLS)
+
 #    if defined(AVS_COMMONS_WITH_AVS_CRYPTO) \
             && !defined(AVS_COMMONS_WITHOUT_TLS)
     void _avs_crypto_cleanup_global_state(void);
@@ -96,12 +96,10 @@ AVS_UNIT_TEST(byte_buffer, defragment) {
     AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_size(buffer), 2);
     AVS_UNIT_ASSERT_EQUAL(avs_buffer_data(buffer)[0], 0xFF);
     AVS_UNIT_ASSERT_EQUAL(avs_buffer_data(buffer)[1], 0xFF);
-    AVS_UNIT_ASSERT_NOT_EQUAL((intptr_t) buffer->begin,
-                              (intptr_t) buffer->data.data);
+    AVS_UNIT_ASSERT_NOT_EQUAL(buffer->begin, 0);
 
     defragment_buffer(buffer);
-    AVS_UNIT_ASSERT_EQUAL((intptr_t) buffer->begin,
-                          (intptr_t) buffer->data.data);
+    AVS_UNIT_ASSERT_EQUAL(buffer->begin, 0);
     AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_size(buffer), 2);
     AVS_UNIT_ASSERT_EQUAL(avs_buffer_data(buffer)[0], 0xFF);
     AVS_UNIT_ASSERT_EQUAL(avs_buffer_data(buffer)[1], 0xFF);
@@ -117,8 +115,7 @@ AVS_UNIT_TEST(byte_buffer, raw_insert_ptr) {
     AVS_UNIT_ASSERT_SUCCESS(avs_buffer_fill_bytes(buffer, 0, 2));
     AVS_UNIT_ASSERT_SUCCESS(avs_buffer_consume_bytes(buffer, 2));
     AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_size(buffer), 0);
-    AVS_UNIT_ASSERT_NOT_EQUAL((intptr_t) buffer->end,
-                              (intptr_t) buffer->data.data);
+    AVS_UNIT_ASSERT_NOT_EQUAL(end_offset(buffer), 0);
 
     AVS_UNIT_ASSERT_NOT_EQUAL(avs_buffer_space_left(buffer),
                               space_left_without_moving(buffer));
@@ -220,3 +217,102 @@ AVS_UNIT_TEST(byte_buffer, fill_bytes) {
 
     avs_buffer_free(&buffer);
 }
+
+AVS_UNIT_TEST(byte_buffer, ring_wraps_without_moving) {
+    avs_buffer_t *buffer;
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_create_ring(&buffer, 8));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_append_bytes(buffer, "abcdef", 6));
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_consume_bytes(buffer, 4));
+    const char *data_before = avs_buffer_data(buffer);
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_append_bytes(buffer, "ghijk", 5));
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_size(buffer), 7);
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_space_left(buffer), 1);
+
+    avs_iovec_t spans[2];
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_spans(buffer, spans), 2);
+    AVS_UNIT_ASSERT_TRUE(spans[0].base == data_before);
+    AVS_UNIT_ASSERT_EQUAL(spans[0].length, 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(spans[0].base, "efgh", 4);
+    AVS_UNIT_ASSERT_EQUAL(spans[1].length, 3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(spans[1].base, "ijk", 3);
+
+    // contiguous access requires explicit linearization
+    const char *linear_data = avs_buffer_linearize(buffer);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(linear_data, "efghijk", 7);
+    AVS_UNIT_ASSERT_TRUE(avs_buffer_data(buffer) == linear_data);
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_spans(buffer, spans), 1);
+    AVS_UNIT_ASSERT_EQUAL(spans[0].length, 7);
+    // already contiguous data is not moved again
+    AVS_UNIT_ASSERT_TRUE(avs_buffer_linearize(buffer) == linear_data);
+
+    avs_buffer_free(&buffer);
+}
+
+AVS_UNIT_TEST(byte_buffer, ring_free_spans) {
+    avs_buffer_t *buffer;
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_create_ring(&buffer, 8));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_fill_bytes(buffer, 'x', 5));
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_consume_bytes(buffer, 3));
+
+    avs_buffer_span_t spans[2];
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_free_spans(buffer, spans), 2);
+    AVS_UNIT_ASSERT_EQUAL(spans[0].length, 3);
+    AVS_UNIT_ASSERT_EQUAL(spans[1].length, 3);
+    memcpy(spans[0].base, "abc", 3);
+    memcpy(spans[1].base, "def", 3);
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_advance_ptr(buffer, 6));
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_space_left(buffer), 0);
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_free_spans(buffer, spans), 0);
+
+    char out[8];
+    avs_iovec_t data_spans[2];
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_spans(buffer, data_spans), 2);
+    memcpy(out, data_spans[0].base, data_spans[0].length);
+    memcpy(out + data_spans[0].length, data_spans[1].base,
+           data_spans[1].length);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(out, "xxabcdef", 8);
+
+    // consuming everything rewinds the buffer
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_consume_bytes(buffer, 8));
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_free_spans(buffer, spans), 1);
+    AVS_UNIT_ASSERT_EQUAL(spans[0].length, 8);
+
+    avs_buffer_free(&buffer);
+}
+
+AVS_UNIT_TEST(byte_buffer, ring_raw_insert_ptr) {
+    avs_buffer_t *buffer;
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_create_ring(&buffer, 8));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_append_bytes(buffer, "abcdef", 6));
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_consume_bytes(buffer, 4));
+    // free space is split, so it needs to be made contiguous
+    char *insert_ptr = avs_buffer_raw_insert_ptr(buffer);
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_space_left(buffer), 6);
+    memcpy(insert_ptr, "ghijkl", 6);
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_advance_ptr(buffer, 6));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(avs_buffer_data(buffer), "efghijkl", 8);
+
+    avs_buffer_free(&buffer);
+}
+
+AVS_UNIT_TEST(byte_buffer, linear_spans) {
+    avs_buffer_t *buffer;
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_create(&buffer, 8));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_append_bytes(buffer, "abcdef", 6));
+    AVS_UNIT_ASSERT_SUCCESS(avs_buffer_consume_bytes(buffer, 4));
+
+    avs_buffer_span_t spans[2];
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_free_spans(buffer, spans), 1);
+    AVS_UNIT_ASSERT_EQUAL(spans[0].length, 6);
+    AVS_UNIT_ASSERT_EQUAL(spans[1].length, 0);
+
+    avs_iovec_t data_spans[2];
+    AVS_UNIT_ASSERT_EQUAL(avs_buffer_data_spans(buffer, data_spans), 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data_spans[0].base, "ef", 2);
+
+    avs_buffer_free(&buffer);
+}
@@ -22,6 +22,7 @@
 #include <openssl/ssl.h>
 
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "../pki.h"
@@ -260,3 +261,156 @@ AVS_UNIT_TEST(backend_openssl, key_loading_from_null) {
     AVS_UNIT_ASSERT_NULL(key);
 #endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_ENGINE
 }
+
+#ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
+static void *read_file(const char *filename, size_t *out_size) {
+    FILE *f = fopen(filename, "rb");
+    AVS_UNIT_ASSERT_NOT_NULL(f);
+    AVS_UNIT_ASSERT_SUCCESS(fseek(f, 0, SEEK_END));
+    long size = ftell(f);
+    AVS_UNIT_ASSERT_TRUE(size > 0);
+    AVS_UNIT_ASSERT_SUCCESS(fseek(f, 0, SEEK_SET));
+    void *data = avs_malloc((size_t) size);
+    AVS_UNIT_ASSERT_NOT_NULL(data);
+    AVS_UNIT_ASSERT_EQUAL(fread(data, 1, (size_t) size, f), size);
+    fclose(f);
+    *out_size = (size_t) size;
+    return data;
+}
+
+static void write_file(const char *filename, const void *data, size_t size) {
+    FILE *f = fopen(filename, "wb");
+    AVS_UNIT_ASSERT_NOT_NULL(f);
+    AVS_UNIT_ASSERT_EQUAL(fwrite(data, 1, size, f), size);
+    AVS_UNIT_ASSERT_SUCCESS(fclose(f));
+}
+
+static X509 *load_cert(const avs_crypto_certificate_chain_info_t *info) {
+    X509 *cert = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_crypto_openssl_load_first_client_cert(&cert, info));
+    AVS_UNIT_ASSERT_NOT_NULL(cert);
+    return cert;
+}
+
+AVS_UNIT_TEST(backend_openssl, cache_buffer) {
+    size_t size;
+    unsigned char *data = (unsigned char *) read_file("../certs/root.crt.der",
+                                                      &size);
+    const avs_crypto_certificate_chain_info_t info =
+            avs_crypto_certificate_chain_info_from_buffer(data, size);
+
+    X509 *cert1 = load_cert(&info);
+    X509 *cert2 = load_cert(&info);
+    AVS_UNIT_ASSERT_TRUE(cert1 == cert2);
+
+    // the last byte is part of the signature, so the result is still parseable
+    data[size - 1] ^= 0xFF;
+    X509 *cert3 = load_cert(&info);
+    AVS_UNIT_ASSERT_TRUE(cert3 != cert1);
+    AVS_UNIT_ASSERT_NOT_EQUAL(X509_cmp(cert3, cert1), 0);
+
+    // the same source contained in an array is a different cache entry, but
+    // invalidating a source drops all the entries referencing it
+    const avs_crypto_certificate_chain_info_t array =
+            avs_crypto_certificate_chain_info_from_array(&info, 1);
+    X509 *cert4 = load_cert(&array);
+    avs_crypto_pki_cache_invalidate_certificate_chain(&info);
+    X509 *cert5 = load_cert(&info);
+    X509 *cert6 = load_cert(&array);
+    AVS_UNIT_ASSERT_TRUE(cert5 != cert3);
+    AVS_UNIT_ASSERT_TRUE(cert6 != cert4);
+    AVS_UNIT_ASSERT_EQUAL(X509_cmp(cert5, cert3), 0);
+
+    X509_free(cert1);
+    X509_free(cert2);
+    X509_free(cert3);
+    X509_free(cert4);
+    X509_free(cert5);
+    X509_free(cert6);
+    avs_free(data);
+    avs_crypto_pki_cache_invalidate_all();
+}
+
+AVS_UNIT_TEST(backend_openssl, cache_file) {
+    char filename[] = "/tmp/test_pki_cache-XXXXXX";
+    int fd = mkstemp(filename);
+    AVS_UNIT_ASSERT_TRUE(fd >= 0);
+    close(fd);
+
+    size_t root_size;
+    void *root = read_file("../certs/root.crt", &root_size);
+    size_t client_size;
+    void *client = read_file("../certs/client.crt", &client_size);
+    AVS_UNIT_ASSERT_NOT_EQUAL(root_size, client_size);
+
+    const avs_crypto_certificate_chain_info_t info =
+            avs_crypto_certificate_chain_info_from_file(filename);
+    write_file(filename, root, root_size);
+    X509 *cert1 = load_cert(&info);
+    X509 *cert2 = load_cert(&info);
+    AVS_UNIT_ASSERT_TRUE(cert1 == cert2);
+
+    write_file(filename, client, client_size);
+    X509 *cert3 = load_cert(&info);
+    AVS_UNIT_ASSERT_TRUE(cert3 != cert1);
+    AVS_UNIT_ASSERT_NOT_EQUAL(X509_cmp(cert3, cert1), 0);
+
+    avs_crypto_pki_cache_invalidate_all();
+    X509 *cert4 = load_cert(&info);
+    AVS_UNIT_ASSERT_TRUE(cert4 != cert3);
+    AVS_UNIT_ASSERT_EQUAL(X509_cmp(cert4, cert3), 0);
+
+    // removed file is not served from the cache
+    unlink(filename);
+    X509 *cert = NULL;
+    AVS_UNIT_ASSERT_FAILED(
+            _avs_crypto_openssl_load_first_client_cert(&cert, &info));
+
+    X509_free(cert1);
+    X509_free(cert2);
+    X509_free(cert3);
+    X509_free(cert4);
+    avs_free(root);
+    avs_free(client);
+    avs_crypto_pki_cache_invalidate_all();
+}
+
+#    ifdef AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT_MTIM
+static void set_mtime(const char *filename, time_t sec, long nsec) {
+    const struct timespec times[2] = {
+        { .tv_sec = sec, .tv_nsec = nsec }, { .tv_sec = sec, .tv_nsec = nsec }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(utimensat(AT_FDCWD, filename, times, 0));
+}
+
+AVS_UNIT_TEST(backend_openssl, cache_file_subsecond_mtime) {
+    char filename[] = "/tmp/test_pki_cache-XXXXXX";
+    int fd = mkstemp(filename);
+    AVS_UNIT_ASSERT_TRUE(fd >= 0);
+    close(fd);
+
+    size_t root_size;
+    void *root = read_file("../certs/root.crt", &root_size);
+    write_file(filename, root, root_size);
+
+    const avs_crypto_certificate_chain_info_t info =
+            avs_crypto_certificate_chain_info_from_file(filename);
+    const time_t now = time(NULL);
+    set_mtime(filename, now, 1000);
+    X509 *cert1 = load_cert(&info);
+
+    // same size and same second, only the sub-second part differs
+    set_mtime(filename, now, 2000);
+    X509 *cert2 = load_cert(&info);
+    AVS_UNIT_ASSERT_TRUE(cert2 != cert1);
+    AVS_UNIT_ASSERT_EQUAL(X509_cmp(cert2, cert1), 0);
+
+    unlink(filename);
+    X509_free(cert1);
+    X509_free(cert2);
+    avs_free(root);
+    avs_crypto_pki_cache_invalidate_all();
+}
+#    endif // AVS_COMMONS_CRYPTO_PKI_CACHE_HAVE_STAT_MTIM
+#endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI_CACHE
@@ -90,7 +90,7 @@ static void reset_everything(void) {
 AVS_UNIT_GLOBAL_INIT(verbose) {
     (void) verbose;
     AVS_UNIT_ASSERT_TRUE(g_log.handler.normal == default_log_handler);
-    AVS_UNIT_ASSERT_FALSE(g_log.is_extended_handler);
+    AVS_UNIT_ASSERT_EQUAL(g_log.handler_type, LOG_HANDLER_NORMAL);
 #ifndef AVS_LOGS_CHECKED_DURING_COMPILE_TIME
     AVS_UNIT_ASSERT_EQUAL(g_log.default_level, AVS_LOG_INFO);
     AVS_UNIT_ASSERT_TRUE(g_log.module_levels == NULL);
@@ -294,6 +294,47 @@ AVS_UNIT_TEST(log, module_levels) {
 #endif /*AVS_LOGS_CHECKED_DURING_COMPILE_TIME*/
 }
 
+#ifdef AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+AVS_UNIT_TEST(log, lockless_level_snapshot) {
+    avs_log_set_default_level(AVS_LOG_WARNING);
+    avs_log_set_level(stable_module, AVS_LOG_ERROR);
+    avs_log_set_level(debugged_module, AVS_LOG_DEBUG);
+
+    AVS_UNIT_ASSERT_EQUAL(atomic_load(&g_levels.min_level), AVS_LOG_DEBUG);
+    AVS_UNIT_ASSERT_NULL(g_levels.retired);
+    const level_snapshot_t *snapshot =
+            (const level_snapshot_t *) atomic_load(&g_levels.snapshot);
+    AVS_UNIT_ASSERT_NOT_NULL(snapshot);
+    AVS_UNIT_ASSERT_EQUAL(snapshot->default_level, AVS_LOG_WARNING);
+    AVS_UNIT_ASSERT_EQUAL(snapshot->module_count, 2);
+    AVS_UNIT_ASSERT_EQUAL_STRING(snapshot->modules[0].module,
+                                 "debugged_module");
+    AVS_UNIT_ASSERT_EQUAL(snapshot->modules[0].level, AVS_LOG_DEBUG);
+    AVS_UNIT_ASSERT_EQUAL_STRING(snapshot->modules[1].module, "stable_module");
+    AVS_UNIT_ASSERT_EQUAL(snapshot->modules[1].level, AVS_LOG_ERROR);
+
+    AVS_UNIT_ASSERT_FALSE(avs_log_should_log__(AVS_LOG_TRACE, "other_module"));
+    AVS_UNIT_ASSERT_FALSE(
+            avs_log_should_log__(AVS_LOG_TRACE, "debugged_module"));
+    AVS_UNIT_ASSERT_TRUE(
+            avs_log_should_log__(AVS_LOG_DEBUG, "debugged_module"));
+    AVS_UNIT_ASSERT_FALSE(
+            avs_log_should_log__(AVS_LOG_WARNING, "stable_module"));
+    AVS_UNIT_ASSERT_TRUE(avs_log_should_log__(AVS_LOG_ERROR, "stable_module"));
+    AVS_UNIT_ASSERT_FALSE(avs_log_should_log__(AVS_LOG_INFO, "other_module"));
+    AVS_UNIT_ASSERT_TRUE(avs_log_should_log__(AVS_LOG_WARNING, "other_module"));
+    AVS_UNIT_ASSERT_FALSE(avs_log_should_log__(AVS_LOG_INFO, NULL));
+    AVS_UNIT_ASSERT_TRUE(avs_log_should_log__(AVS_LOG_QUIET, "stable_module"));
+
+    reset_everything();
+    AVS_UNIT_ASSERT_EQUAL(atomic_load(&g_levels.min_level), AVS_LOG_INFO);
+    snapshot = (const level_snapshot_t *) atomic_load(&g_levels.snapshot);
+    AVS_UNIT_ASSERT_NOT_NULL(snapshot);
+    AVS_UNIT_ASSERT_EQUAL(snapshot->default_level, AVS_LOG_INFO);
+    AVS_UNIT_ASSERT_EQUAL(snapshot->module_count, 0);
+}
+#endif // AVS_LOG_WITH_LOCKLESS_LEVEL_CHECK
+
 static int fail(void) {
     AVS_UNIT_ASSERT_TRUE(0);
     return -1;
@@ -441,3 +482,105 @@ AVS_UNIT_TEST(log, extended) {
 #    define AVS_LOG_LEVEL_DEFAULT INFO
 #endif /*AVS_LOGS_CHECKED_DURING_COMPILE_TIME*/
 }
+
+#ifdef AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
+static const char *STRUCTURED_FORMAT;
+
+static void mock_structured_handler(avs_log_level_t level,
+                                    const char *module,
+                                    const char *file,
+                                    unsigned line,
+                                    const char *format,
+                                    const void *args,
+                                    size_t args_size) {
+    char message[sizeof(EXPECTED_MESSAGE)];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_render(message, sizeof(message), format, args, args_size));
+    AVS_UNIT_ASSERT_EQUAL_STRING(format, STRUCTURED_FORMAT);
+    mock_extended_handler(level, module, file, line, message);
+}
+
+AVS_UNIT_TEST(log, structured) {
+    avs_log_set_structured_handler(mock_structured_handler);
+
+    STRUCTURED_FORMAT = "test";
+    ASSERT_EXTENDED_LOG(test, INFO, __FILE__, __LINE__ + 1, "test");
+    avs_log(test, INFO, STRUCTURED_FORMAT);
+
+    STRUCTURED_FORMAT = "%s %d %.2f %c";
+    ASSERT_EXTENDED_LOG(test, ERROR, __FILE__, __LINE__ + 1, "test 2 3.14 x");
+    avs_log(test, ERROR, STRUCTURED_FORMAT, "test", 2, 3.14159, 'x');
+
+    // arguments too long to encode are passed as a formatted string
+    char long_string[AVS_COMMONS_LOG_MAX_LINE_LENGTH + 16];
+    memset(long_string, 'a', sizeof(long_string) - 1);
+    long_string[sizeof(long_string) - 1] = '\0';
+    char truncated[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+    snprintf(truncated, sizeof(truncated), "%.*s...",
+             AVS_COMMONS_LOG_MAX_LINE_LENGTH - 4, long_string);
+    STRUCTURED_FORMAT = "%s";
+    ASSERT_EXTENDED_LOG(test, WARNING, __FILE__, __LINE__ + 1, "%s", truncated);
+    avs_log(test, WARNING, "%s", long_string);
+
+    ASSERT_LOG_CLEAN;
+    reset_everything();
+}
+
+static void assert_render_matches(const char *format, ...) {
+    char args[256];
+    size_t args_size;
+    char expected[256];
+    char actual[256];
+    va_list ap;
+
+    va_start(ap, format);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_log_encode_args_v(args, sizeof(args), &args_size, format, ap));
+    vsnprintf(expected, sizeof(expected), format, ap);
+    va_end(ap);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_render(actual, sizeof(actual), format, args, args_size));
+    AVS_UNIT_ASSERT_EQUAL_STRING(actual, expected);
+
+    // every argument is required
+    if (args_size) {
+        AVS_UNIT_ASSERT_FAILED(avs_log_render(actual, sizeof(actual), format,
+                                              args, args_size - 1));
+    }
+}
+
+AVS_UNIT_TEST(log, structured_render) {
+    char args[16];
+    assert_render_matches("no arguments, 100%% literal");
+    assert_render_matches("%d %i %u %x %X %o", -1, 2, 3u, 0xabu, 0xcdu, 8u);
+    assert_render_matches("%hhd %hu %ld %lu %lld %llu", 1, 2, -3L, 4UL, -5LL,
+                          6ULL);
+    assert_render_matches("%jd %ju %zu %td", (intmax_t) -7, (uintmax_t) 8,
+                          (size_t) 9, (ptrdiff_t) -10);
+    assert_render_matches("%f %.3e %10.2g %a %Lf", 1.5, 2.5, 3.5, 4.0,
+                          (long double) 5.5);
+    assert_render_matches("[%5s] [%-5s] [%.2s] [%c]", "ab", "cd", "efgh", 'i');
+    assert_render_matches("[%*d] [%-*.*s] [%.*f]", 6, 42, 8, 3, "abcdef", 1,
+                          2.25);
+    assert_render_matches("%p %s", (void *) args, (const char *) NULL);
+    assert_render_matches("%+05d %#x % d", 12, 0x34u, 56);
+
+    // precision limits the number of characters read from the string
+    const char unterminated[3] = { 'a', 'b', 'c' };
+    assert_render_matches("%.3s", unterminated);
+
+    size_t args_size;
+    va_list empty_va_list;
+    memset(&empty_va_list, 0, sizeof(empty_va_list));
+    AVS_UNIT_ASSERT_FAILED(_avs_log_encode_args_v(
+            args, sizeof(args), &args_size, "%n", empty_va_list));
+    AVS_UNIT_ASSERT_FAILED(_avs_log_encode_args_v(
+            args, sizeof(args), &args_size, "%ls", empty_va_list));
+
+    char buf[8];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_render(buf, sizeof(buf), "truncated text", NULL, 0));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "truncat");
+}
+#endif // AVS_COMMONS_LOG_WITH_STRUCTURED_HANDLER
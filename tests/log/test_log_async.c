@@ -0,0 +1,205 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_posix_init.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <avsystem/commons/avs_log.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#define MAX_RECORDED 64
+
+static struct {
+    pthread_mutex_t mutex;
+    size_t count;
+    avs_log_level_t levels[MAX_RECORDED];
+    char messages[MAX_RECORDED][64];
+} g_recorded = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void recording_handler(avs_log_level_t level,
+                              const char *module,
+                              const char *file,
+                              unsigned line,
+                              const char *message) {
+    (void) module;
+    (void) file;
+    (void) line;
+    pthread_mutex_lock(&g_recorded.mutex);
+    if (g_recorded.count < MAX_RECORDED) {
+        g_recorded.levels[g_recorded.count] = level;
+        strncpy(g_recorded.messages[g_recorded.count], message,
+                sizeof(g_recorded.messages[0]) - 1);
+    }
+    ++g_recorded.count;
+    pthread_mutex_unlock(&g_recorded.mutex);
+}
+
+static size_t recorded_count(void) {
+    pthread_mutex_lock(&g_recorded.mutex);
+    size_t result = g_recorded.count;
+    pthread_mutex_unlock(&g_recorded.mutex);
+    return result;
+}
+
+static void reset_recorded(void) {
+    avs_log_reset();
+    avs_log_set_extended_handler(recording_handler);
+    avs_log_set_default_level(AVS_LOG_TRACE);
+    memset(g_recorded.levels, 0, sizeof(g_recorded.levels));
+    memset(g_recorded.messages, 0, sizeof(g_recorded.messages));
+    g_recorded.count = 0;
+}
+
+AVS_UNIT_TEST(log_async, drop) {
+    reset_recorded();
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_async_enable(3, AVS_LOG_ASYNC_OVERFLOW_DROP));
+    AVS_UNIT_ASSERT_FAILED(
+            avs_log_async_enable(3, AVS_LOG_ASYNC_OVERFLOW_DROP));
+    for (int i = 0; i < 10; ++i) {
+        avs_log(test, INFO, "message %d", i);
+    }
+    // capacity is rounded up to 4
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(), 0);
+    AVS_UNIT_ASSERT_EQUAL(avs_log_async_dropped(), 6);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_flush());
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(), 4);
+    for (int i = 0; i < 4; ++i) {
+        char expected[16];
+        sprintf(expected, "message %d", i);
+        AVS_UNIT_ASSERT_EQUAL_STRING(g_recorded.messages[i], expected);
+    }
+
+    avs_log_async_disable();
+    AVS_UNIT_ASSERT_FAILED(avs_log_async_flush());
+    avs_log(test, INFO, "synchronous");
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(), 5);
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_recorded.messages[4], "synchronous");
+}
+
+AVS_UNIT_TEST(log_async, count) {
+    reset_recorded();
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_async_enable(2, AVS_LOG_ASYNC_OVERFLOW_COUNT));
+    for (int i = 0; i < 5; ++i) {
+        avs_log(test, INFO, "message %d", i);
+    }
+    AVS_UNIT_ASSERT_EQUAL(avs_log_async_dropped(), 3);
+    avs_log_async_disable();
+
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(), 3);
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_recorded.messages[0], "message 0");
+    AVS_UNIT_ASSERT_EQUAL(g_recorded.levels[1], AVS_LOG_WARNING);
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_recorded.messages[1],
+                                 "3 log messages dropped");
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_recorded.messages[2], "message 1");
+}
+
+AVS_UNIT_TEST(log_async, block_without_drain_thread) {
+    reset_recorded();
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_async_enable(2, AVS_LOG_ASYNC_OVERFLOW_BLOCK));
+    for (int i = 0; i < 5; ++i) {
+        avs_log(test, INFO, "message %d", i);
+    }
+    // the oldest messages had to be delivered by the logging thread itself
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(), 3);
+    AVS_UNIT_ASSERT_EQUAL(avs_log_async_dropped(), 0);
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_flush());
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(), 5);
+    for (int i = 0; i < 5; ++i) {
+        char expected[16];
+        sprintf(expected, "message %d", i);
+        AVS_UNIT_ASSERT_EQUAL_STRING(g_recorded.messages[i], expected);
+    }
+    avs_log_async_disable();
+}
+
+#define PRODUCER_COUNT 4
+#define MESSAGES_PER_PRODUCER 1000
+
+static void *drain_thread(void *unused) {
+    (void) unused;
+    avs_log_async_run();
+    return NULL;
+}
+
+static void *producer_thread(void *unused) {
+    (void) unused;
+    for (int i = 0; i < MESSAGES_PER_PRODUCER; ++i) {
+        avs_log(test, DEBUG, "message %d", i);
+    }
+    return NULL;
+}
+
+AVS_UNIT_TEST(log_async, drain_thread) {
+    reset_recorded();
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_async_enable(8, AVS_LOG_ASYNC_OVERFLOW_BLOCK));
+
+    pthread_t drain;
+    AVS_UNIT_ASSERT_SUCCESS(pthread_create(&drain, NULL, drain_thread, NULL));
+    pthread_t producers[PRODUCER_COUNT];
+    for (size_t i = 0; i < PRODUCER_COUNT; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                pthread_create(&producers[i], NULL, producer_thread, NULL));
+    }
+    for (size_t i = 0; i < PRODUCER_COUNT; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(producers[i], NULL));
+    }
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_flush());
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(),
+                          PRODUCER_COUNT * MESSAGES_PER_PRODUCER);
+    AVS_UNIT_ASSERT_EQUAL(avs_log_async_dropped(), 0);
+
+    avs_log(test, DEBUG, "last message");
+    avs_log_async_disable();
+    AVS_UNIT_ASSERT_SUCCESS(pthread_join(drain, NULL));
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(),
+                          PRODUCER_COUNT * MESSAGES_PER_PRODUCER + 1);
+}
+
+AVS_UNIT_TEST(log_async, flush_and_disable_with_concurrent_producers) {
+    reset_recorded();
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_log_async_enable(8, AVS_LOG_ASYNC_OVERFLOW_BLOCK));
+
+    // no drain thread: records are delivered by the producers and by the
+    // flushing thread, which may find the oldest record not yet published
+    pthread_t producers[PRODUCER_COUNT];
+    for (size_t i = 0; i < PRODUCER_COUNT; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                pthread_create(&producers[i], NULL, producer_thread, NULL));
+    }
+    for (int i = 0; i < 100; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_log_async_flush());
+    }
+    // producers that are still running log synchronously after this returns
+    avs_log_async_disable();
+    for (size_t i = 0; i < PRODUCER_COUNT; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(producers[i], NULL));
+    }
+    AVS_UNIT_ASSERT_EQUAL(recorded_count(),
+                          PRODUCER_COUNT * MESSAGES_PER_PRODUCER);
+    AVS_UNIT_ASSERT_EQUAL(avs_log_async_dropped(), 0);
+}
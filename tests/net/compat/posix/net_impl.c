@@ -0,0 +1,172 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+#ifdef AVS_COMMONS_NET_WITH_IPV4
+// guaranteed not to resolve (RFC 6761, section 6.4)
+#    define UNRESOLVABLE_HOST "resolve-cache.invalid"
+#    define OTHER_UNRESOLVABLE_HOST "other.resolve-cache.invalid"
+
+typedef struct {
+    avs_net_socket_t *receiver;
+    char receiver_port[NET_PORT_SIZE];
+    avs_net_socket_t *socket;
+    net_socket_impl_t *impl;
+} resolve_cache_env_t;
+
+static resolve_cache_env_t create_resolve_cache_env(size_t cache_size,
+                                                    avs_time_duration_t ttl) {
+    resolve_cache_env_t env;
+    memset(&env, 0, sizeof(env));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&env.receiver, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(env.receiver, "127.0.0.1", "0"));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            env.receiver, env.receiver_port, sizeof(env.receiver_port)));
+
+    avs_net_socket_configuration_t config = {
+        .resolve_cache_size = cache_size,
+        .resolve_cache_ttl = ttl
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&env.socket, &config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_bind(env.socket, "127.0.0.1", "0"));
+    env.impl = (net_socket_impl_t *) env.socket;
+    return env;
+}
+
+static void destroy_resolve_cache_env(resolve_cache_env_t *env) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&env->socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&env->receiver));
+}
+
+/**
+ * Sends to "localhost", so that the receiver's address gets cached, and makes
+ * @p host an alias for it, as if it had been resolved before and stopped
+ * resolving since.
+ */
+static void cache_unresolvable_host(resolve_cache_env_t *env,
+                                    const char *host) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send_to(
+            env->socket, "x", 1, "localhost", env->receiver_port));
+    AVS_UNIT_ASSERT_NOT_EQUAL(env->impl->resolve_cache_count, 0);
+    AVS_UNIT_ASSERT_EQUAL_STRING(env->impl->resolve_cache[0].host,
+                                 "localhost");
+    sockaddr_endpoint_union_t address = env->impl->resolve_cache[0].address;
+    resolve_cache_store(env->impl, host, env->receiver_port, &address);
+}
+
+static avs_error_t send_to_host(resolve_cache_env_t *env, const char *host) {
+    return avs_net_socket_send_to(env->socket, "x", 1, host,
+                                  env->receiver_port);
+}
+
+static void assert_send_fails(resolve_cache_env_t *env, const char *host) {
+    avs_error_t err = send_to_host(env, host);
+    AVS_UNIT_ASSERT_TRUE(avs_is_err(err));
+}
+
+AVS_UNIT_TEST(resolve_cache, used_within_ttl) {
+    resolve_cache_env_t env = create_resolve_cache_env(
+            2, avs_time_duration_from_scalar(1, AVS_TIME_MIN));
+    assert_send_fails(&env, UNRESOLVABLE_HOST);
+
+    cache_unresolvable_host(&env, UNRESOLVABLE_HOST);
+    AVS_UNIT_ASSERT_SUCCESS(send_to_host(&env, UNRESOLVABLE_HOST));
+    AVS_UNIT_ASSERT_SUCCESS(send_to_host(&env, UNRESOLVABLE_HOST));
+
+    // closing the socket flushes the cache
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_close(env.socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_bind(env.socket, "127.0.0.1", "0"));
+    assert_send_fails(&env, UNRESOLVABLE_HOST);
+
+    destroy_resolve_cache_env(&env);
+}
+
+AVS_UNIT_TEST(resolve_cache, expires_after_ttl) {
+    const avs_time_duration_t ttl =
+            avs_time_duration_from_scalar(10, AVS_TIME_S);
+    resolve_cache_env_t env = create_resolve_cache_env(2, ttl);
+
+    avs_time_monotonic_t before = avs_time_monotonic_now();
+    cache_unresolvable_host(&env, UNRESOLVABLE_HOST);
+    avs_time_monotonic_t after = avs_time_monotonic_now();
+    resolve_cache_entry_t *entry = &env.impl->resolve_cache[0];
+    AVS_UNIT_ASSERT_EQUAL_STRING(entry->host, UNRESOLVABLE_HOST);
+    AVS_UNIT_ASSERT_FALSE(avs_time_monotonic_before(
+            entry->expires, avs_time_monotonic_add(before, ttl)));
+    AVS_UNIT_ASSERT_FALSE(avs_time_monotonic_before(
+            avs_time_monotonic_add(after, ttl), entry->expires));
+    AVS_UNIT_ASSERT_SUCCESS(send_to_host(&env, UNRESOLVABLE_HOST));
+
+    // pretend that the TTL has just passed
+    env.impl->resolve_cache[0].expires = avs_time_monotonic_now();
+    assert_send_fails(&env, UNRESOLVABLE_HOST);
+    // the expired entry has been dropped
+    AVS_UNIT_ASSERT_EQUAL(env.impl->resolve_cache_count, 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(env.impl->resolve_cache[0].host,
+                                 "localhost");
+
+    destroy_resolve_cache_env(&env);
+}
+
+AVS_UNIT_TEST(resolve_cache, evicts_least_recently_used) {
+    resolve_cache_env_t env = create_resolve_cache_env(
+            3, avs_time_duration_from_scalar(1, AVS_TIME_MIN));
+    cache_unresolvable_host(&env, UNRESOLVABLE_HOST);
+    cache_unresolvable_host(&env, OTHER_UNRESOLVABLE_HOST);
+    AVS_UNIT_ASSERT_EQUAL(env.impl->resolve_cache_count, 3);
+
+    // OTHER_UNRESOLVABLE_HOST becomes the least recently used entry...
+    AVS_UNIT_ASSERT_SUCCESS(send_to_host(&env, UNRESOLVABLE_HOST));
+    AVS_UNIT_ASSERT_SUCCESS(send_to_host(&env, "localhost"));
+    // ...so caching another destination evicts it
+    char own_port[NET_PORT_SIZE];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            env.socket, own_port, sizeof(own_port)));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_to(env.socket, "x", 1, "localhost", own_port));
+    AVS_UNIT_ASSERT_EQUAL(env.impl->resolve_cache_count, 3);
+    assert_send_fails(&env, OTHER_UNRESOLVABLE_HOST);
+    AVS_UNIT_ASSERT_SUCCESS(send_to_host(&env, UNRESOLVABLE_HOST));
+
+    destroy_resolve_cache_env(&env);
+}
+#endif // AVS_COMMONS_NET_WITH_IPV4
+
+#ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON
+AVS_UNIT_TEST(resolve_cache, port_number_digits_only) {
+    uint16_t port;
+    AVS_UNIT_ASSERT_SUCCESS(parse_port_number("5683", &port));
+    AVS_UNIT_ASSERT_EQUAL(port, 5683);
+    AVS_UNIT_ASSERT_SUCCESS(parse_port_number("65535", &port));
+    AVS_UNIT_ASSERT_EQUAL(port, 65535);
+    AVS_UNIT_ASSERT_SUCCESS(parse_port_number("", &port));
+    AVS_UNIT_ASSERT_EQUAL(port, 0);
+    AVS_UNIT_ASSERT_SUCCESS(parse_port_number(NULL, &port));
+    AVS_UNIT_ASSERT_EQUAL(port, 0);
+
+    AVS_UNIT_ASSERT_FAILED(parse_port_number(" +80", &port));
+    AVS_UNIT_ASSERT_FAILED(parse_port_number("+80", &port));
+    AVS_UNIT_ASSERT_FAILED(parse_port_number("-1", &port));
+    AVS_UNIT_ASSERT_FAILED(parse_port_number("80 ", &port));
+    AVS_UNIT_ASSERT_FAILED(parse_port_number("0x50", &port));
+    AVS_UNIT_ASSERT_FAILED(parse_port_number("65536", &port));
+    AVS_UNIT_ASSERT_FAILED(parse_port_number("99999999999999999999", &port));
+}
+#endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_PTON
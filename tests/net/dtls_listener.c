@@ -0,0 +1,447 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+typedef struct {
+    avs_crypto_prng_ctx_t *prng_ctx;
+    avs_net_socket_t *listener_socket;
+    dtls_listener_t *listener;
+    avs_net_socket_t *client;
+} dtls_listener_env_t;
+
+static avs_net_dtls_listener_configuration_t
+default_config(avs_crypto_prng_ctx_t *prng_ctx) {
+    avs_net_dtls_listener_configuration_t config = {
+        .max_peers = 2,
+        .max_queued_datagrams = 2,
+        .max_datagram_size = 1500,
+        .connection_id_length = 4,
+        .cookie_lifetime = avs_time_duration_from_scalar(1, AVS_TIME_MIN),
+        .prng_ctx = prng_ctx
+    };
+    config.backend_configuration.address_family = AVS_NET_AF_INET4;
+    return config;
+}
+
+static avs_net_socket_t *create_client(avs_net_socket_t *listener_socket) {
+    char port[NET_PORT_SIZE];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(listener_socket, port, sizeof(port)));
+    avs_net_socket_t *client = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(client, "127.0.0.1", port));
+    return client;
+}
+
+static dtls_listener_env_t create_env(void) {
+    dtls_listener_env_t env = {
+        .prng_ctx = avs_crypto_prng_new(NULL, NULL)
+    };
+    AVS_UNIT_ASSERT_NOT_NULL(env.prng_ctx);
+    avs_net_dtls_listener_configuration_t config =
+            default_config(env.prng_ctx);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_dtls_listener_socket_create(&env.listener_socket,
+                                                &config));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(env.listener_socket, "127.0.0.1", NULL));
+    env.listener = (dtls_listener_t *) env.listener_socket;
+
+    env.client = create_client(env.listener_socket);
+    return env;
+}
+
+static void destroy_env(dtls_listener_env_t *env) {
+    avs_net_socket_cleanup(&env->client);
+    avs_net_socket_cleanup(&env->listener_socket);
+    avs_crypto_prng_free(&env->prng_ctx);
+}
+
+static size_t make_client_hello(unsigned char *out,
+                                uint16_t record_sequence,
+                                const unsigned char *cookie,
+                                size_t cookie_size) {
+    static const unsigned char TRAILER[] = {
+        0x00, 0x02, 0xC0, 0xA8, // cipher_suites
+        0x01, 0x00              // compression_methods
+    };
+    unsigned char *body = &out[DTLS_RECORD_HEADER_SIZE
+                               + DTLS_HANDSHAKE_HEADER_SIZE];
+    size_t body_size = 0;
+    body[body_size++] = DTLS_MAJOR_VERSION;
+    body[body_size++] = 253; // DTLS 1.2
+    memset(&body[body_size], 0x42, DTLS_RANDOM_SIZE);
+    body_size += DTLS_RANDOM_SIZE;
+    body[body_size++] = 0; // session_id
+    body[body_size++] = (unsigned char) cookie_size;
+    if (cookie_size) {
+        memcpy(&body[body_size], cookie, cookie_size);
+        body_size += cookie_size;
+    }
+    memcpy(&body[body_size], TRAILER, sizeof(TRAILER));
+    body_size += sizeof(TRAILER);
+
+    memset(out, 0, DTLS_RECORD_HEADER_SIZE + DTLS_HANDSHAKE_HEADER_SIZE);
+    out[0] = DTLS_CONTENT_TYPE_HANDSHAKE;
+    out[1] = DTLS_MAJOR_VERSION;
+    out[2] = DTLS_1_0_MINOR_VERSION;
+    write_u16(&out[DTLS_RECORD_HEADER_SIZE - 2],
+              (uint32_t) (DTLS_HANDSHAKE_HEADER_SIZE + body_size));
+    out[DTLS_RECORD_SEQUENCE_OFFSET + DTLS_RECORD_SEQUENCE_SIZE - 1] =
+            (unsigned char) record_sequence;
+    unsigned char *handshake = &out[DTLS_RECORD_HEADER_SIZE];
+    handshake[0] = DTLS_HANDSHAKE_CLIENT_HELLO;
+    write_u24(&handshake[1], (uint32_t) body_size);
+    write_u24(&handshake[9], (uint32_t) body_size);
+    return DTLS_RECORD_HEADER_SIZE + DTLS_HANDSHAKE_HEADER_SIZE + body_size;
+}
+
+static void send_client_hello(avs_net_socket_t *client,
+                              uint16_t record_sequence,
+                              const unsigned char *cookie,
+                              size_t cookie_size) {
+    unsigned char message[256];
+    size_t size =
+            make_client_hello(message, record_sequence, cookie, cookie_size);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, message, size));
+}
+
+static void receive_all(dtls_listener_env_t *env) {
+    AVS_UNIT_ASSERT_SUCCESS(receive_datagrams(
+            env->listener,
+            avs_time_monotonic_add(
+                    avs_time_monotonic_now(),
+                    avs_time_duration_from_scalar(1, AVS_TIME_S)),
+            NULL, NULL, NULL));
+}
+
+static void
+receive_hello_verify_request(avs_net_socket_t *client,
+                             uint16_t expected_record_sequence,
+                             unsigned char out_cookie[COOKIE_SIZE]) {
+    unsigned char message[256];
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(client, &size, message, sizeof(message)));
+    AVS_UNIT_ASSERT_EQUAL(size, HELLO_VERIFY_REQUEST_SIZE);
+    AVS_UNIT_ASSERT_EQUAL(message[0], DTLS_CONTENT_TYPE_HANDSHAKE);
+    AVS_UNIT_ASSERT_EQUAL(message[1], DTLS_MAJOR_VERSION);
+    AVS_UNIT_ASSERT_EQUAL(message[2], DTLS_1_0_MINOR_VERSION);
+    AVS_UNIT_ASSERT_EQUAL(
+            message[DTLS_RECORD_SEQUENCE_OFFSET + DTLS_RECORD_SEQUENCE_SIZE
+                    - 1],
+            (unsigned char) expected_record_sequence);
+    const unsigned char *handshake = &message[DTLS_RECORD_HEADER_SIZE];
+    AVS_UNIT_ASSERT_EQUAL(handshake[0], DTLS_HANDSHAKE_HELLO_VERIFY_REQUEST);
+    // message_seq
+    AVS_UNIT_ASSERT_EQUAL(read_u16(&handshake[4]), 0);
+    const unsigned char *body = &handshake[DTLS_HANDSHAKE_HEADER_SIZE];
+    AVS_UNIT_ASSERT_EQUAL(body[2], COOKIE_SIZE);
+    memcpy(out_cookie, &body[3], COOKIE_SIZE);
+}
+
+AVS_UNIT_TEST(dtls_listener, invalid_configuration) {
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(prng_ctx);
+    avs_net_socket_t *socket = NULL;
+    avs_net_dtls_listener_configuration_t config = default_config(prng_ctx);
+    config.max_peers = 0;
+    AVS_UNIT_ASSERT_FAILED(avs_net_dtls_listener_socket_create(&socket,
+                                                               &config));
+    config = default_config(prng_ctx);
+    config.connection_id_length =
+            AVS_NET_DTLS_LISTENER_MAX_CONNECTION_ID_LENGTH + 1;
+    AVS_UNIT_ASSERT_FAILED(avs_net_dtls_listener_socket_create(&socket,
+                                                               &config));
+    config = default_config(prng_ctx);
+    config.cookie_lifetime = AVS_TIME_DURATION_ZERO;
+    AVS_UNIT_ASSERT_FAILED(avs_net_dtls_listener_socket_create(&socket,
+                                                               &config));
+    config = default_config(prng_ctx);
+    config.prng_ctx = NULL;
+    AVS_UNIT_ASSERT_FAILED(avs_net_dtls_listener_socket_create(&socket,
+                                                               &config));
+    AVS_UNIT_ASSERT_NULL(socket);
+    avs_crypto_prng_free(&prng_ctx);
+}
+
+AVS_UNIT_TEST(dtls_listener, cookie_exchange) {
+    dtls_listener_env_t env = create_env();
+
+    // no cookie - answered statelessly
+    send_client_hello(env.client, 7, NULL, 0);
+    receive_all(&env);
+    AVS_UNIT_ASSERT_NULL(env.listener->pending_hellos.head);
+    unsigned char cookie[COOKIE_SIZE];
+    receive_hello_verify_request(env.client, 7, cookie);
+
+    // invalid cookie - answered with a new HelloVerifyRequest
+    unsigned char invalid_cookie[COOKIE_SIZE];
+    memcpy(invalid_cookie, cookie, COOKIE_SIZE);
+    invalid_cookie[COOKIE_SIZE - 1] ^= 1;
+    send_client_hello(env.client, 8, invalid_cookie, COOKIE_SIZE);
+    receive_all(&env);
+    AVS_UNIT_ASSERT_NULL(env.listener->pending_hellos.head);
+    unsigned char another_cookie[COOKIE_SIZE];
+    receive_hello_verify_request(env.client, 8, another_cookie);
+
+    // valid cookie - queued for accept
+    send_client_hello(env.client, 9, cookie, COOKIE_SIZE);
+    receive_all(&env);
+    AVS_UNIT_ASSERT_EQUAL(env.listener->pending_hellos.length, 1);
+
+    avs_net_socket_opt_value_t opt;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            env.listener_socket, AVS_NET_SOCKET_HAS_BUFFERED_DATA, &opt));
+    AVS_UNIT_ASSERT_TRUE(opt.flag);
+
+    destroy_env(&env);
+}
+
+static dtls_peer_t *accept_client(dtls_listener_env_t *env,
+                                  avs_net_socket_t *client) {
+    send_client_hello(client, 1, NULL, 0);
+    receive_all(env);
+    unsigned char cookie[COOKIE_SIZE];
+    receive_hello_verify_request(client, 1, cookie);
+    send_client_hello(client, 2, cookie, COOKIE_SIZE);
+    receive_all(env);
+
+    dtls_peer_t *peer = NULL;
+    queued_datagram_t *client_hello = queue_pop(&env->listener->pending_hellos);
+    AVS_UNIT_ASSERT_NOT_NULL(client_hello);
+    AVS_UNIT_ASSERT_SUCCESS(create_peer(env->listener, client_hello, &peer));
+    return peer;
+}
+
+AVS_UNIT_TEST(dtls_listener, peer_routing) {
+    dtls_listener_env_t env = create_env();
+    dtls_peer_t *peer = accept_client(&env, env.client);
+    avs_net_socket_t *peer_socket = (avs_net_socket_t *) peer;
+
+    const unsigned char *connection_id = NULL;
+    size_t connection_id_size = 0;
+    AVS_UNIT_ASSERT_TRUE(_avs_net_dtls_listener_is_peer(
+            peer_socket, &connection_id, &connection_id_size));
+    AVS_UNIT_ASSERT_TRUE(connection_id == peer->connection_id);
+    AVS_UNIT_ASSERT_EQUAL(connection_id_size, 4);
+    AVS_UNIT_ASSERT_FALSE(
+            _avs_net_dtls_listener_is_peer(env.client, NULL, NULL));
+
+    // the ClientHello is the first datagram read by the peer
+    unsigned char buffer[256];
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(buffer[0], DTLS_CONTENT_TYPE_HANDSHAKE);
+
+    // further datagrams are routed by address, without cookie checks
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(env.client, "hello", 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "hello", size);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(peer_socket, "world", 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(env.client, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "world", size);
+
+    // nothing more to read
+    avs_net_socket_opt_value_t opt = {
+        .recv_timeout = AVS_TIME_DURATION_ZERO
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_set_opt(
+            peer_socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, opt));
+    avs_error_t err =
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer));
+    AVS_UNIT_ASSERT_TRUE(avs_is_err(err));
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ETIMEDOUT);
+
+    // closing the listener detaches the peer
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_close(env.listener_socket));
+    AVS_UNIT_ASSERT_NULL(peer->listener);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            peer_socket, AVS_NET_SOCKET_OPT_STATE, &opt));
+    AVS_UNIT_ASSERT_EQUAL(opt.state, AVS_NET_SOCKET_STATE_CLOSED);
+    AVS_UNIT_ASSERT_FAILED(avs_net_socket_send(peer_socket, "x", 1));
+
+    avs_net_socket_cleanup(&peer_socket);
+    destroy_env(&env);
+}
+
+AVS_UNIT_TEST(dtls_listener, direct_receive) {
+    dtls_listener_env_t env = create_env();
+    dtls_peer_t *peer = accept_client(&env, env.client);
+    avs_net_socket_t *peer_socket = (avs_net_socket_t *) peer;
+
+    unsigned char buffer[1500];
+    size_t size = 0;
+    // the queued ClientHello is copied out of the queue
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(buffer[0], DTLS_CONTENT_TYPE_HANDSHAKE);
+
+    // with the queue empty and a buffer large enough for any datagram, the
+    // first one is received straight into the caller's buffer...
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(env.client, "hello", 5));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(env.client, "world", 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_TRUE(env.listener->receive_slots[0].buffer == buffer);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "hello", size);
+    AVS_UNIT_ASSERT_FALSE(peer->migration_pending);
+
+    // ...and datagrams received along with it are still delivered in order
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "world", size);
+
+    avs_net_socket_cleanup(&peer_socket);
+    destroy_env(&env);
+}
+
+static void receive_client_hello(avs_net_socket_t *peer_socket) {
+    unsigned char buffer[256];
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(buffer[0], DTLS_CONTENT_TYPE_HANDSHAKE);
+}
+
+static void send_cid_record(avs_net_socket_t *client,
+                            const dtls_peer_t *peer,
+                            const char *payload) {
+    unsigned char record[64];
+    const size_t payload_size = strlen(payload);
+    size_t size = DTLS_CID_OFFSET;
+    AVS_UNIT_ASSERT_TRUE(size + 4 + 2 + payload_size <= sizeof(record));
+    memset(record, 0, DTLS_CID_OFFSET);
+    record[0] = DTLS_CONTENT_TYPE_TLS12_CID;
+    record[1] = DTLS_MAJOR_VERSION;
+    record[2] = 253; // DTLS 1.2
+    record[DTLS_RECORD_SEQUENCE_OFFSET + 1] = 1; // epoch
+    memcpy(&record[size], peer->connection_id, 4);
+    size += 4;
+    write_u16(&record[size], (uint32_t) payload_size);
+    size += 2;
+    memcpy(&record[size], payload, payload_size);
+    size += payload_size;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, record, size));
+}
+
+static void assert_peer_remote_port(avs_net_socket_t *peer_socket,
+                                    avs_net_socket_t *client) {
+    char peer_port[NET_PORT_SIZE];
+    char client_port[NET_PORT_SIZE];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_remote_port(
+            peer_socket, peer_port, sizeof(peer_port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            client, client_port, sizeof(client_port)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(peer_port, client_port);
+}
+
+AVS_UNIT_TEST(dtls_listener, connection_id_migration) {
+    dtls_listener_env_t env = create_env();
+    dtls_peer_t *peer = accept_client(&env, env.client);
+    avs_net_socket_t *peer_socket = (avs_net_socket_t *) peer;
+    receive_client_hello(peer_socket);
+
+    // a record carrying the peer's Connection ID is routed to it, even though
+    // it comes from an address not known to the listener
+    avs_net_socket_t *new_client = create_client(env.listener_socket);
+    send_cid_record(new_client, peer, "moved");
+    unsigned char buffer[256];
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(buffer[0], DTLS_CONTENT_TYPE_TLS12_CID);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(&buffer[size - 5], "moved", 5);
+
+    // the new address is not used until the record is authenticated
+    AVS_UNIT_ASSERT_TRUE(peer->migration_pending);
+    assert_peer_remote_port(peer_socket, env.client);
+    _avs_net_dtls_listener_peer_authenticated(peer_socket);
+    AVS_UNIT_ASSERT_FALSE(peer->migration_pending);
+    assert_peer_remote_port(peer_socket, new_client);
+    AVS_UNIT_ASSERT_TRUE(find_peer_by_endpoint(env.listener, &peer->endpoint)
+                         == peer);
+
+    // replies go to the new address, and plain datagrams from it are routed
+    // to the peer as well
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(peer_socket, "world", 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(new_client, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "world", size);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(new_client, "hello", 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "hello", size);
+
+    avs_net_socket_cleanup(&new_client);
+    avs_net_socket_cleanup(&peer_socket);
+    destroy_env(&env);
+}
+
+AVS_UNIT_TEST(dtls_listener, migration_closes_stale_peer) {
+    dtls_listener_env_t env = create_env();
+    dtls_peer_t *peer = accept_client(&env, env.client);
+    avs_net_socket_t *peer_socket = (avs_net_socket_t *) peer;
+    receive_client_hello(peer_socket);
+    avs_net_socket_t *other_client = create_client(env.listener_socket);
+    dtls_peer_t *other_peer = accept_client(&env, other_client);
+    avs_net_socket_t *other_peer_socket = (avs_net_socket_t *) other_peer;
+    receive_client_hello(other_peer_socket);
+    AVS_UNIT_ASSERT_EQUAL(env.listener->peer_count, 2);
+
+    // the Connection ID takes precedence over the source address
+    send_cid_record(other_client, peer, "moved");
+    receive_all(&env);
+    AVS_UNIT_ASSERT_EQUAL(peer->queue.length, 1);
+    AVS_UNIT_ASSERT_NULL(other_peer->queue.head);
+    unsigned char buffer[256];
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(&buffer[size - 5], "moved", 5);
+
+    // once authenticated, the peer takes over the address; the peer that was
+    // bound to it before is closed, so the endpoint lookup stays unambiguous
+    _avs_net_dtls_listener_peer_authenticated(peer_socket);
+    assert_peer_remote_port(peer_socket, other_client);
+    AVS_UNIT_ASSERT_TRUE(find_peer_by_endpoint(env.listener, &peer->endpoint)
+                         == peer);
+    AVS_UNIT_ASSERT_EQUAL(env.listener->peer_count, 1);
+    AVS_UNIT_ASSERT_NULL(other_peer->listener);
+    avs_net_socket_opt_value_t opt;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            other_peer_socket, AVS_NET_SOCKET_OPT_STATE, &opt));
+    AVS_UNIT_ASSERT_EQUAL(opt.state, AVS_NET_SOCKET_STATE_CLOSED);
+    AVS_UNIT_ASSERT_FAILED(
+            avs_net_socket_send(other_peer_socket, "x", 1));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(other_client, "hello", 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(peer_socket, &size, buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "hello", size);
+
+    avs_net_socket_cleanup(&other_peer_socket);
+    avs_net_socket_cleanup(&other_client);
+    avs_net_socket_cleanup(&peer_socket);
+    destroy_env(&env);
+}
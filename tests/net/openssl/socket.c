@@ -23,6 +23,15 @@
 
 #include <avsystem/commons/avs_unit_test.h>
 
+#if defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) \
+        || defined(AVS_COMMONS_NET_WITH_DTLS_LISTENER)
+#    include <stdio.h>
+#    include <stdlib.h>
+
+#    include <avsystem/commons/avs_utils.h>
+#endif // defined(AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE) ||
+       // defined(AVS_COMMONS_NET_WITH_DTLS_LISTENER)
+
 AVS_UNIT_TEST(socket, ciphersuites_psk) {
     avs_net_socket_t *socket = NULL;
     avs_net_ssl_configuration_t config = create_default_ssl_config();
@@ -30,9 +39,9 @@ AVS_UNIT_TEST(socket, ciphersuites_psk) {
 
     ssl_socket_t *ssl_socket = (ssl_socket_t *) socket;
 
-    AVS_UNIT_ASSERT_EQUAL(ssl_socket->enabled_ciphersuites.num_ids, 2);
+    AVS_UNIT_ASSERT_EQUAL(ssl_socket->context->enabled_ciphersuites.num_ids, 2);
 
-    ssl_socket->ssl = SSL_new(ssl_socket->ctx);
+    ssl_socket->ssl = SSL_new(ssl_socket->context->ctx);
     AVS_UNIT_ASSERT_NOT_NULL(ssl_socket->ssl);
 
     AVS_UNIT_ASSERT_SUCCESS(fix_socket_ciphersuites(ssl_socket));
@@ -60,9 +69,9 @@ AVS_UNIT_TEST(socket, ciphersuites_cert) {
 
     ssl_socket_t *ssl_socket = (ssl_socket_t *) socket;
 
-    AVS_UNIT_ASSERT_EQUAL(ssl_socket->enabled_ciphersuites.num_ids, 2);
+    AVS_UNIT_ASSERT_EQUAL(ssl_socket->context->enabled_ciphersuites.num_ids, 2);
 
-    ssl_socket->ssl = SSL_new(ssl_socket->ctx);
+    ssl_socket->ssl = SSL_new(ssl_socket->context->ctx);
     AVS_UNIT_ASSERT_NOT_NULL(ssl_socket->ssl);
 
     AVS_UNIT_ASSERT_SUCCESS(fix_socket_ciphersuites(ssl_socket));
@@ -82,3 +91,402 @@ AVS_UNIT_TEST(socket, ciphersuites_cert) {
     AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
     cleanup_default_ssl_config(&config);
 }
+
+#ifdef AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE
+static int connect_tcp_client(const char *port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t) atoi(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0
+            && connect(fd, (const struct sockaddr *) &addr, sizeof(addr))) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static void write_session(int out_fd, SSL_SESSION *session) {
+    unsigned char *der = NULL;
+    int der_size = i2d_SSL_SESSION(session, &der);
+    if (der_size > 0) {
+        const unsigned char *ptr = der;
+        ssize_t written;
+        while (der_size > 0
+               && (written = write(out_fd, ptr, (size_t) der_size)) > 0) {
+            ptr += written;
+            der_size -= (int) written;
+        }
+    }
+    OPENSSL_free(der);
+}
+
+/**
+ * Performs a TLS 1.2 handshake with the server listening on @p port, offering
+ * @p session for resumption if not NULL, and writes the resulting session in
+ * DER format to @p session_out_fd. Runs in a forked child process, so it MUST
+ * NOT use unit test assertions.
+ */
+static int run_tls_client(const char *port,
+                          bool use_session_tickets,
+                          SSL_SESSION *session,
+                          int session_out_fd) {
+    int result = -1;
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    SSL *ssl = NULL;
+    int fd = -1;
+    if (!ctx || !SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION)
+            || !SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION)) {
+        goto finish;
+    }
+    if (!use_session_tickets) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+    if ((fd = connect_tcp_client(port)) < 0 || !(ssl = SSL_new(ctx))
+            || !SSL_set_fd(ssl, fd)
+            || (session && !SSL_set_session(ssl, session))
+            || SSL_connect(ssl) != 1) {
+        goto finish;
+    }
+    write_session(session_out_fd, SSL_get_session(ssl));
+    close(session_out_fd);
+    // wait for close_notify from the server, then reply with our own
+    char byte;
+    SSL_read(ssl, &byte, 1);
+    SSL_shutdown(ssl);
+    result = 0;
+finish:
+    SSL_free(ssl);
+    if (fd >= 0) {
+        close(fd);
+    }
+    SSL_CTX_free(ctx);
+    return result;
+}
+
+static SSL_SESSION *read_session(int fd) {
+    unsigned char der[4096];
+    size_t der_size = 0;
+    ssize_t result;
+    while (der_size < sizeof(der)
+           && (result = read(fd, der + der_size, sizeof(der) - der_size))
+                      > 0) {
+        der_size += (size_t) result;
+    }
+    const unsigned char *ptr = der;
+    return d2i_SSL_SESSION(NULL, &ptr, (long) der_size);
+}
+
+/**
+ * Connects an in-process OpenSSL client, forked off so that it can run
+ * concurrently with the blocking accept and handshake, to @p listen_socket.
+ * If @p *inout_session is NULL, it is set to the session established by the
+ * client; otherwise, the client attempts to resume it.
+ *
+ * @returns Whether the server reports the session as resumed.
+ */
+static bool server_session_cache_test_accept(avs_net_socket_t *listen_socket,
+                                             avs_net_tls_context_t *context,
+                                             const char *port,
+                                             bool use_session_tickets,
+                                             SSL_SESSION **inout_session) {
+    int session_pipe[2];
+    AVS_UNIT_ASSERT_SUCCESS(pipe(session_pipe));
+    // NOTE: the connection is queued in the listen backlog until accepted
+    pid_t client = fork();
+    AVS_UNIT_ASSERT_TRUE(client >= 0);
+    if (!client) {
+        close(session_pipe[0]);
+        // do not linger if the server side fails
+        alarm(20);
+        _exit(run_tls_client(port, use_session_tickets, *inout_session,
+                             session_pipe[1])
+                      ? EXIT_FAILURE
+                      : EXIT_SUCCESS);
+    }
+    close(session_pipe[1]);
+
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(listen_socket, socket));
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.tls_context = context;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_ssl_socket_decorate_in_place(&socket, &config));
+
+    avs_net_socket_opt_value_t opt_value;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            socket, AVS_NET_SOCKET_OPT_SESSION_RESUMED, &opt_value));
+    // NOTE: shutting the socket down without close_notify would make OpenSSL
+    // remove the session from the cache
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+
+    SSL_SESSION *session = read_session(session_pipe[0]);
+    close(session_pipe[0]);
+    int status;
+    AVS_UNIT_ASSERT_EQUAL(waitpid(client, &status, 0), client);
+    AVS_UNIT_ASSERT_TRUE(WIFEXITED(status));
+    AVS_UNIT_ASSERT_EQUAL(WEXITSTATUS(status), EXIT_SUCCESS);
+    AVS_UNIT_ASSERT_NOT_NULL(session);
+    if (*inout_session) {
+        SSL_SESSION_free(session);
+    } else {
+        *inout_session = session;
+    }
+    return opt_value.flag;
+}
+
+static void test_server_session_cache(size_t max_sessions,
+                                      bool use_session_tickets) {
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(prng_ctx);
+    avs_net_tls_server_session_cache_t *cache = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tls_server_session_cache_create(
+            &cache,
+            &(const avs_net_tls_server_session_cache_config_t) {
+                .max_sessions = max_sessions,
+                .session_lifetime =
+                        avs_time_duration_from_scalar(1, AVS_TIME_HOUR),
+                .use_session_tickets = use_session_tickets,
+                .ticket_key_rotation_interval = AVS_TIME_DURATION_INVALID,
+                .prng_ctx = prng_ctx
+            }));
+
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.version = AVS_NET_SSL_VERSION_TLSv1_2;
+    config.prng_ctx = prng_ctx;
+    config.security = avs_net_security_info_from_certificates(
+            (avs_net_certificate_info_t) {
+                .client_cert = avs_crypto_certificate_chain_info_from_file(
+                        "../certs/server.crt"),
+                .client_key = avs_crypto_private_key_info_from_file(
+                        "../certs/server.key", NULL)
+            });
+    config.server_session_cache = cache;
+    avs_net_tls_context_t *context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_tls_context_create(&context, AVS_NET_SSL_SOCKET, &config));
+
+    avs_net_socket_t *listen_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&listen_socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(listen_socket, "127.0.0.1", "0"));
+    char port[sizeof("65535")];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(listen_socket, port, sizeof(port)));
+
+    SSL_SESSION *session = NULL;
+    AVS_UNIT_ASSERT_FALSE(server_session_cache_test_accept(
+            listen_socket, context, port, use_session_tickets, &session));
+    AVS_UNIT_ASSERT_TRUE(server_session_cache_test_accept(
+            listen_socket, context, port, use_session_tickets, &session));
+    if (use_session_tickets) {
+        // tickets issued with the previous key are still accepted
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_tls_server_session_cache_rotate_ticket_keys(cache));
+        AVS_UNIT_ASSERT_TRUE(server_session_cache_test_accept(
+                listen_socket, context, port, use_session_tickets, &session));
+    }
+    SSL_SESSION_free(session);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listen_socket));
+    avs_net_tls_context_cleanup(&context);
+    avs_net_tls_server_session_cache_cleanup(&cache);
+    AVS_UNIT_ASSERT_NULL(cache);
+    avs_crypto_prng_free(&prng_ctx);
+}
+
+AVS_UNIT_TEST(server_session_cache, session_id) {
+    test_server_session_cache(16, false);
+}
+
+AVS_UNIT_TEST(server_session_cache, session_ticket) {
+    test_server_session_cache(0, true);
+}
+#endif // AVS_COMMONS_NET_WITH_TLS_SERVER_SESSION_CACHE
+
+#ifdef AVS_COMMONS_NET_WITH_DTLS_LISTENER
+typedef struct {
+    pid_t pid;
+    FILE *reply;
+} dtls_client_t;
+
+/**
+ * Performs a DTLS 1.2 handshake with the server listening on @p port, sends
+ * @p message, and writes the reply to @p reply_fd. Runs in a forked child
+ * process, so it MUST NOT use unit test assertions.
+ */
+static int run_dtls_client(const char *port,
+                           const char *message,
+                           int reply_fd) {
+    int result = -1;
+    SSL_CTX *ctx = SSL_CTX_new(DTLS_client_method());
+    SSL *ssl = NULL;
+    BIO *bio = NULL;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t) atoi(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    char reply[64];
+    int reply_size;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (!ctx || !SSL_CTX_set_min_proto_version(ctx, DTLS1_2_VERSION)
+            || !SSL_CTX_set_max_proto_version(ctx, DTLS1_2_VERSION) || fd < 0
+            || connect(fd, (const struct sockaddr *) &addr, sizeof(addr))
+            || !(ssl = SSL_new(ctx))
+            || !(bio = BIO_new_dgram(fd, BIO_NOCLOSE))) {
+        goto finish;
+    }
+    BIO_ctrl(bio, BIO_CTRL_DGRAM_SET_CONNECTED, 0, &addr);
+    SSL_set_bio(ssl, bio, bio);
+    if (SSL_connect(ssl) == 1
+            && SSL_write(ssl, message, (int) strlen(message))
+                           == (int) strlen(message)
+            && (reply_size = SSL_read(ssl, reply, sizeof(reply))) > 0
+            && write(reply_fd, reply, (size_t) reply_size) == reply_size) {
+        result = 0;
+    }
+    SSL_shutdown(ssl);
+finish:
+    SSL_free(ssl);
+    if (fd >= 0) {
+        close(fd);
+    }
+    SSL_CTX_free(ctx);
+    return result;
+}
+
+/**
+ * Starts an in-process OpenSSL DTLS client, forked off so that it can run
+ * concurrently with the blocking accept and handshake.
+ */
+static dtls_client_t start_dtls_client(const char *port, const char *message) {
+    int reply_pipe[2];
+    AVS_UNIT_ASSERT_SUCCESS(pipe(reply_pipe));
+    dtls_client_t client = {
+        .pid = fork()
+    };
+    AVS_UNIT_ASSERT_TRUE(client.pid >= 0);
+    if (!client.pid) {
+        close(reply_pipe[0]);
+        // do not linger if the server side fails
+        alarm(20);
+        _exit(run_dtls_client(port, message, reply_pipe[1]) ? EXIT_FAILURE
+                                                            : EXIT_SUCCESS);
+    }
+    close(reply_pipe[1]);
+    client.reply = fdopen(reply_pipe[0], "r");
+    AVS_UNIT_ASSERT_NOT_NULL(client.reply);
+    return client;
+}
+
+static void finish_dtls_client(dtls_client_t *client,
+                               const char *expected_reply) {
+    char reply[64] = "";
+    AVS_UNIT_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), client->reply));
+    AVS_UNIT_ASSERT_EQUAL_STRING(reply, expected_reply);
+    fclose(client->reply);
+    int status;
+    AVS_UNIT_ASSERT_EQUAL(waitpid(client->pid, &status, 0), client->pid);
+    AVS_UNIT_ASSERT_TRUE(WIFEXITED(status));
+    AVS_UNIT_ASSERT_EQUAL(WEXITSTATUS(status), EXIT_SUCCESS);
+}
+
+static avs_net_socket_t *accept_dtls_peer(avs_net_socket_t *listener,
+                                          avs_net_tls_context_t *context) {
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.tls_context = context;
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_dtls_socket_create(&socket, &config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(listener, socket));
+    return socket;
+}
+
+static void echo_to_dtls_peer(avs_net_socket_t *socket,
+                              char *out_message,
+                              size_t message_size) {
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(socket, &size, out_message,
+                                                   message_size - 1));
+    out_message[size] = '\0';
+    char reply[64];
+    AVS_UNIT_ASSERT_TRUE(avs_simple_snprintf(reply, sizeof(reply), "echo-%s",
+                                             out_message)
+                         > 0);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(socket, reply, strlen(reply)));
+}
+
+AVS_UNIT_TEST(dtls_listener, multiple_peers) {
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(prng_ctx);
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.version = AVS_NET_SSL_VERSION_TLSv1_2;
+    config.prng_ctx = prng_ctx;
+    config.security = avs_net_security_info_from_certificates(
+            (avs_net_certificate_info_t) {
+                .client_cert = avs_crypto_certificate_chain_info_from_file(
+                        "../certs/server.crt"),
+                .client_key = avs_crypto_private_key_info_from_file(
+                        "../certs/server.key", NULL)
+            });
+    avs_net_tls_context_t *context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_tls_context_create(&context, AVS_NET_DTLS_SOCKET, &config));
+
+    avs_net_socket_t *listener = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_dtls_listener_socket_create(
+            &listener,
+            &(const avs_net_dtls_listener_configuration_t) {
+                .backend_configuration = {
+                    .address_family = AVS_NET_AF_INET4
+                },
+                .max_peers = 4,
+                .max_queued_datagrams = 8,
+                .max_datagram_size = 4096,
+                .cookie_lifetime = avs_time_duration_from_scalar(
+                        1, AVS_TIME_MIN),
+                .prng_ctx = prng_ctx
+            }));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_bind(listener, "127.0.0.1", "0"));
+    char port[sizeof("65535")];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(listener, port, sizeof(port)));
+
+    dtls_client_t clients[] = { start_dtls_client(port, "first\n"),
+                                start_dtls_client(port, "second\n") };
+    avs_net_socket_t *peers[AVS_ARRAY_SIZE(clients)];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(peers); ++i) {
+        peers[i] = accept_dtls_peer(listener, context);
+    }
+    // both handshakes are complete; each peer only receives its own data
+    char messages[AVS_ARRAY_SIZE(peers)][32];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(peers); ++i) {
+        echo_to_dtls_peer(peers[i], messages[i], sizeof(messages[i]));
+    }
+    AVS_UNIT_ASSERT_NOT_EQUAL_STRING(messages[0], messages[1]);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(peers); ++i) {
+        // at least the record header and an authentication tag or MAC
+        avs_net_socket_opt_value_t overhead;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+                peers[i], AVS_NET_SOCKET_OPT_DTLS_RECORD_OVERHEAD, &overhead));
+        AVS_UNIT_ASSERT_TRUE(overhead.mtu > DTLS1_RT_HEADER_LENGTH);
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&peers[i]));
+    }
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listener));
+    static const char *const EXPECTED_REPLIES[] = { "echo-first\n",
+                                                    "echo-second\n" };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(clients); ++i) {
+        finish_dtls_client(&clients[i], EXPECTED_REPLIES[i]);
+    }
+    avs_net_tls_context_cleanup(&context);
+    avs_crypto_prng_free(&prng_ctx);
+}
+#endif // AVS_COMMONS_NET_WITH_DTLS_LISTENER
@@ -67,11 +67,13 @@ run_socket_set_opt_test_cases(avs_net_socket_t *socket,
             break;
         case AVS_NET_SOCKET_OPT_MTU:
         case AVS_NET_SOCKET_OPT_INNER_MTU:
+        case AVS_NET_SOCKET_OPT_DTLS_RECORD_OVERHEAD:
             opt_val.mtu = 5;
             break;
         case AVS_NET_SOCKET_OPT_SESSION_RESUMED:
         case AVS_NET_SOCKET_HAS_BUFFERED_DATA:
         case AVS_NET_SOCKET_OPT_CONNECTION_ID_RESUMED:
+        case AVS_NET_SOCKET_OPT_UDP_SEGMENTATION:
             opt_val.flag = true;
             break;
         case AVS_NET_SOCKET_OPT_BYTES_SENT:
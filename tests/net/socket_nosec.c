@@ -16,6 +16,7 @@
 
 #include <string.h>
 
+#include <avsystem/commons/avs_addrinfo.h>
 #include <avsystem/commons/avs_log.h>
 
 #include "socket_common_testcases.h"
@@ -275,3 +276,290 @@ AVS_UNIT_TEST(socket, udp_connect_ipv4v6) {
 }
 #endif // defined(AVS_COMMONS_NET_WITH_IPV4) &&
        // defined(AVS_COMMONS_NET_WITH_IPV6)
+
+//// avs_net_socket_sendv //////////////////////////////////////////////////////
+
+#if defined(AVS_COMMONS_NET_WITH_IPV4) \
+        && defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG)
+AVS_UNIT_TEST(socket, udp_sendv_single_datagram) {
+    avs_net_socket_t *listening_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&listening_socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(listening_socket, "127.0.0.1", "0"));
+
+    char listen_port[sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            listening_socket, listen_port, sizeof(listen_port)));
+
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(socket, "127.0.0.1", listen_port));
+
+    const avs_iovec_t iov[] = {
+        { "head", 4 },
+        { NULL, 0 },
+        { "-body-", 6 },
+        { "tail", 4 }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_sendv(socket, iov, AVS_ARRAY_SIZE(iov)));
+
+    char buf[64];
+    size_t received;
+    char host[64];
+    char port[sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive_from(
+            listening_socket, &received, buf, sizeof(buf), host, sizeof(host),
+            port, sizeof(port)));
+    AVS_UNIT_ASSERT_EQUAL(received, strlen("head-body-tail"));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "head-body-tail", received);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listening_socket));
+}
+
+AVS_UNIT_TEST(socket, tcp_sendv_many_blocks) {
+    avs_net_socket_t *listening_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&listening_socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(listening_socket, "127.0.0.1", "0"));
+
+    char listen_port[sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            listening_socket, listen_port, sizeof(listen_port)));
+
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(socket, "127.0.0.1", listen_port));
+    avs_net_socket_t *server_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&server_socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_accept(listening_socket, server_socket));
+
+    /* more blocks than a single sendmsg() call accepts on any sane system */
+    static const char DATA[] = "0123456789abcdef";
+    enum { BLOCK_COUNT = 4096 };
+    avs_iovec_t *iov =
+            (avs_iovec_t *) avs_calloc(BLOCK_COUNT, sizeof(avs_iovec_t));
+    AVS_UNIT_ASSERT_NOT_NULL(iov);
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        iov[i].base = &DATA[i % (sizeof(DATA) - 1)];
+        iov[i].length = 1;
+    }
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_sendv(socket, iov, BLOCK_COUNT));
+    avs_free(iov);
+
+    char buf[BLOCK_COUNT];
+    size_t total_received = 0;
+    while (total_received < sizeof(buf)) {
+        size_t received;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(
+                server_socket, &received, buf + total_received,
+                sizeof(buf) - total_received));
+        AVS_UNIT_ASSERT_NOT_EQUAL(received, 0);
+        total_received += received;
+    }
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        AVS_UNIT_ASSERT_EQUAL(buf[i], DATA[i % (sizeof(DATA) - 1)]);
+    }
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server_socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listening_socket));
+}
+#endif // defined(AVS_COMMONS_NET_WITH_IPV4) &&
+       // defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMSG)
+
+//// avs_net_socket_receive_from_many //////////////////////////////////////////
+
+#if defined(AVS_COMMONS_NET_WITH_IPV4) \
+        && defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
+AVS_UNIT_TEST(socket, udp_receive_from_many) {
+    avs_net_socket_t *listening_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&listening_socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(listening_socket, "127.0.0.1", "0"));
+
+    char listen_port[sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            listening_socket, listen_port, sizeof(listen_port)));
+
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(socket, "127.0.0.1", listen_port));
+    char local_port[sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            socket, local_port, sizeof(local_port)));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(socket, "first", 5));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(socket, "second", 6));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(socket, "truncated", 9));
+
+    char bufs[4][8];
+    avs_net_incoming_datagram_t datagrams[4];
+    memset(datagrams, 0, sizeof(datagrams));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(datagrams); ++i) {
+        datagrams[i].buffer = bufs[i];
+        datagrams[i].buffer_length = sizeof(bufs[i]);
+    }
+    size_t received_count;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive_from_many(
+            listening_socket, datagrams, AVS_ARRAY_SIZE(datagrams),
+            &received_count));
+    AVS_UNIT_ASSERT_EQUAL(received_count, 3);
+
+    AVS_UNIT_ASSERT_EQUAL(datagrams[0].out_size, 5);
+    AVS_UNIT_ASSERT_FALSE(datagrams[0].out_truncated);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(bufs[0], "first", 5);
+    AVS_UNIT_ASSERT_EQUAL(datagrams[1].out_size, 6);
+    AVS_UNIT_ASSERT_FALSE(datagrams[1].out_truncated);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(bufs[1], "second", 6);
+    AVS_UNIT_ASSERT_EQUAL(datagrams[2].out_size, 8);
+    AVS_UNIT_ASSERT_TRUE(datagrams[2].out_truncated);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(bufs[2], "truncate", 8);
+
+    char host[64];
+    char port[sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_resolved_endpoint_get_host_port(
+            &datagrams[1].out_source, host, sizeof(host), port,
+            sizeof(port)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "127.0.0.1");
+    AVS_UNIT_ASSERT_EQUAL_STRING(port, local_port);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listening_socket));
+}
+#endif // defined(AVS_COMMONS_NET_WITH_IPV4) &&
+       // defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
+
+//// avs_net_socket_send_to_many ///////////////////////////////////////////////
+
+#if defined(AVS_COMMONS_NET_WITH_IPV4) \
+        && defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
+static void create_bound_udp_socket(avs_net_socket_t **out_socket,
+                                    avs_net_resolved_endpoint_t *out_endpoint) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(out_socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_bind(*out_socket, "127.0.0.1", "0"));
+    char port[sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(*out_socket, port, sizeof(port)));
+    avs_net_addrinfo_t *info =
+            avs_net_addrinfo_resolve(AVS_NET_UDP_SOCKET, AVS_NET_AF_INET4,
+                                     "127.0.0.1", port, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(info);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_addrinfo_next(info, out_endpoint));
+    avs_net_addrinfo_delete(&info);
+}
+
+static void assert_received(avs_net_socket_t *socket, const char *expected) {
+    char buf[64];
+    size_t received;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(socket, &received, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(received, strlen(expected));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, expected, received);
+}
+
+static void test_send_to_many(bool segmentation) {
+    avs_net_socket_t *receivers[2] = { NULL, NULL };
+    avs_net_resolved_endpoint_t endpoints[2];
+    create_bound_udp_socket(&receivers[0], &endpoints[0]);
+    create_bound_udp_socket(&receivers[1], &endpoints[1]);
+
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_bind(socket, "127.0.0.1", "0"));
+    avs_net_socket_opt_value_t opt = {
+        .flag = segmentation
+    };
+    avs_error_t err = avs_net_socket_set_opt(
+            socket, AVS_NET_SOCKET_OPT_UDP_SEGMENTATION, opt);
+    if (avs_is_err(err)) {
+        AVS_UNIT_ASSERT_TRUE(segmentation);
+        AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ENOTSUP);
+    }
+
+    const avs_net_outgoing_datagram_t datagrams[] = {
+        { "aaaa", 4, &endpoints[0] }, { "bbbb", 4, &endpoints[0] },
+        { "cc", 2, &endpoints[0] },   { "dddd", 4, &endpoints[0] },
+        { "eeee", 4, &endpoints[1] }, { "ffff", 4, &endpoints[1] }
+    };
+    size_t sent_count;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send_to_many(
+            socket, datagrams, AVS_ARRAY_SIZE(datagrams), &sent_count));
+    AVS_UNIT_ASSERT_EQUAL(sent_count, AVS_ARRAY_SIZE(datagrams));
+
+    assert_received(receivers[0], "aaaa");
+    assert_received(receivers[0], "bbbb");
+    assert_received(receivers[0], "cc");
+    assert_received(receivers[0], "dddd");
+    assert_received(receivers[1], "eeee");
+    assert_received(receivers[1], "ffff");
+
+    avs_net_socket_opt_value_t bytes_sent;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            socket, AVS_NET_SOCKET_OPT_BYTES_SENT, &bytes_sent));
+    AVS_UNIT_ASSERT_EQUAL(bytes_sent.bytes_sent, 22);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&receivers[0]));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&receivers[1]));
+}
+
+AVS_UNIT_TEST(socket, udp_send_to_many) {
+    test_send_to_many(false);
+}
+
+AVS_UNIT_TEST(socket, udp_send_to_many_segmentation) {
+    test_send_to_many(true);
+}
+
+AVS_UNIT_TEST(socket, udp_send_to_resolve_cache) {
+    avs_net_socket_t *receivers[2] = { NULL, NULL };
+    avs_net_resolved_endpoint_t endpoints[2];
+    create_bound_udp_socket(&receivers[0], &endpoints[0]);
+    create_bound_udp_socket(&receivers[1], &endpoints[1]);
+    char ports[2][sizeof("65536")];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            receivers[0], ports[0], sizeof(ports[0])));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            receivers[1], ports[1], sizeof(ports[1])));
+
+    avs_net_socket_configuration_t config = {
+        .resolve_cache_size = 1,
+        .resolve_cache_ttl = avs_time_duration_from_scalar(1, AVS_TIME_S)
+    };
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&socket, &config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_bind(socket, "127.0.0.1", "0"));
+
+    // the second entry evicts the first one, then it is resolved again
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_to(socket, "aa", 2, "localhost", ports[0]));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_to(socket, "bb", 2, "localhost", ports[0]));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_to(socket, "cc", 2, "localhost", ports[1]));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_to(socket, "dd", 2, "localhost", ports[0]));
+    // numeric literals bypass both the resolver and the cache
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_to(socket, "ee", 2, "127.0.0.1", ports[1]));
+    AVS_UNIT_ASSERT_FAILED(
+            avs_net_socket_send_to(socket, "ff", 2, "::1", ports[1]));
+
+    assert_received(receivers[0], "aa");
+    assert_received(receivers[0], "bb");
+    assert_received(receivers[1], "cc");
+    assert_received(receivers[0], "dd");
+    assert_received(receivers[1], "ee");
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&receivers[0]));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&receivers[1]));
+}
+#endif // defined(AVS_COMMONS_NET_WITH_IPV4) &&
+       // defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
@@ -77,3 +77,93 @@ AVS_UNIT_TEST(tls13, psk) {
     socket_tls13_test_assert_connectivity(socket);
     AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
 }
+
+AVS_UNIT_TEST(tls13, shared_context) {
+    INIT_TLS13_TEST(SERVER_CERT_VERIFY);
+    config.version = AVS_NET_SSL_VERSION_TLSv1_3;
+
+    avs_net_tls_context_t *tls_context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tls_context_create(
+            &tls_context, AVS_NET_SSL_SOCKET, &config));
+
+    avs_net_ssl_configuration_t socket_config;
+    memset(&socket_config, 0, sizeof(socket_config));
+    socket_config.tls_context = tls_context;
+
+    avs_net_socket_t *socket1 = NULL;
+    avs_net_socket_t *socket2 = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_ssl_socket_create(&socket1, &socket_config));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_ssl_socket_create(&socket2, &socket_config));
+    // sockets keep their own references
+    avs_net_tls_context_cleanup(&tls_context);
+    AVS_UNIT_ASSERT_NULL(tls_context);
+
+    // NOTE: openssl s_server handles only one connection at a time
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket1, "localhost", port));
+    socket_tls13_test_assert_connectivity(socket1);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket1));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket2, "localhost", port));
+    socket_tls13_test_assert_connectivity(socket2);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket2));
+}
+
+AVS_UNIT_TEST(tls13, shared_context_session_resumption) {
+    INIT_TLS13_TEST(SERVER_CERT_NOVERIFY);
+    config.version = AVS_NET_SSL_VERSION_TLSv1_3;
+
+    avs_net_tls_context_t *tls_context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tls_context_create(
+            &tls_context, AVS_NET_SSL_SOCKET, &config));
+
+    char resumption_buffer[8192] = "";
+    avs_net_ssl_configuration_t socket_config;
+    memset(&socket_config, 0, sizeof(socket_config));
+    socket_config.session_resumption_buffer = resumption_buffer;
+    socket_config.session_resumption_buffer_size = sizeof(resumption_buffer);
+    socket_config.tls_context = tls_context;
+
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_socket_create(&socket, &socket_config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "localhost", port));
+    socket_tls13_test_assert_connectivity(socket);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+
+    // a different socket sharing the context resumes the stored session
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_socket_create(&socket, &socket_config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "localhost", port));
+    socket_tls13_test_assert_connectivity(socket);
+
+    avs_net_socket_opt_value_t opt_value;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            socket, AVS_NET_SOCKET_OPT_SESSION_RESUMED, &opt_value));
+    AVS_UNIT_ASSERT_TRUE(opt_value.flag);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    avs_net_tls_context_cleanup(&tls_context);
+}
+
+AVS_UNIT_TEST(tls13, shared_context_type_mismatch) {
+    __attribute__((__cleanup__(avs_crypto_prng_free)))
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(prng_ctx);
+    avs_net_ssl_configuration_t config =
+            socket_tls13_test_default_config(prng_ctx, SERVER_PSK);
+
+    avs_net_tls_context_t *tls_context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tls_context_create(
+            &tls_context, AVS_NET_SSL_SOCKET, &config));
+
+    avs_net_ssl_configuration_t socket_config;
+    memset(&socket_config, 0, sizeof(socket_config));
+    socket_config.tls_context = tls_context;
+
+    avs_net_socket_t *socket = NULL;
+    avs_error_t err = avs_net_dtls_socket_create(&socket, &socket_config);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EINVAL);
+    AVS_UNIT_ASSERT_NULL(socket);
+
+    avs_net_tls_context_cleanup(&tls_context);
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+#ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+#    include <avsystem/commons/avs_stream_inbuf.h>
+#    include <avsystem/commons/avs_stream_membuf.h>
+#endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
+
+typedef struct {
+    avs_crypto_prng_ctx_t *prng_ctx;
+    avs_net_tls_server_session_cache_t *cache;
+} server_session_cache_env_t;
+
+static server_session_cache_env_t
+create_cache(size_t max_sessions, bool use_session_tickets) {
+    server_session_cache_env_t env = {
+        .prng_ctx = avs_crypto_prng_new(NULL, NULL)
+    };
+    AVS_UNIT_ASSERT_NOT_NULL(env.prng_ctx);
+    avs_net_tls_server_session_cache_config_t config = {
+        .max_sessions = max_sessions,
+        .session_lifetime = avs_time_duration_from_scalar(1, AVS_TIME_HOUR),
+        .use_session_tickets = use_session_tickets,
+        .ticket_key_rotation_interval = AVS_TIME_DURATION_INVALID,
+        .prng_ctx = env.prng_ctx
+    };
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_net_tls_server_session_cache_create(&env.cache, &config));
+    return env;
+}
+
+static void destroy_cache(server_session_cache_env_t *env) {
+    _avs_net_tls_server_session_cache_cleanup(&env->cache);
+    AVS_UNIT_ASSERT_NULL(env->cache);
+    avs_crypto_prng_free(&env->prng_ctx);
+}
+
+static void store_string(avs_net_tls_server_session_cache_t *cache,
+                         const char *id,
+                         const char *data) {
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_tls_server_session_cache_store(
+            cache, id, strlen(id), data, strlen(data)));
+}
+
+static void assert_stored(avs_net_tls_server_session_cache_t *cache,
+                          const char *id,
+                          const char *expected_data) {
+    void *data = NULL;
+    size_t data_size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_tls_server_session_cache_retrieve(
+            cache, id, strlen(id), &data, &data_size));
+    AVS_UNIT_ASSERT_EQUAL(data_size, strlen(expected_data));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, expected_data, data_size);
+    avs_free(data);
+}
+
+static void assert_not_stored(avs_net_tls_server_session_cache_t *cache,
+                              const char *id) {
+    void *data = NULL;
+    size_t data_size = 0;
+    avs_error_t err = _avs_net_tls_server_session_cache_retrieve(
+            cache, id, strlen(id), &data, &data_size);
+    AVS_UNIT_ASSERT_TRUE(err.category == AVS_ERRNO_CATEGORY
+                         && err.code == AVS_ENOENT);
+    AVS_UNIT_ASSERT_NULL(data);
+}
+
+static void assert_keys_equal(const avs_net_tls_ticket_key_t *actual,
+                              const avs_net_tls_ticket_key_t *expected) {
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(actual->name, expected->name,
+                                      sizeof(expected->name));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(actual->cipher_key, expected->cipher_key,
+                                      sizeof(expected->cipher_key));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(actual->hmac_key, expected->hmac_key,
+                                      sizeof(expected->hmac_key));
+    AVS_UNIT_ASSERT_TRUE(avs_time_real_equal(actual->created,
+                                             expected->created));
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, invalid_config) {
+    avs_net_tls_server_session_cache_t *cache = NULL;
+    avs_net_tls_server_session_cache_config_t config = {
+        .max_sessions = 0,
+        .session_lifetime = avs_time_duration_from_scalar(1, AVS_TIME_HOUR),
+        .use_session_tickets = false
+    };
+    AVS_UNIT_ASSERT_FAILED(
+            _avs_net_tls_server_session_cache_create(&cache, &config));
+
+    config.max_sessions = 10;
+    config.session_lifetime = AVS_TIME_DURATION_ZERO;
+    AVS_UNIT_ASSERT_FAILED(
+            _avs_net_tls_server_session_cache_create(&cache, &config));
+
+    // tickets require a PRNG
+    config.session_lifetime = avs_time_duration_from_scalar(1, AVS_TIME_HOUR);
+    config.use_session_tickets = true;
+    AVS_UNIT_ASSERT_FAILED(
+            _avs_net_tls_server_session_cache_create(&cache, &config));
+    AVS_UNIT_ASSERT_NULL(cache);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, store_replace_remove) {
+    server_session_cache_env_t env = create_cache(4, false);
+    assert_not_stored(env.cache, "id1");
+
+    store_string(env.cache, "id1", "first");
+    store_string(env.cache, "id2", "second");
+    assert_stored(env.cache, "id1", "first");
+    assert_stored(env.cache, "id2", "second");
+
+    store_string(env.cache, "id1", "replaced");
+    AVS_UNIT_ASSERT_EQUAL(env.cache->session_count, 2);
+    assert_stored(env.cache, "id1", "replaced");
+
+    _avs_net_tls_server_session_cache_remove(env.cache, "id1", 3);
+    assert_not_stored(env.cache, "id1");
+    assert_stored(env.cache, "id2", "second");
+    AVS_UNIT_ASSERT_EQUAL(env.cache->session_count, 1);
+
+    destroy_cache(&env);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, lru_eviction) {
+    server_session_cache_env_t env = create_cache(2, false);
+    store_string(env.cache, "id1", "first");
+    store_string(env.cache, "id2", "second");
+    // make id2 the least recently used one
+    assert_stored(env.cache, "id1", "first");
+
+    store_string(env.cache, "id3", "third");
+    AVS_UNIT_ASSERT_EQUAL(env.cache->session_count, 2);
+    assert_not_stored(env.cache, "id2");
+    assert_stored(env.cache, "id1", "first");
+    assert_stored(env.cache, "id3", "third");
+
+    destroy_cache(&env);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, expiry) {
+    server_session_cache_env_t env = create_cache(2, false);
+    store_string(env.cache, "id1", "first");
+    store_string(env.cache, "id2", "second");
+
+    env.cache->lru_tail->expires = avs_time_real_now();
+    assert_not_stored(env.cache, "id1");
+    AVS_UNIT_ASSERT_EQUAL(env.cache->session_count, 1);
+
+    // expired entries are dropped even if the cache is not full
+    env.cache->lru_tail->expires = avs_time_real_now();
+    store_string(env.cache, "id3", "third");
+    AVS_UNIT_ASSERT_EQUAL(env.cache->session_count, 1);
+    assert_not_stored(env.cache, "id2");
+    assert_stored(env.cache, "id3", "third");
+
+    destroy_cache(&env);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, tickets_only) {
+    server_session_cache_env_t env = create_cache(0, true);
+    AVS_UNIT_ASSERT_FALSE(
+            _avs_net_tls_server_session_cache_stateful(env.cache));
+    AVS_UNIT_ASSERT_TRUE(
+            _avs_net_tls_server_session_cache_tickets_enabled(env.cache));
+
+    store_string(env.cache, "id1", "first");
+    AVS_UNIT_ASSERT_EQUAL(env.cache->session_count, 0);
+    assert_not_stored(env.cache, "id1");
+
+    destroy_cache(&env);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, ticket_key_rotation) {
+    server_session_cache_env_t env = create_cache(0, true);
+    avs_net_tls_ticket_key_t keys[AVS_NET_TLS_TICKET_KEYS_MAX];
+    size_t key_count = 0;
+
+    // the first key is generated lazily
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_tls_server_session_cache_ticket_keys(
+            env.cache, keys, &key_count));
+    AVS_UNIT_ASSERT_EQUAL(key_count, 1);
+    avs_net_tls_ticket_key_t first_key = keys[0];
+
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_tls_server_session_cache_ticket_keys(
+            env.cache, keys, &key_count));
+    AVS_UNIT_ASSERT_EQUAL(key_count, 1);
+    assert_keys_equal(&keys[0], &first_key);
+
+    // explicit rotation retains the previous key
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_net_tls_server_session_cache_rotate_ticket_keys(env.cache));
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_tls_server_session_cache_ticket_keys(
+            env.cache, keys, &key_count));
+    AVS_UNIT_ASSERT_EQUAL(key_count, 2);
+    AVS_UNIT_ASSERT_NOT_EQUAL_BYTES_SIZED(keys[0].name, first_key.name,
+                                          sizeof(first_key.name));
+    assert_keys_equal(&keys[1], &first_key);
+    avs_net_tls_ticket_key_t second_key = keys[0];
+
+    // rotation interval elapsed
+    env.cache->ticket_keys[0].created = avs_time_real_add(
+            avs_time_real_now(),
+            avs_time_duration_mul(env.cache->ticket_key_rotation_interval,
+                                  -1));
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_tls_server_session_cache_ticket_keys(
+            env.cache, keys, &key_count));
+    AVS_UNIT_ASSERT_EQUAL(key_count, 2);
+    AVS_UNIT_ASSERT_NOT_EQUAL_BYTES_SIZED(keys[0].name, second_key.name,
+                                          sizeof(second_key.name));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(keys[1].name, second_key.name,
+                                      sizeof(second_key.name));
+
+    destroy_cache(&env);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, tickets_disabled) {
+    server_session_cache_env_t env = create_cache(1, false);
+    avs_net_tls_ticket_key_t keys[AVS_NET_TLS_TICKET_KEYS_MAX];
+    size_t key_count = 0;
+    AVS_UNIT_ASSERT_FAILED(_avs_net_tls_server_session_cache_ticket_keys(
+            env.cache, keys, &key_count));
+    AVS_UNIT_ASSERT_FAILED(
+            _avs_net_tls_server_session_cache_rotate_ticket_keys(env.cache));
+    destroy_cache(&env);
+}
+
+#ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+static void persist_to_buffer(avs_net_tls_server_session_cache_t *cache,
+                              void **out_buf,
+                              size_t *out_buf_size) {
+    avs_stream_t *membuf = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(membuf);
+    avs_persistence_context_t ctx =
+            avs_persistence_store_context_create(membuf);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_net_tls_server_session_cache_persistence(cache, &ctx));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(membuf, out_buf, out_buf_size));
+    avs_stream_cleanup(&membuf);
+}
+
+static avs_error_t
+restore_from_buffer(avs_net_tls_server_session_cache_t *cache,
+                    void *buf,
+                    size_t buf_size) {
+    avs_stream_inbuf_t inbuf = AVS_STREAM_INBUF_STATIC_INITIALIZER;
+    avs_stream_inbuf_set_buffer(&inbuf, buf, buf_size);
+    avs_persistence_context_t ctx =
+            avs_persistence_restore_context_create((avs_stream_t *) &inbuf);
+    avs_error_t err =
+            _avs_net_tls_server_session_cache_persistence(cache, &ctx);
+    avs_free(buf);
+    return err;
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, persistence) {
+    server_session_cache_env_t env = create_cache(4, true);
+    store_string(env.cache, "id1", "first");
+    store_string(env.cache, "id2", "second");
+    store_string(env.cache, "expired", "third");
+    env.cache->lru_head->expires = avs_time_real_now();
+    // make id1 the most recently used one
+    assert_stored(env.cache, "id1", "first");
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_net_tls_server_session_cache_rotate_ticket_keys(env.cache));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_net_tls_server_session_cache_rotate_ticket_keys(env.cache));
+
+    void *buf = NULL;
+    size_t buf_size;
+    persist_to_buffer(env.cache, &buf, &buf_size);
+
+    server_session_cache_env_t restored = create_cache(4, true);
+    // restoring replaces any previously stored sessions
+    store_string(restored.cache, "id3", "fourth");
+    AVS_UNIT_ASSERT_SUCCESS(
+            restore_from_buffer(restored.cache, buf, buf_size));
+
+    AVS_UNIT_ASSERT_EQUAL(restored.cache->session_count, 2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(restored.cache->lru_head->bytes, "id1",
+                                      3);
+    assert_not_stored(restored.cache, "id3");
+    assert_not_stored(restored.cache, "expired");
+    assert_stored(restored.cache, "id1", "first");
+    assert_stored(restored.cache, "id2", "second");
+
+    AVS_UNIT_ASSERT_EQUAL(restored.cache->ticket_key_count, 2);
+    for (size_t i = 0; i < restored.cache->ticket_key_count; ++i) {
+        assert_keys_equal(&restored.cache->ticket_keys[i],
+                          &env.cache->ticket_keys[i]);
+    }
+
+    destroy_cache(&restored);
+    destroy_cache(&env);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, persistence_smaller_cache) {
+    server_session_cache_env_t env = create_cache(4, false);
+    store_string(env.cache, "id1", "first");
+    store_string(env.cache, "id2", "second");
+    store_string(env.cache, "id3", "third");
+    void *buf = NULL;
+    size_t buf_size;
+    persist_to_buffer(env.cache, &buf, &buf_size);
+
+    // only the most recently used sessions that fit are restored
+    server_session_cache_env_t restored = create_cache(2, false);
+    AVS_UNIT_ASSERT_SUCCESS(
+            restore_from_buffer(restored.cache, buf, buf_size));
+    AVS_UNIT_ASSERT_EQUAL(restored.cache->session_count, 2);
+    assert_not_stored(restored.cache, "id1");
+    assert_stored(restored.cache, "id2", "second");
+    assert_stored(restored.cache, "id3", "third");
+
+    destroy_cache(&restored);
+    destroy_cache(&env);
+}
+
+AVS_UNIT_TEST(tls_server_session_cache, persistence_invalid_session_id) {
+    server_session_cache_env_t env = create_cache(4, false);
+    // longer than any valid TLS session ID
+    store_string(env.cache, "0123456789abcdef0123456789abcdef0", "data");
+    void *buf = NULL;
+    size_t buf_size;
+    persist_to_buffer(env.cache, &buf, &buf_size);
+
+    server_session_cache_env_t restored = create_cache(4, false);
+    avs_error_t err = restore_from_buffer(restored.cache, buf, buf_size);
+    AVS_UNIT_ASSERT_TRUE(avs_is_err(err));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EBADMSG);
+    AVS_UNIT_ASSERT_EQUAL(restored.cache->session_count, 0);
+
+    destroy_cache(&restored);
+    destroy_cache(&env);
+}
+#endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
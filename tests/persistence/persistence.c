@@ -252,3 +252,108 @@ AVS_UNIT_TEST(persistence, restore_from_nonempty_list) {
 
     AVS_LIST_CLEAR(&integer_list);
 }
+
+#ifdef AVS_COMMONS_WITH_AVS_RBTREE
+static int int32_tree_comparator(const void *a_, const void *b_) {
+    return int32_comparator(a_, b_, sizeof(int32_t));
+}
+
+static void noop_cleanup(void *element) {
+    (void) element;
+}
+
+AVS_UNIT_TEST(persistence, tree_store_restore) {
+    SCOPED_PERSISTENCE_TEST_ENV(env);
+
+    avs_persistence_context_t *store_ctx =
+            persistence_create_context(env, CONTEXT_STORE);
+    avs_persistence_context_t *restore_ctx =
+            persistence_create_context(env, CONTEXT_RESTORE);
+
+    AVS_RBTREE(int32_t) tree = AVS_RBTREE_NEW(int32_t, int32_tree_comparator);
+    AVS_UNIT_ASSERT_NOT_NULL(tree);
+    for (int32_t i = 0; i < 200; ++i) {
+        int32_t *elem = AVS_RBTREE_ELEM_NEW(int32_t);
+        AVS_UNIT_ASSERT_NOT_NULL(elem);
+        *elem = (i * 37) % 200;
+        AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_INSERT(tree, elem) == elem);
+    }
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_tree(
+            store_ctx, (AVS_RBTREE(void)) tree, sizeof(**tree),
+            persistence_list_element_handler, NULL, noop_cleanup));
+
+    AVS_RBTREE(int32_t) restored =
+            AVS_RBTREE_NEW(int32_t, int32_tree_comparator);
+    AVS_UNIT_ASSERT_NOT_NULL(restored);
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_tree(
+            restore_ctx, (AVS_RBTREE(void)) restored, sizeof(**restored),
+            persistence_list_element_handler, NULL, noop_cleanup));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(restored), 200);
+
+    int32_t expected = 0;
+    int32_t *elem;
+    AVS_RBTREE_FOREACH(elem, restored) {
+        AVS_UNIT_ASSERT_EQUAL(*elem, expected++);
+    }
+    AVS_UNIT_ASSERT_EQUAL(*AVS_RBTREE_FIND(restored, &(int32_t) { 150 }), 150);
+
+    AVS_RBTREE_DELETE(&tree);
+    AVS_RBTREE_DELETE(&restored);
+}
+
+static void store_int32_tree_data(avs_persistence_context_t *ctx,
+                                  const int32_t *values,
+                                  uint32_t count) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(ctx, &count));
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t value = values[i];
+        AVS_UNIT_ASSERT_SUCCESS(avs_persistence_i32(ctx, &value));
+    }
+}
+
+AVS_UNIT_TEST(persistence, tree_restore_unsorted) {
+    SCOPED_PERSISTENCE_TEST_ENV(env);
+
+    avs_persistence_context_t *store_ctx =
+            persistence_create_context(env, CONTEXT_STORE);
+    avs_persistence_context_t *restore_ctx =
+            persistence_create_context(env, CONTEXT_RESTORE);
+
+    static const int32_t VALUES[] = { 3, 1, 2 };
+    store_int32_tree_data(store_ctx, VALUES, AVS_ARRAY_SIZE(VALUES));
+
+    AVS_RBTREE(int32_t) restored =
+            AVS_RBTREE_NEW(int32_t, int32_tree_comparator);
+    AVS_UNIT_ASSERT_NOT_NULL(restored);
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_tree(
+            restore_ctx, (AVS_RBTREE(void)) restored, sizeof(**restored),
+            persistence_list_element_handler, NULL, noop_cleanup));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(restored), 3);
+    AVS_UNIT_ASSERT_EQUAL(*AVS_RBTREE_FIRST(restored), 1);
+    AVS_UNIT_ASSERT_EQUAL(*AVS_RBTREE_LAST(restored), 3);
+
+    AVS_RBTREE_DELETE(&restored);
+}
+
+AVS_UNIT_TEST(persistence, tree_restore_duplicate) {
+    SCOPED_PERSISTENCE_TEST_ENV(env);
+
+    avs_persistence_context_t *store_ctx =
+            persistence_create_context(env, CONTEXT_STORE);
+    avs_persistence_context_t *restore_ctx =
+            persistence_create_context(env, CONTEXT_RESTORE);
+
+    static const int32_t VALUES[] = { 1, 2, 2, 3 };
+    store_int32_tree_data(store_ctx, VALUES, AVS_ARRAY_SIZE(VALUES));
+
+    AVS_RBTREE(int32_t) restored =
+            AVS_RBTREE_NEW(int32_t, int32_tree_comparator);
+    AVS_UNIT_ASSERT_NOT_NULL(restored);
+    AVS_UNIT_ASSERT_FAILED(avs_persistence_tree(
+            restore_ctx, (AVS_RBTREE(void)) restored, sizeof(**restored),
+            persistence_list_element_handler, NULL, noop_cleanup));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(restored), 0);
+
+    AVS_RBTREE_DELETE(&restored);
+}
+#endif // AVS_COMMONS_WITH_AVS_RBTREE
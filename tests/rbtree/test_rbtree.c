@@ -101,6 +101,9 @@ static void assert_rb_properties_hold_recursive(void *node,
         ++*out_black_height;
     }
     *out_size = 1 + left_size + right_size;
+#ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+    AVS_UNIT_ASSERT_EQUAL(_AVS_RB_SUBTREE_SIZE(node), *out_size);
+#endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
 }
 
 static void assert_rb_properties_hold(AVS_RBTREE(int) tree_) {
@@ -148,6 +151,8 @@ static AVS_RBTREE(int) make_tree(int first, ...) {
 
 static const char *get_color_name(enum rb_color color) {
     switch (color) {
+    case DETACHED_POOLED:
+        return "DETACHED_POOLED";
     case DETACHED:
         return "DETACHED";
     case BLACK:
@@ -167,7 +172,7 @@ static void assert_node_equal(int *node,
                               int *right) {
     AVS_UNIT_ASSERT_EQUAL(value, *node);
     AVS_UNIT_ASSERT_EQUAL_STRING(get_color_name(color),
-                                 get_color_name(_AVS_RB_NODE(node)->color));
+                                 get_color_name(_AVS_RB_COLOR(node)));
     AVS_UNIT_ASSERT_TRUE(parent == _AVS_RB_PARENT(node));
     AVS_UNIT_ASSERT_TRUE(left == _AVS_RB_LEFT(node));
     AVS_UNIT_ASSERT_TRUE(right == _AVS_RB_RIGHT(node));
@@ -667,12 +672,12 @@ AVS_UNIT_TEST(rbtree, insert_case2) {
     AVS_UNIT_ASSERT_TRUE(root == _AVS_RB_PARENT(elem));
     AVS_UNIT_ASSERT_NULL(_AVS_RB_LEFT(elem));
     AVS_UNIT_ASSERT_NULL(_AVS_RB_RIGHT(elem));
-    AVS_UNIT_ASSERT_EQUAL(BLACK, _AVS_RB_NODE(root)->color);
+    AVS_UNIT_ASSERT_EQUAL(BLACK, _AVS_RB_COLOR(root));
 
     AVS_UNIT_ASSERT_NULL(_AVS_RB_PARENT(root));
     AVS_UNIT_ASSERT_TRUE(elem == _AVS_RB_LEFT(root));
     AVS_UNIT_ASSERT_NULL(_AVS_RB_RIGHT(root));
-    AVS_UNIT_ASSERT_EQUAL(RED, _AVS_RB_NODE(elem)->color);
+    AVS_UNIT_ASSERT_EQUAL(RED, _AVS_RB_COLOR(elem));
 
     assert_rb_properties_hold(tree);
 
@@ -1081,3 +1086,413 @@ AVS_UNIT_TEST(rbtree, clone_segfault) {
     AVS_UNIT_ASSERT_NULL(AVS_RBTREE_SIMPLE_CLONE(tree));
     AVS_RBTREE_DELETE(&tree);
 }
+
+#define BUILD_FROM_SORTED_MAX_ELEMENTS 70
+
+AVS_UNIT_TEST(rbtree, build_from_sorted) {
+    AVS_RBTREE_ELEM(int) elems[BUILD_FROM_SORTED_MAX_ELEMENTS];
+    for (size_t count = 0; count <= BUILD_FROM_SORTED_MAX_ELEMENTS; ++count) {
+        AVS_RBTREE(int) tree = AVS_RBTREE_NEW(int, int_comparator);
+        AVS_UNIT_ASSERT_NOT_NULL(tree);
+        for (size_t i = 0; i < count; ++i) {
+            AVS_UNIT_ASSERT_NOT_NULL((elems[i] = AVS_RBTREE_ELEM_NEW(int)));
+            *elems[i] = (int) i;
+        }
+        AVS_UNIT_ASSERT_SUCCESS(
+                AVS_RBTREE_BUILD_FROM_SORTED(tree, elems, count));
+        AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree), count);
+        assert_rb_properties_hold(tree);
+
+        int expected = 0;
+        AVS_RBTREE_ELEM(int) elem;
+        AVS_RBTREE_FOREACH(elem, tree) {
+            AVS_UNIT_ASSERT_EQUAL(*elem, expected++);
+        }
+        AVS_UNIT_ASSERT_EQUAL((size_t) expected, count);
+
+        // the tree remains fully usable
+        AVS_UNIT_ASSERT_NOT_NULL((elem = AVS_RBTREE_ELEM_NEW(int)));
+        *elem = -1;
+        AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_INSERT(tree, elem) == elem);
+        assert_rb_properties_hold(tree);
+        if (count) {
+            elem = AVS_RBTREE_FIND(tree, INTPTR((int) count / 2));
+            AVS_RBTREE_DELETE_ELEM(tree, &elem);
+            assert_rb_properties_hold(tree);
+        }
+
+        AVS_RBTREE_DELETE(&tree);
+    }
+}
+
+AVS_UNIT_TEST(rbtree, build_from_sorted_invalid) {
+    AVS_RBTREE(int) tree = make_tree(1, 0);
+    AVS_RBTREE_ELEM(int) elems[3];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(elems); ++i) {
+        AVS_UNIT_ASSERT_NOT_NULL((elems[i] = AVS_RBTREE_ELEM_NEW(int)));
+        *elems[i] = 10 + (int) i;
+    }
+    // non-empty tree
+    AVS_UNIT_ASSERT_FAILED(AVS_RBTREE_BUILD_FROM_SORTED(tree, elems, 3));
+    AVS_RBTREE_CLEAR(tree);
+
+    // not sorted
+    *elems[2] = 11;
+    AVS_UNIT_ASSERT_FAILED(AVS_RBTREE_BUILD_FROM_SORTED(tree, elems, 3));
+    *elems[2] = 5;
+    AVS_UNIT_ASSERT_FAILED(AVS_RBTREE_BUILD_FROM_SORTED(tree, elems, 3));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree), 0);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(elems); ++i) {
+        assert_node_equal(elems[i], *elems[i], DETACHED, NULL, NULL, NULL);
+    }
+
+    *elems[2] = 12;
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_BUILD_FROM_SORTED(tree, elems, 3));
+    assert_node_equal(elems[1], 11, BLACK, NULL, elems[0], elems[2]);
+    assert_node_equal(elems[0], 10, BLACK, elems[1], NULL, NULL);
+    assert_node_equal(elems[2], 12, BLACK, elems[1], NULL, NULL);
+    AVS_RBTREE_DELETE(&tree);
+}
+
+/* terminated with 0 */
+static void assert_tree_contents(AVS_RBTREE(int) tree, int first, ...) {
+    va_list list;
+    int value = first;
+    size_t num_values = 0;
+
+    assert_rb_properties_hold(tree);
+    va_start(list, first);
+
+    AVS_RBTREE_ELEM(int) elem;
+    AVS_RBTREE_FOREACH(elem, tree) {
+        AVS_UNIT_ASSERT_EQUAL(*elem, value);
+        value = va_arg(list, int);
+        ++num_values;
+    }
+    AVS_UNIT_ASSERT_EQUAL(value, 0);
+
+    va_end(list);
+    AVS_UNIT_ASSERT_EQUAL(num_values, AVS_RBTREE_SIZE(tree));
+}
+
+AVS_UNIT_TEST(rbtree, merge) {
+    AVS_RBTREE(int) dst = make_tree(1, 3, 5, 7, 9, 11, 0);
+    AVS_RBTREE(int) src = make_tree(2, 3, 4, 9, 12, 13, 14, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_MERGE(dst, src));
+    assert_tree_contents(dst, 1, 2, 3, 4, 5, 7, 9, 11, 12, 13, 14, 0);
+    assert_tree_contents(src, 3, 9, 0);
+
+    AVS_RBTREE(int) empty = make_tree(0);
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_MERGE(empty, dst));
+    assert_tree_contents(empty, 1, 2, 3, 4, 5, 7, 9, 11, 12, 13, 14, 0);
+    assert_tree_contents(dst, 0);
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_MERGE(empty, dst));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(empty), 11);
+
+    test_rb_alloc_null_countdown = 1;
+    AVS_UNIT_ASSERT_FAILED(AVS_RBTREE_MERGE(src, empty));
+    assert_tree_contents(src, 3, 9, 0);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(empty), 11);
+
+    AVS_RBTREE_DELETE(&dst);
+    AVS_RBTREE_DELETE(&src);
+    AVS_RBTREE_DELETE(&empty);
+}
+
+AVS_UNIT_TEST(rbtree, intersection) {
+    AVS_RBTREE(int) tree = make_tree(1, 2, 3, 4, 5, 6, 7, 8, 0);
+    AVS_RBTREE(int) other = make_tree(2, 4, 5, 8, 10, 0);
+    AVS_RBTREE(int) removed = make_tree(0);
+
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_INTERSECTION(tree, other, removed));
+    assert_tree_contents(tree, 2, 4, 5, 8, 0);
+    assert_tree_contents(other, 2, 4, 5, 8, 10, 0);
+    assert_tree_contents(removed, 1, 3, 6, 7, 0);
+
+    // removed is not empty
+    AVS_UNIT_ASSERT_FAILED(AVS_RBTREE_INTERSECTION(tree, other, removed));
+    assert_tree_contents(tree, 2, 4, 5, 8, 0);
+
+    AVS_RBTREE_CLEAR(removed);
+    AVS_RBTREE(int) empty = make_tree(0);
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_INTERSECTION(tree, empty, removed));
+    assert_tree_contents(tree, 0);
+    assert_tree_contents(removed, 2, 4, 5, 8, 0);
+
+    AVS_RBTREE_DELETE(&tree);
+    AVS_RBTREE_DELETE(&other);
+    AVS_RBTREE_DELETE(&removed);
+    AVS_RBTREE_DELETE(&empty);
+}
+
+AVS_UNIT_TEST(rbtree, difference) {
+    AVS_RBTREE(int) tree = make_tree(1, 2, 3, 4, 5, 6, 7, 8, 0);
+    AVS_RBTREE(int) other = make_tree(-1, 2, 4, 5, 8, 10, 0);
+    AVS_RBTREE(int) removed = make_tree(0);
+
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_DIFFERENCE(tree, other, removed));
+    assert_tree_contents(tree, 1, 3, 6, 7, 0);
+    assert_tree_contents(other, -1, 2, 4, 5, 8, 10, 0);
+    assert_tree_contents(removed, 2, 4, 5, 8, 0);
+
+    test_rb_alloc_null_countdown = 1;
+    AVS_RBTREE_CLEAR(removed);
+    AVS_UNIT_ASSERT_FAILED(AVS_RBTREE_DIFFERENCE(tree, tree, removed));
+    assert_tree_contents(tree, 1, 3, 6, 7, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RBTREE_DIFFERENCE(tree, tree, removed));
+    assert_tree_contents(tree, 0);
+    assert_tree_contents(removed, 1, 3, 6, 7, 0);
+
+    AVS_RBTREE_DELETE(&tree);
+    AVS_RBTREE_DELETE(&other);
+    AVS_RBTREE_DELETE(&removed);
+}
+
+AVS_UNIT_TEST(rbtree, detach_range) {
+    AVS_RBTREE(int) tree = make_tree(1, 2, 3, 4, 5, 6, 7, 8, 9, 0);
+    AVS_RBTREE(int) out = make_tree(0);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(3), INTPTR(6), out));
+    assert_tree_contents(tree, 1, 2, 7, 8, 9, 0);
+    assert_tree_contents(out, 3, 4, 5, 6, 0);
+
+    // out is not empty
+    AVS_UNIT_ASSERT_FAILED(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(1), INTPTR(2), out));
+    AVS_RBTREE_CLEAR(out);
+
+    // empty ranges
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(3), INTPTR(6), out));
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(9), INTPTR(7), out));
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(10), INTPTR(20), out));
+    assert_tree_contents(tree, 1, 2, 7, 8, 9, 0);
+    assert_tree_contents(out, 0);
+
+    // bounds not present in the tree
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(5), INTPTR(100), out));
+    assert_tree_contents(tree, 1, 2, 0);
+    assert_tree_contents(out, 7, 8, 9, 0);
+    AVS_RBTREE_CLEAR(out);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(-5), INTPTR(1), out));
+    assert_tree_contents(tree, 2, 0);
+    assert_tree_contents(out, 1, 0);
+
+    AVS_RBTREE_DELETE(&tree);
+    AVS_RBTREE_DELETE(&out);
+}
+
+AVS_UNIT_TEST(rbtree, detach_range_small_and_large) {
+    AVS_RBTREE(int) tree = make_tree(0);
+    for (int i = 1; i <= 100; ++i) {
+        AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_ELEM_NEW(int);
+        AVS_UNIT_ASSERT_NOT_NULL(elem);
+        *elem = i;
+        AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_INSERT(tree, elem) == elem);
+    }
+    AVS_RBTREE(int) out = make_tree(0);
+
+    // small ranges are detached element by element, without allocating
+    test_rb_alloc_null_countdown = 1;
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(40), INTPTR(49), out));
+    AVS_UNIT_ASSERT_EQUAL(test_rb_alloc_null_countdown, 1);
+    test_rb_alloc_null_countdown = 0;
+    assert_rb_properties_hold(tree);
+    assert_rb_properties_hold(out);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree), 90);
+    assert_tree_contents(out, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 0);
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_FIND(tree, INTPTR(45)));
+    AVS_RBTREE_CLEAR(out);
+
+    // ranges covering most of the tree are rebuilt
+    test_rb_alloc_null_countdown = 1;
+    AVS_UNIT_ASSERT_FAILED(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(1), INTPTR(80), out));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree), 90);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(out), 0);
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RBTREE_DETACH_RANGE(tree, INTPTR(1), INTPTR(80), out));
+    assert_rb_properties_hold(tree);
+    assert_rb_properties_hold(out);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree), 20);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(out), 70);
+    AVS_UNIT_ASSERT_EQUAL(*AVS_RBTREE_FIRST(tree), 81);
+    AVS_UNIT_ASSERT_EQUAL(*AVS_RBTREE_LAST(out), 80);
+
+    AVS_RBTREE_DELETE(&tree);
+    AVS_RBTREE_DELETE(&out);
+}
+
+#ifdef AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+AVS_UNIT_TEST(rbtree, nth_and_rank) {
+    AVS_RBTREE(int) tree = make_tree(0);
+    for (int i = 0; i < 100; ++i) {
+        AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_ELEM_NEW(int);
+        AVS_UNIT_ASSERT_NOT_NULL(elem);
+        *elem = ((i * 37) % 100) * 2;
+        AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_INSERT(tree, elem) == elem);
+    }
+    assert_rb_properties_hold(tree);
+
+    for (size_t i = 0; i < 100; ++i) {
+        AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_NTH(tree, i);
+        AVS_UNIT_ASSERT_NOT_NULL(elem);
+        AVS_UNIT_ASSERT_EQUAL(*elem, (int) i * 2);
+        AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_RANK(elem), i);
+    }
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_NTH(tree, 100));
+
+    for (int i = 0; i < 100; i += 3) {
+        AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_FIND(tree, INTPTR(i * 2));
+        AVS_RBTREE_DELETE_ELEM(tree, &elem);
+        assert_rb_properties_hold(tree);
+    }
+    size_t index = 0;
+    AVS_RBTREE_ELEM(int) elem;
+    AVS_RBTREE_FOREACH(elem, tree) {
+        AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_NTH(tree, index) == elem);
+        AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_RANK(elem), index);
+        ++index;
+    }
+    AVS_UNIT_ASSERT_EQUAL(index, AVS_RBTREE_SIZE(tree));
+
+    AVS_RBTREE_DELETE(&tree);
+}
+
+AVS_UNIT_TEST(rbtree, count_range) {
+    AVS_RBTREE(int) tree = make_tree(2, 4, 6, 8, 10, 12, 14, 0);
+
+    AVS_UNIT_ASSERT_EQUAL(
+            AVS_RBTREE_COUNT_RANGE(tree, INTPTR(4), INTPTR(10)), 4);
+    AVS_UNIT_ASSERT_EQUAL(
+            AVS_RBTREE_COUNT_RANGE(tree, INTPTR(3), INTPTR(11)), 4);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_COUNT_RANGE(tree, INTPTR(6), INTPTR(6)),
+                          1);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_COUNT_RANGE(tree, INTPTR(7), INTPTR(7)),
+                          0);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_COUNT_RANGE(tree, INTPTR(10), INTPTR(4)),
+                          0);
+    AVS_UNIT_ASSERT_EQUAL(
+            AVS_RBTREE_COUNT_RANGE(tree, INTPTR(-100), INTPTR(100)), 7);
+    AVS_UNIT_ASSERT_EQUAL(
+            AVS_RBTREE_COUNT_RANGE(tree, INTPTR(15), INTPTR(100)), 0);
+
+    AVS_RBTREE_DELETE(&tree);
+}
+#endif // AVS_COMMONS_RBTREE_WITH_ORDER_STATISTICS
+
+AVS_UNIT_TEST(rbtree, pool) {
+    avs_rbtree_pool_t *pool = AVS_RBTREE_POOL_NEW(int, 4);
+    AVS_UNIT_ASSERT_NOT_NULL(pool);
+    AVS_RBTREE(int) tree = AVS_RBTREE_NEW_WITH_POOL(int, int_comparator, pool);
+    AVS_UNIT_ASSERT_NOT_NULL(tree);
+
+    AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_POOL_ELEM_NEW(int, pool);
+    AVS_UNIT_ASSERT_NOT_NULL(elem);
+    assert_node_equal(elem, 0, DETACHED_POOLED, (int *) pool, NULL, NULL);
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_ELEM_NEXT(elem));
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_ELEM_PREV(elem));
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&elem);
+
+    for (int i = 0; i < 10; ++i) {
+        elem = AVS_RBTREE_POOL_ELEM_NEW(int, pool);
+        AVS_UNIT_ASSERT_NOT_NULL(elem);
+        *elem = (i * 7) % 10;
+        AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_INSERT(tree, elem) == elem);
+        assert_rb_properties_hold(tree);
+    }
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree), 10);
+
+    // released slot is reused for the next element
+    elem = AVS_RBTREE_FIND(tree, INTPTR(5));
+    AVS_RBTREE_ELEM(int) detached = elem;
+    AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_DETACH(tree, elem) == detached);
+    assert_node_equal(detached, 5, DETACHED_POOLED, (int *) pool, NULL, NULL);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&detached);
+    assert_rb_properties_hold(tree);
+    AVS_RBTREE_ELEM(int) reused = AVS_RBTREE_POOL_ELEM_NEW(int, pool);
+    AVS_UNIT_ASSERT_TRUE(reused == elem);
+    AVS_UNIT_ASSERT_EQUAL(*reused, 0);
+    *reused = 5;
+    AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_INSERT(tree, reused) == reused);
+
+    int expected = 0;
+    AVS_RBTREE_FOREACH(elem, tree) {
+        AVS_UNIT_ASSERT_EQUAL(*elem, expected++);
+    }
+
+    elem = AVS_RBTREE_FIND(tree, INTPTR(3));
+    AVS_RBTREE_DELETE_ELEM(tree, &elem);
+    AVS_UNIT_ASSERT_NULL(elem);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree), 9);
+    assert_rb_properties_hold(tree);
+
+    AVS_RBTREE_DELETE(&tree);
+    AVS_UNIT_ASSERT_NULL(tree);
+    AVS_RBTREE_POOL_DELETE(&pool);
+    AVS_UNIT_ASSERT_NULL(pool);
+}
+
+AVS_UNIT_TEST(rbtree, pool_clear) {
+    avs_rbtree_pool_t *pool = AVS_RBTREE_POOL_NEW(int, 3);
+    AVS_RBTREE(int) tree1 = AVS_RBTREE_NEW_WITH_POOL(int, int_comparator, pool);
+    AVS_RBTREE(int) tree2 = AVS_RBTREE_NEW_WITH_POOL(int, int_comparator, pool);
+    AVS_UNIT_ASSERT_NOT_NULL(tree1);
+    AVS_UNIT_ASSERT_NOT_NULL(tree2);
+
+    AVS_RBTREE_ELEM(int) first_elem = NULL;
+    for (int i = 0; i < 8; ++i) {
+        AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_POOL_ELEM_NEW(int, pool);
+        AVS_UNIT_ASSERT_NOT_NULL(elem);
+        if (!first_elem) {
+            first_elem = elem;
+        }
+        *elem = i;
+        AVS_RBTREE_INSERT(i % 2 ? tree1 : tree2, elem);
+    }
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree1), 4);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree2), 4);
+
+    AVS_RBTREE_POOL_CLEAR(pool);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree1), 0);
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_FIRST(tree1));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(tree2), 0);
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_FIRST(tree2));
+
+    // slabs are reused after clearing the pool
+    AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_POOL_ELEM_NEW(int, pool);
+    AVS_UNIT_ASSERT_TRUE(elem == first_elem);
+    *elem = 42;
+    AVS_UNIT_ASSERT_TRUE(AVS_RBTREE_INSERT(tree2, elem) == elem);
+    assert_rb_properties_hold(tree2);
+
+    AVS_RBTREE_DELETE(&tree1);
+    AVS_RBTREE_POOL_CLEAR(pool);
+    AVS_RBTREE_DELETE(&tree2);
+    AVS_RBTREE_POOL_DELETE(&pool);
+}
+
+AVS_UNIT_TEST(rbtree, pool_alloc_fail) {
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_POOL_NEW(int, 0));
+
+    avs_rbtree_pool_t *pool = AVS_RBTREE_POOL_NEW(int, 2);
+    AVS_UNIT_ASSERT_NOT_NULL(pool);
+
+    // return NULL for slab allocation
+    test_rb_alloc_null_countdown = 1;
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_POOL_ELEM_NEW(int, pool));
+
+    AVS_RBTREE_ELEM(int) elem = AVS_RBTREE_POOL_ELEM_NEW(int, pool);
+    AVS_UNIT_ASSERT_NOT_NULL(elem);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&elem);
+    AVS_RBTREE_POOL_DELETE(&pool);
+}
@@ -24,6 +24,7 @@
 #include <avsystem/commons/avs_sched.h>
 #include <avsystem/commons/avs_time.h>
 #include <avsystem/commons/avs_unit_test.h>
+#include <avsystem/commons/avs_utils.h>
 
 #define MODULE_NAME sched_test
 #include <avs_x_log_config.h>
@@ -283,4 +284,106 @@ AVS_UNIT_TEST(sched, rescheduling_in_callback) {
     teardown_test(&env);
 }
 
+typedef struct {
+    int *order;
+    size_t *order_size;
+    int value;
+} order_recorder_t;
+
+static void order_recorder(avs_sched_t *sched, const void *recorder_) {
+    (void) sched;
+    const order_recorder_t *recorder = (const order_recorder_t *) recorder_;
+    recorder->order[(*recorder->order_size)++] = recorder->value;
+}
+
+AVS_UNIT_TEST(sched, same_instant_fifo) {
+    sched_test_env_t env = setup_test();
+
+    int order[4];
+    size_t order_size = 0;
+    avs_sched_handle_t task = NULL;
+    const avs_time_duration_t delay =
+            avs_time_duration_from_scalar(1, AVS_TIME_S);
+    for (int i = 0; i < 3; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_DELAYED(
+                env.sched, i == 0 ? &task : NULL, delay, order_recorder,
+                (&(const order_recorder_t) { order, &order_size, i }),
+                sizeof(order_recorder_t)));
+    }
+    // rescheduling to the same instant moves the job to the end of the queue
+    AVS_RESCHED_DELAYED(&task, delay);
+    AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_DELAYED(
+            env.sched, NULL, delay, order_recorder,
+            (&(const order_recorder_t) { order, &order_size, 3 }),
+            sizeof(order_recorder_t)));
+
+    mock_clock_advance(delay);
+    avs_sched_run(env.sched);
+    AVS_UNIT_ASSERT_EQUAL(order_size, 4);
+    AVS_UNIT_ASSERT_EQUAL(order[0], 1);
+    AVS_UNIT_ASSERT_EQUAL(order[1], 2);
+    AVS_UNIT_ASSERT_EQUAL(order[2], 0);
+    AVS_UNIT_ASSERT_EQUAL(order[3], 3);
+
+    teardown_test(&env);
+}
+
+#define MANY_JOBS_COUNT 1000
+
+AVS_UNIT_TEST(sched, many_jobs_ordering) {
+    sched_test_env_t env = setup_test();
+
+    static avs_sched_handle_t tasks[MANY_JOBS_COUNT];
+    static int order[MANY_JOBS_COUNT];
+    size_t order_size = 0;
+    avs_rand_seed_t seed = 42;
+    for (int i = 0; i < MANY_JOBS_COUNT; ++i) {
+        tasks[i] = NULL;
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_DELAYED(
+                env.sched, &tasks[i],
+                avs_time_duration_from_scalar(avs_rand_r(&seed) % 100 + 1,
+                                              AVS_TIME_S),
+                order_recorder,
+                (&(const order_recorder_t) { order, &order_size, i }),
+                sizeof(order_recorder_t)));
+    }
+    // cancel every third job and reschedule every fifth one
+    for (int i = 0; i < MANY_JOBS_COUNT; ++i) {
+        if (i % 3 == 0) {
+            avs_sched_del(&tasks[i]);
+            AVS_UNIT_ASSERT_NULL(tasks[i]);
+        } else if (i % 5 == 0) {
+            AVS_UNIT_ASSERT_SUCCESS(AVS_RESCHED_DELAYED(
+                    &tasks[i], avs_time_duration_from_scalar(
+                                       avs_rand_r(&seed) % 100 + 1,
+                                       AVS_TIME_S)));
+        }
+    }
+
+    avs_time_monotonic_t expected_times[MANY_JOBS_COUNT];
+    for (int i = 0; i < MANY_JOBS_COUNT; ++i) {
+        expected_times[i] = avs_sched_time(&tasks[i]);
+    }
+
+    avs_time_monotonic_t last_time = avs_sched_time_of_next(env.sched);
+    while (avs_time_monotonic_valid(avs_sched_time_of_next(env.sched))) {
+        avs_time_monotonic_t next = avs_sched_time_of_next(env.sched);
+        AVS_UNIT_ASSERT_FALSE(avs_time_monotonic_before(next, last_time));
+        mock_clock_advance(avs_time_monotonic_diff(next, MOCK_CLOCK));
+        size_t executed_before = order_size;
+        avs_sched_run(env.sched);
+        AVS_UNIT_ASSERT_TRUE(order_size > executed_before);
+        for (size_t i = executed_before; i < order_size; ++i) {
+            AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+                    expected_times[order[i]], next));
+            AVS_UNIT_ASSERT_NULL(tasks[order[i]]);
+        }
+        last_time = next;
+    }
+    AVS_UNIT_ASSERT_EQUAL(order_size,
+                          MANY_JOBS_COUNT - (MANY_JOBS_COUNT + 2) / 3);
+
+    teardown_test(&env);
+}
+
 #warning "TODO: More tests"
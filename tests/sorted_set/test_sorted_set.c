@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include <avsystem/commons/avs_memory.h>
+#include <avsystem/commons/avs_sorted_set.h>
 #include <avsystem/commons/avs_unit_test.h>
 
 #ifdef __cplusplus
@@ -73,9 +74,12 @@ static AVS_SORTED_SET(int) make_sorted_set(int first, ...) {
 AVS_UNIT_TEST(sorted_set, create) {
     AVS_SORTED_SET(int) sorted_set = AVS_SORTED_SET_NEW(int, int_comparator);
 
+#ifndef AVS_COMMONS_WITH_AVS_RBTREE
     struct sorted_set *sorted_set_struct = _AVS_SORTED_SET(sorted_set);
     AVS_UNIT_ASSERT_TRUE(sorted_set_struct->cmp == int_comparator);
     AVS_UNIT_ASSERT_NULL(sorted_set_struct->head);
+#endif // AVS_COMMONS_WITH_AVS_RBTREE
+    AVS_UNIT_ASSERT_NULL(AVS_SORTED_SET_FIRST(sorted_set));
     AVS_UNIT_ASSERT_EQUAL((size_t) 0, AVS_SORTED_SET_SIZE(sorted_set));
 
     AVS_SORTED_SET_DELETE(&sorted_set);
@@ -97,8 +101,14 @@ AVS_UNIT_TEST(sorted_set, clear) {
 
     size_t i = 0;
     AVS_SORTED_SET_CLEAR(sorted_set) {
-        AVS_UNIT_ASSERT_EQUAL(**sorted_set, expected_cleanup_order[i++]);
+        AVS_UNIT_ASSERT_TRUE(i < AVS_ARRAY_SIZE(expected_cleanup_order));
+#ifndef AVS_COMMONS_WITH_AVS_RBTREE
+        /* the rbtree backend releases elements in an unspecified order */
+        AVS_UNIT_ASSERT_EQUAL(**sorted_set, expected_cleanup_order[i]);
+#endif // AVS_COMMONS_WITH_AVS_RBTREE
+        ++i;
     }
+    AVS_UNIT_ASSERT_EQUAL(i, AVS_ARRAY_SIZE(expected_cleanup_order));
 
     AVS_UNIT_ASSERT_NOT_NULL(sorted_set);
     AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set), 0);
@@ -294,9 +304,12 @@ AVS_UNIT_TEST(sorted_set, double_insert) {
                          == new_elem);
     AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set), 1);
 
+#ifndef AVS_COMMONS_WITH_AVS_RBTREE
+    /* re-inserting an attached element is only allowed by the list backend */
     AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_INSERT(sorted_set, new_elem)
                          == new_elem);
     AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set), 1);
+#endif // AVS_COMMONS_WITH_AVS_RBTREE
 
     AVS_SORTED_SET_ELEM(int) duplicate_elem = AVS_SORTED_SET_ELEM_NEW(int);
     *duplicate_elem = 42;
@@ -368,6 +381,28 @@ AVS_UNIT_TEST(sorted_set, delete_elem) {
     AVS_SORTED_SET_DELETE(&sorted_set);
 }
 
+#ifndef AVS_COMMONS_WITH_AVS_RBTREE
+/* with AVS_RBTREE, deleting an element that is not attached is undefined */
+AVS_UNIT_TEST(sorted_set, delete_elem_not_in_set) {
+    AVS_SORTED_SET(int) sorted_set = make_sorted_set(1, 2, 3, 0);
+
+    AVS_SORTED_SET_ELEM(int) detached = AVS_SORTED_SET_ELEM_NEW(int);
+    *detached = 2;
+    AVS_SORTED_SET_ELEM(int) attached =
+            AVS_SORTED_SET_FIND(sorted_set, INTPTR(2));
+
+    /* an element equal to one in the set, but not attached to it */
+    AVS_SORTED_SET_DELETE_ELEM(sorted_set, &detached);
+    AVS_UNIT_ASSERT_NOT_NULL(detached);
+    AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set), 3);
+    AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_FIND(sorted_set, INTPTR(2))
+                         == attached);
+
+    AVS_SORTED_SET_ELEM_DELETE_DETACHED(&detached);
+    AVS_SORTED_SET_DELETE(&sorted_set);
+}
+#endif // AVS_COMMONS_WITH_AVS_RBTREE
+
 AVS_UNIT_TEST(sorted_set, detach_elem) {
     AVS_SORTED_SET(int) sorted_set = AVS_SORTED_SET_NEW(int, int_comparator);
 
@@ -394,8 +429,7 @@ AVS_UNIT_TEST(sorted_set, detach_elem) {
 
     /* detach first element */
     AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_DETACH(sorted_set, elem_1) == elem_1);
-    AVS_UNIT_ASSERT_TRUE(*sorted_set
-                         == elem_2); // sorted_set points to elem_2 now
+    AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_FIRST(sorted_set) == elem_2);
     AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set), 5);
 
     /* detach last element */
@@ -411,8 +445,7 @@ AVS_UNIT_TEST(sorted_set, detach_elem) {
     /* detach the last two elements */
     AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_DETACH(sorted_set, elem_2) == elem_2);
     AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set), 1);
-    AVS_UNIT_ASSERT_TRUE(*sorted_set
-                         == elem_5); // sorted_set points to elem_5 now
+    AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_FIRST(sorted_set) == elem_5);
     AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_DETACH(sorted_set, elem_5) == elem_5);
     AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set), 0);
 
@@ -427,3 +460,66 @@ AVS_UNIT_TEST(sorted_set, detach_elem) {
 
     AVS_SORTED_SET_DELETE(&sorted_set);
 }
+
+#define NUM_ELEMENTS 1000
+
+AVS_UNIT_TEST(sorted_set, many_elements) {
+    AVS_SORTED_SET(int) sorted_set = AVS_SORTED_SET_NEW(int, int_comparator);
+
+    // insert even numbers in pseudo-random order; 7 is coprime with 1000
+    for (int i = 0; i < NUM_ELEMENTS; ++i) {
+        AVS_SORTED_SET_ELEM(int) elem = AVS_SORTED_SET_ELEM_NEW(int);
+        *elem = 2 * ((i * 7) % NUM_ELEMENTS);
+        AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_INSERT(sorted_set, elem) == elem);
+    }
+    AVS_UNIT_ASSERT_EQUAL(AVS_SORTED_SET_SIZE(sorted_set),
+                          (size_t) NUM_ELEMENTS);
+    AVS_UNIT_ASSERT_EQUAL(*AVS_SORTED_SET_FIRST(sorted_set), 0);
+    AVS_UNIT_ASSERT_EQUAL(*AVS_SORTED_SET_LAST(sorted_set),
+                          2 * (NUM_ELEMENTS - 1));
+
+    int expected = 0;
+    AVS_SORTED_SET_ELEM(int) it;
+    AVS_SORTED_SET_FOREACH(it, sorted_set) {
+        AVS_UNIT_ASSERT_EQUAL(*it, expected);
+        AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_FIND(sorted_set, INTPTR(expected))
+                             == it);
+        AVS_UNIT_ASSERT_NULL(AVS_SORTED_SET_FIND(sorted_set,
+                                                 INTPTR(expected + 1)));
+        AVS_UNIT_ASSERT_TRUE(
+                AVS_SORTED_SET_LOWER_BOUND(sorted_set, INTPTR(expected - 1))
+                == it);
+        AVS_UNIT_ASSERT_TRUE(
+                AVS_SORTED_SET_UPPER_BOUND(sorted_set, INTPTR(expected))
+                == AVS_SORTED_SET_ELEM_NEXT(it));
+        expected += 2;
+    }
+
+    // remove every third element, including the first and the last ones
+    for (int value = 0; value < 2 * NUM_ELEMENTS; value += 6) {
+        AVS_SORTED_SET_ELEM(int) elem =
+                AVS_SORTED_SET_FIND(sorted_set, INTPTR(value));
+        AVS_UNIT_ASSERT_NOT_NULL(elem);
+        AVS_SORTED_SET_DELETE_ELEM(sorted_set, &elem);
+        AVS_UNIT_ASSERT_NULL(AVS_SORTED_SET_FIND(sorted_set, INTPTR(value)));
+    }
+    AVS_SORTED_SET_ELEM(int) last = AVS_SORTED_SET_LAST(sorted_set);
+    AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_DETACH(sorted_set, last) == last);
+#ifndef AVS_COMMONS_WITH_AVS_RBTREE
+    AVS_UNIT_ASSERT_NULL(AVS_SORTED_SET_DETACH(sorted_set, last));
+#endif // AVS_COMMONS_WITH_AVS_RBTREE
+    AVS_SORTED_SET_ELEM_DELETE_DETACHED(&last);
+
+    size_t count = 0;
+    AVS_SORTED_SET_ELEM(int) prev = NULL;
+    AVS_SORTED_SET_FOREACH(it, sorted_set) {
+        AVS_UNIT_ASSERT_TRUE(*it % 6 != 0);
+        AVS_UNIT_ASSERT_TRUE(!prev || *prev < *it);
+        prev = it;
+        ++count;
+    }
+    AVS_UNIT_ASSERT_EQUAL(count, AVS_SORTED_SET_SIZE(sorted_set));
+    AVS_UNIT_ASSERT_TRUE(AVS_SORTED_SET_LAST(sorted_set) == prev);
+
+    AVS_SORTED_SET_DELETE(&sorted_set);
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs the sorted set test suite against the list-based implementation in
+// builds that use AVS_RBTREE for sorted sets.
+#include <avs_commons_init.h>
+
+#undef AVS_COMMONS_WITH_AVS_RBTREE
+
+#include "src/sorted_set/avs_sorted_set.c"
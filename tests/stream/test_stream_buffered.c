@@ -387,3 +387,57 @@ AVS_UNIT_TEST(stream_buffered, peek) {
 
     teardown_stream(&stream, &ctx);
 }
+
+AVS_UNIT_TEST(stream_buffered, peek_window) {
+    stream_ctx_t ctx;
+    avs_stream_t *stream = setup_input_stream(&ctx);
+
+    const char *data;
+    size_t length;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek_window(stream, 0, &data, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, STREAM_BUFFER_SIZE);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, TEST_DATA, length);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek_window(
+            stream, STREAM_BUFFER_SIZE - 1, &data, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, 1);
+    AVS_UNIT_ASSERT_EQUAL(*data, TEST_DATA[STREAM_BUFFER_SIZE - 1]);
+
+    avs_error_t err = avs_stream_peek_window(stream, STREAM_BUFFER_SIZE, &data,
+                                             &length);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ENOBUFS);
+
+    teardown_stream(&stream, &ctx);
+}
+
+AVS_UNIT_TEST(stream_buffered, getline_across_buffer_boundary) {
+    stream_ctx_t ctx;
+    avs_stream_t *stream = setup_input_stream(&ctx);
+    ctx.data[STREAM_BUFFER_SIZE - 1] = '\r';
+    ctx.data[STREAM_BUFFER_SIZE] = '\n';
+    ctx.data[100] = '\n';
+
+    char buf[STREAM_SIZE];
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_getline(
+            stream, &bytes_read, &message_finished, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, STREAM_BUFFER_SIZE - 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, TEST_DATA, bytes_read);
+    AVS_UNIT_ASSERT_FALSE(message_finished);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_getline(
+            stream, &bytes_read, &message_finished, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 100 - STREAM_BUFFER_SIZE - 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, &TEST_DATA[STREAM_BUFFER_SIZE + 1],
+                                      bytes_read);
+    AVS_UNIT_ASSERT_FALSE(message_finished);
+
+    AVS_UNIT_ASSERT_TRUE(avs_is_eof(avs_stream_getline(
+            stream, &bytes_read, &message_finished, buf, sizeof(buf))));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, STREAM_SIZE - 101);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, &TEST_DATA[101], bytes_read);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+
+    teardown_stream(&stream, &ctx);
+}
@@ -169,3 +169,73 @@ AVS_UNIT_TEST(stream_file, extensions_length) {
     AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
     unlink(filename);
 }
+
+AVS_UNIT_TEST(stream_file, mmap_read) {
+    char filename[sizeof(TEMPLATE)];
+    static const char data[] = "first line\nsecond line\n";
+    avs_stream_t *stream;
+    AVS_UNIT_ASSERT_SUCCESS(make_temporary(filename));
+    AVS_UNIT_ASSERT_NOT_NULL(
+            (stream = avs_stream_file_create(filename, AVS_STREAM_FILE_WRITE)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, data, strlen(data)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+
+    AVS_UNIT_ASSERT_NOT_NULL(
+            (stream = avs_stream_file_create(
+                     filename, AVS_STREAM_FILE_READ | AVS_STREAM_FILE_MMAP)));
+#ifdef AVS_COMMONS_STREAM_WITH_FILE_MMAP
+    const char *window;
+    size_t window_length;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_peek_window(stream, 6, &window, &window_length));
+    AVS_UNIT_ASSERT_EQUAL(window_length, strlen(data) - 6);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(window, "line\n", 5);
+#endif // AVS_COMMONS_STREAM_WITH_FILE_MMAP
+
+    avs_off_t length;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_file_length(stream, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, strlen(data));
+
+    char line[32];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_getline(stream, NULL, NULL, line, sizeof(line)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(line, "first line");
+    avs_off_t offset;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_offset(stream, &offset));
+    AVS_UNIT_ASSERT_EQUAL(offset, strlen("first line\n"));
+
+    char value;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek(stream, 0, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 's');
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_file_seek(stream, 3));
+    size_t bytes_read;
+    bool end_of_msg;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read(stream, &bytes_read, &end_of_msg,
+                                            line, sizeof(line)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, strlen(data) - 3);
+    AVS_UNIT_ASSERT_TRUE(end_of_msg);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(line, data + 3, bytes_read);
+    AVS_UNIT_ASSERT_TRUE(avs_is_eof(avs_stream_peek(stream, 0, &value)));
+
+    avs_error_t err = avs_stream_write(stream, data, 1);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EBADF);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+
+    AVS_UNIT_ASSERT_NULL(avs_stream_file_create(
+            filename, AVS_STREAM_FILE_WRITE | AVS_STREAM_FILE_MMAP));
+    unlink(filename);
+}
+
+AVS_UNIT_TEST(stream_file, mmap_empty_file) {
+    char filename[sizeof(TEMPLATE)];
+    avs_stream_t *stream;
+    AVS_UNIT_ASSERT_SUCCESS(make_temporary(filename));
+    AVS_UNIT_ASSERT_NOT_NULL(
+            (stream = avs_stream_file_create(
+                     filename, AVS_STREAM_FILE_READ | AVS_STREAM_FILE_MMAP)));
+    AVS_UNIT_ASSERT_TRUE(avs_is_eof(avs_stream_peek(stream, 0, &(char) { 0 })));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    unlink(filename);
+}
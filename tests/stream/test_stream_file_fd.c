@@ -0,0 +1,189 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+int mkstemp(char *filename_template);
+
+static char FD_TEMPLATE[] = "/tmp/test_stream_file_fd-XXXXXX";
+
+static void make_temporary_fd_file(char *out_filename) {
+    memcpy(out_filename, FD_TEMPLATE, sizeof(FD_TEMPLATE));
+    int fd = mkstemp(out_filename);
+    AVS_UNIT_ASSERT_TRUE(fd >= 0);
+    close(fd);
+}
+
+static void assert_file_contents(const char *path,
+                                 const char *expected,
+                                 size_t expected_size) {
+    struct stat st;
+    AVS_UNIT_ASSERT_SUCCESS(stat(path, &st));
+    AVS_UNIT_ASSERT_EQUAL(st.st_size, expected_size);
+    if (expected_size == 0) {
+        return;
+    }
+    char *data = (char *) avs_malloc(expected_size);
+    AVS_UNIT_ASSERT_NOT_NULL(data);
+    int fd = open(path, O_RDONLY);
+    AVS_UNIT_ASSERT_TRUE(fd >= 0);
+    AVS_UNIT_ASSERT_EQUAL(read(fd, data, expected_size), expected_size);
+    close(fd);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, expected, expected_size);
+    avs_free(data);
+}
+
+static const char FD_DATA[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+AVS_UNIT_TEST(stream_file_fd, write_coalescing) {
+    char filename[sizeof(FD_TEMPLATE)];
+    make_temporary_fd_file(filename);
+
+    avs_stream_file_fd_config_t config = {
+        .write_buffer_size = 8
+    };
+    avs_stream_t *stream = avs_stream_file_fd_create(filename, &config);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    file_fd_stream_t *file = (file_fd_stream_t *) stream;
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, FD_DATA, 3));
+    AVS_UNIT_ASSERT_EQUAL(file->buffer_used, 3);
+    assert_file_contents(filename, NULL, 0);
+
+    // fills up the buffer, then writes 16 bytes directly, buffers the rest
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, FD_DATA + 3, 23));
+    AVS_UNIT_ASSERT_EQUAL(file->buffer_used, 2);
+    assert_file_contents(filename, FD_DATA, 24);
+
+    avs_off_t offset;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_offset(stream, &offset));
+    AVS_UNIT_ASSERT_EQUAL(offset, 26);
+
+    void *window;
+    size_t window_length;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write_reserve(stream, 1, &window, &window_length));
+    AVS_UNIT_ASSERT_EQUAL(window_length, 6);
+    memcpy(window, FD_DATA + 26, 6);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write_commit(stream, 6));
+    AVS_UNIT_ASSERT_EQUAL(file->buffer_used, 0);
+    assert_file_contents(filename, FD_DATA, 32);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(stream, FD_DATA + 32, strlen(FD_DATA) - 32));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
+    assert_file_contents(filename, FD_DATA, strlen(FD_DATA));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    unlink(filename);
+}
+
+AVS_UNIT_TEST(stream_file_fd, write_error_reports_accepted_length) {
+    // writes to /dev/full always fail with ENOSPC
+    if (access("/dev/full", W_OK)) {
+        return;
+    }
+    avs_stream_file_fd_config_t config = {
+        .write_buffer_size = 8
+    };
+    avs_stream_t *stream = avs_stream_file_fd_create("/dev/full", &config);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    file_fd_stream_t *file = (file_fd_stream_t *) stream;
+
+    size_t length = 3;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write_some(stream, FD_DATA, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, 3);
+
+    // 5 bytes fill up the buffer, which then cannot be flushed
+    length = 20;
+    AVS_UNIT_ASSERT_FAILED(
+            avs_stream_write_some(stream, FD_DATA + 3, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, 5);
+    AVS_UNIT_ASSERT_EQUAL(file->buffer_used, 8);
+    avs_off_t offset;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_offset(stream, &offset));
+    AVS_UNIT_ASSERT_EQUAL(offset, 8);
+
+    // the buffered data cannot be flushed on close either
+    AVS_UNIT_ASSERT_FAILED(avs_stream_cleanup(&stream));
+    AVS_UNIT_ASSERT_NULL(stream);
+
+    // the direct write of whole buffers fails without writing anything
+    stream = avs_stream_file_fd_create("/dev/full", &config);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    length = 20;
+    AVS_UNIT_ASSERT_FAILED(avs_stream_write_some(stream, FD_DATA, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, 0);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_offset(stream, &offset));
+    AVS_UNIT_ASSERT_EQUAL(offset, 0);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_file_fd, preallocate) {
+    char filename[sizeof(FD_TEMPLATE)];
+    make_temporary_fd_file(filename);
+
+    avs_stream_file_fd_config_t config = {
+        .preallocate_size = 4096
+    };
+    avs_stream_t *stream = avs_stream_file_fd_create(filename, &config);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, FD_DATA, 10));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    // file is truncated to the actual data size
+    assert_file_contents(filename, FD_DATA, 10);
+    unlink(filename);
+}
+
+AVS_UNIT_TEST(stream_file_fd, atomic_commit) {
+    char filename[sizeof(FD_TEMPLATE)];
+    make_temporary_fd_file(filename);
+    char tmp_filename[sizeof(FD_TEMPLATE) + sizeof(TMP_SUFFIX) - 1];
+    memcpy(tmp_filename, filename, sizeof(FD_TEMPLATE) - 1);
+    memcpy(tmp_filename + sizeof(FD_TEMPLATE) - 1, TMP_SUFFIX,
+           sizeof(TMP_SUFFIX));
+
+    avs_stream_file_fd_config_t config = {
+        .flags = AVS_STREAM_FILE_FD_ATOMIC | AVS_STREAM_FILE_FD_SYNC
+    };
+
+    // closing without commit leaves the original file untouched
+    avs_stream_t *stream = avs_stream_file_fd_create(filename, &config);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, FD_DATA, 5));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    assert_file_contents(filename, NULL, 0);
+    AVS_UNIT_ASSERT_FAILED(access(tmp_filename, F_OK));
+
+    stream = avs_stream_file_fd_create(filename, &config);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, FD_DATA, 5));
+    assert_file_contents(filename, NULL, 0);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
+    assert_file_contents(filename, FD_DATA, 5);
+    AVS_UNIT_ASSERT_FAILED(access(tmp_filename, F_OK));
+
+    // no more data is accepted after commit
+    avs_error_t err = avs_stream_write(stream, FD_DATA, 5);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EBADF);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    assert_file_contents(filename, FD_DATA, 5);
+    unlink(filename);
+}
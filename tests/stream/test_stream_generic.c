@@ -22,6 +22,7 @@
 #include <avsystem/commons/avs_stream_buffered.h>
 #include <avsystem/commons/avs_stream_file.h>
 #include <avsystem/commons/avs_stream_membuf.h>
+#include <avsystem/commons/avs_stream_outbuf.h>
 #include <avsystem/commons/avs_stream_simple_io.h>
 
 #include "test_stream_common.h"
@@ -596,6 +597,80 @@ AVS_UNIT_TEST(stream_generic, getline_errors) {
     test_input_streams(getline_errors_test);
 }
 
+typedef struct {
+    const avs_stream_v_table_t *const vtable;
+    avs_stream_t *backend;
+} no_window_stream_t;
+
+static avs_error_t no_window_read(avs_stream_t *stream,
+                                  size_t *out_bytes_read,
+                                  bool *out_message_finished,
+                                  void *buffer,
+                                  size_t buffer_length) {
+    return avs_stream_read(((no_window_stream_t *) stream)->backend,
+                           out_bytes_read, out_message_finished, buffer,
+                           buffer_length);
+}
+
+static avs_error_t
+no_window_peek(avs_stream_t *stream, size_t offset, char *out_value) {
+    return avs_stream_peek(((no_window_stream_t *) stream)->backend, offset,
+                           out_value);
+}
+
+static avs_error_t no_window_peek_window(avs_stream_t *stream,
+                                         size_t offset,
+                                         const char **out_data,
+                                         size_t *out_length) {
+    (void) stream;
+    (void) offset;
+    (void) out_data;
+    (void) out_length;
+    return avs_errno(AVS_ENOBUFS);
+}
+
+static const avs_stream_v_table_t no_window_vtable = {
+    .read = no_window_read,
+    .peek = no_window_peek,
+    .extension_list =
+            (const avs_stream_v_table_extension_t[]) {
+                    { AVS_STREAM_V_TABLE_EXTENSION_READ_WINDOW,
+                      &(const avs_stream_v_table_extension_read_window_t) {
+                              no_window_peek_window } },
+                    AVS_STREAM_V_TABLE_EXTENSION_NULL }
+};
+
+AVS_UNIT_TEST(stream_generic, getline_without_window) {
+    no_window_stream_t stream = { &no_window_vtable,
+                                  avs_stream_membuf_create() };
+    AVS_UNIT_ASSERT_NOT_NULL(stream.backend);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(stream.backend, "foo\r\nbar\n", 9));
+
+    char buffer[16];
+    size_t bytes_read;
+    size_t next_offset;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peekline((avs_stream_t *) &stream, 5,
+                                                &bytes_read, &next_offset,
+                                                buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_EQUAL(next_offset, 9);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buffer, "bar");
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_getline((avs_stream_t *) &stream,
+                                               &bytes_read, NULL, buffer,
+                                               sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buffer, "foo");
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_getline((avs_stream_t *) &stream,
+                                               &bytes_read, NULL, buffer,
+                                               sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buffer, "bar");
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream.backend));
+}
+
 //
 // Input + output
 //
@@ -618,3 +693,65 @@ AVS_UNIT_TEST(stream_generic, copy_stream) {
     cleanup_output_streams(istreams, ictx, istream_num);
     cleanup_output_streams(ostreams, octx, ostream_num);
 }
+
+static void copy_to_membuf_test(avs_stream_t *stream) {
+    avs_stream_t *membuf = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(membuf);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_copy(membuf, stream));
+
+    void *data;
+    size_t size;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_membuf_take_ownership(membuf, &data,
+                                                             &size));
+    AVS_UNIT_ASSERT_EQUAL(size, STREAM_SIZE);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, TEST_DATA, STREAM_SIZE);
+    avs_free(data);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&membuf));
+}
+
+AVS_UNIT_TEST(stream_generic, copy_to_membuf) {
+    test_input_streams(copy_to_membuf_test);
+}
+
+static void copy_to_outbuf_test(avs_stream_t *stream) {
+    char buf[STREAM_SIZE];
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_copy((avs_stream_t *) &outbuf, stream));
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), STREAM_SIZE);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, TEST_DATA, STREAM_SIZE);
+}
+
+AVS_UNIT_TEST(stream_generic, copy_to_outbuf) {
+    test_input_streams(copy_to_outbuf_test);
+}
+
+static void copy_to_too_small_outbuf_test(avs_stream_t *stream) {
+    char buf[STREAM_SIZE - 1];
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf));
+    avs_error_t err = avs_stream_copy((avs_stream_t *) &outbuf, stream);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EMSGSIZE);
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), sizeof(buf));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, TEST_DATA, sizeof(buf));
+}
+
+AVS_UNIT_TEST(stream_generic, copy_to_too_small_outbuf) {
+    test_input_streams(copy_to_too_small_outbuf_test);
+}
+
+AVS_UNIT_TEST(stream_generic, writev_fallback) {
+    char buf[16];
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf));
+    const avs_iovec_t iov[] = {
+        { "foo", 3 },
+        { NULL, 0 },
+        { "barbaz", 6 }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_writev((avs_stream_t *) &outbuf, iov,
+                                              AVS_ARRAY_SIZE(iov)));
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), 9);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "foobarbaz", 9);
+}
@@ -62,6 +62,59 @@ AVS_UNIT_TEST(stream_membuf, peek) {
     AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
 }
 
+AVS_UNIT_TEST(stream_membuf, peek_window) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    static const char *str = "very stream";
+    const char *data;
+    size_t length;
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_TRUE(
+            avs_is_eof(avs_stream_peek_window(stream, 0, &data, &length)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, str, strlen(str)));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek_window(stream, 0, &data, &length));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, str, strlen(str));
+    AVS_UNIT_ASSERT_EQUAL(length, strlen(str));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek_window(stream, 5, &data, &length));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, "stream", 6);
+    AVS_UNIT_ASSERT_EQUAL(length, 6);
+
+    char buf[5];
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read_reliably(stream, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek_window(stream, 0, &data, &length));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, "stream", 6);
+    AVS_UNIT_ASSERT_EQUAL(length, 6);
+    AVS_UNIT_ASSERT_TRUE(
+            avs_is_eof(avs_stream_peek_window(stream, 6, &data, &length)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf, write_reserve) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "very", 4));
+
+    void *ptr;
+    size_t length;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write_reserve(stream, 7, &ptr, &length));
+    AVS_UNIT_ASSERT_TRUE(length >= 7);
+    memcpy(ptr, " stream", 7);
+    // nothing is visible before commit
+    AVS_UNIT_ASSERT_TRUE(avs_is_eof(avs_stream_peek(stream, 4, &(char) { 0 })));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write_commit(stream, 7));
+
+    char buf[16];
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read(stream, &bytes_read,
+                                            &message_finished, buf,
+                                            sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 11);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "very stream", 11);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
 AVS_UNIT_TEST(stream_membuf, reset) {
     avs_stream_t *stream = avs_stream_membuf_create();
     static const char *str = "very stream";
@@ -309,3 +362,86 @@ AVS_UNIT_TEST(stream_getline, inline_cr) {
     AVS_UNIT_ASSERT_TRUE(msg_finished);
     AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
 }
+
+AVS_UNIT_TEST(stream_getline, embedded_nul) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    static const char DATA[] = "foo\0bar\n";
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, DATA, sizeof(DATA) - 1));
+
+    char buf[16];
+    size_t bytes_read;
+    size_t next_offset;
+    avs_error_t err = avs_stream_peekline(stream, 0, &bytes_read, &next_offset,
+                                          buf, sizeof(buf));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EIO);
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "foo");
+
+    err = avs_stream_getline(stream, &bytes_read, NULL, buf, sizeof(buf));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EIO);
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "foo");
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_getline, peekline) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    static const char DATA[] = "first\r\nse\rcond\nthird";
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, DATA, sizeof(DATA) - 1));
+
+    char buf[16];
+    size_t bytes_peeked;
+    size_t next_offset;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peekline(
+            stream, 0, &bytes_peeked, &next_offset, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "first");
+    AVS_UNIT_ASSERT_EQUAL(bytes_peeked, 5);
+    AVS_UNIT_ASSERT_EQUAL(next_offset, 7);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peekline(stream, next_offset,
+                                                &bytes_peeked, &next_offset,
+                                                buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "se\rcond");
+    AVS_UNIT_ASSERT_EQUAL(bytes_peeked, 7);
+    AVS_UNIT_ASSERT_EQUAL(next_offset, 15);
+
+    AVS_UNIT_ASSERT_TRUE(avs_is_eof(avs_stream_peekline(
+            stream, next_offset, &bytes_peeked, &next_offset, buf,
+            sizeof(buf))));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "third");
+    AVS_UNIT_ASSERT_EQUAL(next_offset, sizeof(DATA) - 1);
+
+    // nothing has been consumed
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_getline(stream, NULL, NULL, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "first");
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf, take_ownership_iov) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    avs_iovec_t *iov = NULL;
+    size_t iov_count;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership_iov(stream, &iov, &iov_count));
+    AVS_UNIT_ASSERT_NULL(iov);
+    AVS_UNIT_ASSERT_EQUAL(iov_count, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "very stream", 11));
+    char skipped[5];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_read_reliably(stream, skipped, sizeof(skipped)));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership_iov(stream, &iov, &iov_count));
+    AVS_UNIT_ASSERT_EQUAL(iov_count, 1);
+    AVS_UNIT_ASSERT_EQUAL(iov[0].length, 6);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(iov[0].base, "stream", 6);
+    avs_stream_membuf_iov_free(&iov, iov_count);
+    AVS_UNIT_ASSERT_NULL(iov);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
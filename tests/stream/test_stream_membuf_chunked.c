@@ -0,0 +1,207 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+static const char CHUNKED_DATA[] =
+        "The quick brown fox jumps over the lazy dog";
+
+AVS_UNIT_TEST(stream_membuf_chunked, write_read) {
+    avs_stream_t *stream = avs_stream_membuf_chunked_create(8);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(stream, CHUNKED_DATA, sizeof(CHUNKED_DATA)));
+    chunked_membuf_t *membuf = (chunked_membuf_t *) stream;
+    AVS_UNIT_ASSERT_EQUAL(membuf->chunks_count, 6);
+
+    char buf[64];
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_read(stream, &bytes_read, &message_finished, buf, 13));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 13);
+    AVS_UNIT_ASSERT_FALSE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL(membuf->chunks_count, 5);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read(stream, &bytes_read,
+                                            &message_finished, buf + 13,
+                                            sizeof(buf) - 13));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, sizeof(CHUNKED_DATA) - 13);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, CHUNKED_DATA);
+
+    // the last chunk is kept for reuse
+    AVS_UNIT_ASSERT_EQUAL(membuf->chunks_count, 1);
+    AVS_UNIT_ASSERT_EQUAL(membuf->read_offset, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf_chunked, peek) {
+    avs_stream_t *stream = avs_stream_membuf_chunked_create(8);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(stream, CHUNKED_DATA, strlen(CHUNKED_DATA)));
+    char skipped[10];
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read_reliably(stream, skipped, 5));
+
+    char value;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek(stream, 0, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 'u');
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek(stream, 37, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 'g');
+    AVS_UNIT_ASSERT_TRUE(avs_is_eof(avs_stream_peek(stream, 38, &value)));
+
+    const char *data;
+    size_t length;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek_window(stream, 0, &data, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, 3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, "uic", 3);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek_window(stream, 35, &data, &length));
+    AVS_UNIT_ASSERT_EQUAL(length, 3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, "dog", 3);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf_chunked, getline_across_chunks) {
+    avs_stream_t *stream = avs_stream_membuf_chunked_create(4);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write_f(stream, "first line\r\nsecond\n"));
+
+    char line[32];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_getline(stream, NULL, NULL, line, sizeof(line)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(line, "first line");
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_getline(stream, NULL, NULL, line, sizeof(line)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(line, "second");
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf_chunked, take_ownership) {
+    avs_stream_t *stream = avs_stream_membuf_chunked_create(8);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(stream, CHUNKED_DATA, sizeof(CHUNKED_DATA)));
+
+    void *ptr = NULL;
+    size_t size;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(stream, &ptr, &size));
+    AVS_UNIT_ASSERT_EQUAL(size, sizeof(CHUNKED_DATA));
+    AVS_UNIT_ASSERT_EQUAL_STRING((const char *) ptr, CHUNKED_DATA);
+    avs_free(ptr);
+    AVS_UNIT_ASSERT_EQUAL(((chunked_membuf_t *) stream)->chunks_count, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf_chunked, take_ownership_iov) {
+    avs_stream_t *stream = avs_stream_membuf_chunked_create(8);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(stream, CHUNKED_DATA, strlen(CHUNKED_DATA)));
+    char skipped[10];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_read_reliably(stream, skipped, sizeof(skipped)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_membuf_ensure_free_bytes(stream, 100));
+
+    avs_iovec_t *iov = NULL;
+    size_t iov_count;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership_iov(stream, &iov, &iov_count));
+    AVS_UNIT_ASSERT_EQUAL(iov_count, 5);
+    char buf[64];
+    size_t length = 0;
+    for (size_t i = 0; i < iov_count; ++i) {
+        memcpy(buf + length, iov[i].base, iov[i].length);
+        length += iov[i].length;
+    }
+    AVS_UNIT_ASSERT_EQUAL(length, strlen(CHUNKED_DATA) - 10);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, CHUNKED_DATA + 10, length);
+    avs_stream_membuf_iov_free(&iov, iov_count);
+    AVS_UNIT_ASSERT_NULL(iov);
+
+    // spare chunks have been released as well
+    AVS_UNIT_ASSERT_EQUAL(((chunked_membuf_t *) stream)->chunks_count, 0);
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read(stream, &bytes_read,
+                                            &message_finished, buf,
+                                            sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 0);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf_chunked, fit) {
+    avs_stream_t *stream = avs_stream_membuf_chunked_create(8);
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_membuf_ensure_free_bytes(stream, 64));
+    chunked_membuf_t *membuf = (chunked_membuf_t *) stream;
+    AVS_UNIT_ASSERT_EQUAL(membuf->chunks_count, 8);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, CHUNKED_DATA, 20));
+    const char *first_chunk = membuf->chunks[membuf->first_chunk];
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_membuf_fit(stream));
+    AVS_UNIT_ASSERT_EQUAL(membuf->chunks_count, 3);
+    AVS_UNIT_ASSERT_EQUAL(membuf->chunks_capacity, 3);
+    AVS_UNIT_ASSERT_TRUE(membuf->chunks[0] == first_chunk);
+
+    char buf[20];
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read_reliably(stream, buf, 20));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, CHUNKED_DATA, 20);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_membuf_chunked, pool) {
+    avs_stream_membuf_chunk_pool_t *pool =
+            avs_stream_membuf_chunk_pool_create(8, 4);
+    AVS_UNIT_ASSERT_NOT_NULL(pool);
+
+    avs_stream_t *stream1 = avs_stream_membuf_chunked_create_with_pool(pool);
+    AVS_UNIT_ASSERT_NOT_NULL(stream1);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(stream1, CHUNKED_DATA, sizeof(CHUNKED_DATA)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream1));
+    // 6 chunks were released, but only 4 of them are kept
+    AVS_UNIT_ASSERT_EQUAL(pool->free_chunks_count, 4);
+
+    avs_stream_t *stream2 = avs_stream_membuf_chunked_create_with_pool(pool);
+    AVS_UNIT_ASSERT_NOT_NULL(stream2);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream2, CHUNKED_DATA, 20));
+    AVS_UNIT_ASSERT_EQUAL(pool->free_chunks_count, 1);
+
+    char buf[20];
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read_reliably(stream2, buf, 20));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, CHUNKED_DATA, 20);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream2));
+    AVS_UNIT_ASSERT_EQUAL(pool->free_chunks_count, 4);
+
+    avs_stream_membuf_chunk_pool_free(&pool);
+    AVS_UNIT_ASSERT_NULL(pool);
+}
+
+AVS_UNIT_TEST(stream_membuf_chunked, null_pool) {
+    AVS_UNIT_ASSERT_NULL(avs_stream_membuf_chunked_create_with_pool(NULL));
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2024 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <avsystem/commons/avs_socket_v_table.h>
+#include <avsystem/commons/avs_unit_mocksock.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#define OUT_BUFFER_SIZE 8
+
+static avs_net_socket_t *create_connected_mocksock(void) {
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create(&socket);
+    avs_unit_mocksock_expect_connect(socket, "host", "port");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "host", "port"));
+    return socket;
+}
+
+static void cleanup_mocksock_stream(avs_stream_t **stream,
+                                    avs_net_socket_t *socket) {
+    avs_unit_mocksock_assert_expects_met(socket);
+    avs_unit_mocksock_expect_shutdown(socket);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(stream));
+}
+
+AVS_UNIT_TEST(stream_netbuf, writev_fits_in_buffer) {
+    avs_net_socket_t *socket = create_connected_mocksock();
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_netbuf_create(&stream, socket, 0, OUT_BUFFER_SIZE));
+
+    const avs_iovec_t iov[] = { { "ab", 2 }, { NULL, 0 }, { "cd", 2 } };
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_writev(stream, iov, AVS_ARRAY_SIZE(iov)));
+    // nothing is sent until the buffer is full or the message is finished
+    avs_unit_mocksock_assert_expects_met(socket);
+
+    avs_unit_mocksock_expect_output(socket, "abcd", 4);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
+    cleanup_mocksock_stream(&stream, socket);
+}
+
+AVS_UNIT_TEST(stream_netbuf, writev_fills_buffer_exactly) {
+    avs_net_socket_t *socket = create_connected_mocksock();
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_netbuf_create(&stream, socket, 0, OUT_BUFFER_SIZE));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "abc", 3));
+    const avs_iovec_t iov[] = { { "de", 2 }, { "fgh", 3 } };
+    avs_unit_mocksock_expect_output(socket, "abcdefgh", 8);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_writev(stream, iov, AVS_ARRAY_SIZE(iov)));
+    avs_unit_mocksock_assert_expects_met(socket);
+
+    // the buffer shall be empty after the flush
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
+    cleanup_mocksock_stream(&stream, socket);
+}
+
+AVS_UNIT_TEST(stream_netbuf, writev_without_sendv_sends_sequentially) {
+    // mocksock does not implement sendv, so avs_net_socket_sendv() fails with
+    // AVS_ENOTSUP and the data shall be sent block by block
+    avs_net_socket_t *socket = create_connected_mocksock();
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_netbuf_create(&stream, socket, 0, OUT_BUFFER_SIZE));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "abc", 3));
+    const avs_iovec_t iov[] = { { "defgh", 5 }, { NULL, 0 }, { "ijk", 3 } };
+    avs_unit_mocksock_expect_output(socket, "abc", 3);
+    avs_unit_mocksock_expect_output(socket, "defgh", 5);
+    avs_unit_mocksock_expect_output(socket, "ijk", 3);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_writev(stream, iov, AVS_ARRAY_SIZE(iov)));
+    cleanup_mocksock_stream(&stream, socket);
+}
+
+AVS_UNIT_TEST(stream_netbuf, writev_without_sendv_send_error) {
+    avs_net_socket_t *socket = create_connected_mocksock();
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_netbuf_create(&stream, socket, 0, OUT_BUFFER_SIZE));
+
+    const avs_iovec_t iov[] = { { "abcde", 5 }, { "fghij", 5 } };
+    avs_unit_mocksock_expect_output(socket, "abcde", 5);
+    avs_unit_mocksock_output_fail(socket, avs_errno(AVS_ECONNRESET));
+    avs_error_t err = avs_stream_writev(stream, iov, AVS_ARRAY_SIZE(iov));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ECONNRESET);
+    cleanup_mocksock_stream(&stream, socket);
+}
+
+typedef struct {
+    const avs_net_socket_v_table_t *const operations;
+    avs_error_t sendv_result;
+    size_t send_calls;
+    size_t sendv_calls;
+    size_t last_iov_count;
+    char output[64];
+    size_t output_size;
+} sendv_socket_t;
+
+static void sendv_socket_record(sendv_socket_t *socket,
+                                const void *data,
+                                size_t length) {
+    AVS_UNIT_ASSERT_TRUE(length
+                         <= sizeof(socket->output) - socket->output_size);
+    memcpy(socket->output + socket->output_size, data, length);
+    socket->output_size += length;
+}
+
+static avs_error_t sendv_socket_send(avs_net_socket_t *socket_,
+                                     const void *buffer,
+                                     size_t buffer_length) {
+    sendv_socket_t *socket = (sendv_socket_t *) socket_;
+    ++socket->send_calls;
+    sendv_socket_record(socket, buffer, buffer_length);
+    return AVS_OK;
+}
+
+static avs_error_t sendv_socket_sendv(avs_net_socket_t *socket_,
+                                      const avs_iovec_t *iov,
+                                      size_t iov_count) {
+    sendv_socket_t *socket = (sendv_socket_t *) socket_;
+    ++socket->sendv_calls;
+    socket->last_iov_count = iov_count;
+    if (avs_is_ok(socket->sendv_result)) {
+        for (size_t i = 0; i < iov_count; ++i) {
+            sendv_socket_record(socket, iov[i].base, iov[i].length);
+        }
+    }
+    return socket->sendv_result;
+}
+
+static avs_error_t sendv_socket_shutdown(avs_net_socket_t *socket) {
+    (void) socket;
+    return AVS_OK;
+}
+
+static avs_error_t sendv_socket_cleanup(avs_net_socket_t **socket) {
+    *socket = NULL;
+    return AVS_OK;
+}
+
+static const avs_net_socket_v_table_t SENDV_SOCKET_VTABLE = {
+    .send = sendv_socket_send,
+    .shutdown = sendv_socket_shutdown,
+    .cleanup = sendv_socket_cleanup,
+    .sendv = sendv_socket_sendv
+};
+
+AVS_UNIT_TEST(stream_netbuf, writev_sends_buffered_data_with_blocks) {
+    sendv_socket_t socket = {
+        .operations = &SENDV_SOCKET_VTABLE
+    };
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_netbuf_create(&stream, (avs_net_socket_t *) &socket, 0,
+                                     OUT_BUFFER_SIZE));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "abc", 3));
+    const avs_iovec_t iov[] = { { "defgh", 5 }, { "ijk", 3 } };
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_writev(stream, iov, AVS_ARRAY_SIZE(iov)));
+    AVS_UNIT_ASSERT_EQUAL(socket.sendv_calls, 1);
+    AVS_UNIT_ASSERT_EQUAL(socket.last_iov_count, AVS_ARRAY_SIZE(iov) + 1);
+    AVS_UNIT_ASSERT_EQUAL(socket.send_calls, 0);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(socket.output, "abcdefghijk", 11);
+    AVS_UNIT_ASSERT_EQUAL(socket.output_size, 11);
+
+    // buffered data shall not be sent again
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
+    AVS_UNIT_ASSERT_EQUAL(socket.send_calls, 0);
+    AVS_UNIT_ASSERT_EQUAL(socket.output_size, 11);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_netbuf, writev_sendv_error_keeps_buffered_data) {
+    sendv_socket_t socket = {
+        .operations = &SENDV_SOCKET_VTABLE
+    };
+    socket.sendv_result = avs_errno(AVS_ECONNRESET);
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_netbuf_create(&stream, (avs_net_socket_t *) &socket, 0,
+                                     OUT_BUFFER_SIZE));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "abc", 3));
+    const avs_iovec_t iov[] = { { "defghijk", 8 } };
+    avs_error_t err = avs_stream_writev(stream, iov, AVS_ARRAY_SIZE(iov));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ECONNRESET);
+    AVS_UNIT_ASSERT_EQUAL(socket.send_calls, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
+    AVS_UNIT_ASSERT_EQUAL(socket.send_calls, 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(socket.output, "abc", 3);
+    AVS_UNIT_ASSERT_EQUAL(socket.output_size, 3);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_netbuf, writev_many_blocks) {
+    sendv_socket_t socket = {
+        .operations = &SENDV_SOCKET_VTABLE
+    };
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_netbuf_create(&stream, (avs_net_socket_t *) &socket, 0,
+                                     OUT_BUFFER_SIZE));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "+", 1));
+    // more blocks than fit in the on-stack array, forcing a heap allocation
+    avs_iovec_t iov[NETBUF_STACK_IOV_COUNT + 2];
+    static const char DATA[] = "0123456789";
+    AVS_STATIC_ASSERT(sizeof(DATA) - 1 >= AVS_ARRAY_SIZE(iov),
+                      netbuf_test_data_too_short);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(iov); ++i) {
+        iov[i].base = &DATA[i];
+        iov[i].length = 1;
+    }
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_writev(stream, iov, AVS_ARRAY_SIZE(iov)));
+    AVS_UNIT_ASSERT_EQUAL(socket.sendv_calls, 1);
+    AVS_UNIT_ASSERT_EQUAL(socket.last_iov_count, AVS_ARRAY_SIZE(iov) + 1);
+    AVS_UNIT_ASSERT_EQUAL(socket.send_calls, 0);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(socket.output, "+0123456789",
+                                      AVS_ARRAY_SIZE(iov) + 1);
+    AVS_UNIT_ASSERT_EQUAL(socket.output_size, AVS_ARRAY_SIZE(iov) + 1);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+}
+
+AVS_UNIT_TEST(stream_netbuf, datagram_received_into_wrapped_buffer) {
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create_datagram(&socket);
+    avs_unit_mocksock_expect_connect(socket, "host", "port");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "host", "port"));
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_netbuf_create(&stream, socket, 16, 0));
+
+    char buf[16];
+    size_t bytes_read;
+    avs_unit_mocksock_input(socket, "0123456789", 10);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_read(stream, &bytes_read, NULL, buf, 6));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 6);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "012345", 6);
+
+    // the free space is now split into 6 bytes at the end and 6 bytes at the
+    // beginning of the ring; the whole datagram shall still be received
+    avs_unit_mocksock_input(socket, "abcdefghij", 10);
+    char value;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_peek(stream, 13, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 'j');
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_read(stream, &bytes_read, NULL, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 14);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "6789abcdefghij", 14);
+    cleanup_mocksock_stream(&stream, socket);
+}